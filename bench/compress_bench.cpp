@@ -0,0 +1,140 @@
+// Compression benchmark: write throughput and size ratio per zlib level on a
+// sample corpus, each file compressed on its own like a loose object. The
+// "zlib" columns always call zlib directly; when built with MGIT_LIBDEFLATE a
+// second set shows compressZlib's libdeflate backend on the same input.
+//
+//   compress_bench [corpus-dir] [rounds]   (defaults: src, 3)
+//
+// Throughput is uncompressed MB per second (best of `rounds`); ratio is
+// compressed size / original size.
+
+#include "../src/headers/ZlibUtils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+struct Result {
+    double megabytesPerSecond = 0;
+    double ratio = 0;
+};
+
+std::string zlibCompress(const std::string& input, int level) {
+    uLongf size = compressBound(input.size());
+    std::string output(size, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&output[0]), &size,
+                  reinterpret_cast<const Bytef*>(input.data()), input.size(),
+                  level) != Z_OK) {
+        std::cerr << "compress2 failed\n";
+        std::exit(1);
+    }
+    output.resize(size);
+    return output;
+}
+
+std::vector<std::string> loadCorpus(const std::string& root, size_t& total) {
+    std::vector<std::string> files;
+    total = 0;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file())
+            continue;
+        std::ifstream in(entry.path(), std::ios::binary);
+        std::ostringstream data;
+        data << in.rdbuf();
+        // Same "<type> <size>\0" prefix a loose object gets.
+        std::string body = data.str();
+        files.push_back("blob " + std::to_string(body.size()) + '\0' + body);
+        total += files.back().size();
+    }
+    return files;
+}
+
+template <typename Compress>
+Result measure(const std::vector<std::string>& files, size_t total,
+               int rounds, Compress compress) {
+    Result result;
+    double best = 1e30;
+    for (int round = 0; round < rounds; ++round) {
+        size_t compressed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& file : files)
+            compressed += compress(file).size();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+        result.ratio = static_cast<double>(compressed) / total;
+    }
+    result.megabytesPerSecond = total / best / 1e6;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string root = argc > 1 ? argv[1] : "src";
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (rounds < 1)
+        rounds = 1;
+
+    size_t total = 0;
+    std::vector<std::string> files = loadCorpus(root, total);
+    if (files.empty()) {
+        std::cerr << "No files found under " << root << "\n";
+        return 1;
+    }
+
+    // Every backend must round-trip the corpus before it is timed.
+    for (const auto& file : files) {
+        std::string packed = compressZlib(file, 1);
+        if (decompressZlib(std::vector<char>(packed.begin(), packed.end())) !=
+            file) {
+            std::cerr << "ROUND-TRIP MISMATCH (" << zlibBackendName() << ")\n";
+            return 1;
+        }
+    }
+
+    const bool otherBackend = std::strcmp(zlibBackendName(), "zlib") != 0;
+    std::cout << "Compression of " << files.size() << " files, "
+              << std::fixed << std::setprecision(1) << total / 1e6
+              << " MB from " << root << " (MB/s, compressed/original)\n";
+    std::cout << std::left << std::setw(8) << "level" << std::setw(12)
+              << "zlib MB/s" << std::setw(12) << "zlib ratio";
+    if (otherBackend) {
+        std::string name = zlibBackendName();
+        std::cout << std::setw(18) << name + " MB/s" << std::setw(18)
+                  << name + " ratio";
+    }
+    std::cout << "\n";
+
+    for (int level = 0; level <= 9; ++level) {
+        Result zlib = measure(files, total, rounds, [level](const std::string& in) {
+            return zlibCompress(in, level);
+        });
+        std::cout << std::setw(8) << level << std::setprecision(1)
+                  << std::setw(12) << zlib.megabytesPerSecond
+                  << std::setprecision(3) << std::setw(12) << zlib.ratio;
+        if (otherBackend) {
+            Result other = measure(files, total, rounds,
+                                   [level](const std::string& in) {
+                                       return compressZlib(in, level);
+                                   });
+            std::cout << std::setprecision(1) << std::setw(18)
+                      << other.megabytesPerSecond << std::setprecision(3)
+                      << std::setw(18) << other.ratio;
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Ignore matching benchmark: IgnoreRules (hash buckets plus compiled
+// wildcards) against trying every pattern in turn with fnmatch(), the way a
+// straightforward gitignore implementation would. The rules are a typical
+// project .gitignore; the paths are a synthetic source tree. Also checks that
+// both agree on every path, as files and as directories.
+//
+//   ignore_bench [paths]   (default 200000 paths)
+
+#include "../src/headers/GitIgnore.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fnmatch.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const kRules[] = {
+    "# build output",  "build/",          "/out",          "dist/",
+    "target/",         "bin/",            "obj/",          "CMakeFiles/",
+    "/CMakeCache.txt", "cmake-build-*/",  "*.o",           "*.a",
+    "*.so",            "*.so.[0-9]*",     "*.dylib",       "*.obj",
+    "*.lib",           "*.exe",           "*.class",       "*.jar",
+    "*.pyc",           "__pycache__/",    "*.egg-info/",   ".pytest_cache/",
+    "node_modules/",   "npm-debug.log*",  "yarn-error.log", "coverage/",
+    ".nyc_output",     "*.log",           "!keep.log",     "logs/*.gz",
+    "*.tmp",           "*.swp",           "*~",            ".#*",
+    "\\#*#",           ".DS_Store",       "Thumbs.db",     ".idea/",
+    ".vscode/",        "*.iml",           ".env",          ".env.*",
+    "!.env.example",   "docs/_build/",    "test-output-*.xml", "*.[oa].d",
+    "generated/*.h",   "third_party/*/build/",
+};
+
+const char* const kDirs[] = {"src", "include", "lib", "test", "docs", "tools",
+                             "build", "node_modules", "app", "core"};
+const char* const kNames[] = {"main", "util", "parser", "index", "config",
+                              "keep", "README", "Makefile", "server", "view"};
+const char* const kExtensions[] = {".c", ".h", ".cpp", ".o", ".log", ".md", ".py",
+                                   ".pyc", ".js", ".tmp", "", ".so.1", "~", ".json"};
+
+// What the rules say, trying every pattern from the last one back.
+struct NaiveRule {
+    std::string pattern;
+    bool negated = false;
+    bool dirOnly = false;
+    bool anchored = false;
+};
+
+std::vector<NaiveRule> naiveRules() {
+    std::vector<NaiveRule> rules;
+    for (const char* text : kRules) {
+        std::string line = text;
+        if (line.empty() || line[0] == '#')
+            continue;
+        NaiveRule rule;
+        if (line[0] == '!') {
+            rule.negated = true;
+            line.erase(0, 1);
+        }
+        if (line.back() == '/') {
+            rule.dirOnly = true;
+            line.pop_back();
+        }
+        rule.anchored = line.find('/') != std::string::npos;
+        if (rule.anchored && line[0] == '/')
+            line.erase(0, 1);
+        rule.pattern = line;
+        rules.push_back(rule);
+    }
+    return rules;
+}
+
+IgnoreRules::Match naiveMatch(const std::vector<NaiveRule>& rules, const std::string& path,
+                              bool isDir) {
+    size_t slash = path.rfind('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    for (auto it = rules.rbegin(); it != rules.rend(); ++it) {
+        if (it->dirOnly && !isDir)
+            continue;
+        const std::string& subject = it->anchored ? path : name;
+        if (fnmatch(it->pattern.c_str(), subject.c_str(), FNM_PATHNAME) == 0)
+            return it->negated ? IgnoreRules::Match::Included : IgnoreRules::Match::Ignored;
+    }
+    return IgnoreRules::Match::None;
+}
+
+template <typename Fn>
+double nanosPerPath(size_t count, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        fn(i);
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / count;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (count == 0)
+        count = 1;
+
+    std::string text;
+    for (const char* rule : kRules)
+        text += std::string(rule) + "\n";
+    IgnoreRules rules("", text);
+    std::vector<NaiveRule> naive = naiveRules();
+
+    std::mt19937_64 rng(42);
+    auto pick = [&](auto& table) {
+        return std::string(table[rng() % (sizeof(table) / sizeof(table[0]))]);
+    };
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string path;
+        size_t depth = rng() % 4;
+        for (size_t d = 0; d < depth; ++d)
+            path += pick(kDirs) + "/";
+        paths.push_back(path + pick(kNames) + pick(kExtensions));
+    }
+
+    size_t ignored = 0;
+    for (const auto& path : paths) {
+        for (bool isDir : {false, true}) {
+            IgnoreRules::Match expected = naiveMatch(naive, path, isDir);
+            IgnoreRules::Match actual = rules.match(path, isDir);
+            if (expected != actual) {
+                std::cerr << "MISMATCH " << path << (isDir ? "/" : "") << "\n";
+                return 1;
+            }
+            ignored += actual == IgnoreRules::Match::Ignored;
+        }
+    }
+
+    volatile size_t sink = 0;
+    const size_t mask = paths.size();
+    double naiveNs = nanosPerPath(count, [&](size_t i) {
+        sink = sink + static_cast<size_t>(naiveMatch(naive, paths[i % mask], false));
+    });
+    double compiledNs = nanosPerPath(count, [&](size_t i) {
+        sink = sink + static_cast<size_t>(rules.match(paths[i % mask], false));
+    });
+
+    std::cout << "Ignore matching, " << naive.size() << " rules, " << count << " paths ("
+              << ignored << " of " << 2 * count << " file/dir checks ignored)\n"
+              << std::fixed << std::setprecision(1) << std::left << std::setw(22)
+              << "fnmatch per rule" << naiveNs << " ns/path\n"
+              << std::setw(22) << "IgnoreRules" << compiledNs << " ns/path\n";
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Merge-base benchmark on a synthetic history: a DAG of N commits spread
+// over parallel lanes (long-lived branches), with a share of them merging
+// in the head of another lane. Random pairs of recent commits are resolved
+// three ways:
+//
+//   generation  paint-down walk ordered by commit-graph generation numbers
+//   date        the same walk without a commit-graph (date order only)
+//   first-parent  the previous findCommonAncestor (first parents only; kept
+//                 for timing, its answers are often wrong across merges)
+//
+// The two paint-down modes must agree. "lookups" counts commits loaded per
+// query, i.e. how much history each method had to touch.
+//
+//   merge_base_bench [commits] [queries]   (defaults: 500000, 100)
+
+#include "../src/headers/GitMergeBase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Node {
+  std::vector<uint32_t> parents;
+  int64_t time = 0;
+  uint32_t generation = 1;
+};
+
+// index + 1 big-endian in the first four bytes: no commit gets the null ID,
+// and std::hash<ObjectId> (which reads the leading bytes) still spreads them.
+ObjectId idFor(uint32_t index) {
+  ObjectId id;
+  uint32_t value = index + 1;
+  for (int i = 0; i < 4; ++i) {
+    id.data()[3 - i] = static_cast<unsigned char>(value >> (8 * i));
+  }
+  return id;
+}
+
+uint32_t indexFor(const ObjectId &id) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value = value << 8 | id.data()[i];
+  }
+  return value - 1;
+}
+
+std::vector<Node> buildHistory(uint32_t count, std::mt19937 &rng) {
+  const uint32_t lanes = 32;
+  std::vector<Node> nodes(count);
+  std::vector<uint32_t> heads(lanes, 0);
+  std::uniform_int_distribution<uint32_t> pickLane(0, lanes - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::uniform_int_distribution<int> skew(-300, 300);
+  for (uint32_t i = 1; i < count; ++i) {
+    uint32_t lane = pickLane(rng);
+    Node &node = nodes[i];
+    node.parents.push_back(heads[lane]);
+    if (percent(rng) < 15) { // merge another lane
+      uint32_t other = heads[pickLane(rng)];
+      if (other != heads[lane]) {
+        node.parents.push_back(other);
+      }
+    }
+    // Mostly increasing times with some clock skew between machines.
+    node.time = 1000000000 + static_cast<int64_t>(i) * 60 + skew(rng);
+    for (uint32_t parent : node.parents) {
+      node.generation = std::max(node.generation, nodes[parent].generation + 1);
+    }
+    heads[lane] = i;
+  }
+  return nodes;
+}
+
+ObjectId firstParentBase(const ObjectId &a, const ObjectId &b,
+                         const CommitLookup &lookup) {
+  std::unordered_set<ObjectId> historyA;
+  CommitInfo info;
+  for (ObjectId hash = a; !hash.isNull();) {
+    historyA.insert(hash);
+    if (!lookup(hash, info) || info.parents.empty()) {
+      break;
+    }
+    hash = info.parents[0];
+  }
+  for (ObjectId hash = b; !hash.isNull();) {
+    if (historyA.count(hash)) {
+      return hash;
+    }
+    if (!lookup(hash, info) || info.parents.empty()) {
+      break;
+    }
+    hash = info.parents[0];
+  }
+  return ObjectId();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+  int queries = argc > 2 ? std::atoi(argv[2]) : 100;
+  if (count < 1000) {
+    count = 1000;
+  }
+
+  std::mt19937 rng(42);
+  auto buildStart = std::chrono::steady_clock::now();
+  std::vector<Node> nodes = buildHistory(count, rng);
+  std::chrono::duration<double> buildTime =
+      std::chrono::steady_clock::now() - buildStart;
+  size_t merges = std::count_if(nodes.begin(), nodes.end(), [](const Node &n) {
+    return n.parents.size() > 1;
+  });
+  std::cout << "Synthetic history: " << count << " commits, " << merges
+            << " merges (built in " << std::fixed << std::setprecision(2)
+            << buildTime.count() << " s)\n";
+
+  uint64_t lookups = 0;
+  auto makeLookup = [&](bool withGraph) -> CommitLookup {
+    return [&nodes, &lookups, withGraph](const ObjectId &hash,
+                                         CommitInfo &info) {
+      uint32_t index = indexFor(hash);
+      if (index >= nodes.size()) {
+        return false;
+      }
+      ++lookups;
+      const Node &node = nodes[index];
+      info.parents.clear();
+      for (uint32_t parent : node.parents) {
+        info.parents.push_back(idFor(parent));
+      }
+      info.commitTime = node.time;
+      info.generation =
+          withGraph ? node.generation : CommitGraph::kGenerationInfinity;
+      return true;
+    };
+  };
+
+  // Pairs of commits from the most recent tenth of history.
+  std::uniform_int_distribution<uint32_t> recent(count - count / 10,
+                                                 count - 1);
+  std::vector<std::pair<ObjectId, ObjectId>> pairs;
+  for (int i = 0; i < queries; ++i) {
+    pairs.emplace_back(idFor(recent(rng)), idFor(recent(rng)));
+  }
+
+  struct Mode {
+    const char *name;
+    bool withGraph;
+    bool firstParent;
+  };
+  const Mode modes[] = {{"generation", true, false},
+                        {"date", false, false},
+                        {"first-parent", true, true}};
+  std::vector<std::vector<ObjectId>> reference;
+  std::cout << std::left << std::setw(14) << "method" << std::setw(14)
+            << "ms/query" << std::setw(14) << "lookups" << "\n";
+  for (const Mode &mode : modes) {
+    CommitLookup lookup = makeLookup(mode.withGraph);
+    lookups = 0;
+    std::vector<std::vector<ObjectId>> answers;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &[a, b] : pairs) {
+      if (mode.firstParent) {
+        answers.push_back({firstParentBase(a, b, lookup)});
+      } else {
+        answers.push_back(findMergeBases(a, b, lookup));
+        std::sort(answers.back().begin(), answers.back().end());
+      }
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << std::setw(14) << mode.name << std::setw(14)
+              << std::setprecision(3) << elapsed.count() / queries
+              << std::setw(14) << lookups / queries << "\n";
+    if (mode.firstParent) {
+      size_t wrong = 0;
+      for (size_t i = 0; i < answers.size(); ++i) {
+        if (std::find(reference[i].begin(), reference[i].end(),
+                      answers[i][0]) == reference[i].end()) {
+          ++wrong;
+        }
+      }
+      std::cout << "  first-parent answer is not a best merge base for "
+                << wrong << " of " << queries << " pairs\n";
+    } else if (reference.empty()) {
+      reference = answers;
+    } else if (answers != reference) {
+      std::cerr << "MISMATCH between paint-down modes\n";
+      return 1;
+    }
+  }
+  return 0;
+}
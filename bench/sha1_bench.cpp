@@ -0,0 +1,193 @@
+// SHA-1 throughput benchmark: the original hash_sha1 (kept below verbatim as
+// legacySha1) against the streaming context on every backend this CPU
+// supports, with and without collision detection ("+dc"). The last column is
+// the cost of detection on the auto-selected backend. Also cross-checks that
+// all implementations agree.
+//
+//   sha1_bench [megabytes]   (default 256 MB hashed per configuration)
+
+#include "../src/headers/HashUtils.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The implementation hash_sha1 used before the streaming context.
+std::string legacySha1(const std::string& data) {
+    auto leftrotate = [](uint32_t value, int bits) -> uint32_t {
+        return (value << bits) | (value >> (32 - bits));
+    };
+
+    std::vector<unsigned char> msg(data.begin(), data.end());
+    uint64_t bit_len = static_cast<uint64_t>(msg.size()) * 8;
+
+    msg.push_back(0x80);
+    while ((msg.size() % 64) != 56) {
+        msg.push_back(0x00);
+    }
+    for (int i = 7; i >= 0; --i) {
+        msg.push_back(static_cast<unsigned char>((bit_len >> (i * 8)) & 0xFF));
+    }
+
+    uint32_t h0 = 0x67452301;
+    uint32_t h1 = 0xEFCDAB89;
+    uint32_t h2 = 0x98BADCFE;
+    uint32_t h3 = 0x10325476;
+    uint32_t h4 = 0xC3D2E1F0;
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            size_t j = chunk + i * 4;
+            w[i] = (static_cast<uint32_t>(msg[j]) << 24) |
+                   (static_cast<uint32_t>(msg[j + 1]) << 16) |
+                   (static_cast<uint32_t>(msg[j + 2]) << 8) |
+                   static_cast<uint32_t>(msg[j + 3]);
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = leftrotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h0;
+        uint32_t b = h1;
+        uint32_t c = h2;
+        uint32_t d = h3;
+        uint32_t e = h4;
+
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f = 0;
+            uint32_t k = 0;
+            if (i < 20) {
+                f = (b & c) | ((~b) & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = leftrotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = leftrotate(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h0 += a;
+        h1 += b;
+        h2 += c;
+        h3 += d;
+        h4 += e;
+    }
+
+    uint32_t digest[5] = {h0, h1, h2, h3, h4};
+    std::ostringstream result;
+    result << std::hex << std::setfill('0');
+    for (int i = 0; i < 5; ++i) {
+        result << std::setw(8) << digest[i];
+    }
+    return result.str();
+}
+
+std::string streamingSha1(const std::string& data) {
+    return hash_sha1(data);
+}
+
+double measure(const std::string& input, size_t totalBytes,
+               std::string (*fn)(const std::string&)) {
+    size_t rounds = totalBytes / input.size();
+    if (rounds == 0)
+        rounds = 1;
+    volatile char sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+        sink = sink ^ fn(input)[0];
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return static_cast<double>(rounds * input.size()) / elapsed.count() / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    const size_t totalBytes = megabytes * 1024 * 1024;
+
+    std::mt19937_64 rng(42);
+    std::string random(8 * 1024 * 1024, '\0');
+    for (auto& c : random)
+        c = static_cast<char>(rng());
+
+    std::vector<Sha1Backend> backends;
+    for (Sha1Backend b : {Sha1Backend::Scalar, Sha1Backend::ShaNi}) {
+        if (sha1SetBackend(b))
+            backends.push_back(b);
+    }
+    const Sha1Backend detected = backends.back();
+
+    // Correctness: every backend must match the legacy code on all lengths
+    // around the padding boundaries, and chunked updates must match too.
+    for (size_t len = 0; len < 300; ++len) {
+        std::string input = random.substr(0, len);
+        std::string expected = legacySha1(input);
+        for (Sha1Backend b : backends) {
+          for (bool dc : {false, true}) {
+            sha1SetBackend(b);
+            sha1SetCollisionDetection(dc);
+            Sha1 chunked;
+            for (size_t pos = 0; pos < len; pos += 7)
+                chunked.update(input.data() + pos, std::min<size_t>(7, len - pos));
+            if (hash_sha1(input) != expected || chunked.finalHex() != expected) {
+                std::cerr << "MISMATCH backend=" << sha1BackendName(b)
+                          << (dc ? "+dc" : "") << " len=" << len << "\n";
+                return 1;
+            }
+          }
+        }
+    }
+    sha1SetCollisionDetection(false);
+
+    std::cout << "SHA-1 throughput in GB/s (" << megabytes
+              << " MB per cell; auto-selected backend: "
+              << sha1BackendName(detected) << ")\n";
+    std::cout << std::left << std::setw(10) << "size" << std::setw(12)
+              << "legacy";
+    for (Sha1Backend b : backends) {
+        std::cout << std::setw(12) << sha1BackendName(b) << std::setw(12)
+                  << std::string(sha1BackendName(b)) + "+dc";
+    }
+    std::cout << "dc cost\n";
+
+    for (size_t size : {size_t(64), size_t(1024), size_t(16 * 1024),
+                        size_t(1024 * 1024), size_t(8 * 1024 * 1024)}) {
+        std::string input = random.substr(0, size);
+        std::cout << std::setw(10) << size << std::fixed
+                  << std::setprecision(3) << std::setw(12)
+                  << measure(input, totalBytes / 4, legacySha1);
+        double fast = 0, detecting = 0;
+        for (Sha1Backend b : backends) {
+            sha1SetBackend(b);
+            fast = measure(input, totalBytes, streamingSha1);
+            sha1SetCollisionDetection(true);
+            detecting = measure(input, totalBytes, streamingSha1);
+            sha1SetCollisionDetection(false);
+            std::cout << std::setw(12) << fast << std::setw(12) << detecting;
+        }
+        std::cout << std::setprecision(2) << fast / detecting << "x\n";
+    }
+    sha1SetBackend(detected);
+    return 0;
+}
@@ -1,11 +1,13 @@
 #include "headers/CLISetupAndHandlers.hpp"
 #include "headers/GitActivityLogger.hpp"
 #include "headers/GitConfig.hpp"
+#include "headers/GitFsMonitor.hpp"
 #include "headers/GitObjectStorage.hpp"
 #include "headers/GitObjectTypesClasses.hpp"
 #include "headers/GitRepository.hpp"
 #include "headers/ZlibUtils.hpp"
 #include <CLI/CLI.hpp>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -35,10 +37,32 @@ bool handleInit(GitRepository &repo, const std::string &path) {
   return true;
 }
 
+// Object names are hex only on the command line; everything below takes the
+// raw ObjectId. "HEAD" is accepted where allowHead is set.
+static bool parseObjectName(GitRepository &repo, const std::string &name,
+                            ObjectId &id, bool allowHead = false) {
+  if (allowHead && (name == "HEAD" || name == "head")) {
+    id = repo.getHashOfBranchHead(repo.getCurrentBranch());
+    if (id.isNull()) {
+      std::cerr << "Error: HEAD does not point to a valid commit.\n";
+      return false;
+    }
+    return true;
+  }
+  if (!ObjectId::parseHex(name, id)) {
+    std::cerr << "Error: not a valid object name '" << name << "'.\n";
+    return false;
+  }
+  return true;
+}
+
 // ==================== OBJECT OPERATIONS ====================
 bool handleHashObject(GitRepository &repo, const std::string &filepath,
                       bool write) {
-  std::string hash = repo.writeObject(GitObjectType::Blob, filepath, write);
+  ObjectId hash = repo.writeObject(GitObjectType::Blob, filepath, write);
+  if (hash.isNull()) {
+    return false;
+  }
   std::cout << hash << "\n";
   return true;
 }
@@ -47,7 +71,7 @@ bool handleWriteTree(GitRepository &repo, const std::string &folder) {
   IndexManager idx(".git");
   idx.readIndex();
   TreeObject tree(".git");
-  std::string hash = tree.writeTreeFromIndex(idx.getEntries());
+  ObjectId hash = tree.writeTreeFromIndex(idx);
   std::cout << "Tree object written: " << hash << "\n";
   return true;
 }
@@ -56,10 +80,16 @@ bool handleCommitTree(GitRepository &repo, const std::string &tree,
                       const std::string &parent, const std::string &message,
                       const std::string &author) {
   CommitData data;
-  data.tree = tree;
+  if (!parseObjectName(repo, tree, data.tree)) {
+    return false;
+  }
 
   if (!parent.empty()) {
-    data.parents.push_back(parent);
+    ObjectId parentId;
+    if (!parseObjectName(repo, parent, parentId)) {
+      return false;
+    }
+    data.parents.push_back(parentId);
   }
 
   GitConfig config(GitConfig::findGitDir());
@@ -72,7 +102,7 @@ bool handleCommitTree(GitRepository &repo, const std::string &tree,
                    getCurrentTimestampWithTimezone();
   data.message = message;
 
-  std::string hash = repo.writeObject(GitObjectType::Commit, data);
+  ObjectId hash = repo.writeObject(GitObjectType::Commit, data);
   std::cout << "Commit object written: " << hash << "\n";
   return true;
 }
@@ -81,7 +111,9 @@ bool handleTagObject(GitRepository &repo, const std::string &targetHash,
                      const std::string &targetType, const std::string &tagName,
                      const std::string &tagMessage, const std::string &tagger) {
   TagData data;
-  data.objectHash = targetHash;
+  if (!parseObjectName(repo, targetHash, data.objectHash)) {
+    return false;
+  }
   data.objectType = targetType;
   data.tagName = tagName;
 
@@ -93,16 +125,20 @@ bool handleTagObject(GitRepository &repo, const std::string &targetHash,
 
   data.message = tagMessage;
 
-  std::string hash = repo.writeObject(GitObjectType::Tag, data);
+  ObjectId hash = repo.writeObject(GitObjectType::Tag, data);
   std::cout << "Tag object written: " << hash << "\n";
   return true;
 }
 
 // ==================== INSPECTION COMMANDS ====================
 bool handleReadObject(GitRepository &repo, const std::string &hash) {
-  std::string content = repo.readObjectRaw(hash);
+  ObjectId id;
+  if (!parseObjectName(repo, hash, id)) {
+    return false;
+  }
+  ObjectView content = repo.readObjectRaw(id);
   std::cout << "----- Raw Object -----\n";
-  for (char c : content) {
+  for (char c : content.raw()) {
     if (c == '\0') {
       std::cout << "\\0";
     } else if (isprint(static_cast<unsigned char>(c))) {
@@ -118,45 +154,59 @@ bool handleReadObject(GitRepository &repo, const std::string &hash) {
 
 bool handleCatFile(GitRepository &repo, const std::string &hash,
                    bool showContent, bool showType, bool showSize) {
-  std::string resolvedHash = hash;
-  if (hash == "HEAD" || hash == "head") {
-    resolvedHash = repo.getHashOfBranchHead(repo.getCurrentBranch());
-    if (resolvedHash.empty()) {
-      std::cerr << "Error: HEAD does not point to a valid commit.\n";
+  ObjectId resolvedHash;
+  if (!parseObjectName(repo, hash, resolvedHash, true)) {
+    return false;
+  }
+  // -t and -s only need the header: no body is inflated.
+  if (!showContent) {
+    std::string type;
+    uint64_t size = 0;
+    if (!repo.readObjectHeader(resolvedHash, type, size)) {
+      std::cerr << "Object not found\n";
       return false;
     }
+    if (showType)
+      std::cout << type << "\n";
+    if (showSize)
+      std::cout << size << "\n";
+    return true;
   }
-  std::string full = repo.readObjectRaw(resolvedHash);
-  if (full.empty()) {
+  // The body is piped to stdout as it is inflated, so large blobs are never
+  // held in memory.
+  bool ok = repo.streamObjectRaw(
+      resolvedHash,
+      [showType, showSize](const std::string &type, uint64_t size) {
+        if (showType)
+          std::cout << type << "\n";
+        if (showSize)
+          std::cout << size << "\n";
+      },
+      [showContent](const char *data, size_t length) {
+        if (showContent)
+          std::cout.write(data, static_cast<std::streamsize>(length));
+      });
+  if (!ok) {
     std::cerr << "Object not found\n";
     return false;
   }
-  size_t nullIdx = full.find('\0');
-  if (nullIdx == std::string::npos) {
-    std::cerr << "Invalid object format\n";
-    return false;
-  }
-  std::string header = full.substr(0, nullIdx);
-  std::string content = full.substr(nullIdx + 1);
-  std::string type = header.substr(0, header.find(' '));
-  size_t size = std::stoul(header.substr(header.find(' ') + 1));
-  if (showType)
-    std::cout << type << "\n";
-  if (showSize)
-    std::cout << size << "\n";
   if (showContent)
-    std::cout << content << "\n";
+    std::cout << "\n";
   return true;
 }
 
 bool handleLsRead(GitRepository &repo, const std::string &hash) {
-  std::string content = repo.readObjectRaw(hash);
-  if (content.empty()) {
+  ObjectId id;
+  if (!parseObjectName(repo, hash, id)) {
+    return false;
+  }
+  ObjectView content = repo.readObjectRaw(id);
+  if (!content) {
     std::cerr << "Could not read object.\n";
     return false;
   } else {
     std::cout << "----- Object Content -----\n";
-    for (char c : content) {
+    for (char c : content.raw()) {
       if (c == '\0') {
         std::cout << "\\0";
       } else if (isprint(static_cast<unsigned char>(c))) {
@@ -172,13 +222,9 @@ bool handleLsRead(GitRepository &repo, const std::string &hash) {
 }
 
 bool handleLsTree(GitRepository &repo, const std::string &hash) {
-  std::string resolvedHash = hash;
-  if (hash == "HEAD" || hash == "head") {
-    resolvedHash = repo.getHashOfBranchHead(repo.getCurrentBranch());
-    if (resolvedHash.empty()) {
-      std::cerr << "Error: HEAD does not point to a valid commit.\n";
-      return false;
-    }
+  ObjectId resolvedHash;
+  if (!parseObjectName(repo, hash, resolvedHash, true)) {
+    return false;
   }
   std::string content = repo.readObject(GitObjectType::Tree, resolvedHash);
   if (content.empty()) {
@@ -192,8 +238,8 @@ bool handleLsTree(GitRepository &repo, const std::string &hash) {
 
 // =============== INDEX/WORKING DIRECTORY OPERATIONS ===============
 bool handleAddCommand(GitRepository &repo,
-                      const std::vector<std::string> &paths) {
-  repo.indexHandler(paths);
+                      const std::vector<std::string> &paths, bool force) {
+  repo.indexHandler(paths, force);
   return true;
 }
 
@@ -250,7 +296,7 @@ bool handleBranchCommand(GitRepository &repo, const std::string &branchName,
     }
   }
   // Create branch (default)
-  if (!repo.getHashOfBranchHead(repo.getCurrentBranch()).empty()) {
+  if (!repo.getHashOfBranchHead(repo.getCurrentBranch()).isNull()) {
     if (repo.CreateBranch(branchName)) {
       std::cout << "Created branch: " << branchName << "\n";
       return true;
@@ -347,7 +393,8 @@ bool handleMergeStatus(GitRepository &repo) {
 
 bool handleResolveConflict(GitRepository &repo, const std::string &path,
                            const std::string &hash) {
-  if (repo.resolveConflict(path, hash)) {
+  ObjectId id;
+  if (parseObjectName(repo, hash, id) && repo.resolveConflict(path, id)) {
     std::cout << "Conflict resolved for: " << path << "\n";
     return true;
   } else {
@@ -467,6 +514,69 @@ bool handlePullCommand(GitRepository &repo, const std::string &remoteGitDir) {
   }
 }
 
+// ==================== MAINTENANCE ====================
+bool handleGcCommand(GitRepository &repo) {
+  if (repo.compressObjects()) {
+    return true;
+  }
+  std::cerr << "gc failed.\n";
+  return false;
+}
+
+bool handleMergeBase(GitRepository &repo, const std::string &first,
+                     const std::string &second, bool all) {
+  ObjectId a = repo.resolveRevision(first);
+  ObjectId b = repo.resolveRevision(second);
+  if (a.isNull() || b.isNull()) {
+    std::cerr << "Error: unknown revision '" << (a.isNull() ? first : second)
+              << "'.\n";
+    return false;
+  }
+  std::vector<ObjectId> bases = repo.findMergeBases(a, b);
+  if (bases.empty()) {
+    return false; // no common history, like git merge-base
+  }
+  for (const auto &base : bases) {
+    std::cout << base << "\n";
+    if (!all) {
+      break;
+    }
+  }
+  return true;
+}
+
+bool handleCommitGraphWrite(GitRepository &repo) {
+  if (repo.writeCommitGraph()) {
+    return true;
+  }
+  std::cerr << "commit-graph write failed.\n";
+  return false;
+}
+
+bool handleFsMonitorCommand(GitRepository &repo, const std::string &action) {
+  const std::string &gitDir = repo.getGitDir();
+  if (action == "start") {
+    if (!FsMonitor::start(gitDir)) {
+      return false;
+    }
+    std::cout << "fsmonitor daemon started.\n";
+  } else if (action == "stop") {
+    if (!FsMonitor::stop(gitDir)) {
+      return false;
+    }
+    std::cout << "fsmonitor daemon stopped.\n";
+  } else if (action == "status") {
+    if (!FsMonitor::isRunning(gitDir)) {
+      std::cout << "fsmonitor daemon is not running.\n";
+      return false;
+    }
+    std::cout << "fsmonitor daemon is watching the working tree.\n";
+  } else {
+    return FsMonitor::run(gitDir);
+  }
+  return true;
+}
+
 // ==================== REMOTE MANAGEMENT ====================
 bool handleRemoteAdd(GitRepository &repo, const std::string &name,
                      const std::string &path) {
@@ -652,9 +762,13 @@ bool setupLsTreeCommand(CLI::App &app, GitRepository &repo) {
 
 bool setupAddCommand(CLI::App &app, GitRepository &repo) {
   auto paths = std::make_shared<std::vector<std::string>>();
+  auto force = std::make_shared<bool>(false);
   auto cmd = app.add_subcommand("add", "Add files to index");
   cmd->add_option("paths", *paths, "Files to add")->required()->expected(-1);
-  cmd->callback([&repo, paths]() { return handleAddCommand(repo, *paths); });
+  cmd->add_flag("-f,--force", *force, "Add files even if they are ignored");
+  cmd->callback([&repo, paths, force]() {
+    return handleAddCommand(repo, *paths, *force);
+  });
   return true;
 }
 
@@ -989,6 +1103,69 @@ bool setupPullCommand(CLI::App &app, GitRepository &repo) {
   return true;
 }
 
+bool setupGcCommand(CLI::App &app, GitRepository &repo) {
+  auto cmd =
+      app.add_subcommand("gc", "Pack loose objects into a single pack file");
+  cmd->callback([&repo]() {
+    if (!handleGcCommand(repo)) {
+      throw CLI::RuntimeError(1);
+    }
+  });
+  return true;
+}
+
+bool setupMergeBaseCommand(CLI::App &app, GitRepository &repo) {
+  auto cmd = app.add_subcommand("merge-base",
+                                "Find the best common ancestor of two commits");
+  auto first = std::make_shared<std::string>();
+  auto second = std::make_shared<std::string>();
+  auto all = std::make_shared<bool>(false);
+  cmd->add_option("first", *first, "Commit, branch or HEAD")->required();
+  cmd->add_option("second", *second, "Commit, branch or HEAD")->required();
+  cmd->add_flag("-a,--all", *all, "Print every best common ancestor");
+  cmd->callback([&repo, first, second, all]() {
+    if (!handleMergeBase(repo, *first, *second, *all)) {
+      throw CLI::RuntimeError(1);
+    }
+  });
+  return true;
+}
+
+bool setupCommitGraphCommand(CLI::App &app, GitRepository &repo) {
+  auto cmd = app.add_subcommand("commit-graph",
+                                "Maintain the commit-graph used by history walks");
+  cmd->require_subcommand(1);
+  auto write = cmd->add_subcommand(
+      "write", "Add every commit reachable from a branch to the commit-graph");
+  write->callback([&repo]() {
+    if (!handleCommitGraphWrite(repo)) {
+      throw CLI::RuntimeError(1);
+    }
+  });
+  return true;
+}
+
+bool setupFsMonitorCommand(CLI::App &app, GitRepository &repo) {
+  auto cmd = app.add_subcommand(
+      "fsmonitor", "Watch the working tree so status only checks changed paths");
+  cmd->require_subcommand(1);
+  const std::pair<const char *, const char *> actions[] = {
+      {"start", "Start the daemon in the background"},
+      {"stop", "Stop the running daemon"},
+      {"status", "Report whether the daemon is running"},
+      {"run", "Run the daemon in the foreground"},
+  };
+  for (const auto &[name, description] : actions) {
+    std::string action = name;
+    cmd->add_subcommand(name, description)->callback([&repo, action]() {
+      if (!handleFsMonitorCommand(repo, action)) {
+        throw CLI::RuntimeError(1);
+      }
+    });
+  }
+  return true;
+}
+
 bool setupRemoteCommand(CLI::App &app, GitRepository &repo) {
   auto remoteCmd =
       app.add_subcommand("remote", "Manage set of tracked repositories");
@@ -1048,19 +1225,78 @@ bool setupCommitCommand(CLI::App &app, GitRepository &repo) {
   return true;
 }
 
+bool handleLogCommand(GitRepository &repo,
+                      const std::vector<std::string> &revisions,
+                      const std::vector<std::string> &paths,
+                      const RevWalkOptions &options, bool oneline) {
+  return repo.showLog(revisions, paths, options, oneline);
+}
+
 bool setupLogCommand(CLI::App &app, GitRepository &repo) {
-  auto cmd = app.add_subcommand("log", "Show commit logs (not implemented)");
-  cmd->callback([]() {
-    std::cout << "log: Not implemented\n";
-    throw CLI::RuntimeError(1);
+  auto cmd = app.add_subcommand("log", "Show commit logs");
+  auto revisions = std::make_shared<std::vector<std::string>>();
+  auto paths = std::make_shared<std::vector<std::string>>();
+  auto maxCount = std::make_shared<long>(-1);
+  auto topoOrder = std::make_shared<bool>(false);
+  auto dateOrder = std::make_shared<bool>(false);
+  auto firstParent = std::make_shared<bool>(false);
+  auto oneline = std::make_shared<bool>(false);
+  cmd->allow_extras();
+  cmd->add_option("revisions", *revisions,
+                  "Commits to start from (A..B or ^A leave out history), "
+                  "then -- and paths")
+      ->option_text("[<revision>...] [-- <path>...]");
+  // Filled from the arguments after "--" by logCommandLine().
+  cmd->add_option("--path", *paths)->group("");
+  cmd->add_option("-n,--max-count", *maxCount, "Show at most this many commits");
+  auto topo = cmd->add_flag("--topo-order", *topoOrder,
+                            "Show no parent before all of its children");
+  cmd->add_flag("--date-order", *dateOrder, "Newest commit first (default)")
+      ->excludes(topo);
+  cmd->add_flag("--first-parent", *firstParent,
+                "Follow only the first parent of merge commits");
+  cmd->add_flag("--oneline", *oneline, "One line per commit");
+  cmd->callback([cmd, &repo, revisions, paths, maxCount, topoOrder,
+                 firstParent, oneline]() {
+    for (const auto &extra : cmd->remaining()) {
+      std::cerr << "Error: unknown argument '" << extra << "'.\n";
+      throw CLI::RuntimeError(1);
+    }
+    RevWalkOptions options;
+    options.sort = *topoOrder ? RevSort::Topo : RevSort::Date;
+    options.firstParent = *firstParent;
+    options.maxCount = *maxCount;
+    if (!handleLogCommand(repo, *revisions, *paths, options, *oneline)) {
+      throw CLI::RuntimeError(1);
+    }
   });
   return true;
 }
 
+std::vector<std::string> logCommandLine(int argc, char **argv) {
+  std::vector<std::string> args(argv, argv + argc);
+  if (argc < 2 || args[1] != "log") {
+    return args;
+  }
+  auto separator = std::find(args.begin() + 2, args.end(), "--");
+  if (separator == args.end()) {
+    return args;
+  }
+  std::vector<std::string> rewritten(args.begin(), separator);
+  for (auto it = separator + 1; it != args.end(); ++it) {
+    rewritten.push_back("--path=" + *it);
+  }
+  return rewritten;
+}
+
 bool handleLsTreeRecursive(GitRepository &repo, const std::string &hash) {
-  std::map<std::string, std::string> files;
+  ObjectId id;
+  if (!parseObjectName(repo, hash, id, true)) {
+    return false;
+  }
+  std::map<std::string, ObjectId> files;
   TreeObject tree(".git");
-  tree.getAllFiles(hash, files);
+  tree.getAllFiles(id, files);
   for (const auto &[path, file_hash] : files) {
     std::cout << file_hash << "\t" << path << std::endl;
   }
@@ -1100,6 +1336,10 @@ bool setupAllCommands(CLI::App &app, GitRepository &repo) {
   setupPushCommand(app, repo);
   setupPullCommand(app, repo);
   setupRemoteCommand(app, repo);
+  setupGcCommand(app, repo);
+  setupCommitGraphCommand(app, repo);
+  setupFsMonitorCommand(app, repo);
+  setupMergeBaseCommand(app, repo);
   setupConfigCommand(app, repo);
   setupCommitCommand(app, repo);
   setupLogCommand(app, repo);
@@ -0,0 +1,232 @@
+#include "headers/GitBloomFilter.hpp"
+#include "headers/GitObjectTypesClasses.hpp"
+#include "headers/GitTreeCache.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// git's seeds (bloom.c); every key is hash0 + i * hash1.
+const uint32_t kSeed0 = 0x293ae76f;
+const uint32_t kSeed1 = 0x7e646e2c;
+
+uint32_t rotateLeft(uint32_t value, int count) {
+  return (value << count) | (value >> (32 - count));
+}
+
+uint32_t byteAt(const char *data, size_t index, uint32_t version) {
+  if (version == 1) {
+    return static_cast<uint32_t>(static_cast<signed char>(data[index]));
+  }
+  return static_cast<unsigned char>(data[index]);
+}
+
+// Files that differ between two parsed trees, appended to out with their
+// full paths.
+class TreeDiff {
+public:
+  TreeDiff(const std::string &gitDir, size_t limit,
+           std::vector<std::string> &out)
+      : trees(gitDir), limit(limit), out(out) {}
+
+  bool diff(const TreeCache::Tree &oldTree, const TreeCache::Tree &newTree,
+            const std::string &prefix) {
+    static const std::vector<ParsedTreeEntry> none;
+    const auto &a = oldTree ? oldTree->entries : none;
+    const auto &b = newTree ? newTree->entries : none;
+
+    // Usually the same names in the same order: pair them up directly.
+    bool aligned = a.size() == b.size();
+    for (size_t i = 0; aligned && i < a.size(); ++i) {
+      aligned = a[i].name == b[i].name;
+    }
+    if (aligned) {
+      for (size_t i = 0; i < a.size(); ++i) {
+        if (!pair(&a[i], &b[i], prefix)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    std::unordered_map<std::string_view, const ParsedTreeEntry *> unmatched;
+    for (const auto &entry : b) {
+      unmatched[entry.name] = &entry;
+    }
+    for (const auto &entry : a) {
+      auto it = unmatched.find(entry.name);
+      const ParsedTreeEntry *other = nullptr;
+      if (it != unmatched.end()) {
+        other = it->second;
+        unmatched.erase(it);
+      }
+      if (!pair(&entry, other, prefix)) {
+        return false;
+      }
+    }
+    for (const auto &[name, entry] : unmatched) {
+      if (!pair(nullptr, entry, prefix)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // One name on either side (null when absent).
+  bool pair(const ParsedTreeEntry *oldEntry, const ParsedTreeEntry *newEntry,
+            const std::string &prefix) {
+    if (oldEntry && newEntry && oldEntry->mode == newEntry->mode &&
+        oldEntry->id == newEntry->id) {
+      return true;
+    }
+    const ParsedTreeEntry *named = oldEntry ? oldEntry : newEntry;
+    std::string path = prefix;
+    path += named->filename();
+    bool oldIsTree = oldEntry && oldEntry->isTree();
+    bool newIsTree = newEntry && newEntry->isTree();
+    if ((oldEntry && !oldIsTree) || (newEntry && !newIsTree)) {
+      out.push_back(path);
+      if (out.size() > limit) {
+        return false;
+      }
+    }
+    if (!oldIsTree && !newIsTree) {
+      return true;
+    }
+    return diff(oldIsTree ? read(*oldEntry) : nullptr,
+                newIsTree ? read(*newEntry) : nullptr, path + "/");
+  }
+
+  TreeCache::Tree read(const ParsedTreeEntry &entry) {
+    return trees.readParsedTree(entry.id);
+  }
+
+  TreeObject trees;
+  size_t limit;
+  std::vector<std::string> &out;
+};
+
+} // namespace
+
+uint32_t bloomMurmur3(uint32_t seed, const char *data, size_t size,
+                      uint32_t version) {
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  uint32_t hash = seed;
+  size_t blocks = size / 4;
+  for (size_t i = 0; i < blocks; ++i) {
+    uint32_t k = byteAt(data, 4 * i, version) |
+                 (byteAt(data, 4 * i + 1, version) << 8) |
+                 (byteAt(data, 4 * i + 2, version) << 16) |
+                 (byteAt(data, 4 * i + 3, version) << 24);
+    k *= c1;
+    k = rotateLeft(k, 15);
+    k *= c2;
+    hash ^= k;
+    hash = rotateLeft(hash, 13) * 5 + 0xe6546b64;
+  }
+  uint32_t k = 0;
+  size_t tail = blocks * 4;
+  switch (size & 3) {
+  case 3:
+    k ^= byteAt(data, tail + 2, version) << 16;
+    [[fallthrough]];
+  case 2:
+    k ^= byteAt(data, tail + 1, version) << 8;
+    [[fallthrough]];
+  case 1:
+    k ^= byteAt(data, tail, version);
+    k *= c1;
+    k = rotateLeft(k, 15);
+    k *= c2;
+    hash ^= k;
+  }
+  hash ^= static_cast<uint32_t>(size);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+BloomKey::BloomKey(const std::string &path, const BloomSettings &settings) {
+  uint32_t hash0 =
+      bloomMurmur3(kSeed0, path.data(), path.size(), settings.hashVersion);
+  uint32_t hash1 =
+      bloomMurmur3(kSeed1, path.data(), path.size(), settings.hashVersion);
+  hashes_.reserve(settings.hashCount);
+  for (uint32_t i = 0; i < settings.hashCount; ++i) {
+    hashes_.push_back(hash0 + i * hash1);
+  }
+}
+
+std::string buildBloomFilter(const std::vector<std::string> &paths,
+                             const BloomSettings &settings) {
+  if (paths.size() > settings.maxChangedPaths) {
+    return std::string(1, '\xff');
+  }
+  // "a/b/c" also adds "a/b" and "a" (without the trailing slash).
+  std::unordered_set<std::string> keys;
+  for (const auto &path : paths) {
+    for (size_t end = path.size(); end != std::string::npos && end > 0;
+         end = path.rfind('/', end - 1)) {
+      if (!keys.insert(path.substr(0, end)).second) {
+        break; // its parents are in already
+      }
+    }
+  }
+  size_t bytes = (keys.size() * settings.bitsPerEntry + 7) / 8;
+  std::string filter(bytes ? bytes : 1, '\0');
+  uint64_t bits = static_cast<uint64_t>(filter.size()) * 8;
+  for (const auto &path : keys) {
+    BloomKey key(path, settings);
+    for (uint32_t hash : key.hashes()) {
+      uint64_t bit = hash % bits;
+      filter[bit / 8] = static_cast<char>(filter[bit / 8] | (1u << (bit & 7)));
+    }
+  }
+  return filter;
+}
+
+bool bloomFilterContains(const unsigned char *filter, size_t size,
+                         const BloomKey &key) {
+  if (size == 0) {
+    return true;
+  }
+  uint64_t bits = static_cast<uint64_t>(size) * 8;
+  for (uint32_t hash : key.hashes()) {
+    uint64_t bit = hash % bits;
+    if (!(filter[bit / 8] & (1u << (bit & 7)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool collectChangedPaths(const std::string &gitDir, const ObjectId &oldTree,
+                         const ObjectId &newTree, size_t limit,
+                         std::vector<std::string> &out) {
+  if (oldTree == newTree) {
+    return true;
+  }
+  TreeObject trees(gitDir);
+  TreeCache::Tree oldParsed =
+      oldTree.isNull() ? nullptr : trees.readParsedTree(oldTree);
+  TreeCache::Tree newParsed =
+      newTree.isNull() ? nullptr : trees.readParsedTree(newTree);
+  return TreeDiff(gitDir, limit, out).diff(oldParsed, newParsed, "");
+}
+
+std::string computeChangedPathFilter(const std::string &gitDir,
+                                     const ObjectId &parentTree,
+                                     const ObjectId &tree,
+                                     const BloomSettings &settings) {
+  std::vector<std::string> paths;
+  if (!collectChangedPaths(gitDir, parentTree, tree, settings.maxChangedPaths,
+                           paths)) {
+    return std::string(1, '\xff');
+  }
+  return buildBloomFilter(paths, settings);
+}
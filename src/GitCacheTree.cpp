@@ -0,0 +1,236 @@
+#include "headers/GitCacheTree.hpp"
+#include "headers/GitIndex.hpp"
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+bool hasPrefix(const std::string &path, const std::string &prefix) {
+  return path.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Deeper nesting than this in a stored cache-tree means it is corrupt.
+const int kMaxDepth = 4096;
+
+} // namespace
+
+void CacheTree::invalidate(std::string_view path) {
+  Node *node = &root;
+  while (true) {
+    node->entryCount = -1;
+    size_t slash = path.find('/');
+    if (slash == std::string_view::npos) {
+      return;
+    }
+    auto it = node->children.find(path.substr(0, slash));
+    if (it == node->children.end()) {
+      return;
+    }
+    node = it->second.get();
+    path.remove_prefix(slash + 1);
+  }
+}
+
+const CacheTree::Node *CacheTree::findNode(std::string_view dir) const {
+  const Node *node = &root;
+  while (!dir.empty()) {
+    size_t slash = dir.find('/');
+    auto it = node->children.find(dir.substr(0, slash));
+    if (it == node->children.end()) {
+      return nullptr;
+    }
+    node = it->second.get();
+    dir.remove_prefix(slash == std::string_view::npos ? dir.size() : slash + 1);
+  }
+  return node;
+}
+
+int32_t CacheTree::validCount(std::string_view dir, const ObjectId &id) const {
+  const Node *node = findNode(dir);
+  return node && node->entryCount >= 0 && node->id == id ? node->entryCount
+                                                         : -1;
+}
+
+bool CacheTree::prime(std::string_view dir, const ObjectId &id,
+                      int32_t entryCount) {
+  Node *node = &root;
+  while (!dir.empty()) {
+    size_t slash = dir.find('/');
+    std::string_view name = dir.substr(0, slash);
+    auto it = node->children.find(name);
+    if (it == node->children.end()) {
+      it = node->children.emplace(std::string(name), std::make_unique<Node>())
+               .first;
+    }
+    node = it->second.get();
+    dir.remove_prefix(slash == std::string_view::npos ? dir.size() : slash + 1);
+  }
+  if (node->entryCount >= 0) {
+    return false;
+  }
+  node->id = id;
+  node->entryCount = entryCount;
+  return true;
+}
+
+void CacheTree::clear() {
+  root = Node();
+  rebuilt = 0;
+}
+
+ObjectId CacheTree::update(const std::vector<const IndexEntry *> &entries,
+                           const TreeWriter &write) {
+  rebuilt = 0;
+  updateNode(root, entries, 0, "", write);
+  return root.id;
+}
+
+size_t CacheTree::updateNode(Node &node,
+                             const std::vector<const IndexEntry *> &entries,
+                             size_t position, const std::string &prefix,
+                             const TreeWriter &write) {
+  if (node.entryCount >= 0) {
+    // The stored count must still cover exactly this directory's entries;
+    // if it does not, the node is stale and gets rebuilt.
+    size_t end = position + static_cast<size_t>(node.entryCount);
+    if (end <= entries.size() &&
+        (end == position || hasPrefix(entries[end - 1]->path, prefix)) &&
+        (end == entries.size() || !hasPrefix(entries[end]->path, prefix))) {
+      return static_cast<size_t>(node.entryCount);
+    }
+    node.entryCount = -1;
+  }
+
+  // Entries are sorted by full path, so each subdirectory's entries are
+  // contiguous and files and subdirectories come out in git's tree order.
+  std::string body;
+  std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+  size_t i = position;
+  while (i < entries.size() && hasPrefix(entries[i]->path, prefix)) {
+    const IndexEntry &entry = *entries[i];
+    std::string_view rest = std::string_view(entry.path).substr(prefix.size());
+    size_t slash = rest.find('/');
+    if (slash == std::string_view::npos) {
+      body += entry.mode;
+      body.push_back(' ');
+      body.append(rest);
+      body.push_back('\0');
+      body.append(reinterpret_cast<const char *>(entry.hash.data()),
+                  ObjectId::kRawSize);
+      ++i;
+      continue;
+    }
+    std::string name(rest.substr(0, slash));
+    std::unique_ptr<Node> child;
+    auto it = node.children.find(name);
+    if (it != node.children.end()) {
+      child = std::move(it->second);
+    } else {
+      child = std::make_unique<Node>();
+    }
+    i += updateNode(*child, entries, i, prefix + name + "/", write);
+    body += "040000 ";
+    body += name;
+    body.push_back('\0');
+    body.append(reinterpret_cast<const char *>(child->id.data()),
+                ObjectId::kRawSize);
+    children[name] = std::move(child);
+  }
+
+  // Directories that no longer have entries are dropped with the old map.
+  node.children = std::move(children);
+  ObjectId id = write(body);
+  if (id.isNull()) {
+    throw std::runtime_error("Failed to write tree for '" + prefix + "'");
+  }
+  node.id = id;
+  node.entryCount = static_cast<int32_t>(i - position);
+  ++rebuilt;
+  return i - position;
+}
+
+void CacheTree::serialize(std::string &out) const {
+  serializeNode("", root, out);
+}
+
+void CacheTree::serializeNode(const std::string &name, const Node &node,
+                              std::string &out) {
+  out += name;
+  out.push_back('\0');
+  out += std::to_string(node.entryCount);
+  out.push_back(' ');
+  out += std::to_string(node.children.size());
+  out.push_back('\n');
+  if (node.entryCount >= 0) {
+    out.append(reinterpret_cast<const char *>(node.id.data()),
+               ObjectId::kRawSize);
+  }
+  for (const auto &[childName, child] : node.children) {
+    serializeNode(childName, *child, out);
+  }
+}
+
+bool CacheTree::parse(std::string_view data) {
+  clear();
+  std::string name;
+  if (!parseNode(data, name, root, 0) || !name.empty() || !data.empty()) {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool CacheTree::parseNode(std::string_view &data, std::string &name,
+                          Node &node, int depth) {
+  if (depth > kMaxDepth) {
+    return false;
+  }
+  size_t nul = data.find('\0');
+  if (nul == std::string_view::npos) {
+    return false;
+  }
+  name.assign(data.substr(0, nul));
+  data.remove_prefix(nul + 1);
+
+  size_t newline = data.find('\n');
+  if (newline == std::string_view::npos) {
+    return false;
+  }
+  std::string_view counts = data.substr(0, newline);
+  data.remove_prefix(newline + 1);
+  size_t space = counts.find(' ');
+  if (space == std::string_view::npos) {
+    return false;
+  }
+  int32_t entryCount = 0;
+  uint32_t subtreeCount = 0;
+  const char *end = counts.data() + counts.size();
+  auto parsedCount =
+      std::from_chars(counts.data(), counts.data() + space, entryCount);
+  auto parsedSubtrees =
+      std::from_chars(counts.data() + space + 1, end, subtreeCount);
+  if (parsedCount.ec != std::errc() ||
+      parsedCount.ptr != counts.data() + space ||
+      parsedSubtrees.ec != std::errc() || parsedSubtrees.ptr != end ||
+      entryCount < -1) {
+    return false;
+  }
+
+  node.entryCount = entryCount;
+  if (entryCount >= 0) {
+    if (data.size() < ObjectId::kRawSize) {
+      return false;
+    }
+    node.id = ObjectId::fromRaw(data.data());
+    data.remove_prefix(ObjectId::kRawSize);
+  }
+  for (uint32_t i = 0; i < subtreeCount; ++i) {
+    std::string childName;
+    auto child = std::make_unique<Node>();
+    if (!parseNode(data, childName, *child, depth + 1) || childName.empty()) {
+      return false;
+    }
+    node.children[childName] = std::move(child);
+  }
+  return true;
+}
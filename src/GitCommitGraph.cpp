@@ -0,0 +1,829 @@
+#include "headers/GitCommitGraph.hpp"
+#include "headers/GitConfig.hpp"
+#include "headers/GitObjectTypesClasses.hpp"
+#include "headers/GitWorkTree.hpp"
+#include "headers/HashUtils.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+const size_t kHashSize = 20;
+const size_t kHeaderSize = 8;
+const size_t kChunkEntrySize = 12;
+const size_t kCommitDataSize = kHashSize + 16;
+const uint32_t kChunkFanout = 0x4f494446;  // "OIDF"
+const uint32_t kChunkIds = 0x4f49444c;     // "OIDL"
+const uint32_t kChunkCommits = 0x43444154; // "CDAT"
+const uint32_t kChunkEdges = 0x45444745;   // "EDGE"
+const uint32_t kChunkBloomIndex = 0x42494458; // "BIDX"
+const uint32_t kChunkBloomData = 0x42444154;  // "BDAT"
+const uint32_t kChunkBase = 0x42415345;       // "BASE"
+const size_t kBloomHeaderSize = 12;
+const uint32_t kParentNone = 0x70000000u;
+const uint32_t kExtraEdges = 0x80000000u;
+const uint32_t kLastEdge = 0x80000000u;
+const uint32_t kMaxGeneration = 0x3fffffffu;
+// A new layer absorbs the one below it while it has more than 1/kSplitRatio
+// as many commits (git's default --size-multiple).
+const uint32_t kSplitRatio = 2;
+
+uint32_t readBE32(const unsigned char *p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t readBE64(const unsigned char *p) {
+  return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+void appendBE32(std::string &out, uint32_t value) {
+  out.push_back(static_cast<char>((value >> 24) & 0xff));
+  out.push_back(static_cast<char>((value >> 16) & 0xff));
+  out.push_back(static_cast<char>((value >> 8) & 0xff));
+  out.push_back(static_cast<char>(value & 0xff));
+}
+
+void appendBE64(std::string &out, uint64_t value) {
+  appendBE32(out, static_cast<uint32_t>(value >> 32));
+  appendBE32(out, static_cast<uint32_t>(value & 0xffffffff));
+}
+
+int64_t fileMtimeNs(const std::string &path) {
+  struct stat st {};
+  if (stat(path.c_str(), &st) != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+         st.st_mtim.tv_nsec;
+}
+
+// Timestamp of a "Name <email> 1700000000 +0530" identity line.
+int64_t identityTime(const std::string &identity) {
+  size_t close = identity.rfind('>');
+  if (close == std::string::npos) {
+    return 0;
+  }
+  return std::strtoll(identity.c_str() + close + 1, nullptr, 10);
+}
+
+bool readCommitObject(const std::string &gitDir, const ObjectId &id,
+                      CommitInfo &info) {
+  CommitData data = CommitObject(gitDir).readObject(id);
+  if (data.tree.isNull()) {
+    return false;
+  }
+  info.tree = data.tree;
+  info.parents = data.parents;
+  info.commitTime = identityTime(data.committer);
+  info.generation = CommitGraph::kGenerationInfinity;
+  return true;
+}
+
+} // namespace
+
+// ---------------- CommitGraph ----------------
+
+std::string CommitGraph::pathFor(const std::string &gitDir) {
+  return gitDir + "/objects/info/commit-graph";
+}
+
+std::string CommitGraph::chainPathFor(const std::string &gitDir) {
+  return gitDir + "/objects/info/commit-graphs/commit-graph-chain";
+}
+
+std::string CommitGraph::layerPathFor(const std::string &gitDir,
+                                      const ObjectId &checksum) {
+  return gitDir + "/objects/info/commit-graphs/graph-" + checksum.hex() +
+         ".graph";
+}
+
+std::shared_ptr<CommitGraph>
+CommitGraph::forGitDir(const std::string &gitDir) {
+  struct Loaded {
+    std::shared_ptr<CommitGraph> graph;
+    int64_t mtimeNs = -1;
+  };
+  static std::mutex registryMutex;
+  static std::map<std::string, Loaded> registry;
+
+  // The chain file is replaced on every update, so its mtime stands for the
+  // whole chain.
+  int64_t mtimeNs = fileMtimeNs(chainPathFor(gitDir));
+  if (mtimeNs < 0) {
+    mtimeNs = fileMtimeNs(pathFor(gitDir));
+  }
+  std::lock_guard<std::mutex> lock(registryMutex);
+  Loaded &loaded = registry[gitDir];
+  if (loaded.mtimeNs != mtimeNs) {
+    loaded.mtimeNs = mtimeNs;
+    loaded.graph.reset();
+    if (mtimeNs >= 0) {
+      try {
+        loaded.graph = load(gitDir);
+      } catch (const std::exception &e) {
+        std::cerr << "Ignoring unreadable commit-graph: " << e.what()
+                  << std::endl;
+      }
+    }
+  }
+  return loaded.graph;
+}
+
+std::shared_ptr<CommitGraph> CommitGraph::load(const std::string &gitDir) {
+  std::ifstream chain(chainPathFor(gitDir));
+  if (!chain) {
+    std::string path = pathFor(gitDir);
+    return std::filesystem::exists(path) ? open(path) : nullptr;
+  }
+  std::shared_ptr<CommitGraph> graph;
+  std::string line;
+  while (std::getline(chain, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    ObjectId checksum = ObjectId::fromHex(line);
+    if (checksum.isNull()) {
+      throw CommitGraphException("Bad commit-graph chain entry: " + line);
+    }
+    graph = open(layerPathFor(gitDir, checksum), graph);
+    if (graph->checksum() != checksum) {
+      throw CommitGraphException("Commit-graph layer " + line +
+                                 " does not match its checksum");
+    }
+  }
+  if (!graph) {
+    throw CommitGraphException("Empty commit-graph chain");
+  }
+  return graph;
+}
+
+std::shared_ptr<CommitGraph>
+CommitGraph::open(const std::string &path,
+                  const std::shared_ptr<CommitGraph> &base) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw CommitGraphException("Cannot open " + path);
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    throw CommitGraphException("Cannot stat " + path);
+  }
+  std::shared_ptr<CommitGraph> graph(new CommitGraph());
+  graph->size = static_cast<size_t>(st.st_size);
+  void *mapped = mmap(nullptr, graph->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    throw CommitGraphException("Cannot mmap " + path);
+  }
+  graph->data = static_cast<const unsigned char *>(mapped);
+  graph->base = base;
+  graph->baseCount = base ? base->commitCount() : 0;
+
+  const unsigned char *p = graph->data;
+  if (graph->size < kHeaderSize + kChunkEntrySize + kHashSize ||
+      std::memcmp(p, "CGPH", 4) != 0 || p[4] != 1 || p[5] != 1) {
+    throw CommitGraphException("Unsupported commit-graph: " + path);
+  }
+  uint8_t chunkCount = p[6];
+  uint32_t baseLayers = base ? base->layerCount() : 0;
+  if (p[7] != baseLayers) {
+    throw CommitGraphException("Wrong number of base layers in " + path);
+  }
+  size_t tableEnd = kHeaderSize + (chunkCount + 1) * kChunkEntrySize;
+  if (tableEnd + kHashSize > graph->size) {
+    throw CommitGraphException("Truncated commit-graph: " + path);
+  }
+  size_t dataEnd = graph->size - kHashSize;
+  size_t edgesSize = 0;
+  size_t bloomIndexSize = 0;
+  const unsigned char *bloomChunk = nullptr;
+  size_t bloomChunkSize = 0;
+  const unsigned char *baseChunk = nullptr;
+  size_t baseChunkSize = 0;
+  for (uint8_t i = 0; i < chunkCount; ++i) {
+    const unsigned char *entry = p + kHeaderSize + i * kChunkEntrySize;
+    uint32_t id = readBE32(entry);
+    uint64_t offset = readBE64(entry + 4);
+    uint64_t next = readBE64(entry + kChunkEntrySize + 4);
+    if (offset < tableEnd || next < offset || next > dataEnd) {
+      throw CommitGraphException("Bad chunk offset in " + path);
+    }
+    const unsigned char *chunk = p + offset;
+    if (id == kChunkFanout && next - offset == 256 * 4) {
+      graph->fanout = chunk;
+    } else if (id == kChunkIds) {
+      graph->ids = chunk;
+    } else if (id == kChunkCommits) {
+      graph->commits = chunk;
+    } else if (id == kChunkEdges) {
+      graph->edges = chunk;
+      edgesSize = next - offset;
+    } else if (id == kChunkBloomIndex) {
+      graph->bloomIndex = chunk;
+      bloomIndexSize = next - offset;
+    } else if (id == kChunkBloomData) {
+      bloomChunk = chunk;
+      bloomChunkSize = next - offset;
+    } else if (id == kChunkBase) {
+      baseChunk = chunk;
+      baseChunkSize = next - offset;
+    }
+  }
+  if (!graph->fanout || !graph->ids || !graph->commits) {
+    throw CommitGraphException("Missing required chunk in " + path);
+  }
+  graph->count = readBE32(graph->fanout + 255 * 4);
+  graph->edgeCount = edgesSize / 4;
+  if (graph->ids + static_cast<size_t>(graph->count) * kHashSize >
+          graph->data + dataEnd ||
+      graph->commits + static_cast<size_t>(graph->count) * kCommitDataSize >
+          graph->data + dataEnd) {
+    throw CommitGraphException("Truncated commit-graph: " + path);
+  }
+  if (baseLayers) {
+    if (!baseChunk || baseChunkSize != baseLayers * kHashSize) {
+      throw CommitGraphException("Missing base layers in " + path);
+    }
+    const CommitGraph *layer = base.get();
+    for (uint32_t i = baseLayers; i-- > 0; layer = layer->base.get()) {
+      if (ObjectId::fromRaw(baseChunk + i * kHashSize) != layer->checksum()) {
+        throw CommitGraphException("Base layers do not match in " + path);
+      }
+    }
+  }
+  // Filters are optional: ignore them unless both chunks are usable.
+  uint32_t hashVersion = bloomChunkSize >= kBloomHeaderSize
+                             ? readBE32(bloomChunk)
+                             : 0;
+  if (graph->bloomIndex && bloomIndexSize == graph->count * 4ull &&
+      (hashVersion == 1 || hashVersion == 2)) {
+    graph->bloomSettings.hashVersion = hashVersion;
+    graph->bloomSettings.hashCount = readBE32(bloomChunk + 4);
+    graph->bloomSettings.bitsPerEntry = readBE32(bloomChunk + 8);
+    graph->bloomData = bloomChunk + kBloomHeaderSize;
+    graph->bloomDataSize = bloomChunkSize - kBloomHeaderSize;
+  } else {
+    graph->bloomIndex = nullptr;
+  }
+  // Walks only use filters when every layer has them, with one setting.
+  graph->allLayersHaveFilters =
+      graph->bloomIndex &&
+      (!base || (base->allLayersHaveFilters &&
+                 base->bloomSettings.hashVersion == hashVersion &&
+                 base->bloomSettings.hashCount ==
+                     graph->bloomSettings.hashCount &&
+                 base->bloomSettings.bitsPerEntry ==
+                     graph->bloomSettings.bitsPerEntry));
+  return graph;
+}
+
+CommitGraph::~CommitGraph() {
+  if (data) {
+    munmap(const_cast<unsigned char *>(data), size);
+  }
+}
+
+ObjectId CommitGraph::checksum() const {
+  return ObjectId::fromRaw(data + size - kHashSize);
+}
+
+bool CommitGraph::findPosition(const ObjectId &id, uint32_t &position) const {
+  const unsigned char first = id.data()[0];
+  uint32_t lo = first == 0 ? 0 : readBE32(fanout + (first - 1) * 4);
+  uint32_t hi = readBE32(fanout + first * 4);
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int cmp = std::memcmp(ids + mid * kHashSize, id.data(), kHashSize);
+    if (cmp == 0) {
+      position = baseCount + mid;
+      return true;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return base && base->findPosition(id, position);
+}
+
+const CommitGraph *CommitGraph::layerOf(uint32_t &position) const {
+  const CommitGraph *layer = this;
+  while (position < layer->baseCount) {
+    layer = layer->base.get();
+  }
+  position -= layer->baseCount;
+  if (position >= layer->count) {
+    throw CommitGraphException("Commit-graph position out of range");
+  }
+  return layer;
+}
+
+const unsigned char *CommitGraph::commitData(uint32_t position) const {
+  const CommitGraph *layer = layerOf(position);
+  return layer->commits + static_cast<size_t>(position) * kCommitDataSize;
+}
+
+ObjectId CommitGraph::commitIdAt(uint32_t position) const {
+  const CommitGraph *layer = layerOf(position);
+  return ObjectId::fromRaw(layer->ids +
+                           static_cast<size_t>(position) * kHashSize);
+}
+
+ObjectId CommitGraph::treeIdAt(uint32_t position) const {
+  return ObjectId::fromRaw(commitData(position));
+}
+
+std::vector<uint32_t> CommitGraph::parentPositions(uint32_t position) const {
+  const CommitGraph *layer = layerOf(position);
+  const unsigned char *entry = layer->commits +
+                               static_cast<size_t>(position) * kCommitDataSize +
+                               kHashSize;
+  std::vector<uint32_t> parents;
+  uint32_t first = readBE32(entry);
+  uint32_t second = readBE32(entry + 4);
+  if (first == kParentNone) {
+    return parents;
+  }
+  parents.push_back(first);
+  if (second == kParentNone) {
+    return parents;
+  }
+  if (!(second & kExtraEdges)) {
+    parents.push_back(second);
+    return parents;
+  }
+  for (size_t edge = second & ~kExtraEdges; edge < layer->edgeCount; ++edge) {
+    uint32_t value = readBE32(layer->edges + edge * 4);
+    parents.push_back(value & ~kLastEdge);
+    if (value & kLastEdge) {
+      break;
+    }
+  }
+  return parents;
+}
+
+uint32_t CommitGraph::generationAt(uint32_t position) const {
+  return readBE32(commitData(position) + kHashSize + 8) >> 2;
+}
+
+int64_t CommitGraph::commitTimeAt(uint32_t position) const {
+  const unsigned char *entry = commitData(position) + kHashSize + 8;
+  return static_cast<int64_t>(
+      (static_cast<uint64_t>(readBE32(entry) & 0x3) << 32) |
+      readBE32(entry + 4));
+}
+
+bool CommitGraph::read(const ObjectId &id, CommitInfo &info) const {
+  uint32_t position = 0;
+  if (!findPosition(id, position)) {
+    return false;
+  }
+  info.tree = treeIdAt(position);
+  info.parents.clear();
+  for (uint32_t parent : parentPositions(position)) {
+    info.parents.push_back(commitIdAt(parent));
+  }
+  info.commitTime = commitTimeAt(position);
+  info.generation = generationAt(position);
+  return true;
+}
+
+void CommitGraph::changedPathFilter(uint32_t position,
+                                    const unsigned char *&filter,
+                                    size_t &filterSize) const {
+  filter = nullptr;
+  filterSize = 0;
+  if (position >= commitCount()) {
+    return;
+  }
+  const CommitGraph *layer = layerOf(position);
+  if (!layer->bloomIndex) {
+    return;
+  }
+  uint32_t begin =
+      position == 0 ? 0 : readBE32(layer->bloomIndex + (position - 1) * 4);
+  uint32_t end = readBE32(layer->bloomIndex + position * 4);
+  if (begin > end || end > layer->bloomDataSize) {
+    return;
+  }
+  filter = layer->bloomData + begin;
+  filterSize = end - begin;
+}
+
+// ---------------- CommitInfoReader ----------------
+
+CommitInfoReader::CommitInfoReader(const std::string &gitDir)
+    : gitDir(gitDir), graph(CommitGraph::forGitDir(gitDir)) {}
+
+bool CommitInfoReader::read(const ObjectId &id, CommitInfo &info) {
+  if (id.isNull()) {
+    return false;
+  }
+  if (graph && graph->read(id, info)) {
+    return true;
+  }
+  return readCommitObject(gitDir, id, info);
+}
+
+// ---------------- Writing ----------------
+
+namespace {
+
+struct GraphCommit {
+  ObjectId id;
+  ObjectId tree;
+  std::vector<ObjectId> parents;
+  int64_t commitTime = 0;
+  uint32_t generation = 0; // 0 = not computed yet
+  std::string bloom;        // changed-path filter; empty = none
+};
+
+void appendChunkEntry(std::string &out, uint32_t id, uint64_t offset) {
+  appendBE32(out, id);
+  appendBE64(out, offset);
+}
+
+// Fills in the changed-path filters that are missing, in parallel: each
+// commit is diffed against its first parent's tree independently. Parents
+// outside the layer are looked up in its base.
+void computeChangedPathFilters(const std::string &gitDir,
+                               std::vector<GraphCommit> &sorted,
+                               const CommitGraph *base,
+                               const BloomSettings &settings) {
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (sorted[i].bloom.empty()) {
+      missing.push_back(i);
+    }
+  }
+  auto treeOf = [&sorted, base](const ObjectId &id) -> ObjectId {
+    auto it = std::lower_bound(
+        sorted.begin(), sorted.end(), id,
+        [](const GraphCommit &commit, const ObjectId &key) {
+          return commit.id < key;
+        });
+    if (it != sorted.end() && it->id == id) {
+      return it->tree;
+    }
+    uint32_t position = 0;
+    base->findPosition(id, position);
+    return base->treeIdAt(position);
+  };
+  WorkTreeScanner workers;
+  workers.parallelFor(missing.size(), [&](size_t job) {
+    GraphCommit &commit = sorted[missing[job]];
+    ObjectId parentTree =
+        commit.parents.empty() ? ObjectId() : treeOf(commit.parents[0]);
+    commit.bloom =
+        computeChangedPathFilter(gitDir, parentTree, commit.tree, settings);
+  });
+}
+
+// One layer on top of base (null for a graph of its own). Positions of
+// commits in the layer start after those in base.
+std::string serializeGraph(const std::vector<GraphCommit> &sorted,
+                           const CommitGraph *base,
+                           const BloomSettings *bloom) {
+  uint32_t baseCount = base ? base->commitCount() : 0;
+  std::unordered_map<ObjectId, uint32_t> positions;
+  positions.reserve(sorted.size());
+  for (uint32_t i = 0; i < sorted.size(); ++i) {
+    positions.emplace(sorted[i].id, baseCount + i);
+  }
+  auto positionOf = [&](const ObjectId &id) {
+    auto it = positions.find(id);
+    if (it != positions.end()) {
+      return it->second;
+    }
+    uint32_t position = 0;
+    if (!base || !base->findPosition(id, position)) {
+      throw CommitGraphException("Parent " + id.hex() +
+                                 " is missing from the commit-graph");
+    }
+    return position;
+  };
+
+  std::string fanout;
+  uint32_t counts[256] = {};
+  for (const auto &commit : sorted) {
+    ++counts[commit.id.data()[0]];
+  }
+  uint32_t running = 0;
+  for (uint32_t bucket : counts) {
+    running += bucket;
+    appendBE32(fanout, running);
+  }
+
+  std::string idList;
+  std::string commitData;
+  std::string edges;
+  idList.reserve(sorted.size() * kHashSize);
+  commitData.reserve(sorted.size() * kCommitDataSize);
+  for (const auto &commit : sorted) {
+    idList.append(reinterpret_cast<const char *>(commit.id.data()), kHashSize);
+    commitData.append(reinterpret_cast<const char *>(commit.tree.data()),
+                      kHashSize);
+    std::vector<uint32_t> parents;
+    for (const auto &parent : commit.parents) {
+      parents.push_back(positionOf(parent));
+    }
+    appendBE32(commitData, parents.empty() ? kParentNone : parents[0]);
+    if (parents.size() <= 2) {
+      appendBE32(commitData, parents.size() == 2 ? parents[1] : kParentNone);
+    } else {
+      appendBE32(commitData,
+                 kExtraEdges | static_cast<uint32_t>(edges.size() / 4));
+      for (size_t i = 1; i < parents.size(); ++i) {
+        appendBE32(edges, parents[i] |
+                              (i + 1 == parents.size() ? kLastEdge : 0));
+      }
+    }
+    uint64_t time = static_cast<uint64_t>(std::max<int64_t>(commit.commitTime, 0));
+    uint32_t generation = std::min(commit.generation, kMaxGeneration);
+    appendBE32(commitData, (generation << 2) |
+                               static_cast<uint32_t>((time >> 32) & 0x3));
+    appendBE32(commitData, static_cast<uint32_t>(time & 0xffffffff));
+  }
+
+  std::vector<std::pair<uint32_t, const std::string *>> chunks = {
+      {kChunkFanout, &fanout}, {kChunkIds, &idList}, {kChunkCommits, &commitData}};
+  if (!edges.empty()) {
+    chunks.push_back({kChunkEdges, &edges});
+  }
+  std::string bloomIndex;
+  std::string bloomData;
+  if (bloom) {
+    appendBE32(bloomData, bloom->hashVersion);
+    appendBE32(bloomData, bloom->hashCount);
+    appendBE32(bloomData, bloom->bitsPerEntry);
+    for (const auto &commit : sorted) {
+      bloomData += commit.bloom;
+      appendBE32(bloomIndex,
+                 static_cast<uint32_t>(bloomData.size() - kBloomHeaderSize));
+    }
+    chunks.push_back({kChunkBloomIndex, &bloomIndex});
+    chunks.push_back({kChunkBloomData, &bloomData});
+  }
+  std::string baseList;
+  uint32_t baseLayers = 0;
+  for (const CommitGraph *layer = base; layer;
+       layer = layer->baseGraph().get(), ++baseLayers) {
+    ObjectId checksum = layer->checksum();
+    baseList.insert(0, reinterpret_cast<const char *>(checksum.data()),
+                    kHashSize);
+  }
+  if (base) {
+    chunks.push_back({kChunkBase, &baseList});
+  }
+
+  std::string out = "CGPH";
+  out.push_back(1); // version
+  out.push_back(1); // SHA-1
+  out.push_back(static_cast<char>(chunks.size()));
+  out.push_back(static_cast<char>(baseLayers));
+  uint64_t offset = kHeaderSize + (chunks.size() + 1) * kChunkEntrySize;
+  for (const auto &[id, body] : chunks) {
+    appendChunkEntry(out, id, offset);
+    offset += body->size();
+  }
+  appendChunkEntry(out, 0, offset);
+  for (const auto &chunk : chunks) {
+    out += *chunk.second;
+  }
+  Sha1 ctx;
+  ctx.update(out);
+  out += ctx.finalRaw();
+  return out;
+}
+
+void writeFileAtomically(const std::string &path, const std::string &bytes) {
+  std::ostringstream tmpName;
+  tmpName << path << ".tmp-" << getpid() << "-" << std::this_thread::get_id();
+  std::string tmpPath = tmpName.str();
+  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  out.close();
+  if (!out) {
+    std::filesystem::remove(tmpPath);
+    throw CommitGraphException("Failed to write " + tmpPath);
+  }
+  std::filesystem::rename(tmpPath, path);
+}
+
+} // namespace
+
+long updateCommitGraph(const std::string &gitDir,
+                       const std::vector<ObjectId> &tips, bool force,
+                       bool addFilters) {
+  try {
+    bool changedPaths = true;
+    if (std::filesystem::exists(gitDir + "/config")) {
+      GitConfig config(gitDir);
+      std::string enabled;
+      if (!force && config.getConfig("core.commitGraph", enabled) &&
+          (enabled == "false" || enabled == "0")) {
+        return 0;
+      }
+      if (config.getConfig("commitGraph.changedPaths", enabled) &&
+          (enabled == "false" || enabled == "0")) {
+        changedPaths = false;
+      }
+    }
+
+    std::shared_ptr<CommitGraph> existing;
+    try {
+      existing = CommitGraph::load(gitDir);
+    } catch (const std::exception &e) {
+      std::cerr << "Rewriting unreadable commit-graph: " << e.what()
+                << std::endl;
+    }
+
+    // Collect the commits that are reachable from tips but not in the graph.
+    std::vector<GraphCommit> added;
+    std::unordered_map<ObjectId, size_t> addedIndex;
+    std::vector<ObjectId> pending;
+    for (const auto &tip : tips) {
+      if (!tip.isNull()) {
+        pending.push_back(tip);
+      }
+    }
+    while (!pending.empty()) {
+      ObjectId id = pending.back();
+      pending.pop_back();
+      uint32_t position = 0;
+      if (addedIndex.count(id) ||
+          (existing && existing->findPosition(id, position))) {
+        continue;
+      }
+      CommitInfo info;
+      if (!readCommitObject(gitDir, id, info)) {
+        throw CommitGraphException("Cannot read commit " + id.hex());
+      }
+      GraphCommit commit;
+      commit.id = id;
+      commit.tree = info.tree;
+      commit.commitTime = info.commitTime;
+      for (const auto &parent : info.parents) {
+        commit.parents.push_back(parent);
+        pending.push_back(parent);
+      }
+      addedIndex.emplace(id, added.size());
+      added.push_back(std::move(commit));
+    }
+    // Filters are kept up to date once the graph has them; a graph without
+    // them only gets them on request (commit-graph write, gc). Turning
+    // commitGraph.changedPaths off drops them on the next write.
+    BloomSettings bloomSettings;
+    bool hadFilters = existing && existing->hasChangedPathFilters();
+    bool writeFilters = changedPaths && (hadFilters || force || addFilters);
+    if (hadFilters) {
+      bloomSettings = existing->changedPathSettings();
+    }
+    if (added.empty() && existing && writeFilters == hadFilters) {
+      return 0;
+    }
+
+    // Generation numbers of new commits; parents already in the graph keep
+    // the generation stored there.
+    auto generationOf = [&](const ObjectId &id) -> uint32_t {
+      auto it = addedIndex.find(id);
+      if (it != addedIndex.end()) {
+        return added[it->second].generation;
+      }
+      uint32_t position = 0;
+      existing->findPosition(id, position);
+      return existing->generationAt(position);
+    };
+    for (size_t i = 0; i < added.size(); ++i) {
+      std::vector<size_t> stack = {i};
+      while (!stack.empty()) {
+        GraphCommit &commit = added[stack.back()];
+        if (commit.generation) {
+          stack.pop_back();
+          continue;
+        }
+        bool ready = true;
+        uint32_t generation = 1;
+        for (const auto &parent : commit.parents) {
+          uint32_t parentGeneration = generationOf(parent);
+          if (!parentGeneration) {
+            stack.push_back(addedIndex.at(parent));
+            ready = false;
+          } else {
+            generation = std::max(generation, parentGeneration + 1);
+          }
+        }
+        if (ready) {
+          commit.generation = generation;
+          stack.pop_back();
+        }
+      }
+    }
+
+    // The layers the new one absorbs: all of them when filters are added or
+    // dropped, otherwise those no more than kSplitRatio times its size.
+    std::vector<std::shared_ptr<CommitGraph>> layers; // oldest first
+    for (auto layer = existing; layer; layer = layer->baseGraph()) {
+      layers.insert(layers.begin(), layer);
+    }
+    size_t kept = writeFilters == hadFilters ? layers.size() : 0;
+    uint64_t layerSize = added.size();
+    while (kept > 0) {
+      const CommitGraph &below = *layers[kept - 1];
+      uint32_t belowSize = below.commitCount() - below.baseCommitCount();
+      if (layerSize * kSplitRatio <= belowSize) {
+        break;
+      }
+      layerSize += belowSize;
+      --kept;
+    }
+    std::shared_ptr<CommitGraph> base = kept ? layers[kept - 1] : nullptr;
+
+    std::vector<GraphCommit> layer;
+    layer.reserve(layerSize);
+    uint32_t existingCount = existing ? existing->commitCount() : 0;
+    for (uint32_t i = base ? base->commitCount() : 0; i < existingCount; ++i) {
+      GraphCommit commit;
+      commit.id = existing->commitIdAt(i);
+      commit.tree = existing->treeIdAt(i);
+      for (uint32_t parent : existing->parentPositions(i)) {
+        commit.parents.push_back(existing->commitIdAt(parent));
+      }
+      commit.commitTime = existing->commitTimeAt(i);
+      commit.generation = existing->generationAt(i);
+      if (writeFilters) {
+        const unsigned char *filter = nullptr;
+        size_t filterSize = 0;
+        existing->changedPathFilter(i, filter, filterSize);
+        commit.bloom.assign(reinterpret_cast<const char *>(filter), filterSize);
+      }
+      layer.push_back(std::move(commit));
+    }
+    for (auto &commit : added) {
+      layer.push_back(std::move(commit));
+    }
+    std::sort(layer.begin(), layer.end(),
+              [](const GraphCommit &a, const GraphCommit &b) {
+                return a.id < b.id;
+              });
+    if (writeFilters) {
+      computeChangedPathFilters(gitDir, layer, base.get(), bloomSettings);
+    }
+    std::string bytes = serializeGraph(
+        layer, base.get(), writeFilters ? &bloomSettings : nullptr);
+    ObjectId checksum = ObjectId::fromRaw(bytes.data() + bytes.size() -
+                                          kHashSize);
+
+    // A single file from before chains becomes the first layer as it is.
+    std::string legacyPath = CommitGraph::pathFor(gitDir);
+    std::string chainDir = gitDir + "/objects/info/commit-graphs";
+    std::filesystem::create_directories(chainDir);
+    std::string chain;
+    for (size_t i = 0; i < kept; ++i) {
+      std::string layerPath =
+          CommitGraph::layerPathFor(gitDir, layers[i]->checksum());
+      if (!std::filesystem::exists(layerPath)) {
+        std::filesystem::rename(legacyPath, layerPath);
+      }
+      chain += layers[i]->checksum().hex() + "\n";
+    }
+    chain += checksum.hex() + "\n";
+    writeFileAtomically(CommitGraph::layerPathFor(gitDir, checksum), bytes);
+    writeFileAtomically(CommitGraph::chainPathFor(gitDir), chain);
+
+    // Absorbed layers (and anything else the chain no longer names) go; git
+    // reads a single file in preference to the chain, so that goes too.
+    layers.clear();
+    base.reset();
+    existing.reset();
+    std::filesystem::remove(legacyPath);
+    for (const auto &entry : std::filesystem::directory_iterator(chainDir)) {
+      std::string name = entry.path().filename().string();
+      if (name.size() == 6 + ObjectId::kHexSize + 6 &&
+          name.compare(0, 6, "graph-") == 0 &&
+          chain.find(name.substr(6, ObjectId::kHexSize)) == std::string::npos) {
+        std::filesystem::remove(entry.path());
+      }
+    }
+    return static_cast<long>(added.size());
+  } catch (const std::exception &e) {
+    std::cerr << "updateCommitGraph failed: " << e.what() << std::endl;
+    return -1;
+  }
+}
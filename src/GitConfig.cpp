@@ -56,7 +56,7 @@ bool GitConfig::setConfig(const std::string &key, const std::string &value) {
   }
 }
 
-bool GitConfig::getConfig(const std::string &key, std::string &value) {
+bool GitConfig::getConfig(const std::string &key, std::string &value) const {
   try {
     if (key.empty()) {
       throw ConfigException("Config key cannot be empty");
@@ -234,8 +234,7 @@ bool GitConfig::setUserEmail(const std::string &email) {
 
 std::string GitConfig::getUserName() const {
   std::string value;
-  GitConfig mutableThis = *this;
-  if (mutableThis.getConfig("user.name", value)) {
+  if (getConfig("user.name", value)) {
     return value;
   }
   return "Your Name";
@@ -243,13 +242,80 @@ std::string GitConfig::getUserName() const {
 
 std::string GitConfig::getUserEmail() const {
   std::string value;
-  GitConfig mutableThis = *this;
-  if (mutableThis.getConfig("user.email", value)) {
+  if (getConfig("user.email", value)) {
     return value;
   }
   return "your@email.com";
 }
 
+namespace {
+
+bool parseCompressionLevel(const GitConfig &config, const std::string &key,
+                           int &level) {
+  std::string value;
+  if (!config.getConfig(key, value)) {
+    return false;
+  }
+  try {
+    size_t used = 0;
+    int parsed = std::stoi(value, &used);
+    if (used == value.size() && parsed >= -1 && parsed <= 9) {
+      level = parsed;
+      return true;
+    }
+  } catch (const std::exception &) {
+  }
+  std::cerr << "warning: bad zlib compression level '" << value << "' for "
+            << key << ", using the default\n";
+  return false;
+}
+
+} // namespace
+
+int GitConfig::getCompressionLevel() const {
+  int level = -1;
+  parseCompressionLevel(*this, "core.compression", level);
+  return level;
+}
+
+int GitConfig::getLooseCompressionLevel() const {
+  int level = 1;
+  if (parseCompressionLevel(*this, "core.looseCompression", level)) {
+    return level;
+  }
+  parseCompressionLevel(*this, "core.compression", level);
+  return level;
+}
+
+size_t GitConfig::getByteSize(const std::string &key, size_t fallback) const {
+  std::string value;
+  if (!getConfig(key, value)) {
+    return fallback;
+  }
+  try {
+    size_t used = 0;
+    unsigned long long parsed = std::stoull(value, &used);
+    std::string suffix = value.substr(used);
+    unsigned long long scale = 1;
+    if (suffix == "k" || suffix == "K") {
+      scale = 1024;
+    } else if (suffix == "m" || suffix == "M") {
+      scale = 1024 * 1024;
+    } else if (suffix == "g" || suffix == "G") {
+      scale = 1024 * 1024 * 1024;
+    } else if (!suffix.empty()) {
+      throw ConfigException("unknown suffix");
+    }
+    if (value[0] != '-') {
+      return static_cast<size_t>(parsed * scale);
+    }
+  } catch (const std::exception &) {
+  }
+  std::cerr << "warning: bad size '" << value << "' for " << key
+            << ", using the default\n";
+  return fallback;
+}
+
 bool GitConfig::addRemote(const std::string &name, const std::string &path) {
   return setConfig("remote." + name, path);
 }
@@ -259,8 +325,7 @@ bool GitConfig::removeRemote(const std::string &name) {
 }
 
 bool GitConfig::getRemote(const std::string &name, std::string &path) const {
-  GitConfig mutableThis = *this; // getConfig is not const, workaround
-  return mutableThis.getConfig("remote." + name, path);
+  return getConfig("remote." + name, path);
 }
 
 std::vector<std::pair<std::string, std::string>>
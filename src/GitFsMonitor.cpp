@@ -0,0 +1,557 @@
+#include "headers/GitFsMonitor.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char *const kSocketName = "fsmonitor--daemon.ipc";
+const char *const kTokenPrefix = "mgit:";
+// Journal entries kept; a token older than that gets a trivial answer.
+const size_t kMaxJournal = 1 << 20;
+const int kClientTimeoutMs = 2000;
+const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB |
+                            IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |
+                            IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW |
+                            IN_EXCL_UNLINK;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int) { stopRequested = 1; }
+
+bool isIgnoredDir(const char *name) {
+  return std::strcmp(name, ".git") == 0 || std::strcmp(name, ".mgit") == 0;
+}
+
+std::string joinPath(const std::string &dir, const std::string &name) {
+  return dir.empty() ? name : dir + "/" + name;
+}
+
+std::string parentOf(const std::string &path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+std::string socketPath(const std::string &gitDir) {
+  return gitDir + "/" + kSocketName;
+}
+
+bool socketAddress(const std::string &gitDir, sockaddr_un &addr) {
+  std::string path = socketPath(gitDir);
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  addr = sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+void setTimeouts(int fd) {
+  timeval timeout{kClientTimeoutMs / 1000, (kClientTimeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool sendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Sends request to the daemon and reads its whole reply. False if no daemon
+// is listening, or on any error or timeout.
+bool exchange(const std::string &gitDir, const std::string &request,
+              std::string &reply) {
+  sockaddr_un addr;
+  if (!socketAddress(gitDir, addr)) {
+    return false;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return false;
+  }
+  setTimeouts(fd);
+  bool ok = connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ==
+                0 &&
+            sendAll(fd, request);
+  char buffer[65536];
+  while (ok) {
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n == 0) {
+      break;
+    }
+    if (n < 0) {
+      ok = errno == EINTR;
+      continue;
+    }
+    reply.append(buffer, static_cast<size_t>(n));
+  }
+  close(fd);
+  return ok;
+}
+
+// The daemon: one thread polling the inotify descriptor and the listening
+// socket. Events are drained before each answer, so every change made
+// before a client connected is in the journal it is answered from.
+class Daemon {
+public:
+  explicit Daemon(const std::string &gitDir) : gitDir(gitDir) {}
+  ~Daemon();
+  bool serve();
+
+private:
+  void beginEpoch();
+  std::string token() const;
+  void record(std::string path) { journal.push_back(std::move(path)); }
+  void trimJournal();
+  void watchTree(const std::string &dir);
+  void unwatchTree(const std::string &dir);
+  void rewatchAll();
+  void readEvents();
+  void handleEvent(const inotify_event &event);
+  // Answers one client; false when asked to quit.
+  bool answer(int client);
+
+  std::string gitDir;
+  int inotifyFd = -1;
+  int listenFd = -1;
+  std::unordered_map<int, std::string> wdToPath;
+  std::map<std::string, int> pathToWd; // ordered to drop whole subtrees
+  std::string epoch;
+  unsigned epochCount = 0;
+  uint64_t base = 0; // sequence number of journal[0]
+  std::vector<std::string> journal;
+  bool reliable = true; // every directory is watched
+  bool overflowed = false;
+};
+
+Daemon::~Daemon() {
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(socketPath(gitDir).c_str());
+  }
+  if (inotifyFd >= 0) {
+    close(inotifyFd);
+  }
+}
+
+void Daemon::beginEpoch() {
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  epoch =
+      std::to_string(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()) +
+      "-" + std::to_string(getpid()) + "-" + std::to_string(++epochCount);
+  base = 0;
+  journal.clear();
+}
+
+std::string Daemon::token() const {
+  return kTokenPrefix + epoch + ":" + std::to_string(base + journal.size());
+}
+
+void Daemon::trimJournal() {
+  if (journal.size() > kMaxJournal) {
+    base += journal.size();
+    journal.clear();
+  }
+}
+
+void Daemon::watchTree(const std::string &dir) {
+  int wd = inotify_add_watch(inotifyFd, dir.empty() ? "." : dir.c_str(),
+                             kWatchMask);
+  if (wd < 0) {
+    // Gone again already, or not a directory; anything else (usually the
+    // max_user_watches limit) leaves changes unseen.
+    if (errno != ENOENT && errno != ENOTDIR && reliable) {
+      std::cerr << "fsmonitor: cannot watch '" << dir
+                << "': " << std::strerror(errno)
+                << "; every query will get a full scan\n";
+      reliable = false;
+    }
+    return;
+  }
+  wdToPath[wd] = dir;
+  pathToWd[dir] = wd;
+  DIR *handle = opendir(dir.empty() ? "." : dir.c_str());
+  if (!handle) {
+    return;
+  }
+  std::vector<std::string> subdirs;
+  while (dirent *ent = readdir(handle)) {
+    const char *name = ent->d_name;
+    if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0 ||
+        isIgnoredDir(name)) {
+      continue;
+    }
+    std::string path = joinPath(dir, name);
+    bool isDir = ent->d_type == DT_DIR;
+    if (ent->d_type == DT_UNKNOWN) {
+      struct stat st {};
+      isDir = lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+    if (isDir) {
+      subdirs.push_back(std::move(path));
+    }
+  }
+  closedir(handle);
+  for (const auto &sub : subdirs) {
+    watchTree(sub);
+  }
+}
+
+void Daemon::unwatchTree(const std::string &dir) {
+  auto forget = [this](std::map<std::string, int>::iterator it) {
+    inotify_rm_watch(inotifyFd, it->second);
+    wdToPath.erase(it->second);
+    return pathToWd.erase(it);
+  };
+  auto it = pathToWd.find(dir);
+  if (it != pathToWd.end()) {
+    forget(it);
+  }
+  std::string prefix = dir + "/";
+  it = pathToWd.lower_bound(prefix);
+  while (it != pathToWd.end() &&
+         it->first.compare(0, prefix.size(), prefix) == 0) {
+    it = forget(it);
+  }
+}
+
+void Daemon::rewatchAll() {
+  for (const auto &[wd, path] : wdToPath) {
+    inotify_rm_watch(inotifyFd, wd);
+  }
+  wdToPath.clear();
+  pathToWd.clear();
+  reliable = true;
+  beginEpoch();
+  watchTree("");
+}
+
+void Daemon::readEvents() {
+  alignas(inotify_event) char buffer[64 * 1024];
+  while (true) {
+    ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      break; // EAGAIN: drained
+    }
+    for (char *p = buffer; p < buffer + n;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      handleEvent(*event);
+      p += sizeof(inotify_event) + event->len;
+    }
+  }
+  if (overflowed) {
+    // Events were lost: start over with fresh watches and a new epoch, so
+    // every outstanding token gets a trivial answer.
+    overflowed = false;
+    rewatchAll();
+  }
+  trimJournal();
+}
+
+void Daemon::handleEvent(const inotify_event &event) {
+  if (event.mask & IN_Q_OVERFLOW) {
+    overflowed = true;
+    return;
+  }
+  auto it = wdToPath.find(event.wd);
+  if (it == wdToPath.end()) {
+    return; // already unwatched
+  }
+  const std::string dir = it->second;
+  if (event.mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+    // Subdirectories are handled through their parent's events; the root
+    // going away ends the daemon.
+    if (dir.empty()) {
+      stopRequested = 1;
+    }
+    if (event.mask & IN_IGNORED) {
+      pathToWd.erase(dir);
+      wdToPath.erase(it);
+    }
+    return;
+  }
+  if (event.len == 0 || isIgnoredDir(event.name)) {
+    return;
+  }
+  std::string path = joinPath(dir, event.name);
+  if (event.mask & IN_ISDIR) {
+    if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+      // Files may already be inside; the whole directory is reported.
+      watchTree(path);
+      record(path + "/");
+    } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+      unwatchTree(path);
+      record(path + "/");
+    }
+    return;
+  }
+  record(std::move(path));
+}
+
+bool Daemon::answer(int client) {
+  setTimeouts(client);
+  std::string request;
+  char buffer[512];
+  while (request.find('\n') == std::string::npos && request.size() < 4096) {
+    ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      return true; // client gone
+    }
+    request.append(buffer, static_cast<size_t>(n));
+  }
+  request.erase(std::min(request.find('\n'), request.size()));
+  if (request == "quit") {
+    return false;
+  }
+
+  readEvents();
+  std::string reply = token();
+  reply.push_back('\0');
+  // Tokens are "mgit:<epoch>:<sequence>"; anything else is answered
+  // trivially.
+  std::string current = kTokenPrefix + epoch + ":";
+  uint64_t since = 0;
+  bool known = reliable && request.size() > current.size() &&
+               request.compare(0, current.size(), current) == 0;
+  if (known) {
+    try {
+      size_t used = 0;
+      since = std::stoull(request.substr(current.size()), &used);
+      known = used == request.size() - current.size() && since >= base &&
+              since <= base + journal.size();
+    } catch (const std::exception &) {
+      known = false;
+    }
+  }
+  if (!known) {
+    reply += "/";
+    reply.push_back('\0');
+  } else {
+    std::unordered_set<std::string> sent;
+    for (size_t i = since - base; i < journal.size(); ++i) {
+      if (sent.insert(journal[i]).second) {
+        reply += journal[i];
+        reply.push_back('\0');
+      }
+    }
+  }
+  sendAll(client, reply);
+  return true;
+}
+
+bool Daemon::serve() {
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd < 0) {
+    std::cerr << "fsmonitor: inotify_init1: " << std::strerror(errno) << "\n";
+    return false;
+  }
+  beginEpoch();
+  watchTree("");
+
+  // Bound only once the tree is watched, so no token is handed out before.
+  sockaddr_un addr;
+  if (!socketAddress(gitDir, addr)) {
+    std::cerr << "fsmonitor: socket path too long: " << socketPath(gitDir)
+              << "\n";
+    return false;
+  }
+  unlink(addr.sun_path); // left behind by a daemon that did not exit cleanly
+  listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listenFd < 0 ||
+      bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      listen(listenFd, 16) != 0) {
+    std::cerr << "fsmonitor: cannot listen on " << addr.sun_path << ": "
+              << std::strerror(errno) << "\n";
+    return false;
+  }
+
+  stopRequested = 0;
+  std::signal(SIGTERM, onStopSignal);
+  std::signal(SIGINT, onStopSignal);
+  std::signal(SIGHUP, onStopSignal);
+  std::signal(SIGPIPE, SIG_IGN);
+  while (!stopRequested) {
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {listenFd, POLLIN, 0}};
+    int ready = poll(fds, 2, 5000);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "fsmonitor: poll: " << std::strerror(errno) << "\n";
+      return false;
+    }
+    if (ready == 0) {
+      // Stop once the repository (and with it the socket) is gone.
+      struct stat st {};
+      if (lstat(addr.sun_path, &st) != 0) {
+        break;
+      }
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      readEvents();
+    }
+    if (fds[1].revents & POLLIN) {
+      int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (client >= 0) {
+        bool keepRunning = answer(client);
+        close(client);
+        if (!keepRunning) {
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool FsMonitor::Changes::mayHaveChanged(const std::string &path) const {
+  if (trivial || paths.count(path)) {
+    return true;
+  }
+  if (dirs.empty()) {
+    return false;
+  }
+  for (size_t slash = path.find('/'); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    if (dirs.count(path.substr(0, slash))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FsMonitor::Changes::dirMayHaveChanged(const std::string &dir) const {
+  return trivial || parents.count(dir) || dirs.count(dir) ||
+         mayHaveChanged(dir);
+}
+
+FsMonitor::Changes FsMonitor::query(const std::string &gitDir,
+                                    const std::string &token) {
+  Changes changes;
+  std::string reply;
+  if (!exchange(gitDir, token + "\n", reply) || reply.empty() ||
+      reply.back() != '\0' || reply.compare(0, 5, kTokenPrefix) != 0) {
+    return changes;
+  }
+  std::vector<std::string> items;
+  for (size_t start = 0; start < reply.size();) {
+    size_t end = reply.find('\0', start);
+    items.push_back(reply.substr(start, end - start));
+    start = end + 1;
+  }
+  changes.token = items[0];
+  if (items.size() == 2 && items[1] == "/") {
+    return changes;
+  }
+  changes.trivial = false;
+  for (size_t i = 1; i < items.size(); ++i) {
+    std::string &path = items[i];
+    if (!path.empty() && path.back() == '/') {
+      path.pop_back();
+      changes.parents.insert(parentOf(path));
+      changes.dirs.insert(std::move(path));
+    } else {
+      changes.parents.insert(parentOf(path));
+      changes.paths.insert(std::move(path));
+    }
+  }
+  return changes;
+}
+
+bool FsMonitor::isRunning(const std::string &gitDir) {
+  return !query(gitDir, "").token.empty();
+}
+
+bool FsMonitor::run(const std::string &gitDir) {
+  if (isRunning(gitDir)) {
+    std::cerr << "fsmonitor daemon is already running.\n";
+    return false;
+  }
+  Daemon daemon(gitDir);
+  return daemon.serve();
+}
+
+bool FsMonitor::start(const std::string &gitDir) {
+  if (isRunning(gitDir)) {
+    std::cerr << "fsmonitor daemon is already running.\n";
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    std::cerr << "fsmonitor: fork: " << std::strerror(errno) << "\n";
+    return false;
+  }
+  if (pid == 0) {
+    setsid();
+    int devNull = open("/dev/null", O_RDWR);
+    if (devNull >= 0) {
+      dup2(devNull, STDIN_FILENO);
+      dup2(devNull, STDOUT_FILENO);
+      dup2(devNull, STDERR_FILENO);
+      close(devNull);
+    }
+    Daemon daemon(gitDir);
+    _exit(daemon.serve() ? 0 : 1);
+  }
+  // Watching a large tree takes a while; wait until the socket answers.
+  for (int i = 0; i < 600; ++i) {
+    if (isRunning(gitDir)) {
+      return true;
+    }
+    int status = 0;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  std::cerr << "fsmonitor daemon failed to start.\n";
+  return false;
+}
+
+bool FsMonitor::stop(const std::string &gitDir) {
+  std::string reply;
+  if (!exchange(gitDir, "quit\n", reply)) {
+    std::cerr << "fsmonitor daemon is not running.\n";
+    return false;
+  }
+  for (int i = 0; i < 100 && isRunning(gitDir); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  return true;
+}
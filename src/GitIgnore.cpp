@@ -0,0 +1,559 @@
+#include "headers/GitIgnore.hpp"
+#include "headers/GitConfig.hpp"
+#include "headers/HashUtils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+  return text.size() >= prefix.size() &&
+         text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Adds the characters of a POSIX class ("alpha", "digit", ...) to set.
+bool addNamedClass(std::string_view name, std::bitset<256> &set) {
+  int (*test)(int) = nullptr;
+  if (name == "alnum") {
+    test = isalnum;
+  } else if (name == "alpha") {
+    test = isalpha;
+  } else if (name == "blank") {
+    test = isblank;
+  } else if (name == "cntrl") {
+    test = iscntrl;
+  } else if (name == "digit") {
+    test = isdigit;
+  } else if (name == "graph") {
+    test = isgraph;
+  } else if (name == "lower") {
+    test = islower;
+  } else if (name == "print") {
+    test = isprint;
+  } else if (name == "punct") {
+    test = ispunct;
+  } else if (name == "space") {
+    test = isspace;
+  } else if (name == "upper") {
+    test = isupper;
+  } else if (name == "xdigit") {
+    test = isxdigit;
+  } else {
+    return false;
+  }
+  for (int c = 0; c < 128; ++c) {
+    if (test(c)) {
+      set.set(static_cast<size_t>(c));
+    }
+  }
+  return true;
+}
+
+bool readFile(const std::string &path, std::string &text) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  text.assign(std::istreambuf_iterator<char>(in),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+} // namespace
+
+// ---- IgnoreGlob ----
+
+IgnoreGlob::IgnoreGlob(std::string_view pattern) {
+  size_t i = 0;
+  while (i < pattern.size()) {
+    char c = pattern[i];
+    if (c == '*') {
+      size_t end = pattern.find_first_not_of('*', i);
+      if (end == std::string_view::npos) {
+        end = pattern.size();
+      }
+      // "**" only spans directories as a whole path component.
+      bool component = end - i >= 2 && (i == 0 || pattern[i - 1] == '/');
+      if (component && end == pattern.size()) {
+        tokens.push_back({Op::AnyPath});
+      } else if (component && pattern[end] == '/') {
+        tokens.push_back({Op::AnyDirs});
+        tokens.push_back({Op::AnyDirsInner});
+        ++end;
+      } else {
+        tokens.push_back({Op::Star});
+      }
+      i = end;
+    } else if (c == '?') {
+      tokens.push_back({Op::AnyChar});
+      ++i;
+    } else if (size_t end = c == '[' ? parseClass(pattern, i) : 0) {
+      i = end;
+    } else {
+      // An unterminated '[' is a literal one.
+      if (c == '\\' && i + 1 < pattern.size()) {
+        c = pattern[++i];
+      }
+      Token token{Op::Char};
+      token.ch = static_cast<unsigned char>(c);
+      tokens.push_back(token);
+      ++i;
+    }
+  }
+
+  size_t head = 0;
+  while (head < tokens.size() && tokens[head].op == Op::Char) {
+    literalPrefix.push_back(static_cast<char>(tokens[head++].ch));
+  }
+  literal = head == tokens.size();
+  if (!literal) {
+    size_t tail = tokens.size();
+    while (tokens[tail - 1].op == Op::Char) {
+      --tail;
+    }
+    for (size_t j = tail; j < tokens.size(); ++j) {
+      literalSuffix.push_back(static_cast<char>(tokens[j].ch));
+    }
+    starSuffix = tail == 1 && tokens[0].op == Op::Star;
+    std::string run;
+    for (const Token &token : tokens) {
+      if (token.op == Op::Char) {
+        run.push_back(static_cast<char>(token.ch));
+        continue;
+      }
+      if (run.size() > literalInfix.size()) {
+        literalInfix = run;
+      }
+      run.clear();
+    }
+    if (run.size() > literalInfix.size()) {
+      literalInfix = run;
+    }
+  }
+  for (size_t state = 0; state < tokens.size(); ++state) {
+    Op op = tokens[state].op;
+    if (op == Op::Star || op == Op::AnyPath || op == Op::AnyDirs) {
+      epsilonStates.push_back(static_cast<uint32_t>(state));
+    }
+  }
+  if (tokens.size() < 64) {
+    compileMoves();
+  }
+}
+
+void IgnoreGlob::compileMoves() {
+  for (unsigned c = 0; c < 256; ++c) {
+    Moves m;
+    for (size_t state = 0; state < tokens.size(); ++state) {
+      const Token &token = tokens[state];
+      const uint64_t bit = uint64_t{1} << state;
+      switch (token.op) {
+      case Op::Char:
+        m.advance |= c == token.ch ? bit : 0;
+        break;
+      case Op::AnyChar:
+        m.advance |= c != '/' ? bit : 0;
+        break;
+      case Op::Class:
+        m.advance |= classes[token.cls][c] ? bit : 0;
+        break;
+      case Op::Star:
+        m.stay |= c != '/' ? bit : 0;
+        break;
+      case Op::AnyPath:
+        m.stay |= bit;
+        break;
+      case Op::AnyDirs:
+        (c == '/' ? m.stay : m.advance) |= bit;
+        break;
+      case Op::AnyDirsInner:
+        (c == '/' ? m.back : m.stay) |= bit;
+        break;
+      }
+    }
+    auto it = std::find(moves.begin(), moves.end(), m);
+    moveIndex[c] = static_cast<unsigned char>(it - moves.begin());
+    if (it == moves.end()) {
+      moves.push_back(m);
+    }
+  }
+}
+
+uint64_t IgnoreGlob::closeStates(uint64_t states) const {
+  // Epsilon moves only go forward, so one ascending pass closes the set.
+  for (uint32_t state : epsilonStates) {
+    if (states >> state & 1) {
+      states |= uint64_t{1} << (state + (tokens[state].op == Op::AnyDirs ? 2 : 1));
+    }
+  }
+  return states;
+}
+
+size_t IgnoreGlob::parseClass(std::string_view pattern, size_t pos) {
+  size_t i = pos + 1;
+  bool negated = false;
+  if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^')) {
+    negated = true;
+    ++i;
+  }
+  std::bitset<256> set;
+  bool first = true; // a ']' right after the '[' is a member
+  while (i < pattern.size() && (first || pattern[i] != ']')) {
+    first = false;
+    if (pattern.compare(i, 2, "[:") == 0) {
+      size_t close = pattern.find(":]", i + 2);
+      if (close != std::string_view::npos) {
+        if (!addNamedClass(pattern.substr(i + 2, close - i - 2), set)) {
+          return 0;
+        }
+        i = close + 2;
+        continue;
+      }
+    }
+    if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+      ++i;
+    }
+    unsigned char low = static_cast<unsigned char>(pattern[i++]);
+    unsigned char high = low;
+    if (i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+      i += pattern[i + 1] == '\\' && i + 2 < pattern.size() ? 2 : 1;
+      high = static_cast<unsigned char>(pattern[i++]);
+    }
+    for (unsigned value = low; value <= high; ++value) {
+      set.set(value);
+    }
+  }
+  if (i >= pattern.size()) {
+    return 0;
+  }
+  if (negated) {
+    set.flip();
+  }
+  set.reset('/');
+  Token token{Op::Class};
+  token.cls = static_cast<uint32_t>(classes.size());
+  classes.push_back(set);
+  tokens.push_back(token);
+  return i + 1;
+}
+
+bool IgnoreGlob::matches(std::string_view text) const {
+  if (moves.empty()) {
+    return matchesLong(text);
+  }
+  // Bit s: the first s tokens have matched; bit tokens.size() accepts.
+  uint64_t states = closeStates(1);
+  for (char c : text) {
+    const Moves &m = moves[moveIndex[static_cast<unsigned char>(c)]];
+    states = (states & m.advance) << 1 | (states & m.stay) |
+             (states & m.back) >> 1;
+    if (states == 0) {
+      return false;
+    }
+    states = closeStates(states);
+  }
+  return (states >> tokens.size() & 1) != 0;
+}
+
+bool IgnoreGlob::matchesLong(std::string_view text) const {
+  // Bit s of a state set: the first s tokens have matched. The last bit
+  // (s == tokens.size()) accepts.
+  const size_t accept = tokens.size();
+  const size_t words = accept / 64 + 1;
+  thread_local std::vector<uint64_t> current;
+  thread_local std::vector<uint64_t> next;
+  current.assign(words, 0);
+  next.assign(words, 0);
+
+  auto add = [](std::vector<uint64_t> &states, size_t state) {
+    states[state / 64] |= uint64_t{1} << (state % 64);
+  };
+  auto has = [](const std::vector<uint64_t> &states, size_t state) {
+    return (states[state / 64] >> (state % 64) & 1) != 0;
+  };
+  // Epsilon moves only go forward, so one ascending pass closes the set.
+  auto close = [&](std::vector<uint64_t> &states) {
+    for (uint32_t state : epsilonStates) {
+      if (has(states, state)) {
+        add(states, state + (tokens[state].op == Op::AnyDirs ? 2 : 1));
+      }
+    }
+  };
+
+  add(current, 0);
+  close(current);
+  for (char c : text) {
+    const unsigned char ch = static_cast<unsigned char>(c);
+    std::fill(next.begin(), next.end(), 0);
+    bool live = false;
+    for (size_t word = 0; word < words; ++word) {
+      for (uint64_t bits = current[word]; bits != 0; bits &= bits - 1) {
+        size_t state = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+        if (state == accept) {
+          continue;
+        }
+        const Token &token = tokens[state];
+        switch (token.op) {
+        case Op::Char:
+          if (ch == token.ch) {
+            add(next, state + 1);
+            live = true;
+          }
+          break;
+        case Op::AnyChar:
+          if (ch != '/') {
+            add(next, state + 1);
+            live = true;
+          }
+          break;
+        case Op::Class:
+          if (classes[token.cls][ch]) {
+            add(next, state + 1);
+            live = true;
+          }
+          break;
+        case Op::Star:
+          if (ch != '/') {
+            add(next, state);
+            live = true;
+          }
+          break;
+        case Op::AnyPath:
+          add(next, state);
+          live = true;
+          break;
+        case Op::AnyDirs:
+          add(next, ch == '/' ? state : state + 1);
+          live = true;
+          break;
+        case Op::AnyDirsInner:
+          add(next, ch == '/' ? state - 1 : state);
+          live = true;
+          break;
+        }
+      }
+    }
+    if (!live) {
+      return false;
+    }
+    close(next);
+    current.swap(next);
+  }
+  return has(current, accept);
+}
+
+// ---- IgnoreRules ----
+
+IgnoreRules::IgnoreRules(std::string base, std::string_view text)
+    : base(std::move(base)) {
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    addPattern(text.substr(0, newline));
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                          : newline + 1);
+  }
+  // Only now that rules no longer grows can the buckets point into it.
+  for (size_t index = 0; index < rules.size(); ++index) {
+    addToBucket(static_cast<uint32_t>(index));
+  }
+}
+
+void IgnoreRules::addPattern(std::string_view line) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  // Trailing spaces are dropped unless escaped ("\ ").
+  while (!line.empty() && line.back() == ' ' &&
+         !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+    line.remove_suffix(1);
+  }
+  if (line.empty() || line[0] == '#') {
+    return;
+  }
+  bool negated = line[0] == '!';
+  if (negated) {
+    line.remove_prefix(1);
+  }
+  bool dirOnly = !line.empty() && line.back() == '/';
+  if (dirOnly) {
+    line.remove_suffix(1);
+  }
+  bool anchored = line.find('/') != std::string_view::npos;
+  if (anchored && line[0] == '/') {
+    line.remove_prefix(1);
+  }
+  if (line.empty()) {
+    return;
+  }
+
+  rules.push_back(Rule{IgnoreGlob(line), negated, dirOnly, anchored});
+}
+
+void IgnoreRules::addToBucket(uint32_t index) {
+  const Rule &rule = rules[index];
+  const IgnoreGlob &glob = rule.glob;
+  std::string_view suffix = glob.suffix();
+  size_t dot = suffix.rfind('.');
+  if (glob.isLiteral()) {
+    (rule.anchored ? byPath : byName)[glob.prefix()].push_back(index);
+  } else if (!rule.anchored && glob.isStarSuffix() &&
+             dot != std::string_view::npos) {
+    byExtension[suffix.substr(dot + 1)].push_back(index);
+  } else {
+    wildcards.push_back(index);
+  }
+}
+
+IgnoreRules::Match IgnoreRules::match(std::string_view path,
+                                      bool isDir) const {
+  if (rules.empty()) {
+    return Match::None;
+  }
+  std::string_view below = path;
+  if (!base.empty()) {
+    below.remove_prefix(std::min(below.size(), base.size() + 1));
+  }
+  size_t slash = below.rfind('/');
+  std::string_view name =
+      slash == std::string_view::npos ? below : below.substr(slash + 1);
+
+  // The last matching rule wins, so each list is searched backwards and
+  // only for rules after the best match found so far.
+  int64_t best = -1;
+  auto search = [&](const std::vector<uint32_t> &candidates, auto &&test) {
+    for (auto it = candidates.rbegin();
+         it != candidates.rend() && static_cast<int64_t>(*it) > best; ++it) {
+      const Rule &rule = rules[*it];
+      if ((!rule.dirOnly || isDir) && test(rule)) {
+        best = *it;
+        return;
+      }
+    }
+  };
+  auto searchBucket = [&](const Bucket &bucket, std::string_view key,
+                          auto &&test) {
+    if (bucket.empty()) {
+      return;
+    }
+    auto it = bucket.find(key);
+    if (it != bucket.end()) {
+      search(it->second, test);
+    }
+  };
+  auto always = [](const Rule &) { return true; };
+
+  searchBucket(byName, name, always);
+  searchBucket(byPath, below, always);
+  size_t dot = name.rfind('.');
+  if (dot != std::string_view::npos) {
+    searchBucket(byExtension, name.substr(dot + 1), [&](const Rule &rule) {
+      return endsWith(name, rule.glob.suffix());
+    });
+  }
+  search(wildcards, [&](const Rule &rule) {
+    std::string_view subject = rule.anchored ? below : name;
+    const IgnoreGlob &glob = rule.glob;
+    return subject.size() >= glob.prefix().size() + glob.suffix().size() &&
+           startsWith(subject, glob.prefix()) &&
+           endsWith(subject, glob.suffix()) &&
+           subject.find(glob.infix()) != std::string_view::npos &&
+           glob.matches(subject);
+  });
+
+  if (best < 0) {
+    return Match::None;
+  }
+  return rules[static_cast<size_t>(best)].negated ? Match::Included
+                                                  : Match::Ignored;
+}
+
+// ---- IgnoreStack ----
+
+IgnoreStack::IgnoreStack(Ptr parent, IgnoreRules rules, const ObjectId &id)
+    : parent(std::move(parent)), rules(std::move(rules)), stackId(id) {}
+
+IgnoreStack::Ptr IgnoreStack::push(const Ptr &parent, const std::string &dir,
+                                   const std::string &text) {
+  Sha1 sha;
+  if (parent) {
+    sha.update(parent->id().data(), ObjectId::kRawSize);
+  }
+  sha.update(dir);
+  sha.update("", 1);
+  sha.update(text);
+  unsigned char digest[Sha1::kDigestSize];
+  sha.final(digest);
+  return Ptr(new IgnoreStack(parent, IgnoreRules(dir, text),
+                             ObjectId::fromRaw(digest)));
+}
+
+IgnoreStack::Ptr IgnoreStack::forRepository(const std::string &gitDir) {
+  Ptr stack = push(nullptr, "", "");
+  std::string text;
+  std::string excludesFile;
+  if (GitConfig(gitDir).getConfig("core.excludesFile", excludesFile) &&
+      !excludesFile.empty()) {
+    const char *home = std::getenv("HOME");
+    if (home && startsWith(excludesFile, "~/")) {
+      excludesFile = home + excludesFile.substr(1);
+    }
+    if (readFile(excludesFile, text)) {
+      stack = push(stack, "", text);
+    }
+  }
+  if (readFile(gitDir + "/info/exclude", text)) {
+    stack = push(stack, "", text);
+  }
+  return stack;
+}
+
+IgnoreStack::Ptr IgnoreStack::enter(const Ptr &parent, const std::string &root,
+                                    const std::string &dir) {
+  std::string path = dir.empty() ? root : root + "/" + dir;
+  std::string text;
+  if (!readFile(path + "/" + kFileName, text)) {
+    return parent;
+  }
+  return push(parent, dir, text);
+}
+
+bool IgnoreStack::isPathIgnored(const Ptr &repository, const std::string &root,
+                                std::string_view path) {
+  Ptr stack = repository;
+  size_t start = 0;
+  while (true) {
+    stack = enter(stack, root,
+                  std::string(path.substr(0, start == 0 ? 0 : start - 1)));
+    size_t slash = path.find('/', start);
+    if (slash == std::string_view::npos) {
+      return stack->isIgnored(path, false);
+    }
+    if (stack->isIgnored(path.substr(0, slash), true)) {
+      return true;
+    }
+    start = slash + 1;
+  }
+}
+
+bool IgnoreStack::isIgnored(std::string_view path, bool isDir) const {
+  for (const IgnoreStack *frame = this; frame; frame = frame->parent.get()) {
+    switch (frame->rules.match(path, isDir)) {
+    case IgnoreRules::Match::Ignored:
+      return true;
+    case IgnoreRules::Match::Included:
+      return false;
+    case IgnoreRules::Match::None:
+      break;
+    }
+  }
+  return false;
+}
@@ -1,20 +1,416 @@
 #include "headers/GitIndex.hpp"
+#include "headers/GitFsMonitor.hpp"
 #include "headers/GitMerge.hpp"
 #include "headers/GitObjectStorage.hpp"
 #include "headers/GitObjectTypesClasses.hpp"
+#include "headers/GitWorkTree.hpp"
 #include "headers/HashUtils.hpp"
-#include "headers/ZlibUtils.hpp"
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+namespace {
+
+const char kIndexMagic[4] = {'M', 'G', 'I', 'X'};
+const uint32_t kIndexVersion = 3;
+const uint32_t kIndexHeaderSizeV2 = 16;
+// version 3 adds the string table size (extensions follow the table)
+const uint32_t kIndexHeaderSize = kIndexHeaderSizeV2 + 4;
+const char kCacheTreeSignature[4] = {'T', 'R', 'E', 'E'};
+const char kUntrackedCacheSignature[4] = {'U', 'N', 'T', 'R'};
+const char kFsMonitorSignature[4] = {'F', 'S', 'M', 'N'};
+// Reported paths above which a status saves the new fsmonitor token even if
+// nothing else changed, so the daemon's answers do not keep growing.
+const size_t kFsMonitorSaveThreshold = 1000;
+const size_t kRawHashSize = 20;
+// mode, state, path offset/length, marker offset/length, three raw hashes
+const uint32_t kIndexRecordSizeV1 = 6 * 4 + 3 * kRawHashSize;
+// version 2 appends mtime, ctime, size, inode and device
+const uint32_t kIndexRecordSize = kIndexRecordSizeV1 + 5 * 8;
+constexpr ObjectId kEmptyBlobId =
+    ObjectId::fromHex("e69de29bb2d1d6434b8b29ae775ad8c2e48c5391");
+
+uint32_t readBE32(const unsigned char *p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t readBE64(const unsigned char *p) {
+  return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+void appendBE32(std::string &out, uint32_t value) {
+  out.push_back(static_cast<char>((value >> 24) & 0xff));
+  out.push_back(static_cast<char>((value >> 16) & 0xff));
+  out.push_back(static_cast<char>((value >> 8) & 0xff));
+  out.push_back(static_cast<char>(value & 0xff));
+}
+
+void appendBE64(std::string &out, uint64_t value) {
+  appendBE32(out, static_cast<uint32_t>(value >> 32));
+  appendBE32(out, static_cast<uint32_t>(value & 0xffffffff));
+}
+
+int64_t timespecToNs(const struct timespec &ts) {
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+std::string formatMode(uint32_t mode) {
+  std::ostringstream out;
+  out << std::oct << std::setw(6) << std::setfill('0') << mode;
+  return out.str();
+}
+
+bool hasPrefix(const std::string &path, const std::string &prefix) {
+  return path.compare(0, prefix.size(), prefix) == 0;
+}
+
+// git's tree order: a directory sorts as if its name ended in '/', so a
+// depth-first walk visits paths in plain byte order, like the index.
+bool treeOrderLess(const ParsedTreeEntry *a, const ParsedTreeEntry *b) {
+  std::string_view x = a->filename();
+  std::string_view y = b->filename();
+  size_t common = std::min(x.size(), y.size());
+  int cmp = x.compare(0, common, y, 0, common);
+  if (cmp != 0) {
+    return cmp < 0;
+  }
+  auto next = [common](std::string_view name, bool isTree) {
+    return common < name.size() ? static_cast<unsigned char>(name[common])
+                                : isTree ? '/' : -1;
+  };
+  return next(x, a->isTree()) < next(y, b->isTree());
+}
+
+// Staged changes as one merge-join of the HEAD tree, read lazily in tree
+// order, with the path-sorted index. A subtree the cache-tree records as
+// the tree of its index entries is skipped without being read; a subtree
+// found to match the index exactly is recorded in the cache-tree, so the
+// next status (and commit) can skip it too.
+class HeadIndexJoin {
+public:
+  HeadIndexJoin(const std::string &gitDir, CacheTree &cacheTree,
+                const std::vector<const IndexEntry *> &sorted,
+                StatusResult &result)
+      : reader(gitDir), cacheTree(cacheTree), sorted(sorted), result(result) {
+    // A directory staged as a single entry (`add <dir>`) sorts before its
+    // siblings in the index but after them in HEAD's tree, where it is
+    // compared file by file; the cache-tree would call it unchanged.
+    useCacheTree = std::none_of(
+        sorted.begin(), sorted.end(),
+        [](const IndexEntry *entry) { return entry->mode == "040000"; });
+  }
+
+  void run(const ObjectId &headTree) {
+    if (!headTree.isNull() && !skip("", "", headTree)) {
+      bool same = join(headTree, "");
+      same &= !addNewWithin("");
+      if (same && position > 0) {
+        primed |=
+            cacheTree.prime("", headTree, static_cast<int32_t>(position));
+      }
+    }
+    addNewWithin("");
+    for (const auto &path : deleted) {
+      result.staged_changes.push_back({"deleted", path});
+    }
+  }
+
+  size_t treesRead = 0;
+  size_t subtreesSkipped = 0;
+  bool primed = false; // the cache-tree gained valid directories
+
+private:
+  // Index entries before `key` are not in HEAD; returns true if any.
+  bool addNewBefore(const std::string &key) {
+    size_t start = position;
+    while (position < sorted.size() && sorted[position]->path < key) {
+      result.staged_changes.push_back({"new file", sorted[position++]->path});
+    }
+    return position != start;
+  }
+
+  bool addNewWithin(const std::string &prefix) {
+    size_t start = position;
+    while (position < sorted.size() &&
+           hasPrefix(sorted[position]->path, prefix)) {
+      result.staged_changes.push_back({"new file", sorted[position++]->path});
+    }
+    return position != start;
+  }
+
+  bool skip(const std::string &dir, const std::string &prefix,
+            const ObjectId &id) {
+    int32_t count = useCacheTree ? cacheTree.validCount(dir, id) : -1;
+    if (count <= 0) {
+      return false;
+    }
+    // The count must still cover exactly the entries below the directory.
+    size_t end = position + static_cast<size_t>(count);
+    if (end > sorted.size() || !hasPrefix(sorted[position]->path, prefix) ||
+        !hasPrefix(sorted[end - 1]->path, prefix) ||
+        (end < sorted.size() && hasPrefix(sorted[end]->path, prefix))) {
+      return false;
+    }
+    position = end;
+    ++subtreesSkipped;
+    return true;
+  }
+
+  // Reports a changed ID; true if ID and mode are the same.
+  bool compare(const IndexEntry &indexed, const ParsedTreeEntry &entry,
+               const std::string &path) {
+    if (indexed.hash != entry.id) {
+      result.staged_changes.push_back({"modified", path});
+      return false;
+    }
+    return indexed.mode == treeEntryModeString(entry.mode);
+  }
+
+  // Joins the tree against the index entries below prefix ("" or "dir/").
+  // Returns true when they match it exactly (same paths, IDs and modes).
+  bool join(const ObjectId &treeId, const std::string &prefix) {
+    TreeCache::Tree tree = reader.readParsedTree(treeId);
+    ++treesRead;
+    if (!tree) {
+      return false;
+    }
+    std::vector<const ParsedTreeEntry *> order;
+    order.reserve(tree->entries.size());
+    for (const ParsedTreeEntry &entry : tree->entries) {
+      order.push_back(&entry);
+    }
+    // A tree not written from the index may be in another order; it is
+    // walked in path order but not recorded in the cache-tree.
+    bool same = std::is_sorted(order.begin(), order.end(), treeOrderLess);
+    if (!same) {
+      std::sort(order.begin(), order.end(), treeOrderLess);
+    }
+    for (const ParsedTreeEntry *entry : order) {
+      std::string path = prefix;
+      path += entry->filename();
+      if (entry->isTree()) {
+        std::string dirPrefix = path + "/";
+        same &= !addNewBefore(dirPrefix);
+        if (skip(path, dirPrefix, entry->id)) {
+          continue;
+        }
+        size_t start = position;
+        bool subtreeSame = join(entry->id, dirPrefix);
+        subtreeSame &= !addNewWithin(dirPrefix);
+        if (subtreeSame && position > start) {
+          primed |= cacheTree.prime(path, entry->id,
+                                    static_cast<int32_t>(position - start));
+        } else {
+          same = false;
+        }
+        continue;
+      }
+      same &= !addNewBefore(path);
+      if (position < sorted.size() && sorted[position]->path == path) {
+        same &= compare(*sorted[position++], *entry, path);
+      } else {
+        deleted.push_back(std::move(path));
+        same = false;
+      }
+    }
+    return same;
+  }
+
+  TreeObject reader;
+  CacheTree &cacheTree;
+  const std::vector<const IndexEntry *> &sorted;
+  StatusResult &result;
+  bool useCacheTree = true;
+  size_t position = 0;
+  std::vector<std::string> deleted; // reported after the index's changes
+};
+
+} // namespace
+
+// ---------------- IndexFileView ----------------
+
+bool IndexFileView::isBinaryIndex(const std::string &indexPath) {
+  std::ifstream in(indexPath, std::ios::binary);
+  char magic[4] = {0};
+  return in.read(magic, 4) && std::memcmp(magic, kIndexMagic, 4) == 0;
+}
+
+std::unique_ptr<IndexFileView>
+IndexFileView::open(const std::string &indexPath) {
+  int fd = ::open(indexPath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < kIndexHeaderSizeV2 + kRawHashSize) {
+    ::close(fd);
+    return nullptr;
+  }
+  std::unique_ptr<IndexFileView> view(new IndexFileView());
+  view->dataSize = static_cast<size_t>(st.st_size);
+  void *mapped = mmap(nullptr, view->dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("Cannot mmap " + indexPath);
+  }
+  view->data = static_cast<const unsigned char *>(mapped);
+  view->mtimeNs = timespecToNs(st.st_mtim);
+
+  if (std::memcmp(view->data, kIndexMagic, 4) != 0) {
+    return nullptr;
+  }
+  view->version = readBE32(view->data + 4);
+  if (view->version < 1 || view->version > kIndexVersion) {
+    throw std::runtime_error("Unsupported index version in " + indexPath);
+  }
+  view->count = readBE32(view->data + 8);
+  view->recordSize = readBE32(view->data + 12);
+  uint32_t headerSize =
+      view->version >= 3 ? kIndexHeaderSize : kIndexHeaderSizeV2;
+  if (headerSize + kRawHashSize > view->dataSize) {
+    throw std::runtime_error("Truncated index file " + indexPath);
+  }
+  size_t recordsEnd =
+      headerSize + static_cast<size_t>(view->count) * view->recordSize;
+  uint32_t minRecordSize =
+      view->version == 1 ? kIndexRecordSizeV1 : kIndexRecordSize;
+  if (view->recordSize < minRecordSize ||
+      recordsEnd + kRawHashSize > view->dataSize) {
+    throw std::runtime_error("Truncated index file " + indexPath);
+  }
+  size_t bodyEnd = view->dataSize - kRawHashSize;
+  view->records = view->data + headerSize;
+  view->strings = view->data + recordsEnd;
+  view->stringsSize = bodyEnd - recordsEnd;
+  if (view->version >= 3) {
+    size_t stringsSize = readBE32(view->data + 16);
+    if (stringsSize > view->stringsSize) {
+      throw std::runtime_error("Truncated index file " + indexPath);
+    }
+    view->stringsSize = stringsSize;
+    view->extensions = view->strings + stringsSize;
+    view->extensionsSize = bodyEnd - recordsEnd - stringsSize;
+  }
+  return view;
+}
+
+IndexFileView::~IndexFileView() {
+  if (data) {
+    munmap(const_cast<unsigned char *>(data), dataSize);
+  }
+}
+
+const unsigned char *IndexFileView::record(uint32_t position) const {
+  if (position >= count) {
+    throw std::out_of_range("Index position out of range");
+  }
+  return records + static_cast<size_t>(position) * recordSize;
+}
+
+std::string_view IndexFileView::stringAt(uint32_t offset,
+                                         uint32_t length) const {
+  if (static_cast<size_t>(offset) + length > stringsSize) {
+    throw std::runtime_error("Index string table is corrupt");
+  }
+  return std::string_view(reinterpret_cast<const char *>(strings) + offset,
+                          length);
+}
+
+std::string_view IndexFileView::pathAt(uint32_t position) const {
+  const unsigned char *r = record(position);
+  return stringAt(readBE32(r + 8), readBE32(r + 12));
+}
+
+IndexEntry IndexFileView::entryAt(uint32_t position) const {
+  const unsigned char *r = record(position);
+  IndexEntry entry;
+  entry.mode = formatMode(readBE32(r));
+  uint32_t state = readBE32(r + 4);
+  if (state > static_cast<uint32_t>(ConflictState::RESOLVED)) {
+    throw std::runtime_error("Index entry has invalid conflict state");
+  }
+  entry.conflict_state = static_cast<ConflictState>(state);
+  entry.path = std::string(stringAt(readBE32(r + 8), readBE32(r + 12)));
+  entry.conflict_marker =
+      std::string(stringAt(readBE32(r + 16), readBE32(r + 20)));
+  entry.hash = ObjectId::fromRaw(r + 24);
+  entry.base_hash = ObjectId::fromRaw(r + 24 + kRawHashSize);
+  entry.their_hash = ObjectId::fromRaw(r + 24 + 2 * kRawHashSize);
+  if (version >= 2) {
+    const unsigned char *st = r + kIndexRecordSizeV1;
+    entry.mtime_ns = static_cast<int64_t>(readBE64(st));
+    entry.ctime_ns = static_cast<int64_t>(readBE64(st + 8));
+    entry.size = readBE64(st + 16);
+    entry.ino = readBE64(st + 24);
+    entry.dev = readBE64(st + 32);
+  }
+  return entry;
+}
+
+bool IndexFileView::find(std::string_view path, uint32_t &position) const {
+  uint32_t lo = 0;
+  uint32_t hi = count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int cmp = pathAt(mid).compare(path);
+    if (cmp == 0) {
+      position = mid;
+      return true;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return false;
+}
+
+bool IndexFileView::verifyChecksum() const {
+  Sha1 ctx;
+  ctx.update(data, dataSize - kRawHashSize);
+  unsigned char digest[Sha1::kDigestSize];
+  ctx.final(digest);
+  return std::memcmp(digest, data + dataSize - kRawHashSize,
+                     kRawHashSize) == 0;
+}
+
+std::string_view IndexFileView::extension(const char *signature) const {
+  const unsigned char *p = extensions;
+  size_t left = extensionsSize;
+  while (left >= 8) {
+    size_t size = readBE32(p + 4);
+    if (size > left - 8) {
+      throw std::runtime_error("Index extension is truncated");
+    }
+    if (std::memcmp(p, signature, 4) == 0) {
+      return std::string_view(reinterpret_cast<const char *>(p + 8), size);
+    }
+    p += 8 + size;
+    left -= 8 + size;
+  }
+  return std::string_view();
+}
+
+// ---------------- IndexManager ----------------
+
 IndexManager::IndexManager(const std::string &gitDir) : gitDir(gitDir) {}
 
 IndexEntry IndexManager::gitIndexEntryFromPath(const std::string &path) {
@@ -29,28 +425,20 @@ IndexEntry IndexManager::gitIndexEntryFromPath(const std::string &path) {
   newEntry.mode = std::filesystem::is_directory(path) ? "040000" : "100644";
 
   // Set default values for merge-related fields
-  newEntry.base_hash = std::string(40, '0');
-  newEntry.their_hash = std::string(40, '0');
+  newEntry.base_hash = ObjectId();
+  newEntry.their_hash = ObjectId();
   newEntry.conflict_state = ConflictState::NONE;
   newEntry.conflict_marker = "";
 
   // Read content for files
   if (std::filesystem::is_regular_file(path)) {
-    std::ifstream curr_file(path, std::ios::binary);
-    if (!curr_file.is_open()) {
-      std::cerr << "Unable to open the file: " << path << std::endl;
-      return newEntry;
-    }
-
-    std::ostringstream data;
-    data << curr_file.rdbuf();
-    std::string content = data.str();
+    // Stat before reading: if the file changes while it is being hashed, the
+    // cached stat data will not match next time and it is hashed again.
+    fillStatData(newEntry);
 
-    // Create blob object
+    // Create blob object (streamed; the file is never held in memory)
     BlobObject blob(gitDir);
     newEntry.hash = blob.writeObject(path, true);
-
-    curr_file.close();
   } else if (std::filesystem::is_directory(path)) {
     // Create tree object
     TreeObject subTree(gitDir);
@@ -63,7 +451,90 @@ IndexEntry IndexManager::gitIndexEntryFromPath(const std::string &path) {
   return newEntry;
 }
 
+bool IndexManager::fillStatData(IndexEntry &entry) {
+  struct stat st {};
+  if (lstat(entry.path.c_str(), &st) != 0) {
+    return false;
+  }
+  entry.mtime_ns = timespecToNs(st.st_mtim);
+  entry.ctime_ns = timespecToNs(st.st_ctim);
+  entry.size = static_cast<uint64_t>(st.st_size);
+  entry.ino = static_cast<uint64_t>(st.st_ino);
+  entry.dev = static_cast<uint64_t>(st.st_dev);
+  return true;
+}
+
+bool IndexManager::statDataMatches(const IndexEntry &entry) {
+  if (entry.mtime_ns == 0) {
+    return false; // never stat'ed, e.g. after reset or merge
+  }
+  // A size of 0 on a non-empty blob marks an entry smudged by writeIndex().
+  if (entry.size == 0 && entry.hash != kEmptyBlobId) {
+    return false;
+  }
+  struct stat st {};
+  if (lstat(entry.path.c_str(), &st) != 0) {
+    return false;
+  }
+  return entry.mtime_ns == timespecToNs(st.st_mtim) &&
+         entry.ctime_ns == timespecToNs(st.st_ctim) &&
+         entry.size == static_cast<uint64_t>(st.st_size) &&
+         entry.ino == static_cast<uint64_t>(st.st_ino) &&
+         entry.dev == static_cast<uint64_t>(st.st_dev);
+}
+
+bool IndexManager::isRacilyClean(const IndexEntry &entry) const {
+  // A file written in the same timestamp tick as the index may have changed
+  // after it was hashed without its stat data showing it.
+  return indexMtimeNs != 0 && entry.mtime_ns >= indexMtimeNs;
+}
+
+bool IndexManager::isUnchanged(const std::string &path) const {
+  IndexEntry mappedEntry;
+  const IndexEntry *entry = nullptr;
+  uint32_t position = 0;
+  if (view) {
+    if (!view->find(path, position)) {
+      return false;
+    }
+    mappedEntry = view->entryAt(position);
+    entry = &mappedEntry;
+  } else {
+    auto it = pathToIndex.find(path);
+    if (it == pathToIndex.end()) {
+      return false;
+    }
+    entry = &entries[it->second];
+  }
+  return entry->conflict_state == ConflictState::NONE &&
+         statDataMatches(*entry) && !isRacilyClean(*entry);
+}
+
+bool IndexManager::isTracked(const std::string &path) const {
+  uint32_t position = 0;
+  return view ? view->find(path, position) : pathToIndex.count(path) > 0;
+}
+
+bool IndexManager::mapIndex() {
+  std::string path = gitDir + "/index";
+  if (!IndexFileView::isBinaryIndex(path)) {
+    return readIndex();
+  }
+  std::unique_ptr<IndexFileView> mapped = IndexFileView::open(path);
+  if (!mapped || !mapped->verifyChecksum()) {
+    throw std::runtime_error("Index file is not in mgit format or is corrupt");
+  }
+  entries.clear();
+  pathToIndex.clear();
+  conflictMarkers.clear();
+  clearCaches();
+  indexMtimeNs = mapped->fileMtimeNs();
+  view = std::move(mapped);
+  return true;
+}
+
 bool IndexManager::readIndex() {
+  view.reset();
   std::string path = gitDir + "/index";
   if (!std::filesystem::exists(path)) {
     // Create an empty index file if it does not exist
@@ -77,6 +548,7 @@ bool IndexManager::readIndex() {
     entries.clear();
     pathToIndex.clear();
     conflictMarkers.clear();
+    clearCaches();
     return true;
   }
 
@@ -88,11 +560,59 @@ bool IndexManager::readIndex() {
     entries.clear();
     pathToIndex.clear();
     conflictMarkers.clear();
+    clearCaches();
     checkFile.close();
     return true;
   }
   checkFile.close();
 
+  if (!IndexFileView::isBinaryIndex(path)) {
+    clearCaches();
+    return readLegacyIndex(path);
+  }
+
+  std::unique_ptr<IndexFileView> view = IndexFileView::open(path);
+  if (!view || !view->verifyChecksum()) {
+    throw std::runtime_error("Index file is not in mgit format or is corrupt");
+  }
+  entries.clear();
+  pathToIndex.clear();
+  conflictMarkers.clear();
+  indexMtimeNs = view->fileMtimeNs();
+  entries.reserve(view->size());
+  pathToIndex.reserve(view->size());
+  for (uint32_t i = 0; i < view->size(); ++i) {
+    entries.push_back(view->entryAt(i));
+    pathToIndex.emplace(entries.back().path, i);
+  }
+  // A damaged cache is only a lost optimization.
+  if (!cacheTree.parse(view->extension(kCacheTreeSignature))) {
+    cacheTree.clear();
+  }
+  if (!untrackedCache.parse(view->extension(kUntrackedCacheSignature))) {
+    untrackedCache.clear();
+  }
+  fsmonitorToken.clear();
+  std::string_view fsmonitor = view->extension(kFsMonitorSignature);
+  size_t tokenEnd = fsmonitor.find('\0');
+  if (tokenEnd != std::string_view::npos &&
+      fsmonitor.size() - tokenEnd - 1 == (entries.size() + 7) / 8) {
+    fsmonitorToken = std::string(fsmonitor.substr(0, tokenEnd));
+    const char *bits = fsmonitor.data() + tokenEnd + 1;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      entries[i].fsmonitor_valid = (bits[i / 8] >> (i % 8)) & 1;
+    }
+  }
+  return true;
+}
+
+void IndexManager::clearCaches() {
+  cacheTree.clear();
+  untrackedCache.clear();
+  fsmonitorToken.clear();
+}
+
+bool IndexManager::readLegacyIndex(const std::string &path) {
   std::ifstream index;
   try {
     index.exceptions(std::ifstream::badbit); // Only throw on true I/O errors
@@ -119,14 +639,12 @@ bool IndexManager::readIndex() {
       }
       entry.mode = fields[0];
       entry.path = fields[1];
-      entry.hash = fields[2];
-      entry.base_hash = fields[3];
-      entry.their_hash = fields[4];
       conflict_state_int = std::stoi(fields[5]);
       entry.conflict_marker = fields[6] == "-" ? "" : fields[6];
       entry.conflict_state = static_cast<ConflictState>(conflict_state_int);
-      if (entry.hash.length() != 40 || entry.base_hash.length() != 40 ||
-          entry.their_hash.length() != 40) {
+      if (!ObjectId::parseHex(fields[2], entry.hash) ||
+          !ObjectId::parseHex(fields[3], entry.base_hash) ||
+          !ObjectId::parseHex(fields[4], entry.their_hash)) {
         throw std::runtime_error(
             "Index file is not in mgit format or is corrupt");
       }
@@ -146,6 +664,24 @@ bool IndexManager::readIndex() {
 
 void IndexManager::addOrUpdateEntry(const IndexEntry &entry) {
   auto it = pathToIndex.find(entry.path);
+  if (it != pathToIndex.end()) {
+    IndexEntry &existing = entries[it->second];
+    if (existing.hash == entry.hash && existing.mode == entry.mode &&
+        existing.conflict_state == ConflictState::NONE &&
+        entry.conflict_state == ConflictState::NONE) {
+      // Same content re-added (e.g. by "add ."): only the stat data is new,
+      // so the cached trees and directory listings stay valid.
+      existing.mtime_ns = entry.mtime_ns;
+      existing.ctime_ns = entry.ctime_ns;
+      existing.size = entry.size;
+      existing.ino = entry.ino;
+      existing.dev = entry.dev;
+      existing.fsmonitor_valid = entry.fsmonitor_valid;
+      return;
+    }
+  }
+  cacheTree.invalidate(entry.path);
+  untrackedCache.invalidate(entry.path);
   if (it != pathToIndex.end()) {
     entries[it->second] = entry;
   } else {
@@ -158,6 +694,22 @@ const std::vector<IndexEntry> &IndexManager::getEntries() const {
   return entries;
 }
 
+std::vector<const IndexEntry *> IndexManager::sortedEntries() const {
+  std::vector<const IndexEntry *> sorted;
+  sorted.reserve(entries.size());
+  for (const auto &entry : entries) {
+    sorted.push_back(&entry);
+  }
+  auto byPath = [](const IndexEntry *a, const IndexEntry *b) {
+    return a->path < b->path;
+  };
+  // Entries read from disk are already in order; only appended ones are not.
+  if (!std::is_sorted(sorted.begin(), sorted.end(), byPath)) {
+    std::sort(sorted.begin(), sorted.end(), byPath);
+  }
+  return sorted;
+}
+
 void IndexManager::printEntries() const {
   for (const auto &entry : entries) {
     std::cout << entry.mode << " " << entry.path << " " << entry.hash << " "
@@ -181,11 +733,11 @@ void IndexManager::recordConflict(const std::string &path,
   // Create conflict marker
   BlobObject blobObj(gitDir);
   std::string baseContent =
-      base.hash.empty() ? "" : blobObj.readObject(base.hash).content;
+      base.hash.isNull() ? "" : blobObj.readObject(base.hash).content;
   std::string ourContent =
-      ours.hash.empty() ? "" : blobObj.readObject(ours.hash).content;
+      ours.hash.isNull() ? "" : blobObj.readObject(ours.hash).content;
   std::string theirContent =
-      theirs.hash.empty() ? "" : blobObj.readObject(theirs.hash).content;
+      theirs.hash.isNull() ? "" : blobObj.readObject(theirs.hash).content;
 
   ConflictMarker marker = {baseContent, ourContent, theirContent};
 
@@ -228,7 +780,7 @@ bool IndexManager::isConflicted(const std::string &path) const {
 }
 
 bool IndexManager::resolveConflict(const std::string &path,
-                                   const std::string &hash) {
+                                   const ObjectId &id) {
   try {
     auto it = pathToIndex.find(path);
     if (it == pathToIndex.end()) {
@@ -236,7 +788,8 @@ bool IndexManager::resolveConflict(const std::string &path,
       return false;
     }
     IndexEntry &entry = entries[it->second];
-    entry.hash = hash;
+    entry.hash = id;
+    cacheTree.invalidate(path);
     entry.conflict_state = ConflictState::RESOLVED;
     entry.conflict_marker.clear();
     std::string markerPath = path + ".mgit-conflict";
@@ -244,9 +797,9 @@ bool IndexManager::resolveConflict(const std::string &path,
       std::filesystem::remove(markerPath);
     }
     BlobObject blobObj(gitDir);
-    std::string content = blobObj.readObject(hash).content;
+    ObjectView content = blobObj.readView(id);
     std::ofstream file(path);
-    file << content;
+    file << content.body();
     file.close();
     return true;
   } catch (const std::exception &e) {
@@ -267,6 +820,12 @@ void IndexManager::abortMerge() {
   }
 
   // Remove conflict entries from index
+  for (const auto &entry : entries) {
+    if (entry.conflict_state == ConflictState::UNRESOLVED) {
+      cacheTree.invalidate(entry.path);
+      untrackedCache.invalidate(entry.path);
+    }
+  }
   entries.erase(std::remove_if(entries.begin(), entries.end(),
                                [](const IndexEntry &entry) {
                                  return entry.conflict_state ==
@@ -303,149 +862,324 @@ IndexManager::getConflictMarker(const std::string &path) const {
 
 void IndexManager::writeIndex() {
   std::string path = gitDir + "/index";
-  std::ofstream index;
   try {
-    index.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-    index.open(path);
+    // Records are written in path order so readers can binary-search them.
+    std::vector<const IndexEntry *> sorted = sortedEntries();
+
+    auto buildImage = [this, &sorted]() {
+      std::string records;
+      std::string strings;
+      records.reserve(sorted.size() * kIndexRecordSize);
+      for (const IndexEntry *entry : sorted) {
+        std::string marker = entry->conflict_marker;
+        marker.erase(0, marker.find_first_not_of(" \t\n\r"));
+        marker.erase(marker.find_last_not_of(" \t\n\r") + 1);
+
+        uint32_t mode = 0;
+        try {
+          mode = static_cast<uint32_t>(std::stoul(entry->mode, nullptr, 8));
+        } catch (const std::exception &) {
+          throw std::runtime_error("Invalid mode '" + entry->mode + "' for " +
+                                   entry->path);
+        }
+        appendBE32(records, mode);
+        appendBE32(records, static_cast<uint32_t>(entry->conflict_state));
+        appendBE32(records, static_cast<uint32_t>(strings.size()));
+        appendBE32(records, static_cast<uint32_t>(entry->path.size()));
+        strings += entry->path;
+        strings.push_back('\0');
+        appendBE32(records, static_cast<uint32_t>(strings.size()));
+        appendBE32(records, static_cast<uint32_t>(marker.size()));
+        strings += marker;
+        strings.push_back('\0');
+        records.append(reinterpret_cast<const char *>(entry->hash.data()),
+                       kRawHashSize);
+        // As with the old text index, base/their hashes are not persisted.
+        records.append(kRawHashSize * 2, '\0');
+        appendBE64(records, static_cast<uint64_t>(entry->mtime_ns));
+        appendBE64(records, static_cast<uint64_t>(entry->ctime_ns));
+        appendBE64(records, entry->size);
+        appendBE64(records, entry->ino);
+        appendBE64(records, entry->dev);
+      }
 
-    auto sanitize = [](const std::string &s) -> std::string {
-      std::string out;
-      for (char c : s) {
-        if (c != '\n' && c != '\r' && c != '\t')
-          out += c;
+      std::string out(kIndexMagic, 4);
+      appendBE32(out, kIndexVersion);
+      appendBE32(out, static_cast<uint32_t>(sorted.size()));
+      appendBE32(out, kIndexRecordSize);
+      appendBE32(out, static_cast<uint32_t>(strings.size()));
+      out += records;
+      out += strings;
+      std::string tree;
+      cacheTree.serialize(tree);
+      out.append(kCacheTreeSignature, 4);
+      appendBE32(out, static_cast<uint32_t>(tree.size()));
+      out += tree;
+      std::string untracked;
+      untrackedCache.serialize(untracked);
+      out.append(kUntrackedCacheSignature, 4);
+      appendBE32(out, static_cast<uint32_t>(untracked.size()));
+      out += untracked;
+      if (!fsmonitorToken.empty()) {
+        std::string fsmonitor = fsmonitorToken;
+        fsmonitor.push_back('\0');
+        size_t bitsStart = fsmonitor.size();
+        fsmonitor.append((sorted.size() + 7) / 8, '\0');
+        for (size_t i = 0; i < sorted.size(); ++i) {
+          if (sorted[i]->fsmonitor_valid) {
+            fsmonitor[bitsStart + i / 8] |= static_cast<char>(1 << (i % 8));
+          }
+        }
+        out.append(kFsMonitorSignature, 4);
+        appendBE32(out, static_cast<uint32_t>(fsmonitor.size()));
+        out += fsmonitor;
       }
+      out += hash_sha1_raw(out);
       return out;
     };
 
-    for (auto entry : entries) {
-      entry.base_hash = std::string(40, '0');
-      entry.their_hash = std::string(40, '0');
-      std::string marker = entry.conflict_marker;
-      marker.erase(0, marker.find_first_not_of(" \t\n\r"));
-      marker.erase(marker.find_last_not_of(" \t\n\r") + 1);
-      if (marker.empty())
-        marker = "-";
-      std::string mode = sanitize(entry.mode);
-      std::string pathf = sanitize(entry.path);
-      std::string hash = sanitize(entry.hash).substr(0, 40);
-      std::string base_hash = sanitize(entry.base_hash).substr(0, 40);
-      std::string their_hash = sanitize(entry.their_hash).substr(0, 40);
-      std::string state =
-          std::to_string(static_cast<int>(entry.conflict_state));
-      std::string mark = sanitize(marker);
-      std::string line = mode + "\t" + pathf + "\t" + hash + "\t" + base_hash +
-                         "\t" + their_hash + "\t" + state + "\t" + mark;
-      index << line << "\n";
+    // Write a lock file and rename it so readers never see a partial index.
+    std::string lockPath = path + ".lock";
+    auto writeLock = [&lockPath](const std::string &out) {
+      std::ofstream index;
+      index.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+      index.open(lockPath, std::ios::binary | std::ios::trunc);
+      index.write(out.data(), static_cast<std::streamsize>(out.size()));
+      index.close();
+      struct stat st {};
+      if (stat(lockPath.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot stat " + lockPath);
+      }
+      return timespecToNs(st.st_mtim);
+    };
+    int64_t newMtimeNs = writeLock(buildImage());
+
+    // Entries modified in the same tick as the new index would look clean
+    // forever after; smudge their size so the next status rehashes them.
+    // Directories in the untracked cache are re-read for the same reason.
+    bool smudged = untrackedCache.invalidateNewerThan(newMtimeNs);
+    for (auto &entry : entries) {
+      if (entry.size != 0 && entry.mtime_ns >= newMtimeNs) {
+        entry.size = 0;
+        entry.fsmonitor_valid = false;
+        smudged = true;
+      }
     }
-    index.close();
+    if (smudged) {
+      newMtimeNs = writeLock(buildImage());
+    }
+    std::filesystem::rename(lockPath, path);
+    indexMtimeNs = newMtimeNs;
   } catch (const std::exception &e) {
     std::cerr << "Error writing index: " << e.what() << std::endl;
   }
 }
 
-StatusResult IndexManager::computeStatus(const std::string &headTreeHash) {
+StatusResult IndexManager::computeStatus(const ObjectId &headTree) {
   StatusResult result;
 
-  // 1. Get HEAD files
-  std::map<std::string, std::string> headFiles;
-  if (!headTreeHash.empty()) {
-    TreeObject tree(gitDir);
-    tree.getAllFiles(headTreeHash, headFiles);
-  }
-
-  // 2. Get Index files
+  // 1. Read the index
   readIndex();
-  std::map<std::string, std::string> indexFiles;
-  for (const auto &entry : entries) {
-    indexFiles[entry.path] = entry.hash;
+  std::vector<const IndexEntry *> sorted = sortedEntries();
+
+  // 2-3. Compare HEAD and Index for staged changes, reading only the HEAD
+  // subtrees the cache-tree cannot vouch for.
+  HeadIndexJoin join(gitDir, cacheTree, sorted, result);
+  join.run(headTree);
+  // MGIT_TRACE_CACHE_TREE=1 reports how much of HEAD had to be read.
+  const char *traceTree = std::getenv("MGIT_TRACE_CACHE_TREE");
+  if (traceTree && *traceTree && std::string(traceTree) != "0") {
+    std::cerr << "cache-tree: " << join.treesRead << " HEAD trees read, "
+              << join.subtreesSkipped << " subtrees skipped\n";
   }
 
-  // 3. Compare HEAD and Index for staged changes
-  std::map<std::string, std::string> headFilesCopy = headFiles;
-  for (const auto &[path, hash] : indexFiles) {
-    auto it = headFilesCopy.find(path);
-    if (it == headFilesCopy.end()) {
-      result.staged_changes.push_back({"new file", path});
-    } else {
-      if (it->second != hash) {
-        result.staged_changes.push_back({"modified", path});
-      }
-      headFilesCopy.erase(it);
-    }
+  // With an fsmonitor daemon running, only the paths it reports as changed
+  // since the saved token are looked at below.
+  FsMonitor::Changes changes = FsMonitor::query(gitDir, fsmonitorToken);
+  const bool monitored = !changes.token.empty();
+
+  // 4. Untracked files, minus ignored ones; ignored directories are not
+  // entered. Directories whose stat data is unchanged since the last status
+  // are only stat'ed, not read (see UntrackedCache), and those the daemon
+  // did not report are not even stat'ed.
+  WorkTreeScanner scanner(".");
+  WorkTreeScanner::UntrackedStats walkStats;
+  std::function<bool(const std::string &)> dirMayHaveChanged;
+  if (!changes.trivial) {
+    dirMayHaveChanged = [&changes](const std::string &dir) {
+      return changes.dirMayHaveChanged(dir);
+    };
   }
-  for (const auto &[path, hash] : headFilesCopy) {
-    result.staged_changes.push_back({"deleted", path});
+  result.untracked_files = scanner.listUntracked(
+      untrackedCache, IgnoreStack::forRepository(gitDir),
+      [this](const std::string &path) { return pathToIndex.count(path) != 0; },
+      walkStats, dirMayHaveChanged);
+  // MGIT_TRACE_UNTRACKED_CACHE=1 reports how many directories were read.
+  const char *trace = std::getenv("MGIT_TRACE_UNTRACKED_CACHE");
+  if (trace && *trace && std::string(trace) != "0") {
+    std::cerr << "untracked cache: " << walkStats.dirsRead << " of "
+              << walkStats.dirsChecked << " directories read\n";
   }
 
-  // 4. Compare Index and Working Directory for unstaged changes and untracked
-  // files
-  std::unordered_set<std::string> visited;
-  for (auto it = std::filesystem::recursive_directory_iterator(
-           ".", std::filesystem::directory_options::skip_permission_denied);
-       it != std::filesystem::recursive_directory_iterator(); ++it) {
-    const auto &file = *it;
-    if (file.is_directory()) {
-      if (file.path().filename() == ".git" ||
-          file.path().filename() == ".mgit") {
-        it.disable_recursion_pending();
-      }
-      continue;
+  // 5. Compare Index and Working Directory for unstaged changes. Only
+  // tracked files whose stat data changed (or that are racily clean) need
+  // to be read and hashed again; that work is spread across threads.
+  enum class FileState {
+    Unchecked, // known clean from the fsmonitor
+    Clean,
+    Modified,
+    Deleted,
+    Refreshed,
+    Other // not a regular file
+  };
+  std::vector<size_t> candidates;
+  candidates.reserve(entries.size());
+  for (const IndexEntry *entry : sorted) {
+    candidates.push_back(static_cast<size_t>(entry - entries.data()));
+  }
+  std::vector<FileState> states(candidates.size(), FileState::Clean);
+  std::vector<IndexEntry> refreshedEntries(candidates.size());
+  scanner.parallelFor(candidates.size(), [&](size_t i) {
+    const IndexEntry &entry = entries[candidates[i]];
+    if (!changes.trivial && entry.fsmonitor_valid &&
+        !changes.mayHaveChanged(entry.path)) {
+      states[i] = FileState::Unchecked;
+      return;
     }
-
-    std::string pathStr = file.path().lexically_normal().string();
-    std::replace(pathStr.begin(), pathStr.end(), '\\', '/');
-    if (pathStr.rfind("./", 0) == 0) {
-      pathStr = pathStr.substr(2);
+    if (statDataMatches(entry) && !isRacilyClean(entry)) {
+      return;
     }
-
-    visited.insert(pathStr);
-
-    auto index_it = indexFiles.find(pathStr);
-    if (index_it == indexFiles.end()) {
-      result.untracked_files.push_back(pathStr);
-      continue;
+    struct stat st {};
+    if (stat(entry.path.c_str(), &st) != 0) {
+      states[i] = FileState::Deleted;
+      return;
+    }
+    if (!S_ISREG(st.st_mode)) {
+      states[i] = FileState::Other; // e.g. replaced by a directory
+      return;
     }
-
     BlobObject obj(gitDir);
-    std::string currHash = obj.writeObject(pathStr, false);
+    ObjectId current = obj.writeObject(entry.path, false);
+    if (current != entry.hash) {
+      states[i] = FileState::Modified;
+      return;
+    }
+    refreshedEntries[i].path = entry.path;
+    if (fillStatData(refreshedEntries[i])) {
+      states[i] = FileState::Refreshed;
+    }
+  });
 
-    if (currHash != index_it->second) {
-      result.unstaged_changes.push_back({"modified", pathStr});
+  bool refreshed = walkStats.changed || join.primed;
+  size_t checked = 0;
+  std::vector<std::string> deleted;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    IndexEntry &entry = entries[candidates[i]];
+    checked += states[i] != FileState::Unchecked;
+    if (monitored) {
+      bool valid = states[i] == FileState::Unchecked ||
+                   states[i] == FileState::Clean ||
+                   states[i] == FileState::Refreshed;
+      refreshed |= entry.fsmonitor_valid != valid;
+      entry.fsmonitor_valid = valid;
+    }
+    if (states[i] == FileState::Modified) {
+      result.unstaged_changes.push_back({"modified", entry.path});
+    } else if (states[i] == FileState::Deleted) {
+      deleted.push_back(entry.path);
+    } else if (states[i] == FileState::Refreshed) {
+      const IndexEntry &fresh = refreshedEntries[i];
+      entry.mtime_ns = fresh.mtime_ns;
+      entry.ctime_ns = fresh.ctime_ns;
+      entry.size = fresh.size;
+      entry.ino = fresh.ino;
+      entry.dev = fresh.dev;
+      refreshed = true;
     }
   }
+  for (const auto &path : deleted) {
+    result.unstaged_changes.push_back({"deleted", path});
+  }
 
-  // Check for deleted files (in index but not in workdir)
-  for (const auto &[path, hash] : indexFiles) {
-    if (visited.find(path) == visited.end()) {
-      if (!std::filesystem::exists(path)) {
-        result.unstaged_changes.push_back({"deleted", path});
-      }
-    }
+  // The new token is saved along with anything else that changed. On its
+  // own it is only worth a write when the index had none, or when the
+  // daemon's answers grow long; keeping an older token is always safe.
+  if (monitored) {
+    refreshed |= fsmonitorToken.empty() ||
+                 changes.reported() > kFsMonitorSaveThreshold;
+    fsmonitorToken = changes.token;
+  }
+  // MGIT_TRACE_FSMONITOR=1 reports what the daemon said.
+  const char *traceMonitor = std::getenv("MGIT_TRACE_FSMONITOR");
+  if (traceMonitor && *traceMonitor && std::string(traceMonitor) != "0") {
+    std::cerr << "fsmonitor: "
+              << (!monitored        ? std::string("no daemon")
+                  : changes.trivial ? std::string("full scan")
+                                    : std::to_string(changes.reported()) +
+                                          " paths reported")
+              << ", " << checked << " of " << candidates.size()
+              << " entries checked\n";
+  }
+
+  // Save the refreshed stat data and untracked cache so unchanged files are
+  // not hashed, nor unchanged directories read, again.
+  if (refreshed) {
+    writeIndex();
   }
   return result;
 }
 
-void IndexManager::resetFromTree(const std::string &treeHash) {
+bool IndexManager::listChangedFiles(const IgnoreStack::Ptr &ignore,
+                                    std::vector<std::string> &files) {
+  FsMonitor::Changes changes = FsMonitor::query(gitDir, fsmonitorToken);
+  if (changes.trivial) {
+    return false;
+  }
+  WorkTreeScanner scanner(".");
+  WorkTreeScanner::UntrackedStats walkStats;
+  files = scanner.listUntracked(
+      untrackedCache, ignore,
+      [this](const std::string &path) { return pathToIndex.count(path) != 0; },
+      walkStats, [&changes](const std::string &dir) {
+        return changes.dirMayHaveChanged(dir);
+      });
+  for (auto &entry : entries) {
+    if (entry.fsmonitor_valid && !changes.mayHaveChanged(entry.path)) {
+      continue;
+    }
+    // Whether or not it is hashed now, the next status checks it again.
+    entry.fsmonitor_valid = false;
+    struct stat st {};
+    if ((!statDataMatches(entry) || isRacilyClean(entry)) &&
+        stat(entry.path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      files.push_back(entry.path);
+    }
+  }
+  std::sort(files.begin(), files.end());
+  fsmonitorToken = changes.token;
+  return true;
+}
+
+void IndexManager::resetFromTree(const ObjectId &treeId) {
   entries.clear();
   pathToIndex.clear();
   conflictMarkers.clear();
+  clearCaches();
 
-  if (treeHash.empty()) {
+  if (treeId.isNull()) {
     writeIndex(); // Write an empty index
     return;
   }
 
   TreeObject tree(gitDir);
-  std::map<std::string, std::string> files;
-  tree.getAllFiles(treeHash, files);
+  std::map<std::string, ObjectId> files;
+  tree.getAllFiles(treeId, files);
 
   for (const auto &[path, hash] : files) {
     IndexEntry entry;
     entry.mode = "100644"; // Assuming file, which is what getAllFiles returns
     entry.path = path;
     entry.hash = hash;
-    entry.base_hash = std::string(40, '0');
-    entry.their_hash = std::string(40, '0');
     entry.conflict_state = ConflictState::NONE;
     entry.conflict_marker = "";
     addOrUpdateEntry(entry);
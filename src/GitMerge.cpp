@@ -51,17 +51,10 @@ GitMerge::~GitMerge() {
   index.reset();
 }
 
-bool GitMerge::validateCommit(const std::string &commitHash) {
+bool GitMerge::validateCommit(const ObjectId &commit) {
   try {
-    if (commitHash.empty()) {
-      throw MergeException("Commit hash cannot be empty");
-    }
-    if (commitHash.size() != 40) {
-      throw MergeException("Invalid commit hash length: " +
-                           std::to_string(commitHash.size()));
-    }
-    if (!std::all_of(commitHash.begin(), commitHash.end(), ::isxdigit)) {
-      throw MergeException("Invalid commit hash format");
+    if (commit.isNull()) {
+      throw MergeException("Commit hash cannot be null");
     }
     return true;
   } catch (const std::exception &e) {
@@ -100,12 +93,12 @@ bool GitMerge::validatePath(const std::string &path) {
   }
 }
 
-std::string GitMerge::getBlobContent(const std::string &hash) {
-  if (hash.empty())
+std::string GitMerge::getBlobContent(const ObjectId &id) {
+  if (id.isNull())
     return "";
 
   BlobObject blob(gitDir);
-  BlobData data = blob.readObject(hash);
+  BlobData data = blob.readObject(id);
   // return data.content;
   if (data.content.empty()) {
     throw std::runtime_error("Failed to read blob content");
@@ -138,10 +131,9 @@ std::string GitMerge::mergeFileContents(const std::string &baseContent,
   return result.str();
 }
 
-bool GitMerge::mergeTrees(const std::string &currentTree,
-                          const std::string &targetTree,
-                          const std::string &ancestorTree,
-                          std::string &mergedTreeHash) {
+bool GitMerge::mergeTrees(const ObjectId &currentTree,
+                          const ObjectId &targetTree,
+                          const ObjectId &ancestorTree, ObjectId &mergedTree) {
   try {
     // Get tree objects
     TreeObject tree(gitDir);
@@ -150,7 +142,7 @@ bool GitMerge::mergeTrees(const std::string &currentTree,
     std::vector<TreeEntry> ancestorEntries = tree.readObject(ancestorTree);
 
     // Convert to map for easier processing
-    std::map<std::string, std::string> currentMap, targetMap, ancestorMap;
+    std::map<std::string, ObjectId> currentMap, targetMap, ancestorMap;
     for (const auto &entry : currentEntries) {
       currentMap[entry.filename] = entry.hash;
     }
@@ -168,7 +160,7 @@ bool GitMerge::mergeTrees(const std::string &currentTree,
     for (const auto &[path, currentHash] : currentMap) {
       if (targetMap.find(path) != targetMap.end()) {
         // Both branches modified
-        std::string baseHash = ancestorMap[path];
+        ObjectId baseHash = ancestorMap[path];
         std::string ourContent = getBlobContent(currentHash);
         std::string theirContent = getBlobContent(targetMap[path]);
         std::string baseContent = getBlobContent(baseHash);
@@ -176,7 +168,7 @@ bool GitMerge::mergeTrees(const std::string &currentTree,
         std::string mergedContent =
             mergeFileContents(baseContent, ourContent, theirContent);
         BlobObject blobObj(gitDir);
-        std::string mergedHash = blobObj.writeObject(mergedContent, true);
+        ObjectId mergedHash = blobObj.writeObject(mergedContent, true);
         newTree << "100644 " << mergedHash << "\0" << path;
       } else if (ancestorMap.find(path) == ancestorMap.end()) {
         // Only current branch modified
@@ -192,7 +184,7 @@ bool GitMerge::mergeTrees(const std::string &currentTree,
     }
 
     // Create new tree object
-    mergedTreeHash = tree.writeObject(newTree.str());
+    mergedTree = tree.writeObject(newTree.str());
     return true;
   } catch (const std::exception &e) {
     std::cerr << "Tree merge failed: " << e.what() << "\n";
@@ -200,9 +192,9 @@ bool GitMerge::mergeTrees(const std::string &currentTree,
   }
 }
 
-bool GitMerge::threeWayMerge(const std::string &currentCommit,
-                             const std::string &targetCommit,
-                             const std::string &commonAncestor) {
+bool GitMerge::threeWayMerge(const ObjectId &currentCommit,
+                             const ObjectId &targetCommit,
+                             const ObjectId &commonAncestor) {
   try {
     // Get tree hashes
     CommitObject commit(gitDir);
@@ -211,7 +203,7 @@ bool GitMerge::threeWayMerge(const std::string &currentCommit,
     CommitData ancestorTreeCommit = commit.readObject(commonAncestor);
 
     // Merge trees
-    std::string mergedTree;
+    ObjectId mergedTree;
     if (!mergeTrees(currentTreeCommit.tree, targetTreeCommit.tree,
                     ancestorTreeCommit.tree, mergedTree)) {
       throw std::runtime_error("Failed to merge trees");
@@ -238,32 +230,32 @@ bool GitMerge::checkForConflicts(const std::string &currentBranch,
   GitRepository repo(gitDir);
 
   // Get tree hashes for both branches
-  std::string currentHead = repo.getHashOfBranchHead(currentBranch);
-  std::string targetHead = repo.getHashOfBranchHead(targetBranch);
+  ObjectId currentHead = repo.getHashOfBranchHead(currentBranch);
+  ObjectId targetHead = repo.getHashOfBranchHead(targetBranch);
 
-  if (currentHead.empty() || targetHead.empty()) {
+  if (currentHead.isNull() || targetHead.isNull()) {
     throw MergeException("One or both branches have no commits");
   }
 
   // Get tree objects from commits
   CommitObject commitObj(gitDir);
   CommitData currentCommitData = commitObj.readObject(currentHead);
-  std::string currentTreeHash = currentCommitData.tree;
+  ObjectId currentTreeHash = currentCommitData.tree;
   validateTreeHash(currentTreeHash);
 
   CommitData targetCommitData = commitObj.readObject(targetHead);
-  std::string targetTreeHash = targetCommitData.tree;
+  ObjectId targetTreeHash = targetCommitData.tree;
   validateTreeHash(targetTreeHash);
 
   // Find common ancestor (for three-way merge)
-  std::string commonAncestor = repo.findCommonAncestor(currentHead, targetHead);
-  std::string ancestorTreeHash;
-  if (!commonAncestor.empty()) {
+  ObjectId commonAncestor = repo.findCommonAncestor(currentHead, targetHead);
+  ObjectId ancestorTreeHash;
+  if (!commonAncestor.isNull()) {
     CommitData ancestorCommitData = commitObj.readObject(commonAncestor);
     ancestorTreeHash = ancestorCommitData.tree;
   }
 
-  if (!ancestorTreeHash.empty()) {
+  if (!ancestorTreeHash.isNull()) {
     validateTreeHash(ancestorTreeHash);
   }
 
@@ -283,20 +275,13 @@ bool GitMerge::checkForConflicts(const std::string &currentBranch,
   return !conflicts.empty();
 }
 
-bool GitMerge::validateTreeHash(const std::string &treeHash) {
+bool GitMerge::validateTreeHash(const ObjectId &tree) {
   try {
-    if (treeHash.empty()) {
-      throw MergeException("Tree hash cannot be empty");
-    }
-    if (treeHash.size() != 40) {
-      throw MergeException("Invalid tree hash length: " +
-                           std::to_string(treeHash.size()));
+    if (tree.isNull()) {
+      throw MergeException("Tree hash cannot be null");
     }
-    if (!std::all_of(treeHash.begin(), treeHash.end(), ::isxdigit)) {
-      throw MergeException("Invalid tree hash format");
-    }
-    if (storage->readObject(treeHash).empty()) {
-      throw MergeException("Tree object not found: " + treeHash);
+    if (storage->readObject(tree).empty()) {
+      throw MergeException("Tree object not found: " + tree.hex());
     }
     return true;
   } catch (const std::exception &e) {
@@ -305,21 +290,14 @@ bool GitMerge::validateTreeHash(const std::string &treeHash) {
   }
 }
 
-bool GitMerge::validateBlobHash(const std::string &blobHash) {
+bool GitMerge::validateBlobHash(const ObjectId &blob) {
   try {
-    if (blobHash.empty()) {
-      throw MergeException("Blob hash cannot be empty");
-    }
-    if (blobHash.size() != 40) {
-      throw MergeException("Invalid blob hash length: " +
-                           std::to_string(blobHash.size()));
-    }
-    if (!std::all_of(blobHash.begin(), blobHash.end(), ::isxdigit)) {
-      throw MergeException("Invalid blob hash format");
+    if (blob.isNull()) {
+      throw MergeException("Blob hash cannot be null");
     }
     BlobObject blobObj(gitDir);
-    if (blobObj.readObject(blobHash).content.empty()) {
-      throw MergeException("Blob object not found: " + blobHash);
+    if (blobObj.readView(blob).size() == 0) {
+      throw MergeException("Blob object not found: " + blob.hex());
     }
     return true;
   } catch (const std::exception &e) {
@@ -348,8 +326,7 @@ std::string GitMerge::getConflictDetails(const std::string &filename) {
   return it != conflictDetails.end() ? it->second : "";
 }
 
-bool GitMerge::compareTrees(const std::string &tree1,
-                            const std::string &tree2) {
+bool GitMerge::compareTrees(const ObjectId &tree1, const ObjectId &tree2) {
   GitObjectStorage storage(gitDir);
 
   // Get tree entries
@@ -405,21 +382,20 @@ bool GitMerge::compareTrees(const std::string &tree1,
   return conflicts.empty();
 }
 
-bool GitMerge::compareBlobs(const std::string &blob1,
-                            const std::string &blob2) {
+bool GitMerge::compareBlobs(const ObjectId &blob1, const ObjectId &blob2) {
   GitObjectStorage storage(gitDir);
 
   // Get blob contents
   BlobObject blobObj(gitDir);
-  std::string content1 = blobObj.readObject(blob1).content;
-  std::string content2 = blobObj.readObject(blob2).content;
+  ObjectView content1 = blobObj.readView(blob1);
+  ObjectView content2 = blobObj.readView(blob2);
 
   // Compare contents
-  return content1 == content2;
+  return content1.body() == content2.body();
 }
 
-bool GitMerge::findConflictsInTree(const std::string &tree1,
-                                   const std::string &tree2) {
+bool GitMerge::findConflictsInTree(const ObjectId &tree1,
+                                   const ObjectId &tree2) {
   try {
     return !compareTreeEntries(tree1, tree2, true);
   } catch (const std::exception &e) {
@@ -428,8 +404,8 @@ bool GitMerge::findConflictsInTree(const std::string &tree1,
   }
 }
 
-bool GitMerge::findConflictsInBlob(const std::string &blob1,
-                                   const std::string &blob2,
+bool GitMerge::findConflictsInBlob(const ObjectId &blob1,
+                                   const ObjectId &blob2,
                                    const std::string &filename) {
   try {
     if (!compareBlobs(blob1, blob2)) {
@@ -444,8 +420,8 @@ bool GitMerge::findConflictsInBlob(const std::string &blob1,
   }
 }
 
-bool GitMerge::detectFileRenames(const std::string &tree1,
-                                 const std::string &tree2) {
+bool GitMerge::detectFileRenames(const ObjectId &tree1,
+                                 const ObjectId &tree2) {
   try {
     (void)tree1;
     (void)tree2;
@@ -457,8 +433,8 @@ bool GitMerge::detectFileRenames(const std::string &tree1,
   }
 }
 
-bool GitMerge::detectDirectoryConflicts(const std::string &tree1,
-                                        const std::string &tree2) {
+bool GitMerge::detectDirectoryConflicts(const ObjectId &tree1,
+                                        const ObjectId &tree2) {
   try {
     return !compareTreeEntries(tree1, tree2, true);
   } catch (const std::exception &e) {
@@ -467,21 +443,25 @@ bool GitMerge::detectDirectoryConflicts(const std::string &tree1,
   }
 }
 
-bool GitMerge::compareTreeEntries(const std::string &tree1,
-                                  const std::string &tree2, bool recursive) {
+bool GitMerge::compareTreeEntries(const ObjectId &tree1,
+                                  const ObjectId &tree2, bool recursive) {
   try {
-    std::vector<TreeEntry> entries1 = TreeObject(gitDir).readObject(tree1);
-    std::vector<TreeEntry> entries2 = TreeObject(gitDir).readObject(tree2);
-    std::map<std::string, TreeEntry> map1, map2;
-    for (const auto &entry : entries1)
-      map1[entry.filename] = entry;
-    for (const auto &entry : entries2)
-      map2[entry.filename] = entry;
+    TreeObject treeObj(gitDir);
+    static const ParsedTree emptyTree;
+    TreeCache::Tree parsed1 = treeObj.readParsedTree(tree1);
+    TreeCache::Tree parsed2 = treeObj.readParsedTree(tree2);
+    const ParsedTree &entries1 = parsed1 ? *parsed1 : emptyTree;
+    const ParsedTree &entries2 = parsed2 ? *parsed2 : emptyTree;
+
+    std::unordered_map<std::string_view, const ParsedTreeEntry *> unmatched;
+    for (const auto &entry : entries2.entries)
+      unmatched[entry.name] = &entry;
 
     bool equal = true;
-    for (const auto &[name, entry1] : map1) {
-      auto it2 = map2.find(name);
-      if (it2 == map2.end()) {
+    for (const auto &entry1 : entries1.entries) {
+      const std::string name(entry1.filename());
+      auto it2 = unmatched.find(entry1.name);
+      if (it2 == unmatched.end()) {
         conflicts[name] = ConflictStatus::DELETED_IN_THEIRS;
         conflictDetails[name] =
             "File exists in current branch but deleted in target branch";
@@ -489,7 +469,8 @@ bool GitMerge::compareTreeEntries(const std::string &tree1,
         continue;
       }
 
-      const auto &entry2 = it2->second;
+      const ParsedTreeEntry &entry2 = *it2->second;
+      unmatched.erase(it2);
       if (entry1.mode != entry2.mode) {
         conflicts[name] = ConflictStatus::TREE_CONFLICT;
         conflictDetails[name] = "File mode/type differs";
@@ -497,23 +478,24 @@ bool GitMerge::compareTreeEntries(const std::string &tree1,
         continue;
       }
 
-      if (entry1.mode == "040000" && recursive) {
-        if (!compareTreeEntries(entry1.hash, entry2.hash, true)) {
+      if (entry1.id == entry2.id) {
+        continue; // identical blob or subtree
+      }
+      if (entry1.isTree() && recursive) {
+        if (!compareTreeEntries(entry1.id, entry2.id, true)) {
           equal = false;
         }
-      } else if (entry1.hash != entry2.hash) {
-        findConflictsInBlob(entry1.hash, entry2.hash, name);
+      } else {
+        findConflictsInBlob(entry1.id, entry2.id, name);
         equal = false;
       }
     }
 
-    for (const auto &[name, _entry2] : map2) {
-      if (map1.find(name) == map1.end()) {
-        conflicts[name] = ConflictStatus::DELETED_IN_OURS;
-        conflictDetails[name] =
-            "File exists in target branch but deleted in current branch";
-        equal = false;
-      }
+    for (const auto &[name, _entry2] : unmatched) {
+      conflicts[std::string(name)] = ConflictStatus::DELETED_IN_OURS;
+      conflictDetails[std::string(name)] =
+          "File exists in target branch but deleted in current branch";
+      equal = false;
     }
     return equal;
   } catch (const std::exception &e) {
@@ -0,0 +1,187 @@
+#include "headers/GitMergeBase.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+const uint8_t kParent1 = 1;
+const uint8_t kParent2 = 2;
+const uint8_t kStale = 4;
+const uint8_t kResult = 8;
+
+struct WalkCommit {
+  CommitInfo info;
+  uint8_t flags = 0;
+};
+
+// Commits loaded during one walk. Map nodes never move, so pointers to
+// entries stay valid while the walk adds more.
+class CommitSet {
+public:
+  explicit CommitSet(const CommitLookup &lookup) : lookup(lookup) {}
+
+  // Null if the commit cannot be read.
+  WalkCommit *get(const ObjectId &id) {
+    auto it = commits.find(id);
+    if (it != commits.end()) {
+      return it->second.get();
+    }
+    std::unique_ptr<WalkCommit> commit(new WalkCommit());
+    if (!lookup(id, commit->info)) {
+      commits.emplace(id, nullptr);
+      return nullptr;
+    }
+    return commits.emplace(id, std::move(commit)).first->second.get();
+  }
+
+private:
+  const CommitLookup &lookup;
+  std::unordered_map<ObjectId, std::unique_ptr<WalkCommit>> commits;
+};
+
+struct QueueItem {
+  WalkCommit *commit;
+  ObjectId id;
+  bool staleWhenQueued;
+};
+
+// Highest generation first; date breaks ties (and orders commits that are
+// not in the commit-graph).
+struct LowerPriority {
+  bool operator()(const QueueItem &a, const QueueItem &b) const {
+    if (a.commit->info.generation != b.commit->info.generation) {
+      return a.commit->info.generation < b.commit->info.generation;
+    }
+    return a.commit->info.commitTime < b.commit->info.commitTime;
+  }
+};
+
+} // namespace
+
+bool isAncestor(const ObjectId &ancestor, const ObjectId &descendant,
+                const CommitLookup &lookup) {
+  if (ancestor == descendant) {
+    return true;
+  }
+  CommitInfo target;
+  if (!lookup(ancestor, target)) {
+    return false;
+  }
+  // Only commits at or above the ancestor's generation can reach it.
+  uint32_t minGeneration = target.generation == CommitGraph::kGenerationInfinity
+                               ? 0
+                               : target.generation;
+  std::unordered_set<ObjectId> seen = {descendant};
+  std::vector<ObjectId> pending = {descendant};
+  CommitInfo info;
+  while (!pending.empty()) {
+    ObjectId id = pending.back();
+    pending.pop_back();
+    if (!lookup(id, info) || info.generation < minGeneration) {
+      continue;
+    }
+    for (const auto &parent : info.parents) {
+      if (parent == ancestor) {
+        return true;
+      }
+      if (seen.insert(parent).second) {
+        pending.push_back(parent);
+      }
+    }
+  }
+  return false;
+}
+
+std::vector<ObjectId> findMergeBases(const ObjectId &a, const ObjectId &b,
+                                     const CommitLookup &lookup) {
+  CommitSet commits(lookup);
+  WalkCommit *first = commits.get(a);
+  WalkCommit *second = commits.get(b);
+  if (!first || !second) {
+    return {};
+  }
+  if (a == b) {
+    return {a};
+  }
+
+  std::priority_queue<QueueItem, std::vector<QueueItem>, LowerPriority> queue;
+  size_t nonStale = 0;
+  auto push = [&](WalkCommit *commit, const ObjectId &id) {
+    bool stale = commit->flags & kStale;
+    queue.push({commit, id, stale});
+    if (!stale) {
+      ++nonStale;
+    }
+  };
+  first->flags |= kParent1;
+  second->flags |= kParent2;
+  push(first, a);
+  push(second, b);
+
+  std::vector<ObjectId> results;
+  std::vector<WalkCommit *> resultCommits;
+  // Once every queued commit is stale, nothing left can be a better base.
+  while (nonStale > 0) {
+    QueueItem item = queue.top();
+    queue.pop();
+    if (!item.staleWhenQueued) {
+      --nonStale;
+    }
+    WalkCommit *commit = item.commit;
+    uint8_t flags = commit->flags & (kParent1 | kParent2 | kStale);
+    if ((flags & (kParent1 | kParent2)) == (kParent1 | kParent2)) {
+      if (!(commit->flags & kResult)) {
+        commit->flags |= kResult;
+        results.push_back(item.id);
+        resultCommits.push_back(commit);
+      }
+      flags |= kStale;
+    }
+    for (const auto &parentId : commit->info.parents) {
+      WalkCommit *parent = commits.get(parentId);
+      if (!parent || (parent->flags & flags) == flags) {
+        continue;
+      }
+      parent->flags |= flags;
+      push(parent, parentId);
+    }
+  }
+
+  // A result reached again from another result is an ancestor of it.
+  std::vector<ObjectId> bases;
+  std::vector<int64_t> times;
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (!(resultCommits[i]->flags & kStale)) {
+      bases.push_back(results[i]);
+      times.push_back(resultCommits[i]->info.commitTime);
+    }
+  }
+  if (bases.size() > 1) {
+    std::vector<bool> redundant(bases.size(), false);
+    for (size_t i = 0; i < bases.size(); ++i) {
+      for (size_t j = 0; j < bases.size() && !redundant[i]; ++j) {
+        if (i != j && !redundant[j] && isAncestor(bases[i], bases[j], lookup)) {
+          redundant[i] = true;
+        }
+      }
+    }
+    std::vector<std::pair<int64_t, ObjectId>> kept;
+    for (size_t i = 0; i < bases.size(); ++i) {
+      if (!redundant[i]) {
+        kept.emplace_back(times[i], bases[i]);
+      }
+    }
+    // Newest first, like git merge-base --all.
+    std::stable_sort(kept.begin(), kept.end(),
+                     [](const auto &x, const auto &y) { return x.first > y.first; });
+    bases.clear();
+    for (const auto &entry : kept) {
+      bases.push_back(entry.second);
+    }
+  }
+  return bases;
+}
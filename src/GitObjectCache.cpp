@@ -0,0 +1,95 @@
+#include "headers/GitObjectCache.hpp"
+#include "headers/GitConfig.hpp"
+#include <filesystem>
+#include <map>
+
+std::shared_ptr<ObjectCache> ObjectCache::forGitDir(const std::string &gitDir) {
+  static std::mutex registryMutex;
+  static std::map<std::string, std::shared_ptr<ObjectCache>> registry;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = registry.find(gitDir);
+  if (it != registry.end()) {
+    return it->second;
+  }
+  size_t budget = kDefaultBudget;
+  if (std::filesystem::exists(gitDir + "/config")) {
+    budget = GitConfig(gitDir).getByteSize("core.objectCacheSize", budget);
+  }
+  std::shared_ptr<ObjectCache> cache(new ObjectCache(budget));
+  registry[gitDir] = cache;
+  return cache;
+}
+
+ObjectCache::ObjectCache(size_t budget) : budget(budget) {}
+
+ObjectCache::Object ObjectCache::get(const ObjectId &id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(id);
+  if (it == index.end()) {
+    ++misses;
+    return nullptr;
+  }
+  ++hits;
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+void ObjectCache::put(const ObjectId &id, std::string object) {
+  put(id, std::make_shared<const std::string>(std::move(object)));
+}
+
+void ObjectCache::put(const ObjectId &id, Object object) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!object || object->size() > budget / 4 || index.count(id)) {
+    return;
+  }
+  bytes += object->size();
+  lru.emplace_front(id, std::move(object));
+  index[id] = lru.begin();
+  evictLocked(budget);
+}
+
+void ObjectCache::erase(const ObjectId &id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(id);
+  if (it == index.end()) {
+    return;
+  }
+  bytes -= it->second->second->size();
+  lru.erase(it->second);
+  index.erase(it);
+}
+
+void ObjectCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  lru.clear();
+  index.clear();
+  bytes = 0;
+}
+
+void ObjectCache::setBudget(size_t newBudget) {
+  std::lock_guard<std::mutex> lock(mutex);
+  budget = newBudget;
+  evictLocked(budget);
+}
+
+ObjectCache::Stats ObjectCache::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  Stats result;
+  result.hits = hits;
+  result.misses = misses;
+  result.evictions = evictions;
+  result.entries = index.size();
+  result.bytes = bytes;
+  result.budget = budget;
+  return result;
+}
+
+void ObjectCache::evictLocked(size_t limit) {
+  while (bytes > limit && !lru.empty()) {
+    bytes -= lru.back().second->size();
+    index.erase(lru.back().first);
+    lru.pop_back();
+    ++evictions;
+  }
+}
@@ -1,39 +1,60 @@
 #include "headers/GitObjectStorage.hpp"
+#include "headers/GitConfig.hpp"
+#include "headers/GitObjectCache.hpp"
+#include "headers/GitPackFile.hpp"
 #include "headers/HashUtils.hpp"
 #include "headers/ZlibUtils.hpp"
 #include <algorithm>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 GitObjectStorage::GitObjectStorage(const std::string &gitDir)
-    : gitDir(gitDir) {}
+    : gitDir(gitDir), cache(ObjectCache::forGitDir(gitDir)) {}
 
-bool GitObjectStorage::writeObject(const std::string &hash,
+bool GitObjectStorage::writeObject(const ObjectId &id,
                                    const std::string &content) {
   try {
-    if (hash.empty()) {
-      throw StorageException("Hash cannot be empty");
+    if (id.isNull()) {
+      throw StorageException("Object ID cannot be null");
     }
     if (content.empty()) {
       throw StorageException("Content cannot be empty");
     }
 
-    std::string objectPath = getObjectPath(hash);
+    std::string objectPath = getObjectPath(id);
     std::filesystem::create_directories(
         std::filesystem::path(objectPath).parent_path());
 
-    std::ofstream objectFile(objectPath);
+    // Write under a unique name and rename, so concurrent writers of the
+    // same object (e.g. parallel add) never expose a partial file.
+    std::ostringstream tmpName;
+    tmpName << objectPath << ".tmp-" << getpid() << "-"
+            << std::this_thread::get_id();
+    std::string tmpPath = tmpName.str();
+    std::ofstream objectFile(tmpPath, std::ios::binary | std::ios::trunc);
     if (!objectFile.is_open()) {
       throw StorageException("Failed to create object file: " + objectPath);
     }
 
     objectFile << content;
     objectFile.close();
+    if (!objectFile) {
+      std::filesystem::remove(tmpPath);
+      throw StorageException("Failed to write object file: " + objectPath);
+    }
+    std::filesystem::rename(tmpPath, objectPath);
 
     return true;
   } catch (const std::exception &e) {
@@ -42,20 +63,25 @@ bool GitObjectStorage::writeObject(const std::string &hash,
   }
 }
 
-bool GitObjectStorage::deleteObject(const std::string &hash) {
+bool GitObjectStorage::deleteObject(const ObjectId &id) {
   try {
-    if (hash.empty()) {
-      throw StorageException("Hash cannot be empty");
+    if (id.isNull()) {
+      throw StorageException("Object ID cannot be null");
     }
 
-    std::string objectPath = getObjectPath(hash);
+    std::string objectPath = getObjectPath(id);
     if (!std::filesystem::exists(objectPath)) {
-      throw StorageException("Object does not exist: " + hash);
+      if (PackStore::forGitDir(gitDir)->contains(id)) {
+        throw StorageException("Object is packed and cannot be deleted: " +
+                               id.hex());
+      }
+      throw StorageException("Object does not exist: " + id.hex());
     }
 
     if (!std::filesystem::remove(objectPath)) {
-      throw StorageException("Failed to delete object: " + hash);
+      throw StorageException("Failed to delete object: " + id.hex());
     }
+    cache->erase(id);
 
     return true;
   } catch (const std::exception &e) {
@@ -64,13 +90,16 @@ bool GitObjectStorage::deleteObject(const std::string &hash) {
   }
 }
 
-bool GitObjectStorage::objectExists(const std::string &hash) {
+bool GitObjectStorage::objectExists(const ObjectId &id) {
   try {
-    if (hash.empty()) {
+    if (id.isNull()) {
       return false;
     }
 
-    std::string objectPath = getObjectPath(hash);
+    if (PackStore::forGitDir(gitDir)->contains(id)) {
+      return true;
+    }
+    std::string objectPath = getObjectPath(id);
     return std::filesystem::exists(objectPath);
   } catch (const std::exception &e) {
     std::cerr << "objectExists failed: " << e.what() << std::endl;
@@ -118,15 +147,116 @@ bool GitObjectStorage::cleanupOrphanedObjects() {
   }
 }
 
-bool GitObjectStorage::compressObjects() {
+bool GitObjectStorage::compressObjects(
+    const std::unordered_map<ObjectId, std::string> &pathHints) {
   try {
     std::string objectsDir = gitDir + "/objects";
     if (!std::filesystem::exists(objectsDir)) {
       return true;
     }
 
-    // TODO: Implement object compression
-    // This would involve compressing loose objects into pack files
+    std::vector<ObjectId> loose = listLooseObjects();
+    std::shared_ptr<PackStore> store = PackStore::forGitDir(gitDir);
+    std::vector<ObjectId> packed = store->listObjects();
+    if (loose.empty() && store->packCount() <= 1) {
+      return true;
+    }
+    std::vector<std::string> oldPacks;
+    std::string packDir = objectsDir + "/pack";
+    if (std::filesystem::exists(packDir)) {
+      for (const auto &entry : std::filesystem::directory_iterator(packDir)) {
+        if (entry.path().extension() == ".pack") {
+          oldPacks.push_back(entry.path().string());
+        }
+      }
+    }
+
+    // Everything goes into one new pack so deltas can be found across
+    // objects that were packed by earlier runs.
+    PackWriter writer(
+        gitDir,
+        [this](const ObjectId &id) {
+          try {
+            return readObject(id);
+          } catch (const std::exception &e) {
+            std::cerr << "compressObjects: " << e.what() << std::endl;
+            return std::string();
+          }
+        },
+        [this](const ObjectId &id, std::string &type, uint64_t &size) {
+          try {
+            return readObjectHeader(id, type, size);
+          } catch (const std::exception &e) {
+            std::cerr << "compressObjects: " << e.what() << std::endl;
+            return false;
+          }
+        });
+    GitConfig config(gitDir);
+    std::string window;
+    std::string depth;
+    size_t deltaWindow = 10;
+    size_t deltaDepth = 50;
+    if (config.getConfig("pack.window", window)) {
+      deltaWindow = std::stoul(window);
+    }
+    if (config.getConfig("pack.depth", depth)) {
+      deltaDepth = std::stoul(depth);
+    }
+    writer.setDeltaOptions(deltaWindow, deltaDepth);
+    writer.setCompressionLevel(config.getCompressionLevel());
+
+    std::unordered_set<ObjectId> seen;
+    for (const auto &list : {packed, loose}) {
+      for (const auto &id : list) {
+        if (!seen.insert(id).second) {
+          continue;
+        }
+        auto hint = pathHints.find(id);
+        writer.addObject(id, hint == pathHints.end() ? "" : hint->second);
+      }
+    }
+    std::string packPath = writer.write();
+    if (packPath.empty()) {
+      throw StorageException("No objects could be packed");
+    }
+    lastDeltaCount = writer.getDeltaCount();
+
+    // Only drop old packs and loose copies once the new pack is in place.
+    std::unordered_set<ObjectId> written(writer.getWrittenObjects().begin(),
+                                         writer.getWrittenObjects().end());
+    for (const auto &oldPack : oldPacks) {
+      if (oldPack == packPath) {
+        continue;
+      }
+      std::shared_ptr<PackFile> pack = PackFile::open(oldPack);
+      bool covered = true;
+      for (uint32_t i = 0; i < pack->objectCount() && covered; ++i) {
+        covered = written.count(pack->objectIdAt(i)) > 0;
+      }
+      if (!covered) {
+        continue;
+      }
+      std::string base = oldPack.substr(0, oldPack.size() - 5);
+      std::filesystem::remove(base + ".idx");
+      std::filesystem::remove(oldPack);
+    }
+    store->reload();
+
+    std::unordered_set<std::string> fanoutDirs;
+    for (const auto &id : loose) {
+      if (!written.count(id)) {
+        continue;
+      }
+      std::filesystem::path objectPath = getObjectPath(id);
+      std::filesystem::remove(objectPath);
+      fanoutDirs.insert(objectPath.parent_path().string());
+    }
+    for (const auto &dir : fanoutDirs) {
+      std::error_code ec;
+      if (std::filesystem::is_empty(dir, ec)) {
+        std::filesystem::remove(dir, ec);
+      }
+    }
 
     return true;
   } catch (const std::exception &e) {
@@ -135,15 +265,19 @@ bool GitObjectStorage::compressObjects() {
   }
 }
 
-bool GitObjectStorage::validateObjectIntegrity(const std::string &hash) {
+bool GitObjectStorage::validateObjectIntegrity(const ObjectId &id) {
   try {
-    if (!validateHash(hash)) {
+    if (id.isNull()) {
       return false;
     }
 
-    std::string objectPath = getObjectPath(hash);
+    std::string objectPath = getObjectPath(id);
     if (!std::filesystem::exists(objectPath)) {
-      throw StorageException("Object file does not exist: " + hash);
+      if (PackStore::forGitDir(gitDir)->contains(id)) {
+        // Pack entries are covered by the pack/index checksums.
+        return !readObject(id).empty();
+      }
+      throw StorageException("Object file does not exist: " + id.hex());
     }
 
     std::ifstream objectFile(objectPath);
@@ -156,7 +290,7 @@ bool GitObjectStorage::validateObjectIntegrity(const std::string &hash) {
     objectFile.close();
 
     if (content.empty()) {
-      throw StorageException("Object file is empty: " + hash);
+      throw StorageException("Object file is empty: " + id.hex());
     }
 
     // TODO: Add more integrity checks (e.g., verify content matches hash)
@@ -168,33 +302,242 @@ bool GitObjectStorage::validateObjectIntegrity(const std::string &hash) {
   }
 }
 
-std::string GitObjectStorage::readObject(const std::string &hash) {
+namespace {
+
+// Parses "<type> <size>" (the part of an object header before the NUL).
+void parseObjectHeader(std::string_view header, std::string_view &type,
+                       uint64_t &size) {
+  size_t space = header.find(' ');
+  if (space == std::string_view::npos || space + 1 == header.size() ||
+      header.size() - space - 1 > 20 ||
+      header.find_first_not_of("0123456789", space + 1) !=
+          std::string_view::npos) {
+    throw StorageException("Invalid object header: " + std::string(header));
+  }
+  type = header.substr(0, space);
+  size = 0;
+  for (char c : header.substr(space + 1)) {
+    size = size * 10 + static_cast<uint64_t>(c - '0');
+  }
+}
+
+void parseObjectHeader(std::string_view header, std::string &type,
+                       uint64_t &size) {
+  std::string_view typeView;
+  parseObjectHeader(header, typeView, size);
+  type.assign(typeView);
+}
+
+GitObjectType objectTypeFromName(std::string_view name) {
+  if (name == "blob")
+    return GitObjectType::Blob;
+  if (name == "tree")
+    return GitObjectType::Tree;
+  if (name == "commit")
+    return GitObjectType::Commit;
+  if (name == "tag")
+    return GitObjectType::Tag;
+  return GitObjectType::Unknown;
+}
+
+} // namespace
+
+ObjectView::ObjectView(std::shared_ptr<const std::string> object)
+    : buffer(std::move(object)) {
+  std::string_view all(*buffer);
+  size_t nul = all.substr(0, 64).find('\0');
+  if (nul == std::string_view::npos) {
+    throw StorageException("Object header is missing its NUL");
+  }
+  uint64_t size = 0;
+  parseObjectHeader(all.substr(0, nul), typeName_, size);
+  body_ = all.substr(nul + 1);
+  if (body_.size() != size) {
+    throw StorageException("Object size " + std::to_string(body_.size()) +
+                           " does not match its header (" +
+                           std::to_string(size) + ")");
+  }
+  type_ = objectTypeFromName(typeName_);
+}
+
+ObjectView GitObjectStorage::readObjectView(const ObjectId &id) {
   try {
-    if (hash.empty()) {
-      return "";
+    if (id.isNull()) {
+      return ObjectView();
     }
-    std::string path =
-        gitDir + "/objects/" + hash.substr(0, 2) + "/" + hash.substr(2);
-    if (!std::filesystem::exists(path)) {
-      throw std::runtime_error("Error: Blob file not found: " + path);
+    ObjectCache::Object object = cache->get(id);
+    if (!object) {
+      std::string inflated = PackStore::forGitDir(gitDir)->readObject(id);
+      if (inflated.empty()) {
+        inflated = readLooseObject(id);
+      }
+      // The cache shares this buffer rather than taking its own copy.
+      object = std::make_shared<const std::string>(std::move(inflated));
+      cache->put(id, object);
     }
+    return ObjectView(std::move(object));
+  } catch (const std::exception &e) {
+    std::cerr << "Exception occurred at GitObjectStorage::readObject: "
+              << e.what() << std::endl;
+    return ObjectView();
+  }
+}
+
+std::string GitObjectStorage::readObject(const ObjectId &id) {
+  ObjectView view = readObjectView(id);
+  return std::string(view.raw());
+}
 
-    std::ifstream blobFile(path, std::ios::binary);
-    if (!blobFile.is_open()) {
-      throw std::runtime_error("Error: Cannot open blob file: " + path);
+bool GitObjectStorage::readObjectHeader(const ObjectId &id,
+                                        std::string &type, uint64_t &size) {
+  try {
+    if (id.isNull()) {
+      throw StorageException("Object ID cannot be null");
+    }
+    if (ObjectCache::Object object = cache->get(id)) {
+      ObjectView view(std::move(object));
+      type.assign(view.typeName());
+      size = view.size();
+      return true;
+    }
+    if (PackStore::forGitDir(gitDir)->readHeader(id, type, size)) {
+      return true;
     }
 
-    std::vector<char> compressedData((std::istreambuf_iterator<char>(blobFile)),
-                                     std::istreambuf_iterator<char>());
-    blobFile.close();
+    std::ifstream objectFile(getObjectPath(id), std::ios::binary);
+    if (!objectFile.is_open()) {
+      throw StorageException("Object not found: " + id.hex());
+    }
+    // The header is the first few inflated bytes. Only a deflate block
+    // header (at most a few hundred bytes) comes before it, so the first
+    // read nearly always suffices.
+    std::vector<char> compressed;
+    for (size_t want = 4096;; want *= 4) {
+      size_t have = compressed.size();
+      compressed.resize(want);
+      objectFile.read(compressed.data() + have,
+                      static_cast<std::streamsize>(want - have));
+      compressed.resize(have + static_cast<size_t>(objectFile.gcount()));
+      std::string prefix = inflatePrefix(
+          reinterpret_cast<const unsigned char *>(compressed.data()),
+          compressed.size(), 64);
+      size_t nul = prefix.find('\0');
+      if (nul != std::string::npos) {
+        parseObjectHeader(std::string_view(prefix).substr(0, nul), type,
+                          size);
+        return true;
+      }
+      if (prefix.size() == 64 || !objectFile) {
+        throw StorageException("Invalid object header in " + id.hex());
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "readObjectHeader failed: " << e.what() << std::endl;
+    return false;
+  }
+}
 
-    std::string decompressedData = decompressZlib(compressedData);
-    return decompressedData;
+bool GitObjectStorage::streamObject(const ObjectId &id,
+                                    const ObjectHeaderFn &onHeader,
+                                    const ZlibSink &onBody) {
+  try {
+    if (id.isNull()) {
+      throw StorageException("Object ID cannot be null");
+    }
+    std::string type;
+    uint64_t size = 0;
+
+    // An object already in the cache is handed over from there.
+    if (ObjectCache::Object object = cache->get(id)) {
+      ObjectView view(std::move(object));
+      if (onHeader) {
+        onHeader(std::string(view.typeName()), view.size());
+      }
+      if (onBody && view.size() > 0) {
+        onBody(view.body().data(), view.body().size());
+      }
+      return true;
+    }
+    if (PackStore::forGitDir(gitDir)->streamObject(id, onHeader, onBody)) {
+      return true;
+    }
+
+    std::string path = getObjectPath(id);
+    std::ifstream objectFile(path, std::ios::binary);
+    if (!objectFile.is_open()) {
+      throw StorageException("Object not found: " + id.hex());
+    }
+
+    // The header is collected byte by byte until its NUL (it may straddle
+    // two inflated chunks); everything after it is body.
+    std::string header;
+    bool inBody = false;
+    uint64_t received = 0;
+    ZlibInflater inflater([&](const char *data, size_t length) {
+      if (!inBody) {
+        const char *nul =
+            static_cast<const char *>(std::memchr(data, '\0', length));
+        size_t headerPart = nul ? static_cast<size_t>(nul - data) : length;
+        header.append(data, headerPart);
+        if (header.size() > 64) {
+          throw StorageException("Invalid object header in " + id.hex());
+        }
+        if (!nul) {
+          return;
+        }
+        parseObjectHeader(header, type, size);
+        if (onHeader) {
+          onHeader(type, size);
+        }
+        inBody = true;
+        data += headerPart + 1;
+        length -= headerPart + 1;
+      }
+      received += length;
+      if (received > size) {
+        throw StorageException("Object is larger than its header says: " +
+                               id.hex());
+      }
+      if (onBody && length > 0) {
+        onBody(data, length);
+      }
+    });
+
+    std::vector<char> chunk(128 * 1024);
+    while (!inflater.finished() && objectFile) {
+      objectFile.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      size_t got = static_cast<size_t>(objectFile.gcount());
+      if (got == 0) {
+        break;
+      }
+      inflater.write(chunk.data(), got);
+    }
+    if (!inflater.finished() || !inBody || received != size) {
+      throw StorageException("Truncated object: " + id.hex());
+    }
+    return true;
   } catch (const std::exception &e) {
-    std::cerr << "Exception occurred at GitObjectStorage::readObject: "
-              << e.what() << std::endl;
-    return "";
+    std::cerr << "streamObject failed: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+std::string GitObjectStorage::readLooseObject(const ObjectId &id) const {
+  std::string path = getObjectPath(id);
+  if (!std::filesystem::exists(path)) {
+    throw std::runtime_error("Error: Blob file not found: " + path);
   }
+
+  std::ifstream blobFile(path, std::ios::binary);
+  if (!blobFile.is_open()) {
+    throw std::runtime_error("Error: Cannot open blob file: " + path);
+  }
+
+  std::vector<char> compressedData((std::istreambuf_iterator<char>(blobFile)),
+                                   std::istreambuf_iterator<char>());
+  blobFile.close();
+
+  return decompressZlib(compressedData);
 }
 
 std::string GitObjectStorage::objectTypeToString(GitObjectType type) {
@@ -214,59 +557,192 @@ std::string GitObjectStorage::objectTypeToString(GitObjectType type) {
 
 GitObjectType
 GitObjectStorage::parseGitObjectTypeFromString(const std::string &typeStr) {
-  if (typeStr == "blob")
-    return GitObjectType::Blob;
-  if (typeStr == "tree")
-    return GitObjectType::Tree;
-  if (typeStr == "commit")
-    return GitObjectType::Commit;
-  if (typeStr == "tag")
-    return GitObjectType::Tag;
-  return GitObjectType::Unknown;
+  return objectTypeFromName(typeStr);
+}
+
+namespace {
+
+const size_t kStreamChunkSize = 128 * 1024;
+
+// Reads exactly `size` bytes from `in` in fixed-size chunks, handing each
+// chunk to fn. Throws if the stream is shorter or longer than promised (for
+// files: it changed while being read), since the header already committed
+// to the size.
+template <typename Fn>
+void forEachChunk(std::istream &in, uint64_t size, Fn fn) {
+  std::vector<char> chunk(kStreamChunkSize);
+  uint64_t remaining = size;
+  while (remaining > 0) {
+    size_t want = static_cast<size_t>(
+        std::min<uint64_t>(remaining, chunk.size()));
+    in.read(chunk.data(), static_cast<std::streamsize>(want));
+    size_t got = static_cast<size_t>(in.gcount());
+    if (got == 0) {
+      throw StorageException("Input ended before the expected " +
+                             std::to_string(size) + " bytes");
+    }
+    fn(chunk.data(), got);
+    remaining -= got;
+  }
+  if (in.peek() != std::char_traits<char>::eof()) {
+    throw StorageException("Input is longer than the expected " +
+                           std::to_string(size) + " bytes");
+  }
+}
+
+} // namespace
+
+// core.looseCompression is read once per repository and process: blobs are
+// written from many short-lived storage objects (and threads) during add.
+int GitObjectStorage::looseCompressionLevel() const {
+  static std::mutex mutex;
+  static std::unordered_map<std::string, int> levels;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = levels.find(gitDir);
+  if (it == levels.end()) {
+    it = levels.emplace(gitDir, GitConfig(gitDir).getLooseCompressionLevel())
+             .first;
+  }
+  return it->second;
+}
+
+std::string GitObjectStorage::tempObjectPath() const {
+  std::ostringstream name;
+  name << gitDir << "/objects/tmp_obj_" << getpid() << "-"
+       << std::this_thread::get_id();
+  return name.str();
 }
 
-std::string GitObjectStorage::writeObject(const std::string &content) {
+// Moves a finished temporary object file to its final path. The rename is
+// atomic, so readers never see a partial object; if another writer got there
+// first the copies are identical and the temporary file is dropped.
+void GitObjectStorage::installLooseObject(const std::string &tmpPath,
+                                          const ObjectId &id) {
+  std::string objPath = getObjectPath(id);
+  if (std::filesystem::exists(objPath)) {
+    std::filesystem::remove(tmpPath);
+    return;
+  }
+  std::filesystem::create_directories(
+      std::filesystem::path(objPath).parent_path());
+  std::filesystem::rename(tmpPath, objPath);
+}
+
+ObjectId GitObjectStorage::writeObject(const std::string &content) {
+  std::string tmpPath;
   try {
     if (content.empty()) {
       throw StorageException("Content cannot be empty");
     }
 
-    std::string hash = hash_sha1(content);
-    std::string compressed = compressZlib(content);
-
-    std::string objDir = gitDir + "/objects/" + hash.substr(0, 2);
-    if (!std::filesystem::exists(objDir)) {
-      std::filesystem::create_directories(objDir);
+    ObjectId id;
+    Sha1 ctx;
+    ctx.update(content);
+    ctx.final(id.data());
+    if (objectExists(id)) {
+      return id; // content-addressed: an existing copy is identical
     }
+    std::string compressed = compressZlib(content, looseCompressionLevel());
 
-    std::string objPath = objDir + "/" + hash.substr(2);
-    std::filesystem::create_directories(
-        std::filesystem::path(objPath).parent_path());
-    std::ofstream outFile(objPath, std::ios::binary);
+    std::filesystem::create_directories(gitDir + "/objects");
+    tmpPath = tempObjectPath();
+    std::ofstream outFile(tmpPath, std::ios::binary | std::ios::trunc);
     if (!outFile.is_open()) {
-      throw StorageException("Failed to create object file: " + objPath);
+      throw StorageException("Failed to create object file: " + tmpPath);
     }
-
     outFile.write(compressed.data(), compressed.size());
     outFile.close();
+    if (!outFile) {
+      throw StorageException("Failed to write object file: " + tmpPath);
+    }
+    installLooseObject(tmpPath, id);
 
-    return hash;
+    return id;
   } catch (const std::exception &e) {
     std::cerr << "writeObject failed: " << e.what() << std::endl;
-    return "";
+    if (!tmpPath.empty()) {
+      std::error_code ec;
+      std::filesystem::remove(tmpPath, ec);
+    }
+    return ObjectId();
   }
 }
 
-std::string GitObjectStorage::getObjectPath(const std::string &hash) const {
+ObjectId GitObjectStorage::writeObjectStream(const std::string &type,
+                                             std::istream &in,
+                                             uint64_t size) {
+  std::string tmpPath;
+  try {
+    std::filesystem::create_directories(gitDir + "/objects");
+    tmpPath = tempObjectPath();
+    std::ofstream outFile(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!outFile.is_open()) {
+      throw StorageException("Failed to create object file: " + tmpPath);
+    }
+
+    ZlibDeflater deflater(
+        [&outFile](const char *data, size_t length) {
+          outFile.write(data, static_cast<std::streamsize>(length));
+        },
+        looseCompressionLevel());
+    Sha1 ctx;
+    std::string header = type + " " + std::to_string(size) + '\0';
+    ctx.update(header);
+    deflater.write(header.data(), header.size());
+    forEachChunk(in, size, [&](const char *data, size_t length) {
+      ctx.update(data, length);
+      deflater.write(data, length);
+    });
+    deflater.finish();
+    outFile.close();
+    if (!outFile) {
+      throw StorageException("Failed to write object file: " + tmpPath);
+    }
+
+    ObjectId id;
+    ctx.final(id.data());
+    if (PackStore::forGitDir(gitDir)->contains(id)) {
+      std::filesystem::remove(tmpPath);
+      return id;
+    }
+    installLooseObject(tmpPath, id);
+    return id;
+  } catch (const std::exception &e) {
+    std::cerr << "writeObjectStream failed: " << e.what() << std::endl;
+    if (!tmpPath.empty()) {
+      std::error_code ec;
+      std::filesystem::remove(tmpPath, ec);
+    }
+    return ObjectId();
+  }
+}
+
+ObjectId GitObjectStorage::hashObjectStream(const std::string &type,
+                                            std::istream &in, uint64_t size) {
+  try {
+    Sha1 ctx;
+    ctx.update(type + " " + std::to_string(size) + '\0');
+    forEachChunk(in, size, [&ctx](const char *data, size_t length) {
+      ctx.update(data, length);
+    });
+    ObjectId id;
+    ctx.final(id.data());
+    return id;
+  } catch (const std::exception &e) {
+    std::cerr << "hashObjectStream failed: " << e.what() << std::endl;
+    return ObjectId();
+  }
+}
+
+std::string GitObjectStorage::getObjectPath(const ObjectId &id) const {
   // Standard git object storage path: .git/objects/xx/yyyy... where xx are
-  // first 2 chars
-  if (hash.size() < 2)
-    return "";
-  return gitDir + "/objects/" + hash.substr(0, 2) + "/" + hash.substr(2);
+  // the first 2 hex digits
+  std::string hex = id.hex();
+  return gitDir + "/objects/" + hex.substr(0, 2) + "/" + hex.substr(2);
 }
 
-std::vector<std::string> GitObjectStorage::listAllObjects() const {
-  std::vector<std::string> objects;
+std::vector<ObjectId> GitObjectStorage::listLooseObjects() const {
+  std::vector<ObjectId> objects;
   std::string base = gitDir + "/objects";
   if (!std::filesystem::exists(base)) {
     return objects;
@@ -280,10 +756,25 @@ std::vector<std::string> GitObjectStorage::listAllObjects() const {
       continue;
     }
     for (const auto &objEntry : std::filesystem::directory_iterator(dirEntry.path())) {
-      if (!objEntry.is_regular_file()) {
+      std::string rest = objEntry.path().filename().string();
+      // Skips temporary files left behind by interrupted writes.
+      ObjectId id;
+      if (!objEntry.is_regular_file() ||
+          !ObjectId::parseHex(prefix + rest, id)) {
         continue;
       }
-      objects.push_back(prefix + objEntry.path().filename().string());
+      objects.push_back(id);
+    }
+  }
+  return objects;
+}
+
+std::vector<ObjectId> GitObjectStorage::listAllObjects() const {
+  std::vector<ObjectId> objects = listLooseObjects();
+  std::unordered_set<ObjectId> seen(objects.begin(), objects.end());
+  for (const auto &id : PackStore::forGitDir(gitDir)->listObjects()) {
+    if (seen.insert(id).second) {
+      objects.push_back(id);
     }
   }
   return objects;
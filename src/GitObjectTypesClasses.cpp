@@ -5,6 +5,7 @@
 #include "headers/ZlibUtils.hpp"
 
 #include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
@@ -16,43 +17,42 @@
 BlobObject::BlobObject(const std::string &gitDir)
     : GitObjectStorage(gitDir), type(GitObjectType::Blob), content({}) {}
 
-std::string BlobObject::writeObject(const std::string &path,
-                                    const bool &write) {
+ObjectId BlobObject::writeObject(const std::string &path, const bool &write) {
   std::ifstream file(path, std::ios::binary);
   if (!file.is_open()) {
     std::cerr << "Error: Unable to open file: " << path << "\n";
-    return "";
+    return ObjectId();
+  }
+  std::error_code ec;
+  uint64_t size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    std::cerr << "Error: Unable to stat file: " << path << "\n";
+    return ObjectId();
   }
 
-  std::ostringstream data;
-  data << file.rdbuf();
-  std::string content = data.str();
-  file.close();
-
-  // Always create the Git object header for hash calculation
-  std::string header = "blob " + std::to_string(content.size()) + '\0';
-  std::string fullContent = header + content;
-
+  // The file is streamed in chunks rather than read whole, so blobs larger
+  // than memory can be hashed and stored.
   if (write) {
-    return GitObjectStorage::writeObject(fullContent);
-  } else {
-    return hash_sha1(fullContent);
+    return GitObjectStorage::writeObjectStream("blob", file, size);
   }
+  return GitObjectStorage::hashObjectStream("blob", file, size);
 }
 
-BlobData BlobObject::readObject(const std::string &hash) {
+BlobData BlobObject::readObject(const ObjectId &id) {
   BlobData data;
-  std::string decompressed = GitObjectStorage::readObject(hash);
+  ObjectView view = readView(id);
+  data.content.assign(view.body());
+  return data;
+}
 
-  size_t nullPos = decompressed.find('\0');
-  if (nullPos == std::string::npos) {
-    std::cerr << "Error: Invalid blob object (missing null byte).\n";
-    return data;
+ObjectView BlobObject::readView(const ObjectId &id) {
+  ObjectView view = GitObjectStorage::readObjectView(id);
+  if (view && view.type() != GitObjectType::Blob) {
+    std::cerr << "Error: " << id << " is a " << view.typeName()
+              << ", not a blob.\n";
+    return ObjectView();
   }
-
-  data.content = decompressed.substr(nullPos + 1);
-  content = data;
-  return data;
+  return view;
 }
 
 const BlobData &BlobObject::getContent() const { return content; }
@@ -62,12 +62,12 @@ GitObjectType BlobObject::getType() const { return type; }
 TreeObject::TreeObject(const std::string &gitDir)
     : GitObjectStorage(gitDir), type(GitObjectType::Tree), content({}) {}
 
-std::string TreeObject::writeObject(const std::string &path) {
+ObjectId TreeObject::writeObject(const std::string &path) {
   std::vector<TreeEntry> entries;
 
   if (!std::filesystem::exists(path)) {
     std::cerr << "no such directory to make tree \n";
-    return "";
+    return ObjectId();
   }
 
   for (const auto &entry : std::filesystem::directory_iterator(path)) {
@@ -93,11 +93,7 @@ std::string TreeObject::writeObject(const std::string &path) {
   for (const auto &entry : entries) {
     binaryTreeContent += entry.mode + " " + entry.filename;
     binaryTreeContent.push_back('\0');
-    for (int i = 0; i < 40; i += 2) {
-      std::string bytestr = entry.hash.substr(i, 2);
-      char byte = static_cast<char>(std::stoi(bytestr, nullptr, 16));
-      binaryTreeContent += byte;
-    }
+    binaryTreeContent += entry.hash.raw();
   }
 
   std::string header =
@@ -107,50 +103,36 @@ std::string TreeObject::writeObject(const std::string &path) {
   return GitObjectStorage::writeObject(full);
 }
 
-std::vector<TreeEntry> TreeObject::readObject(const std::string &hash) {
-  std::vector<TreeEntry> entries;
-  std::string decompressed = GitObjectStorage::readObject(hash);
-
-  if (decompressed.empty()) {
-    return entries;
+TreeCache::Tree TreeObject::readParsedTree(const ObjectId &id) {
+  std::shared_ptr<TreeCache> cache = TreeCache::forGitDir(getGitDir());
+  if (TreeCache::Tree tree = cache->get(id)) {
+    return tree;
   }
-
-  size_t nullPos = decompressed.find('\0');
-  if (nullPos == std::string::npos) {
+  ObjectView view = GitObjectStorage::readObjectView(id);
+  if (!view) {
+    return nullptr;
+  }
+  TreeCache::Tree tree = TreeCache::parse(view.raw());
+  if (!tree) {
     std::cerr << "Error: Invalid tree object (missing null byte).\n";
-    return entries;
+    return nullptr;
   }
+  cache->put(id, tree);
+  return tree;
+}
 
-  std::string treeBody = decompressed.substr(nullPos + 1);
-  size_t i = 0;
-
-  while (i < treeBody.size()) {
-    TreeEntry entry;
-    // Parse mode
-    while (i < treeBody.size() && treeBody[i] != ' ')
-      entry.mode += treeBody[i++];
-    if (i >= treeBody.size())
-      break;
-    i++;
-    // Parse filename
-    while (i < treeBody.size() && treeBody[i] != '\0')
-      entry.filename += treeBody[i++];
-    if (i >= treeBody.size())
-      break;
-    i++;
-    // Parse 20-byte hash
-    if (i + 20 > treeBody.size())
-      break;
-    std::ostringstream hexHash;
-    for (int j = 0; j < 20; ++j) {
-      hexHash << std::hex << std::setw(2) << std::setfill('0')
-              << (static_cast<unsigned int>(
-                     static_cast<unsigned char>(treeBody[i + j])));
-    }
-    entry.hash = hexHash.str();
-    i += 20;
+std::vector<TreeEntry> TreeObject::readObject(const ObjectId &id) {
+  std::vector<TreeEntry> entries;
+  TreeCache::Tree tree = readParsedTree(id);
+  if (!tree) {
+    return entries;
+  }
 
-    entries.push_back(entry);
+  entries.reserve(tree->entries.size());
+  for (const ParsedTreeEntry &parsed : tree->entries) {
+    entries.push_back(
+        {treeEntryModeString(parsed.mode), std::string(parsed.filename()),
+         parsed.id});
   }
 
   content = entries;
@@ -162,39 +144,44 @@ const std::vector<TreeEntry> &TreeObject::getContent() const { return content; }
 GitObjectType TreeObject::getType() const { return type; }
 
 void TreeObject::restoreTreeContents(
-    const std::string &hash, const std::string &path,
+    const ObjectId &id, const std::string &path,
     std::unordered_set<std::string> &treePaths) {
-  std::vector<TreeEntry> entities = readObject(hash);
+  TreeCache::Tree tree = readParsedTree(id);
+  if (!tree) {
+    return;
+  }
 
-  for (const TreeEntry &entity : entities) {
-    std::string fullPath = path + "/" + entity.filename;
+  for (const ParsedTreeEntry &entity : tree->entries) {
+    std::string fullPath = path + "/";
+    fullPath += entity.filename();
     std::string relativePath =
         std::filesystem::relative(fullPath, path).string();
     treePaths.insert(relativePath);
 
-    if (entity.mode == "100644" || entity.mode == "100755") {
-      // File (blob)
-      BlobObject blobObj(getGitDir());
-      BlobData blob = blobObj.readObject(entity.hash);
-
+    if (entity.mode == TreeEntryMode::Regular ||
+        entity.mode == TreeEntryMode::Executable) {
+      // File (blob), streamed straight from the object store to disk
       std::filesystem::create_directories(
           std::filesystem::path(fullPath).parent_path());
 
       std::ofstream outFile(fullPath, std::ios::binary);
-      outFile << blob.content;
+      streamObject(entity.id, nullptr, [&outFile](const char *data,
+                                                  size_t length) {
+        outFile.write(data, static_cast<std::streamsize>(length));
+      });
       outFile.close();
-    } else if (entity.mode == "040000") {
+    } else if (entity.isTree()) {
       // Directory (tree)
       std::filesystem::create_directories(fullPath);
-      restoreTreeContents(entity.hash, fullPath, treePaths); // Recursive call
+      restoreTreeContents(entity.id, fullPath, treePaths); // Recursive call
     }
   }
 }
 
-bool TreeObject::restoreWorkingDirectoryFromTreeHash(const std::string &hash,
+bool TreeObject::restoreWorkingDirectoryFromTreeHash(const ObjectId &id,
                                                      const std::string &path) {
   std::unordered_set<std::string> treePaths;
-  restoreTreeContents(hash, path, treePaths);
+  restoreTreeContents(id, path, treePaths);
   std::vector<std::filesystem::path> to_delete;
   for (auto it = std::filesystem::recursive_directory_iterator(path);
        it != std::filesystem::recursive_directory_iterator(); ++it) {
@@ -217,7 +204,7 @@ bool TreeObject::restoreWorkingDirectoryFromTreeHash(const std::string &hash,
 CommitObject::CommitObject(const std::string &gitDir)
     : GitObjectStorage(gitDir), type(GitObjectType::Commit), content({}) {}
 
-std::string CommitObject::writeObject(const CommitData &data) {
+ObjectId CommitObject::writeObject(const CommitData &data) {
   std::ostringstream commitText;
   commitText << "tree " << data.tree << "\n";
   for (const auto &parent : data.parents) {
@@ -233,44 +220,72 @@ std::string CommitObject::writeObject(const CommitData &data) {
   return GitObjectStorage::writeObject(fullContent);
 }
 
-CommitData CommitObject::readObject(const std::string &hash) {
-  CommitData data;
-  std::string decompressed = GitObjectStorage::readObject(hash);
-  if (decompressed.empty()) {
-    return data;
+CommitData CommitObject::readObject(const ObjectId &id) {
+  ObjectView view = GitObjectStorage::readObjectView(id);
+  if (!view) {
+    return CommitData();
   }
-  size_t nullPos = decompressed.find('\0');
-  if (nullPos == std::string::npos) {
-    std::cerr << "Error: Invalid commit object (missing null byte).\n";
-    return data;
-  }
-  std::string body = decompressed.substr(nullPos + 1);
-  std::istringstream iss(body);
-  std::string line;
-  bool inMessage = false;
-  while (std::getline(iss, line)) {
-    if (line.empty()) {
-      inMessage = true;
-      continue;
-    }
-    if (inMessage) {
-      data.message += line + "\n";
-      continue;
-    }
-    if (line.rfind("tree ", 0) == 0) {
-      data.tree = line.substr(5);
-    } else if (line.rfind("parent ", 0) == 0) {
-      data.parents.push_back(line.substr(7));
-    } else if (line.rfind("author ", 0) == 0) {
-      data.author = line.substr(7);
-    } else if (line.rfind("committer ", 0) == 0) {
-      data.committer = line.substr(10);
+  CommitData data = parse(view.body());
+  content = data;
+  return data;
+}
+
+namespace {
+
+// Splits "<key> <value>" header lines off the front of an object body. At
+// the blank line that ends the headers, message gets the rest (without its
+// final newline) and next() returns false.
+class HeaderLines {
+public:
+  explicit HeaderLines(std::string_view body) : rest(body) {}
+
+  bool next(std::string_view &key, std::string_view &value,
+            std::string_view &message) {
+    while (!rest.empty()) {
+      size_t end = rest.find('\n');
+      std::string_view line = rest.substr(0, end);
+      rest.remove_prefix(end == std::string_view::npos ? rest.size()
+                                                       : end + 1);
+      if (line.empty()) {
+        message = rest;
+        if (!message.empty() && message.back() == '\n') {
+          message.remove_suffix(1);
+        }
+        return false;
+      }
+      size_t space = line.find(' ');
+      if (space == std::string_view::npos) {
+        continue;
+      }
+      key = line.substr(0, space);
+      value = line.substr(space + 1);
+      return true;
     }
+    return false;
   }
-  if (!data.message.empty() && data.message.back() == '\n') {
-    data.message.pop_back();
+
+private:
+  std::string_view rest;
+};
+
+} // namespace
+
+CommitData CommitObject::parse(std::string_view body) {
+  CommitData data;
+  HeaderLines lines(body);
+  std::string_view key, value, message;
+  while (lines.next(key, value, message)) {
+    if (key == "tree") {
+      data.tree = ObjectId::fromHex(value);
+    } else if (key == "parent") {
+      data.parents.push_back(ObjectId::fromHex(value));
+    } else if (key == "author") {
+      data.author.assign(value);
+    } else if (key == "committer") {
+      data.committer.assign(value);
+    }
   }
-  content = data;
+  data.message.assign(message);
   return data;
 }
 
@@ -281,7 +296,7 @@ GitObjectType CommitObject::getType() const { return type; }
 TagObject::TagObject(const std::string &gitDir)
     : GitObjectStorage(gitDir), type(GitObjectType::Tag), content({}) {}
 
-std::string TagObject::writeObject(const TagData &data) {
+ObjectId TagObject::writeObject(const TagData &data) {
   std::ostringstream tagStream;
 
   tagStream << "object " << data.objectHash << "\n";
@@ -299,49 +314,32 @@ std::string TagObject::writeObject(const TagData &data) {
   return GitObjectStorage::writeObject(fullTag);
 }
 
-TagData TagObject::readObject(const std::string &hash) {
-  TagData tag;
-  std::string decompressed = GitObjectStorage::readObject(hash);
-
-  size_t nullPos = decompressed.find('\0');
-  if (nullPos == std::string::npos) {
-    std::cerr << "Error: Invalid tag object (missing null byte).\n";
-    return tag;
+TagData TagObject::readObject(const ObjectId &id) {
+  ObjectView view = GitObjectStorage::readObjectView(id);
+  if (!view) {
+    return TagData();
   }
+  TagData tag = parse(view.body());
+  content = tag;
+  return tag;
+}
 
-  std::string body = decompressed.substr(nullPos + 1);
-  std::istringstream iss(body);
-  std::string line;
-  bool inMessage = false;
-
-  while (std::getline(iss, line)) {
-    if (line.empty()) {
-      inMessage = true;
-      continue;
-    }
-
-    if (inMessage) {
-      tag.message += line + "\n";
-      continue;
-    }
-
-    if (line.rfind("object ", 0) == 0) {
-      tag.objectHash = line.substr(7);
-    } else if (line.rfind("type ", 0) == 0) {
-      tag.objectType = line.substr(5);
-    } else if (line.rfind("tag ", 0) == 0) {
-      tag.tagName = line.substr(4);
-    } else if (line.rfind("tagger ", 0) == 0) {
-      tag.tagger = line.substr(7);
+TagData TagObject::parse(std::string_view body) {
+  TagData tag;
+  HeaderLines lines(body);
+  std::string_view key, value, message;
+  while (lines.next(key, value, message)) {
+    if (key == "object") {
+      tag.objectHash = ObjectId::fromHex(value);
+    } else if (key == "type") {
+      tag.objectType.assign(value);
+    } else if (key == "tag") {
+      tag.tagName.assign(value);
+    } else if (key == "tagger") {
+      tag.tagger.assign(value);
     }
   }
-
-  // Remove trailing newline from message
-  if (!tag.message.empty() && tag.message.back() == '\n') {
-    tag.message.pop_back();
-  }
-
-  content = tag;
+  tag.message.assign(message);
   return tag;
 }
 
@@ -374,17 +372,8 @@ bool TreeObject::validateEntry(const TreeEntry &entry) {
       throw ObjectException("Tree entry filename cannot be empty");
     }
 
-    if (entry.hash.empty()) {
-      throw ObjectException("Tree entry hash cannot be empty");
-    }
-
-    if (entry.hash.size() != 40) {
-      throw ObjectException("Invalid tree entry hash length: " +
-                            std::to_string(entry.hash.size()));
-    }
-
-    if (!std::all_of(entry.hash.begin(), entry.hash.end(), ::isxdigit)) {
-      throw ObjectException("Invalid tree entry hash format");
+    if (entry.hash.isNull()) {
+      throw ObjectException("Tree entry hash cannot be null");
     }
 
     // Validate mode
@@ -400,26 +389,17 @@ bool TreeObject::validateEntry(const TreeEntry &entry) {
   }
 }
 
-bool CommitObject::validateCommit(const std::string &treeHash,
+bool CommitObject::validateCommit(const ObjectId &tree,
                                   const std::string &message) {
   try {
-    if (treeHash.empty()) {
-      throw ObjectException("Tree hash cannot be empty");
+    if (tree.isNull()) {
+      throw ObjectException("Tree hash cannot be null");
     }
 
     if (message.empty()) {
       throw ObjectException("Commit message cannot be empty");
     }
 
-    if (treeHash.size() != 40) {
-      throw ObjectException("Invalid tree hash length: " +
-                            std::to_string(treeHash.size()));
-    }
-
-    if (!std::all_of(treeHash.begin(), treeHash.end(), ::isxdigit)) {
-      throw ObjectException("Invalid tree hash format");
-    }
-
     return true;
   } catch (const std::exception &e) {
     std::cerr << "CommitObject::validateCommit failed: " << e.what()
@@ -440,8 +420,8 @@ bool BlobObject::updateContent(const std::string &newContent) {
     GitObjectStorage storage;
     std::string header = "blob " + std::to_string(newContent.size()) + '\0';
     std::string fullContent = header + newContent;
-    std::string hash = storage.writeObject(fullContent);
-    if (hash.empty()) {
+    ObjectId id = storage.writeObject(fullContent);
+    if (id.isNull()) {
       throw ObjectException("Failed to update blob in storage");
     }
 
@@ -468,8 +448,8 @@ bool TreeObject::addEntry(const TreeEntry &entry) {
     content.push_back(entry);
 
     // Re-serialize and update hash
-    std::string newHash = writeObject("."); // This will recreate the tree
-    if (newHash.empty()) {
+    ObjectId newId = writeObject("."); // This will recreate the tree
+    if (newId.isNull()) {
       throw ObjectException("Failed to update tree after adding entry");
     }
 
@@ -498,8 +478,8 @@ bool TreeObject::removeEntry(const std::string &filename) {
     content.erase(it);
 
     // Re-serialize and update hash
-    std::string newHash = writeObject("."); // This will recreate the tree
-    if (newHash.empty()) {
+    ObjectId newId = writeObject("."); // This will recreate the tree
+    if (newId.isNull()) {
       throw ObjectException("Failed to update tree after removing entry");
     }
 
@@ -511,67 +491,51 @@ bool TreeObject::removeEntry(const std::string &filename) {
 }
 
 void TreeObject_getAllFilesRecursive(
-    TreeObject *self, const std::string &treeHash,
-    const std::string &currentPath, std::map<std::string, std::string> &files) {
-  std::vector<TreeEntry> entries = self->readObject(treeHash);
-  for (const auto &entry : entries) {
-    std::string path = currentPath.empty() ? entry.filename
-                                           : currentPath + "/" + entry.filename;
-    if (entry.mode == "040000") { // Tree
-      TreeObject_getAllFilesRecursive(self, entry.hash, path, files);
+    TreeObject *self, const ObjectId &treeId, const std::string &currentPath,
+    std::map<std::string, ObjectId> &files) {
+  TreeCache::Tree tree = self->readParsedTree(treeId);
+  if (!tree) {
+    return;
+  }
+  for (const ParsedTreeEntry &entry : tree->entries) {
+    std::string path =
+        currentPath.empty() ? std::string() : currentPath + "/";
+    path += entry.filename();
+    if (entry.isTree()) {
+      TreeObject_getAllFilesRecursive(self, entry.id, path, files);
     } else { // Blob
-      files[path] = entry.hash;
+      files[path] = entry.id;
     }
   }
 }
 
-void TreeObject::getAllFiles(const std::string &treeHash,
-                             std::map<std::string, std::string> &files) {
-  TreeObject_getAllFilesRecursive(this, treeHash, "", files);
+void TreeObject::getAllFiles(const ObjectId &treeId,
+                             std::map<std::string, ObjectId> &files) {
+  TreeObject_getAllFilesRecursive(this, treeId, "", files);
 }
 
-std::string
-TreeObject::writeTreeRecursive(const std::vector<IndexEntry> &entries) {
-  std::map<std::string, std::vector<IndexEntry>> children;
-  std::vector<IndexEntry> files;
-
-  for (const auto &entry : entries) {
-    size_t slashPos = entry.path.find('/');
-    if (slashPos == std::string::npos) {
-      files.push_back(entry);
-    } else {
-      std::string dir = entry.path.substr(0, slashPos);
-      IndexEntry childEntry = entry;
-      childEntry.path = entry.path.substr(slashPos + 1);
-      children[dir].push_back(childEntry);
-    }
-  }
-
-  std::string binaryTreeContent;
-
-  // Process files
-  for (const auto &file : files) {
-    binaryTreeContent += file.mode + " " + file.path;
-    binaryTreeContent.push_back('\0');
-    std::string binHash = hexToBinary(file.hash);
-    binaryTreeContent += binHash;
-  }
-
-  // Process directories
-  for (const auto &[dirName, childEntries] : children) {
-    std::string subTreeHash = writeTreeRecursive(childEntries);
-    binaryTreeContent += "040000 " + dirName + "\0";
-    std::string binHash = hexToBinary(subTreeHash);
-    binaryTreeContent += binHash;
+ObjectId TreeObject::writeTreeFromIndex(IndexManager &index) {
+  try {
+    CacheTree &cacheTree = index.getCacheTree();
+    ObjectId root = cacheTree.update(
+        index.sortedEntries(), [this](const std::string &body) {
+          std::string full = "tree " + std::to_string(body.size()) + '\0';
+          full += body;
+          return GitObjectStorage::writeObject(full);
+        });
+    size_t rebuilt = cacheTree.rebuiltCount();
+    if (rebuilt > 0) {
+      index.writeIndex();
+    }
+    // MGIT_TRACE_CACHE_TREE=1 reports how many trees had to be rebuilt.
+    const char *trace = std::getenv("MGIT_TRACE_CACHE_TREE");
+    if (trace && *trace && std::string(trace) != "0") {
+      std::cerr << "cache-tree: " << rebuilt << " trees rebuilt\n";
+    }
+    return root;
+  } catch (const std::exception &e) {
+    std::cerr << "TreeObject::writeTreeFromIndex failed: " << e.what()
+              << std::endl;
+    return ObjectId();
   }
-
-  std::string header =
-      "tree " + std::to_string(binaryTreeContent.size()) + '\0';
-  std::string full = header + binaryTreeContent;
-  return GitObjectStorage::writeObject(full);
-}
-
-std::string
-TreeObject::writeTreeFromIndex(const std::vector<IndexEntry> &entries) {
-  return writeTreeRecursive(entries);
 }
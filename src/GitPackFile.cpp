@@ -0,0 +1,871 @@
+#include "headers/GitPackFile.hpp"
+#include "headers/DeltaUtils.hpp"
+#include "headers/HashUtils.hpp"
+#include "headers/ZlibUtils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+const unsigned char kIdxMagic[4] = {0xff, 't', 'O', 'c'};
+const uint32_t kIdxVersion = 2;
+const uint32_t kPackVersion = 2;
+const size_t kHashSize = 20;
+// Objects above this size are stored whole (git's core.bigFileThreshold).
+const size_t kMaxDeltaObject = 512u * 1024 * 1024;
+// Longest delta chain a reader follows; a REF_DELTA cycle ends here.
+const size_t kMaxDeltaChain = 10000;
+
+uint32_t readBE32(const unsigned char *p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t readBE64(const unsigned char *p) {
+  return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+void appendBE32(std::string &out, uint32_t value) {
+  out.push_back(static_cast<char>((value >> 24) & 0xff));
+  out.push_back(static_cast<char>((value >> 16) & 0xff));
+  out.push_back(static_cast<char>((value >> 8) & 0xff));
+  out.push_back(static_cast<char>(value & 0xff));
+}
+
+void appendBE64(std::string &out, uint64_t value) {
+  appendBE32(out, static_cast<uint32_t>(value >> 32));
+  appendBE32(out, static_cast<uint32_t>(value & 0xffffffff));
+}
+
+const unsigned char *mapFile(const std::string &path, size_t &size) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw PackException("Cannot open " + path);
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    throw PackException("Cannot stat " + path);
+  }
+  size = static_cast<size_t>(st.st_size);
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw PackException("Cannot mmap " + path);
+  }
+  return static_cast<const unsigned char *>(data);
+}
+
+const char *packTypeName(uint8_t type) {
+  switch (static_cast<PackObjectType>(type)) {
+  case PackObjectType::Commit:
+    return "commit";
+  case PackObjectType::Tree:
+    return "tree";
+  case PackObjectType::Blob:
+    return "blob";
+  case PackObjectType::Tag:
+    return "tag";
+  default:
+    return nullptr;
+  }
+}
+
+bool packTypeFromName(const std::string &name, PackObjectType &type) {
+  if (name == "commit")
+    type = PackObjectType::Commit;
+  else if (name == "tree")
+    type = PackObjectType::Tree;
+  else if (name == "blob")
+    type = PackObjectType::Blob;
+  else if (name == "tag")
+    type = PackObjectType::Tag;
+  else
+    return false;
+  return true;
+}
+
+void appendEntryHeader(std::string &out, PackObjectType type, uint64_t size) {
+  unsigned char c = static_cast<unsigned char>(
+      (static_cast<uint8_t>(type) << 4) | (size & 0x0f));
+  size >>= 4;
+  while (size) {
+    out.push_back(static_cast<char>(c | 0x80));
+    c = static_cast<unsigned char>(size & 0x7f);
+    size >>= 7;
+  }
+  out.push_back(static_cast<char>(c));
+}
+
+int64_t directoryMtimeNs(const std::string &path) {
+  struct stat st {};
+  if (stat(path.c_str(), &st) != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+         st.st_mtim.tv_nsec;
+}
+
+} // namespace
+
+// ---------------- PackFile ----------------
+
+std::shared_ptr<PackFile> PackFile::open(const std::string &packPath) {
+  std::shared_ptr<PackFile> pack(new PackFile());
+  pack->packPath = packPath;
+  std::string idxPath = packPath.substr(0, packPath.size() - 5) + ".idx";
+
+  pack->idxData = mapFile(idxPath, pack->idxSize);
+  pack->packData = mapFile(packPath, pack->packSize);
+
+  const unsigned char *idx = pack->idxData;
+  size_t minIdx = 8 + 256 * 4 + 2 * kHashSize;
+  if (pack->idxSize < minIdx || std::memcmp(idx, kIdxMagic, 4) != 0 ||
+      readBE32(idx + 4) != kIdxVersion) {
+    throw PackException("Unsupported pack index: " + idxPath);
+  }
+  pack->fanout = idx + 8;
+  pack->count = readBE32(pack->fanout + 255 * 4);
+  pack->names = pack->fanout + 256 * 4;
+  const unsigned char *crcs = pack->names + pack->count * kHashSize;
+  pack->offsets = crcs + pack->count * 4;
+  pack->largeOffsets = pack->offsets + pack->count * 4;
+  if (static_cast<size_t>(pack->largeOffsets - idx) + 2 * kHashSize >
+      pack->idxSize) {
+    throw PackException("Truncated pack index: " + idxPath);
+  }
+  pack->largeOffsetCount =
+      (pack->idxSize - 2 * kHashSize - (pack->largeOffsets - idx)) / 8;
+
+  if (pack->packSize < 12 + kHashSize ||
+      std::memcmp(pack->packData, "PACK", 4) != 0 ||
+      readBE32(pack->packData + 4) != kPackVersion ||
+      readBE32(pack->packData + 8) != pack->count) {
+    throw PackException("Pack does not match its index: " + packPath);
+  }
+  return pack;
+}
+
+PackFile::~PackFile() {
+  if (packData) {
+    munmap(const_cast<unsigned char *>(packData), packSize);
+  }
+  if (idxData) {
+    munmap(const_cast<unsigned char *>(idxData), idxSize);
+  }
+}
+
+bool PackFile::findOffset(const ObjectId &id, uint64_t &offset) const {
+  const unsigned char first = id.data()[0];
+  uint32_t lo = first == 0 ? 0 : readBE32(fanout + (first - 1) * 4);
+  uint32_t hi = readBE32(fanout + first * 4);
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int cmp = std::memcmp(names + mid * kHashSize, id.data(), kHashSize);
+    if (cmp == 0) {
+      uint32_t small = readBE32(offsets + mid * 4);
+      if (small & 0x80000000u) {
+        uint32_t large = small & 0x7fffffffu;
+        if (large >= largeOffsetCount) {
+          throw PackException("Large offset out of range in index of " +
+                              packPath);
+        }
+        offset = readBE64(largeOffsets + static_cast<size_t>(large) * 8);
+      } else {
+        offset = small;
+      }
+      return true;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return false;
+}
+
+bool PackFile::contains(const ObjectId &id) const {
+  uint64_t offset = 0;
+  return findOffset(id, offset);
+}
+
+ObjectId PackFile::objectIdAt(uint32_t position) const {
+  return ObjectId::fromRaw(names + position * kHashSize);
+}
+
+std::string PackFile::readObject(const ObjectId &id) const {
+  uint64_t offset = 0;
+  if (!findOffset(id, offset)) {
+    return "";
+  }
+  return readObjectAt(offset);
+}
+
+std::string PackFile::readObjectAt(uint64_t offset) const {
+  uint8_t type = 0;
+  std::string body;
+  unpackEntry(offset, type, body);
+  std::string object =
+      std::string(packTypeName(type)) + " " + std::to_string(body.size());
+  object.push_back('\0');
+  object += body;
+  return object;
+}
+
+const unsigned char *PackFile::readEntryHeader(uint64_t offset,
+                                               uint8_t &type, uint64_t &size,
+                                               uint64_t &baseOffset) const {
+  const size_t dataEnd = packSize - kHashSize;
+  if (offset >= dataEnd) {
+    throw PackException("Object offset out of range in " + packPath);
+  }
+  const unsigned char *p = packData + offset;
+  const unsigned char *end = packData + dataEnd;
+  unsigned char c = *p++;
+  type = (c >> 4) & 0x07;
+  size = c & 0x0f;
+  int shift = 4;
+  while (c & 0x80) {
+    if (p >= end || shift > 57) {
+      throw PackException("Corrupt object header in " + packPath);
+    }
+    c = *p++;
+    size |= static_cast<uint64_t>(c & 0x7f) << shift;
+    shift += 7;
+  }
+
+  baseOffset = 0;
+  if (type == static_cast<uint8_t>(PackObjectType::OfsDelta)) {
+    if (p >= end) {
+      throw PackException("Truncated delta in " + packPath);
+    }
+    c = *p++;
+    uint64_t distance = c & 0x7f;
+    while (c & 0x80) {
+      if (p >= end) {
+        throw PackException("Truncated delta in " + packPath);
+      }
+      c = *p++;
+      distance = ((distance + 1) << 7) | (c & 0x7f);
+    }
+    if (distance == 0 || distance > offset) {
+      throw PackException("Invalid delta base offset in " + packPath);
+    }
+    baseOffset = offset - distance;
+  } else if (type == static_cast<uint8_t>(PackObjectType::RefDelta)) {
+    if (static_cast<size_t>(end - p) < kHashSize) {
+      throw PackException("Truncated delta in " + packPath);
+    }
+    ObjectId baseId = ObjectId::fromRaw(p);
+    p += kHashSize;
+    if (!findOffset(baseId, baseOffset)) {
+      throw PackException("Delta base " + baseId.hex() + " missing from " +
+                          packPath);
+    }
+  } else if (!packTypeName(type)) {
+    throw PackException("Unsupported pack object type " +
+                        std::to_string(type) + " in " + packPath);
+  }
+  return p;
+}
+
+bool PackFile::readHeader(const ObjectId &id, std::string &type,
+                          uint64_t &size) const {
+  uint64_t offset = 0;
+  if (!findOffset(id, offset)) {
+    return false;
+  }
+  const unsigned char *end = packData + packSize - kHashSize;
+  uint8_t entryType = 0;
+  uint64_t baseOffset = 0;
+  const unsigned char *data =
+      readEntryHeader(offset, entryType, size, baseOffset);
+  if (!packTypeName(entryType)) {
+    // Two varints of at most 10 bytes each: base size, then target size.
+    std::string delta =
+        inflatePrefix(data, static_cast<size_t>(end - data), 20);
+    size = deltaTargetSize(delta.data(), delta.size());
+    uint64_t baseSize = 0;
+    for (size_t chain = 1; !packTypeName(entryType); ++chain) {
+      if (chain > kMaxDeltaChain) {
+        throw PackException("Delta chain too long in " + packPath);
+      }
+      readEntryHeader(baseOffset, entryType, baseSize, baseOffset);
+    }
+  }
+  type = packTypeName(entryType);
+  return true;
+}
+
+bool PackFile::streamObject(const ObjectId &id, const HeaderFn &onHeader,
+                            const ZlibSink &onBody) const {
+  uint64_t offset = 0;
+  if (!findOffset(id, offset)) {
+    return false;
+  }
+  uint8_t type = 0;
+  uint64_t size = 0;
+  uint64_t baseOffset = 0;
+  const unsigned char *data = readEntryHeader(offset, type, size, baseOffset);
+  if (!packTypeName(type)) {
+    std::string body;
+    unpackEntry(offset, type, body);
+    if (onHeader) {
+      onHeader(packTypeName(type), body.size());
+    }
+    if (onBody && !body.empty()) {
+      onBody(body.data(), body.size());
+    }
+    return true;
+  }
+
+  if (onHeader) {
+    onHeader(packTypeName(type), size);
+  }
+  uint64_t received = 0;
+  ZlibInflater inflater([&](const char *chunk, size_t length) {
+    received += length;
+    if (received > size) {
+      throw PackException("Object " + id.hex() +
+                          " is larger than its entry header in " + packPath);
+    }
+    if (onBody) {
+      onBody(chunk, length);
+    }
+  });
+  const unsigned char *end = packData + packSize - kHashSize;
+  if (!inflater.write(data, static_cast<size_t>(end - data)) ||
+      received != size) {
+    throw PackException("Truncated object " + id.hex() + " in " + packPath);
+  }
+  return true;
+}
+
+void PackFile::unpackEntry(uint64_t offset, uint8_t &type,
+                           std::string &body) const {
+  const unsigned char *end = packData + packSize - kHashSize;
+  // Deltas are collected walking towards the base, then applied in reverse.
+  std::vector<std::string> deltas;
+
+  while (true) {
+    uint64_t size = 0;
+    uint64_t baseOffset = 0;
+    const unsigned char *p = readEntryHeader(offset, type, size, baseOffset);
+    std::string data = decompressZlib(p, static_cast<size_t>(end - p),
+                                      static_cast<size_t>(size));
+    if (packTypeName(type)) {
+      body = std::move(data);
+      break;
+    }
+    if (deltas.size() == kMaxDeltaChain) {
+      throw PackException("Delta chain too long in " + packPath);
+    }
+    deltas.push_back(std::move(data));
+    offset = baseOffset;
+  }
+
+  for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+    body = applyDelta(body, it->data(), it->size());
+  }
+}
+
+// ---------------- PackStore ----------------
+
+std::shared_ptr<PackStore> PackStore::forGitDir(const std::string &gitDir) {
+  static std::mutex registryMutex;
+  static std::map<std::string, std::shared_ptr<PackStore>> registry;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = registry.find(gitDir);
+  if (it != registry.end()) {
+    return it->second;
+  }
+  std::shared_ptr<PackStore> store(new PackStore(gitDir));
+  registry[gitDir] = store;
+  return store;
+}
+
+PackStore::PackStore(const std::string &gitDir)
+    : packDir(gitDir + "/objects/pack") {}
+
+void PackStore::scanLocked() {
+  packs.clear();
+  scannedMtimeNs = directoryMtimeNs(packDir);
+  scanned = true;
+  if (scannedMtimeNs < 0) {
+    return;
+  }
+  std::vector<std::string> packPaths;
+  for (const auto &entry : std::filesystem::directory_iterator(packDir)) {
+    std::string name = entry.path().filename().string();
+    if (name.rfind("pack-", 0) != 0 || entry.path().extension() != ".idx") {
+      continue;
+    }
+    std::string packPath = entry.path().string();
+    packPath = packPath.substr(0, packPath.size() - 4) + ".pack";
+    if (std::filesystem::exists(packPath)) {
+      packPaths.push_back(packPath);
+    }
+  }
+  std::sort(packPaths.begin(), packPaths.end());
+  for (const auto &packPath : packPaths) {
+    try {
+      packs.push_back(PackFile::open(packPath));
+    } catch (const std::exception &e) {
+      std::cerr << "Ignoring unreadable pack " << packPath << ": " << e.what()
+                << std::endl;
+    }
+  }
+}
+
+bool PackStore::refreshIfChangedLocked() {
+  if (!scanned || directoryMtimeNs(packDir) != scannedMtimeNs) {
+    scanLocked();
+    return true;
+  }
+  return false;
+}
+
+void PackStore::reload() {
+  std::lock_guard<std::mutex> lock(mutex);
+  scanLocked();
+}
+
+bool PackStore::contains(const ObjectId &id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!scanned) {
+    scanLocked();
+  }
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (const auto &pack : packs) {
+      if (pack->contains(id)) {
+        return true;
+      }
+    }
+    // A miss may mean another process (gc, pull) added a pack meanwhile.
+    if (!refreshIfChangedLocked()) {
+      break;
+    }
+  }
+  return false;
+}
+
+std::string PackStore::readObject(const ObjectId &id) {
+  std::vector<std::shared_ptr<PackFile>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!scanned) {
+      scanLocked();
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->contains(id)) {
+      return pack->readObject(id);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!refreshIfChangedLocked()) {
+      return "";
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->contains(id)) {
+      return pack->readObject(id);
+    }
+  }
+  return "";
+}
+
+bool PackStore::readHeader(const ObjectId &id, std::string &type,
+                           uint64_t &size) {
+  std::vector<std::shared_ptr<PackFile>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!scanned) {
+      scanLocked();
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->readHeader(id, type, size)) {
+      return true;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!refreshIfChangedLocked()) {
+      return false;
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->readHeader(id, type, size)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PackStore::streamObject(const ObjectId &id,
+                             const PackFile::HeaderFn &onHeader,
+                             const ZlibSink &onBody) {
+  std::vector<std::shared_ptr<PackFile>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!scanned) {
+      scanLocked();
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->streamObject(id, onHeader, onBody)) {
+      return true;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!refreshIfChangedLocked()) {
+      return false;
+    }
+    snapshot = packs;
+  }
+  for (const auto &pack : snapshot) {
+    if (pack->streamObject(id, onHeader, onBody)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<ObjectId> PackStore::listObjects() {
+  std::lock_guard<std::mutex> lock(mutex);
+  refreshIfChangedLocked();
+  std::vector<ObjectId> result;
+  for (const auto &pack : packs) {
+    for (uint32_t i = 0; i < pack->objectCount(); ++i) {
+      result.push_back(pack->objectIdAt(i));
+    }
+  }
+  return result;
+}
+
+size_t PackStore::packCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  refreshIfChangedLocked();
+  return packs.size();
+}
+
+// ---------------- PackWriter ----------------
+
+PackWriter::PackWriter(const std::string &gitDir, ObjectLoader loader,
+                       HeaderLoader headerLoader)
+    : gitDir(gitDir), loader(std::move(loader)),
+      headerLoader(std::move(headerLoader)) {}
+
+void PackWriter::addObject(const ObjectId &id, const std::string &nameHint) {
+  PendingObject object;
+  object.id = id;
+  // Same hash as git's pack_name_hash(): the last characters of the path
+  // weigh most, so "a/Makefile" and "b/Makefile" sort next to each other.
+  for (unsigned char c : nameHint) {
+    if (std::isspace(c)) {
+      continue;
+    }
+    object.nameHash = (object.nameHash >> 2) + (static_cast<uint32_t>(c) << 24);
+  }
+  pending.push_back(object);
+}
+
+void PackWriter::setDeltaOptions(size_t window, size_t depth) {
+  this->window = window;
+  this->depth = depth;
+}
+
+std::string PackWriter::write() {
+  struct IndexRecord {
+    ObjectId id;
+    uint64_t offset;
+    uint32_t crc;
+  };
+  struct WindowEntry {
+    PackObjectType type;
+    uint64_t offset;
+    size_t depth;
+    std::unique_ptr<DeltaIndex> index;
+  };
+
+  auto splitObject = [](const std::string &object, PackObjectType &type,
+                        size_t &bodyStart) {
+    size_t nullPos = object.find('\0');
+    size_t spacePos = object.find(' ');
+    if (object.empty() || nullPos == std::string::npos ||
+        spacePos == std::string::npos || spacePos > nullPos) {
+      return false;
+    }
+    bodyStart = nullPos + 1;
+    return packTypeFromName(object.substr(0, spacePos), type);
+  };
+
+  // Pass 1: learn type and size of every object so they can be ordered for
+  // the delta search. Only headers are read when the caller can supply them.
+  std::vector<PendingObject> objects;
+  objects.reserve(pending.size());
+  for (auto object : pending) {
+    std::string typeName;
+    uint64_t size = 0;
+    if (headerLoader) {
+      if (!headerLoader(object.id, typeName, size) ||
+          !packTypeFromName(typeName, object.type)) {
+        std::cerr << "Skipping unreadable object " << object.id << std::endl;
+        continue;
+      }
+      object.size = static_cast<size_t>(size);
+    } else {
+      std::string data = loader(object.id);
+      size_t bodyStart = 0;
+      if (!splitObject(data, object.type, bodyStart)) {
+        std::cerr << "Skipping unreadable object " << object.id << std::endl;
+        continue;
+      }
+      object.size = data.size() - bodyStart;
+    }
+    objects.push_back(object);
+  }
+  std::sort(objects.begin(), objects.end(),
+            [](const PendingObject &a, const PendingObject &b) {
+              if (a.type != b.type)
+                return a.type < b.type;
+              if (a.nameHash != b.nameHash)
+                return a.nameHash < b.nameHash;
+              if (a.size != b.size)
+                return a.size > b.size;
+              return a.id < b.id;
+            });
+  if (objects.empty()) {
+    return "";
+  }
+
+  std::string packDir = gitDir + "/objects/pack";
+  std::filesystem::create_directories(packDir);
+
+  // The pack is streamed to a temporary file and hashed as it goes; only
+  // the delta window stays in memory.
+  std::string tmpPackPath = packDir + "/tmp_pack_" + std::to_string(getpid());
+  std::fstream out(tmpPackPath, std::ios::binary | std::ios::in |
+                                    std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    throw PackException("Failed to create " + tmpPackPath);
+  }
+  Sha1 packHash;
+  uint64_t packOffset = 0;
+  auto emit = [&](const std::string &data) {
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    packHash.update(data);
+    packOffset += data.size();
+  };
+
+  written.clear();
+  deltaCount = 0;
+  std::vector<IndexRecord> records;
+  std::deque<WindowEntry> recent;
+  // The count is what pass 1 found readable; patched if pass 2 disagrees.
+  std::string header = "PACK";
+  appendBE32(header, kPackVersion);
+  appendBE32(header, static_cast<uint32_t>(objects.size()));
+  emit(header);
+
+  // Pass 2: write objects in sorted order; bases always precede deltas.
+  std::string entry;
+  for (const auto &object : objects) {
+    std::string data = loader(object.id);
+    PackObjectType type;
+    size_t bodyStart = 0;
+    if (!splitObject(data, type, bodyStart)) {
+      std::cerr << "Skipping unreadable object " << object.id << std::endl;
+      continue;
+    }
+    std::string body = data.substr(bodyStart);
+    data.clear();
+    data.shrink_to_fit();
+
+    // Pick the smallest delta in the window; as in git, the acceptable size
+    // shrinks for bases that are already deep in a chain.
+    std::string bestDelta;
+    const WindowEntry *bestBase = nullptr;
+    if (window > 0 && depth > 0 && body.size() >= 64 &&
+        body.size() <= kMaxDeltaObject) {
+      for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+        if (it->type != type || it->depth >= depth || !it->index) {
+          continue;
+        }
+        size_t sourceSize = it->index->getSource().size();
+        if (sourceSize < body.size() / 32) {
+          continue;
+        }
+        size_t limit = (body.size() / 2 - 20) * (depth - it->depth) / depth;
+        if (!bestDelta.empty() && bestDelta.size() - 1 < limit) {
+          limit = bestDelta.size() - 1;
+        }
+        if (limit == 0) {
+          continue;
+        }
+        std::string delta = it->index->createDelta(body, limit);
+        if (!delta.empty()) {
+          bestDelta = std::move(delta);
+          bestBase = &*it;
+        }
+      }
+    }
+
+    IndexRecord record;
+    record.id = object.id;
+    record.offset = packOffset;
+    size_t entryDepth = 0;
+    entry.clear();
+    if (bestBase) {
+      appendEntryHeader(entry, PackObjectType::OfsDelta, bestDelta.size());
+      uint64_t distance = record.offset - bestBase->offset;
+      unsigned char buf[10];
+      size_t pos = sizeof(buf) - 1;
+      buf[pos] = distance & 0x7f;
+      while (distance >>= 7) {
+        buf[--pos] = static_cast<unsigned char>(0x80 | (--distance & 0x7f));
+      }
+      entry.append(reinterpret_cast<const char *>(buf + pos),
+                   sizeof(buf) - pos);
+      entry += compressZlib(bestDelta, compressionLevel);
+      entryDepth = bestBase->depth + 1;
+      ++deltaCount;
+    } else {
+      appendEntryHeader(entry, type, body.size());
+      entry += compressZlib(body, compressionLevel);
+    }
+    record.crc = crc32(0L, reinterpret_cast<const Bytef *>(entry.data()),
+                       static_cast<uInt>(entry.size()));
+    emit(entry);
+    records.push_back(record);
+    written.push_back(object.id);
+
+    if (window > 0) {
+      WindowEntry windowEntry{type, record.offset, entryDepth, nullptr};
+      if (body.size() <= kMaxDeltaObject) {
+        windowEntry.index = std::make_unique<DeltaIndex>(std::move(body));
+      }
+      recent.push_back(std::move(windowEntry));
+      if (recent.size() > window) {
+        recent.pop_front();
+      }
+    }
+  }
+  recent.clear();
+
+  if (records.empty()) {
+    out.close();
+    std::filesystem::remove(tmpPackPath);
+    return "";
+  }
+  std::string checksum;
+  if (records.size() == objects.size()) {
+    checksum = packHash.finalRaw();
+  } else {
+    // An object vanished between the passes: fix the count and rehash the
+    // file, as git's fixup_pack_header_footer does.
+    std::string count;
+    appendBE32(count, static_cast<uint32_t>(records.size()));
+    out.seekp(8);
+    out.write(count.data(), 4);
+    out.seekg(0);
+    Sha1 rehash;
+    std::vector<char> chunk(1 << 16);
+    uint64_t remaining = packOffset;
+    while (remaining > 0 && out) {
+      size_t want = static_cast<size_t>(
+          std::min<uint64_t>(remaining, chunk.size()));
+      out.read(chunk.data(), static_cast<std::streamsize>(want));
+      rehash.update(chunk.data(), want);
+      remaining -= want;
+    }
+    checksum = rehash.finalRaw();
+    out.clear();
+    out.seekp(0, std::ios::end);
+  }
+  out.write(checksum.data(), static_cast<std::streamsize>(checksum.size()));
+  out.close();
+  if (!out) {
+    std::filesystem::remove(tmpPackPath);
+    throw PackException("Failed to write " + tmpPackPath);
+  }
+
+  std::sort(records.begin(), records.end(),
+            [](const IndexRecord &a, const IndexRecord &b) {
+              return a.id < b.id;
+            });
+
+  std::string idx(reinterpret_cast<const char *>(kIdxMagic), 4);
+  appendBE32(idx, kIdxVersion);
+  uint32_t buckets[256] = {0};
+  for (const auto &record : records) {
+    buckets[record.id.data()[0]]++;
+  }
+  uint32_t running = 0;
+  for (uint32_t bucket : buckets) {
+    running += bucket;
+    appendBE32(idx, running);
+  }
+  for (const auto &record : records) {
+    idx.append(reinterpret_cast<const char *>(record.id.data()),
+               ObjectId::kRawSize);
+  }
+  for (const auto &record : records) {
+    appendBE32(idx, record.crc);
+  }
+  std::vector<uint64_t> large;
+  for (const auto &record : records) {
+    if (record.offset >= 0x80000000ull) {
+      appendBE32(idx, 0x80000000u | static_cast<uint32_t>(large.size()));
+      large.push_back(record.offset);
+    } else {
+      appendBE32(idx, static_cast<uint32_t>(record.offset));
+    }
+  }
+  for (uint64_t offset : large) {
+    appendBE64(idx, offset);
+  }
+  idx += checksum;
+  idx += hash_sha1_raw(idx);
+
+  std::string base = packDir + "/pack-" + binaryToHex(checksum);
+
+  // The .idx is what makes a pack visible, so it is renamed in last.
+  auto writeAtomically = [](const std::string &path, const std::string &data) {
+    std::string tmpPath = path + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      throw PackException("Failed to create " + tmpPath);
+    }
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    out.close();
+    if (!out) {
+      throw PackException("Failed to write " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path);
+  };
+  std::filesystem::rename(tmpPackPath, base + ".pack");
+  writeAtomically(base + ".idx", idx);
+  return base + ".pack";
+}
@@ -1,25 +1,36 @@
 #include "headers/GitRepository.hpp"
 #include "headers/GitBranch.hpp"
+#include "headers/GitCommitGraph.hpp"
 #include "headers/GitConfig.hpp"
 #include "headers/GitHead.hpp"
 #include "headers/GitIndex.hpp"
 #include "headers/GitInit.hpp"
 #include "headers/GitMerge.hpp"
+#include "headers/GitMergeBase.hpp"
 #include "headers/GitObjectStorage.hpp"
 #include "headers/GitObjectTypesClasses.hpp"
+#include "headers/GitPackFile.hpp"
+#include "headers/GitWorkTree.hpp"
 #include "headers/ZlibUtils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 GitRepository::GitRepository(const std::string &root)
-    : gitDir(root), merge(nullptr) {}
+    : gitDir(root), objectCache(ObjectCache::forGitDir(root)),
+      merge(nullptr) {}
 
 void GitRepository::ensureMergeInitialized() {
   if (!merge && std::filesystem::exists(gitDir)) {
@@ -30,6 +41,7 @@ void GitRepository::ensureMergeInitialized() {
 bool GitRepository::init(const std::string &path) {
   try {
     gitDir = path;
+    objectCache = ObjectCache::forGitDir(gitDir);
     GitInit objInit(gitDir);
     objInit.run();
     ensureMergeInitialized();
@@ -41,9 +53,9 @@ bool GitRepository::init(const std::string &path) {
 }
 
 // ---------- Blob / Tree ----------
-std::string GitRepository::writeObject(const GitObjectType type,
-                                       const std::string &path,
-                                       const bool &write) {
+ObjectId GitRepository::writeObject(const GitObjectType type,
+                                    const std::string &path,
+                                    const bool &write) {
   if (type == GitObjectType::Blob) {
     BlobObject blob(gitDir);
     return blob.writeObject(path, write);
@@ -52,43 +64,67 @@ std::string GitRepository::writeObject(const GitObjectType type,
     return tree.writeObject(path);
   } else {
     std::cerr << "Invalid object type for path-based creation\n";
-    return "";
+    return ObjectId();
   }
 }
 
 // ---------- Commit ----------
-std::string GitRepository::writeObject(GitObjectType type,
-                                       const CommitData &data) {
+ObjectId GitRepository::writeObject(GitObjectType type,
+                                    const CommitData &data) {
   if (type != GitObjectType::Commit) {
     std::cerr << "Invalid object type used for commit\n";
-    return "";
+    return ObjectId();
   }
   CommitObject commit(gitDir);
   return commit.writeObject(data);
 }
 
 // ---------- Tag ----------
-std::string GitRepository::writeObject(GitObjectType type,
-                                       const TagData &data) {
+ObjectId GitRepository::writeObject(GitObjectType type,
+                                    const TagData &data) {
   if (type != GitObjectType::Tag) {
     std::cerr << "Invalid object type used for tag\n";
-    return "";
+    return ObjectId();
   }
   TagObject tag(gitDir);
   return tag.writeObject(data);
 }
 
-std::string GitRepository::readObjectRaw(const std::string &path) {
+ObjectView GitRepository::readObjectRaw(const ObjectId &id) {
+  GitObjectStorage obj(gitDir);
+  return obj.readObjectView(id);
+}
+
+bool GitRepository::readObjectHeader(const ObjectId &id, std::string &type,
+                                     uint64_t &size) {
+  GitObjectStorage obj(gitDir);
+  return obj.readObjectHeader(id, type, size);
+}
+
+bool GitRepository::streamObjectRaw(
+    const ObjectId &id, const GitObjectStorage::ObjectHeaderFn &onHeader,
+    const ZlibSink &onBody) {
   GitObjectStorage obj(gitDir);
-  return obj.readObject(path);
+  return obj.streamObject(id, onHeader, onBody);
 }
 
 std::string GitRepository::readObject(const GitObjectType type,
-                                      const std::string &hash) {
+                                      const ObjectId &hash) {
+  // Check the type from the header before anything is inflated and parsed.
+  GitObjectStorage storage(gitDir);
+  std::string actualType;
+  uint64_t size = 0;
+  if (!storage.readObjectHeader(hash, actualType, size)) {
+    return "";
+  }
+  if (storage.parseGitObjectTypeFromString(actualType) != type) {
+    std::cerr << "Error: " << hash << " is a " << actualType << ", not a "
+              << storage.objectTypeToString(type) << ".\n";
+    return "";
+  }
   if (type == GitObjectType::Blob) {
     BlobObject blob(gitDir);
-    BlobData data = blob.readObject(hash);
-    return data.content;
+    return std::string(blob.readView(hash).body());
   } else if (type == GitObjectType::Tree) {
     TreeObject tree(gitDir);
     std::vector<TreeEntry> entries = tree.readObject(hash);
@@ -125,37 +161,102 @@ std::string GitRepository::readObject(const GitObjectType type,
   }
 }
 
-void GitRepository::indexHandler(const std::vector<std::string> &paths) {
+void GitRepository::indexHandler(const std::vector<std::string> &paths,
+                                 bool force) {
   IndexManager idx(gitDir);
-  if (!idx.readIndex()) {
-    std::cerr << "Failed to read index." << std::endl;
-    return;
-  }
+  // Ignore rules only keep untracked files out; tracked ones are updated.
+  IgnoreStack::Ptr ignore = IgnoreStack::forRepository(gitDir);
 
   if (paths.size() == 1 && paths[0] == ".") {
-    for (const auto &entry :
-         std::filesystem::recursive_directory_iterator(".")) {
-      if (entry.is_regular_file()) {
-        std::string pathStr = entry.path().string();
-        IndexEntry newEntry = idx.gitIndexEntryFromPath(pathStr);
-        if (!newEntry.hash.empty()) {
-          idx.addOrUpdateEntry(newEntry);
+    if (!idx.readIndex()) {
+      std::cerr << "Failed to read index." << std::endl;
+      return;
+    }
+    std::unordered_set<std::string> tracked;
+    for (const auto &entry : idx.getEntries()) {
+      tracked.insert(entry.path);
+    }
+    // Hash and store blobs in parallel, then apply them in path order.
+    // With an fsmonitor daemon running, only untracked files and the
+    // tracked ones it reports are looked at; otherwise the whole tree is.
+    WorkTreeScanner scanner(".");
+    std::vector<std::string> files;
+    if (force || !idx.listChangedFiles(ignore, files)) {
+      files = scanner.listFiles(force ? nullptr : ignore);
+      if (!force) {
+        // Tracked files inside ignored directories were not listed.
+        std::unordered_set<std::string> listed(files.begin(), files.end());
+        for (const auto &path : tracked) {
+          if (!listed.count(path) && std::filesystem::is_regular_file(path)) {
+            files.push_back(path);
+          }
         }
+        std::sort(files.begin(), files.end());
       }
     }
-  } else {
-    for (const std::string &path : paths) {
-      if (!std::filesystem::exists(path)) {
-        std::cerr << "Error: Path does not exist: " << path << std::endl;
-        continue; // don't return, just skip this one
+    // Tracked files whose stat data shows no change are left as they are;
+    // their entries keep a null hash below.
+    std::vector<IndexEntry> newEntries(files.size());
+    scanner.parallelFor(files.size(), [&](size_t i) {
+      if (!idx.isUnchanged(files[i])) {
+        newEntries[i] = idx.gitIndexEntryFromPath(files[i]);
       }
-      IndexEntry newEntry = idx.gitIndexEntryFromPath(path);
-      if (!newEntry.hash.empty()) {
+    });
+    for (const auto &newEntry : newEntries) {
+      if (!newEntry.hash.isNull()) {
         idx.addOrUpdateEntry(newEntry);
       }
     }
+    idx.writeIndex();
+    return;
   }
 
+  // Named paths are looked up in the mapped index; it is only decoded and
+  // rewritten when one of them has to be staged.
+  if (!idx.mapIndex()) {
+    std::cerr << "Failed to read index." << std::endl;
+    return;
+  }
+  std::vector<IndexEntry> newEntries;
+  std::vector<std::string> ignoredPaths;
+  for (const std::string &path : paths) {
+    if (!std::filesystem::exists(path)) {
+      std::cerr << "Error: Path does not exist: " << path << std::endl;
+      continue; // don't return, just skip this one
+    }
+    std::string relative =
+        std::filesystem::path(path).lexically_normal().generic_string();
+    if (!force && !idx.isTracked(relative) &&
+        IgnoreStack::isPathIgnored(ignore, ".", relative)) {
+      ignoredPaths.push_back(path);
+      continue;
+    }
+    if (idx.isUnchanged(relative)) {
+      continue;
+    }
+    IndexEntry newEntry = idx.gitIndexEntryFromPath(path);
+    if (!newEntry.hash.isNull()) {
+      newEntries.push_back(std::move(newEntry));
+    }
+  }
+  if (!ignoredPaths.empty()) {
+    std::cerr << "The following paths are ignored by one of your "
+              << IgnoreStack::kFileName << " files:\n";
+    for (const auto &path : ignoredPaths) {
+      std::cerr << path << "\n";
+    }
+    std::cerr << "hint: Use -f if you really want to add them.\n";
+  }
+  if (newEntries.empty()) {
+    return;
+  }
+  if (!idx.readIndex()) {
+    std::cerr << "Failed to read index." << std::endl;
+    return;
+  }
+  for (const auto &newEntry : newEntries) {
+    idx.addOrUpdateEntry(newEntry);
+  }
   idx.writeIndex();
 }
 
@@ -163,9 +264,9 @@ bool GitRepository::reportStatus(bool shortFormat, bool showUntracked) {
   try {
     IndexManager idx(gitDir);
 
-    std::string headCommitHash = getHashOfBranchHead(getCurrentBranch());
-    std::string headTreeHash;
-    if (!headCommitHash.empty()) {
+    ObjectId headCommitHash = getHashOfBranchHead(getCurrentBranch());
+    ObjectId headTreeHash;
+    if (!headCommitHash.isNull()) {
       CommitObject commitObj(gitDir);
       CommitData commitData = commitObj.readObject(headCommitHash);
       headTreeHash = commitData.tree;
@@ -176,7 +277,7 @@ bool GitRepository::reportStatus(bool shortFormat, bool showUntracked) {
     std::ostringstream out;
     out << "On branch " << getCurrentBranch() << "\n";
 
-    if (headCommitHash.empty()) {
+    if (headCommitHash.isNull()) {
       out << "\nNo commits yet\n";
     }
 
@@ -268,8 +369,8 @@ bool GitRepository::changeCurrentBranch(const std::string &targetBranch,
     gitHead head(gitDir);
     head.writeHeadToHeadOfNewBranch(targetBranch);
     // After switching, restore working directory to latest commit on branch
-    std::string latest = getHashOfBranchHead(targetBranch);
-    if (!latest.empty()) {
+    ObjectId latest = getHashOfBranchHead(targetBranch);
+    if (!latest.isNull()) {
       gotoStateAtPerticularCommit(latest);
     }
     return true;
@@ -279,9 +380,10 @@ bool GitRepository::changeCurrentBranch(const std::string &targetBranch,
   }
 }
 
-std::string GitRepository::getHashOfBranchHead(const std::string &branchName) {
+ObjectId GitRepository::getHashOfBranchHead(const std::string &branchName) {
   Branch branchObj(gitDir);
-  return branchObj.getBranchHash(branchName);
+  // Refs stay hex text on disk.
+  return ObjectId::fromHex(branchObj.getBranchHash(branchName));
 }
 
 bool GitRepository::deleteBranch(const std::string &branchName) {
@@ -298,8 +400,8 @@ bool GitRepository::renameBranch(const std::string &oldName,
 bool GitRepository::exportHeadAsZip(const std::string &branchName,
                                     const std::string &outputZipPath) {
   // Step 1: Get HEAD commit hash of the branch
-  std::string commitHash = getHashOfBranchHead(branchName);
-  if (commitHash.empty()) {
+  ObjectId commitHash = getHashOfBranchHead(branchName);
+  if (commitHash.isNull()) {
     std::cerr << "Branch '" << branchName << "' does not exist.\n";
     return false;
   }
@@ -307,7 +409,7 @@ bool GitRepository::exportHeadAsZip(const std::string &branchName,
   // Step 2: Get tree hash from the commit
   CommitObject commitObj(gitDir);
   CommitData commitData = commitObj.readObject(commitHash);
-  std::string treeHash = commitData.tree;
+  ObjectId treeHash = commitData.tree;
 
   // Step 3: Create a temporary export directory
   std::string tempDir = ".mgit_export_tmp";
@@ -359,9 +461,9 @@ bool GitRepository::isFullyMerged(const std::string &branchName) {
   }
 
   // Get commit histories for both branches
-  std::unordered_set<std::string> currentBranchHistory =
+  std::unordered_set<ObjectId> currentBranchHistory =
       logBranchCommitHistory(currentBranch);
-  std::unordered_set<std::string> targetBranchHistory =
+  std::unordered_set<ObjectId> targetBranchHistory =
       logBranchCommitHistory(branchName);
 
   // Check if all commits from target branch are in current branch
@@ -412,14 +514,14 @@ bool GitRepository::mergeBranch(const std::string &targetBranch) {
     throw std::runtime_error("Cannot merge branch into itself");
   }
 
-  std::string currentHead = getHashOfBranchHead(currentBranch);
-  std::string targetHead = getHashOfBranchHead(targetBranch);
+  ObjectId currentHead = getHashOfBranchHead(currentBranch);
+  ObjectId targetHead = getHashOfBranchHead(targetBranch);
 
-  if (currentHead.empty() || targetHead.empty()) {
+  if (currentHead.isNull() || targetHead.isNull()) {
     throw std::runtime_error("One or both branches have no commits");
   }
 
-  std::string baseCommitHash = findCommonAncestor(currentHead, targetHead);
+  ObjectId baseCommitHash = findCommonAncestor(currentHead, targetHead);
 
   if (baseCommitHash == targetHead) {
     std::cout << "Already up-to-date." << std::endl;
@@ -430,18 +532,18 @@ bool GitRepository::mergeBranch(const std::string &targetBranch) {
     // Fast-forward merge
     gotoStateAtPerticularCommit(targetHead);
     gitHead head(gitDir);
-    head.updateHead(targetHead);
+    head.updateHead(targetHead.hex());
     std::cout << "Fast-forward merge." << std::endl;
     return true;
   }
 
   CommitObject commitObj(gitDir);
-  std::string baseTree = commitObj.readObject(baseCommitHash).tree;
-  std::string ourTree = commitObj.readObject(currentHead).tree;
-  std::string theirTree = commitObj.readObject(targetHead).tree;
+  ObjectId baseTree = commitObj.readObject(baseCommitHash).tree;
+  ObjectId ourTree = commitObj.readObject(currentHead).tree;
+  ObjectId theirTree = commitObj.readObject(targetHead).tree;
 
   TreeObject treeObj(gitDir);
-  std::map<std::string, std::string> baseFiles, ourFiles, theirFiles;
+  std::map<std::string, ObjectId> baseFiles, ourFiles, theirFiles;
   treeObj.getAllFiles(baseTree, baseFiles);
   treeObj.getAllFiles(ourTree, ourFiles);
   treeObj.getAllFiles(theirTree, theirFiles);
@@ -459,9 +561,10 @@ bool GitRepository::mergeBranch(const std::string &targetBranch) {
     allPaths.insert(path);
 
   for (const std::string &path : allPaths) {
-    std::string baseHash = baseFiles.count(path) ? baseFiles[path] : "";
-    std::string ourHash = ourFiles.count(path) ? ourFiles[path] : "";
-    std::string theirHash = theirFiles.count(path) ? theirFiles[path] : "";
+    // Missing on a side reads as the null ID.
+    ObjectId baseHash = baseFiles[path];
+    ObjectId ourHash = ourFiles[path];
+    ObjectId theirHash = theirFiles[path];
 
     if (ourHash != theirHash) {
       if (baseHash == ourHash) { // Changed in theirs
@@ -470,21 +573,21 @@ bool GitRepository::mergeBranch(const std::string &targetBranch) {
         idx.addOrUpdateEntry(entry);
         BlobObject blob(gitDir);
         std::ofstream f(path);
-        f << blob.readObject(theirHash).content;
+        f << blob.readView(theirHash).body();
         f.close();
       } else if (baseHash == theirHash) { // Changed in ours
         // Do nothing, it's already in our branch
       } else { // Conflict
         conflictingFiles.push_back(path);
         BlobObject blob(gitDir);
-        std::string ourContent = blob.readObject(ourHash).content;
-        std::string theirContent = blob.readObject(theirHash).content;
+        ObjectView ourContent = blob.readView(ourHash);
+        ObjectView theirContent = blob.readView(theirHash);
 
         std::ofstream f(path);
         f << "<<<<<<< HEAD\n";
-        f << ourContent;
+        f << ourContent.body();
         f << "=======\n";
-        f << theirContent;
+        f << theirContent.body();
         f << ">>>>>>> " << targetBranch << "\n";
         f.close();
 
@@ -537,7 +640,7 @@ bool GitRepository::resolveConflicts() {
   }
 
   // All conflicts resolved, proceed with commit
-  std::string currentHead = getHashOfBranchHead(getCurrentBranch());
+  ObjectId currentHead = getHashOfBranchHead(getCurrentBranch());
   std::string mergeHead;
   std::ifstream mergeHeadFile(gitDir + "/MERGE_HEAD");
   if (mergeHeadFile) {
@@ -552,7 +655,7 @@ bool GitRepository::resolveConflicts() {
     mergeBranchFile.close();
   }
 
-  if (currentHead.empty() || mergeHead.empty() || targetBranch.empty()) {
+  if (currentHead.isNull() || mergeHead.empty() || targetBranch.empty()) {
     std::cerr << "error: Could not find HEAD, MERGE_HEAD, or MERGE_BRANCH. "
                  "Cannot complete merge."
               << std::endl;
@@ -571,22 +674,22 @@ bool GitRepository::resolveConflicts() {
   }
 }
 
-std::string GitRepository::createMergeCommit(const std::string &message,
-                                             const std::string &author,
-                                             const std::string &currentCommit,
-                                             const std::string &targetCommit) {
+ObjectId GitRepository::createMergeCommit(const std::string &message,
+                                          const std::string &author,
+                                          const ObjectId &currentCommit,
+                                          const ObjectId &targetCommit) {
   // Validate inputs
-  if (message.empty() || currentCommit.empty() || targetCommit.empty()) {
+  if (message.empty() || currentCommit.isNull() || targetCommit.isNull()) {
     std::cerr << "Error: Invalid merge commit parameters\n";
-    return "";
+    return ObjectId();
   }
 
   // Create commit data
   CommitData data;
   data.tree = writeObject(GitObjectType::Tree, ".", true);
-  if (data.tree.empty()) {
+  if (data.tree.isNull()) {
     std::cerr << "Error: Failed to create tree object\n";
-    return "";
+    return ObjectId();
   }
 
   // Add both parents
@@ -597,10 +700,10 @@ std::string GitRepository::createMergeCommit(const std::string &message,
   data.message = message;
 
   // Create commit object
-  std::string hash = writeObject(GitObjectType::Commit, data);
-  if (hash.empty()) {
+  ObjectId hash = writeObject(GitObjectType::Commit, data);
+  if (hash.isNull()) {
     std::cerr << "Error: Failed to create merge commit\n";
-    return "";
+    return ObjectId();
   }
 
   return hash;
@@ -618,10 +721,10 @@ bool GitRepository::abortMerge() {
       std::filesystem::remove(mergeBranchPath);
     }
 
-    std::string headCommit = getHashOfBranchHead(getCurrentBranch());
-    if (headCommit.empty()) {
+    ObjectId headCommit = getHashOfBranchHead(getCurrentBranch());
+    if (headCommit.isNull()) {
       IndexManager idx(gitDir);
-      idx.resetFromTree(""); // Reset to an empty index
+      idx.resetFromTree(ObjectId()); // Reset to an empty index
       // Also need to clean the working directory
       for (auto &p : std::filesystem::directory_iterator(".")) {
         if (p.path().filename() != ".git" && p.path().filename() != ".mgit") {
@@ -634,7 +737,7 @@ bool GitRepository::abortMerge() {
 
     CommitObject commitObj(gitDir);
     CommitData commitData = commitObj.readObject(headCommit);
-    std::string headTreeHash = commitData.tree;
+    ObjectId headTreeHash = commitData.tree;
 
     TreeObject treeObj(gitDir);
     treeObj.restoreWorkingDirectoryFromTreeHash(headTreeHash, ".");
@@ -663,7 +766,7 @@ bool GitRepository::isConflicted(const std::string &path) {
 }
 
 bool GitRepository::resolveConflict(const std::string &path,
-                                    const std::string &hash) {
+                                    const ObjectId &hash) {
   try {
     IndexManager idx(gitDir);
     return idx.resolveConflict(path, hash);
@@ -704,17 +807,17 @@ bool GitRepository::createCommit(const std::string &message,
   }
 
   TreeObject tree(gitDir);
-  std::string treeHash = tree.writeTreeFromIndex(idx.getEntries());
+  ObjectId treeHash = tree.writeTreeFromIndex(idx);
 
-  if (treeHash.empty()) {
+  if (treeHash.isNull()) {
     std::cerr << "Failed to create tree from index.\n";
     return false;
   }
 
   CommitData data;
   data.tree = treeHash;
-  std::string parent = getHashOfBranchHead(getCurrentBranch());
-  if (!parent.empty()) {
+  ObjectId parent = getHashOfBranchHead(getCurrentBranch());
+  if (!parent.isNull()) {
     data.parents.push_back(parent);
   }
 
@@ -724,7 +827,7 @@ bool GitRepository::createCommit(const std::string &message,
     std::ifstream mergeHeadFile(mergeHeadPath);
     std::string mergeParent;
     mergeHeadFile >> mergeParent;
-    data.parents.push_back(mergeParent);
+    data.parents.push_back(ObjectId::fromHex(mergeParent));
     std::filesystem::remove(mergeHeadPath);
   }
 
@@ -734,25 +837,25 @@ bool GitRepository::createCommit(const std::string &message,
   data.committer =
       userName + " <" + userEmail + "> " + getCurrentTimestampWithTimezone();
   data.message = message;
-  std::string hash = writeObject(GitObjectType::Commit, data);
+  ObjectId hash = writeObject(GitObjectType::Commit, data);
   std::cout << "Commit object written: " << hash << "\n";
   gitHead head(gitDir);
-  head.updateHead(hash);
+  head.updateHead(hash.hex());
+  updateCommitGraph(gitDir, {hash});
   return true;
 }
 
-std::unordered_set<std::string>
+std::unordered_set<ObjectId>
 GitRepository::logBranchCommitHistory(const std::string &branchName) {
-  std::string currHash = getHashOfBranchHead(branchName);
-  std::unordered_set<std::string> commitList;
+  ObjectId currHash = getHashOfBranchHead(branchName);
+  std::unordered_set<ObjectId> commitList;
 
-  CommitObject commitObj(gitDir);
+  CommitInfoReader commits(gitDir);
+  CommitInfo commit;
 
-  while (!currHash.empty()) {
+  while (!currHash.isNull()) {
     commitList.insert(currHash);
-    CommitData commit = commitObj.readObject(currHash);
-
-    if (commit.parents.empty()) {
+    if (!commits.read(currHash, commit) || commit.parents.empty()) {
       break;
     }
 
@@ -762,35 +865,189 @@ GitRepository::logBranchCommitHistory(const std::string &branchName) {
   return commitList;
 }
 
-std::string GitRepository::findCommonAncestor(const std::string &commitA,
-                                              const std::string &commitB) {
-  std::unordered_set<std::string> historyA = logBranchCommitHistory(commitA);
-  std::string currentB = commitB;
-  CommitObject commitObj(gitDir);
+ObjectId GitRepository::resolveRevision(const std::string &name) {
+  if (name == "HEAD" || name == "head") {
+    return getHashOfBranchHead(getCurrentBranch());
+  }
+  ObjectId hash = getHashOfBranchHead(name);
+  if (!hash.isNull()) {
+    return hash;
+  }
+  ObjectId::parseHex(name, hash);
+  return hash;
+}
+
+std::vector<ObjectId> GitRepository::findMergeBases(const ObjectId &commitA,
+                                                    const ObjectId &commitB) {
+  CommitInfoReader commits(gitDir);
+  return ::findMergeBases(commitA, commitB,
+                          [&commits](const ObjectId &id, CommitInfo &info) {
+                            return commits.read(id, info);
+                          });
+}
+
+ObjectId GitRepository::findCommonAncestor(const ObjectId &commitA,
+                                           const ObjectId &commitB) {
+  std::vector<ObjectId> bases = findMergeBases(commitA, commitB);
+  // With several equally good bases (criss-cross merges) the newest is used.
+  return bases.empty() ? ObjectId() : bases.front(); // null = none
+}
+
+namespace {
 
-  while (!currentB.empty()) {
-    if (historyA.count(currentB)) {
-      return currentB;
+// "Thu Oct 16 14:03:11 2026 +0200" from an identity line
+// "Name <email> 1760616191 +0200", in the author's own timezone.
+std::string formatIdentDate(const std::string &ident) {
+  size_t close = ident.rfind('>');
+  if (close == std::string::npos) {
+    return "";
+  }
+  std::istringstream fields(ident.substr(close + 1));
+  long long seconds = 0;
+  std::string zone;
+  if (!(fields >> seconds >> zone)) {
+    return "";
+  }
+  long offset = 0;
+  if (zone.size() == 5 && (zone[0] == '+' || zone[0] == '-')) {
+    offset = std::stol(zone.substr(1, 2)) * 3600 +
+             std::stol(zone.substr(3, 2)) * 60;
+    if (zone[0] == '-') {
+      offset = -offset;
     }
-    CommitData commit = commitObj.readObject(currentB);
-    if (commit.parents.empty()) {
-      break;
+  }
+  std::time_t local = static_cast<std::time_t>(seconds + offset);
+  std::tm parts{};
+  gmtime_r(&local, &parts);
+  char buf[64];
+  std::strftime(buf, sizeof(buf), "%a %b %e %H:%M:%S %Y", &parts);
+  std::string text = buf;
+  // %e pads single-digit days with a space; git prints "Oct 6".
+  size_t pad = text.find("  ");
+  if (pad != std::string::npos) {
+    text.erase(pad, 1);
+  }
+  return text + " " + zone;
+}
+
+} // namespace
+
+bool GitRepository::showLog(const std::vector<std::string> &revisions,
+                            const std::vector<std::string> &paths,
+                            const RevWalkOptions &options, bool oneline) {
+  CommitInfoReader commits(gitDir);
+  RevWalk walk(
+      [&commits](const ObjectId &id, CommitInfo &info) {
+        return commits.read(id, info);
+      },
+      options);
+  std::unique_ptr<PathLimiter> limiter;
+  if (!paths.empty()) {
+    limiter.reset(new PathLimiter(gitDir, paths));
+    walk.limitToPaths([&limiter](const ObjectId &id,
+                                 const CommitInfo &info, size_t parent) {
+      return limiter->changed(id, info, parent);
+    });
+  }
+
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+  for (const auto &revision : revisions) {
+    size_t dots = revision.find("..");
+    if (dots != std::string::npos) {
+      std::string from = revision.substr(0, dots);
+      std::string to = revision.substr(dots + 2);
+      exclude.push_back(from.empty() ? "HEAD" : from);
+      include.push_back(to.empty() ? "HEAD" : to);
+    } else if (!revision.empty() && revision[0] == '^') {
+      exclude.push_back(revision.substr(1));
+    } else {
+      include.push_back(revision);
+    }
+  }
+  if (include.empty()) {
+    include.push_back("HEAD");
+  }
+
+  for (size_t i = 0; i < include.size() + exclude.size(); ++i) {
+    bool hide = i >= include.size();
+    const std::string &name = hide ? exclude[i - include.size()] : include[i];
+    ObjectId hash = resolveRevision(name);
+    if (hash.isNull()) {
+      if (name == "HEAD" && !hide) {
+        std::cerr << "Current branch '" << getCurrentBranch()
+                  << "' does not have any commits yet.\n";
+      } else {
+        std::cerr << "Error: unknown revision '" << name << "'.\n";
+      }
+      return false;
+    }
+    if (!(hide ? walk.hide(hash) : walk.push(hash))) {
+      std::cerr << "Error: cannot read commit " << hash << ".\n";
+      return false;
+    }
+  }
+
+  // Only the commits actually printed are inflated and parsed.
+  CommitObject commitObj(gitDir);
+  ObjectId hash;
+  CommitInfo info;
+  bool first = true;
+  while (walk.next(hash, info)) {
+    CommitData data = commitObj.readObject(hash);
+    if (oneline) {
+      std::cout << hash.hex().substr(0, 7) << " "
+                << data.message.substr(0, data.message.find('\n')) << "\n";
+      continue;
+    }
+    if (!first) {
+      std::cout << "\n";
+    }
+    first = false;
+    std::cout << "commit " << hash << "\n";
+    if (info.parents.size() > 1) {
+      std::cout << "Merge:";
+      for (const auto &parent : info.parents) {
+        std::cout << " " << parent.hex().substr(0, 7);
+      }
+      std::cout << "\n";
+    }
+    size_t close = data.author.rfind('>');
+    std::cout << "Author: "
+              << (close == std::string::npos ? data.author
+                                             : data.author.substr(0, close + 1))
+              << "\n";
+    std::cout << "Date:   " << formatIdentDate(data.author) << "\n\n";
+    std::istringstream message(data.message);
+    std::string line;
+    while (std::getline(message, line)) {
+      std::cout << "    " << line << "\n";
     }
-    currentB = commit.parents[0];
   }
-  return ""; // No common ancestor found
+  std::cout.flush();
+
+  // MGIT_TRACE_BLOOM=1 reports how often changed-path filters saved a
+  // tree comparison.
+  const char *traceBloom = std::getenv("MGIT_TRACE_BLOOM");
+  if (limiter && traceBloom && *traceBloom && std::string(traceBloom) != "0") {
+    const PathLimiter::Stats &stats = limiter->stats();
+    std::cerr << "changed-path filters: " << stats.filterNo
+              << " ruled out, " << stats.filterMaybe << " maybe ("
+              << stats.falsePositive << " false positives), "
+              << stats.noFilter << " without a filter\n";
+  }
+  return true;
 }
 
-bool GitRepository::gotoStateAtPerticularCommit(const std::string &hash) {
-  std::string path = gitDir + "/objects/" + hash.substr(0, 2) + "/" + hash.substr(2);
-  if (!std::filesystem::exists(path)) {
+bool GitRepository::gotoStateAtPerticularCommit(const ObjectId &hash) {
+  GitObjectStorage storage(gitDir);
+  if (!storage.objectExists(hash)) {
     std::cerr
         << "No such commit exists. Ensure it is part of the current branch.\n";
     return false;
   }
-  std::unordered_set<std::string> commitListInCurrentBranch(
-      logBranchCommitHistory(getCurrentBranch()).begin(),
-      logBranchCommitHistory(getCurrentBranch()).end());
+  std::unordered_set<ObjectId> commitListInCurrentBranch =
+      logBranchCommitHistory(getCurrentBranch());
   if (commitListInCurrentBranch.find(hash) == commitListInCurrentBranch.end()) {
     std::cerr << "Commit is not part of current branch history.\n";
     return false;
@@ -810,11 +1067,98 @@ bool GitRepository::gotoStateAtPerticularCommit(const std::string &hash) {
   TreeObject treeObj(gitDir);
   treeObj.restoreWorkingDirectoryFromTreeHash(commit.tree, ".");
   gitHead head(gitDir);
-  head.updateHead(hash);
+  head.updateHead(hash.hex());
   std::cout << "Repository successfully reset to commit: " << hash << "\n";
   return true;
 }
 
+bool GitRepository::compressObjects() {
+  GitObjectStorage storage(gitDir);
+  std::shared_ptr<PackStore> packs = PackStore::forGitDir(gitDir);
+  size_t packedBefore = packs->listObjects().size();
+
+  // Record the path each reachable blob/tree was seen at so the pack writer
+  // can put versions of the same file next to each other.
+  std::unordered_map<ObjectId, std::string> pathHints;
+  std::unordered_set<ObjectId> visitedCommits;
+  std::vector<ObjectId> pendingCommits;
+  Branch branch(gitDir);
+  for (const auto &name : branch.getAllBranches()) {
+    ObjectId hash = ObjectId::fromHex(branch.getBranchHash(name));
+    if (!hash.isNull()) {
+      pendingCommits.push_back(hash);
+    }
+  }
+  std::vector<ObjectId> tips = pendingCommits;
+  std::function<void(const ObjectId &, const std::string &)> visitTree =
+      [&](const ObjectId &treeHash, const std::string &prefix) {
+        if (!pathHints.emplace(treeHash, prefix).second) {
+          return;
+        }
+        TreeObject treeObj(gitDir);
+        for (const auto &entry : treeObj.readObject(treeHash)) {
+          std::string path =
+              prefix.empty() ? entry.filename : prefix + "/" + entry.filename;
+          if (entry.mode == "40000" || entry.mode == "040000") {
+            visitTree(entry.hash, path);
+          } else {
+            pathHints.emplace(entry.hash, path);
+          }
+        }
+      };
+  try {
+    while (!pendingCommits.empty()) {
+      ObjectId hash = pendingCommits.back();
+      pendingCommits.pop_back();
+      if (!visitedCommits.insert(hash).second) {
+        continue;
+      }
+      CommitObject commitObj(gitDir);
+      CommitData commit = commitObj.readObject(hash);
+      for (const auto &parent : commit.parents) {
+        pendingCommits.push_back(parent);
+      }
+      if (!commit.tree.isNull()) {
+        visitTree(commit.tree, "");
+      }
+    }
+  } catch (const std::exception &e) {
+    // Hints only improve delta selection; pack whatever we have.
+    std::cerr << "gc: history walk stopped early: " << e.what() << std::endl;
+  }
+
+  if (!storage.compressObjects(pathHints)) {
+    return false;
+  }
+  size_t packedAfter = packs->listObjects().size();
+  std::cout << "Packed "
+            << (packedAfter > packedBefore ? packedAfter - packedBefore : 0)
+            << " loose objects (" << storage.getLastDeltaCount()
+            << " stored as deltas); " << packs->packCount()
+            << " pack(s) in repository.\n";
+  updateCommitGraph(gitDir, tips, false, true);
+  return true;
+}
+
+bool GitRepository::writeCommitGraph() {
+  Branch branch(gitDir);
+  std::vector<ObjectId> tips;
+  for (const auto &name : branch.getAllBranches()) {
+    ObjectId hash = ObjectId::fromHex(branch.getBranchHash(name));
+    if (!hash.isNull()) {
+      tips.push_back(hash);
+    }
+  }
+  long added = updateCommitGraph(gitDir, tips, true);
+  if (added < 0) {
+    return false;
+  }
+  std::shared_ptr<CommitGraph> graph = CommitGraph::forGitDir(gitDir);
+  std::cout << "Commit-graph holds " << (graph ? graph->commitCount() : 0)
+            << " commits (" << added << " new).\n";
+  return true;
+}
+
 bool GitRepository::push(const std::string &remote) {
   std::string remoteGitDir = remote;
   // If not a path, try to resolve as remote name
@@ -904,10 +1248,21 @@ bool GitRepository::pull(const std::string &remote) {
                     fs::copy_options::overwrite_existing);
     }
   }
+  // Fold the pulled history into the commit-graph.
+  std::vector<ObjectId> tips;
+  Branch branches(gitDir);
+  for (const auto &name : branches.getAllBranches()) {
+    ObjectId hash = ObjectId::fromHex(branches.getBranchHash(name));
+    if (!hash.isNull()) {
+      tips.push_back(hash);
+    }
+  }
+  updateCommitGraph(gitDir, tips);
+
   // Automatically checkout latest commit on current branch
   std::string branch = getCurrentBranch();
-  std::string latest = getHashOfBranchHead(branch);
-  if (!latest.empty()) {
+  ObjectId latest = getHashOfBranchHead(branch);
+  if (!latest.isNull()) {
     gotoStateAtPerticularCommit(latest);
   }
   return true;
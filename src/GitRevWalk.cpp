@@ -0,0 +1,328 @@
+#include "headers/GitRevWalk.hpp"
+#include "headers/GitConfig.hpp"
+#include "headers/GitObjectTypesClasses.hpp"
+#include "headers/GitTreeCache.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+
+namespace {
+
+const uint8_t kQueued = 1;        // added to the pending queue
+const uint8_t kUninteresting = 2; // reachable from a hidden commit
+
+} // namespace
+
+bool RevWalk::ShowFirst::operator()(const Node *a, const Node *b) const {
+  // priority_queue pops the largest element: "less" means shown later.
+  if (sort == RevSort::Topo &&
+      a->info.generation != b->info.generation) {
+    return a->info.generation < b->info.generation;
+  }
+  if (a->info.commitTime != b->info.commitTime) {
+    return a->info.commitTime < b->info.commitTime;
+  }
+  return a->sequence > b->sequence;
+}
+
+bool RevWalk::HigherGeneration::operator()(const Node *a,
+                                           const Node *b) const {
+  return a->info.generation < b->info.generation;
+}
+
+RevWalk::RevWalk(CommitLookup lookup, RevWalkOptions options)
+    : lookup(std::move(lookup)), options(options),
+      pending(ShowFirst{options.sort}) {}
+
+RevWalk::Node *RevWalk::load(const ObjectId &id) {
+  auto it = commits.find(id);
+  if (it != commits.end()) {
+    return it->second.get();
+  }
+  std::unique_ptr<Node> node(new Node());
+  if (!lookup(id, node->info)) {
+    commits.emplace(id, nullptr);
+    return nullptr;
+  }
+  node->id = id;
+  node->sequence = nextSequence++;
+  return commits.emplace(id, std::move(node)).first->second.get();
+}
+
+void RevWalk::resolveGeneration(Node *node) {
+  // Only commits that are not in the commit-graph lack a generation; walk
+  // down to the graph (or the roots) and fill them in on the way back.
+  std::vector<Node *> stack = {node};
+  while (!stack.empty()) {
+    Node *top = stack.back();
+    if (top->info.generation != CommitGraph::kGenerationInfinity) {
+      stack.pop_back();
+      continue;
+    }
+    uint32_t generation = 1;
+    bool ready = true;
+    for (const auto &parentId : top->info.parents) {
+      Node *parent = load(parentId);
+      if (!parent) {
+        continue; // missing parent: treat as a root
+      }
+      if (parent->info.generation == CommitGraph::kGenerationInfinity) {
+        stack.push_back(parent);
+        ready = false;
+      } else {
+        generation = std::max(generation, parent->info.generation + 1);
+      }
+    }
+    if (ready) {
+      top->info.generation =
+          std::min(generation, CommitGraph::kGenerationInfinity - 1);
+      stack.pop_back();
+    }
+  }
+}
+
+bool RevWalk::push(const ObjectId &id) {
+  Node *node = load(id);
+  if (!node) {
+    return false;
+  }
+  if (!(node->flags & kQueued)) {
+    node->flags |= kQueued;
+    if (options.sort == RevSort::Topo) {
+      resolveGeneration(node);
+    }
+    pending.push(node);
+  }
+  return true;
+}
+
+bool RevWalk::hide(const ObjectId &id) {
+  Node *node = load(id);
+  if (!node) {
+    return false;
+  }
+  hasHidden = true;
+  if (!(node->flags & kUninteresting)) {
+    node->flags |= kUninteresting;
+    resolveGeneration(node);
+    hidden.push(node);
+  }
+  return true;
+}
+
+void RevWalk::hideAbove(uint32_t generation) {
+  // A hidden commit can only reach commits of a lower generation, so once
+  // everything above `generation` is expanded, the commit being shown is
+  // marked if and only if it is reachable from a hidden commit.
+  while (!hidden.empty() && hidden.top()->info.generation > generation) {
+    Node *node = hidden.top();
+    hidden.pop();
+    // All parents, even with firstParent: like git, A..B leaves out
+    // everything reachable from A, not just A's first-parent chain.
+    for (const auto &parentId : node->info.parents) {
+      Node *parent = load(parentId);
+      if (!parent || (parent->flags & kUninteresting)) {
+        continue;
+      }
+      parent->flags |= kUninteresting;
+      resolveGeneration(parent);
+      hidden.push(parent);
+    }
+  }
+}
+
+bool RevWalk::next(ObjectId &id, CommitInfo &info) {
+  while (!pending.empty()) {
+    if (options.maxCount >= 0 && shown >= options.maxCount) {
+      return false;
+    }
+    Node *node = pending.top();
+    pending.pop();
+    if (hasHidden) {
+      resolveGeneration(node);
+      hideAbove(node->info.generation);
+    }
+    if (node->flags & kUninteresting) {
+      continue;
+    }
+    size_t parentCount = options.firstParent
+                             ? std::min<size_t>(1, node->info.parents.size())
+                             : node->info.parents.size();
+    size_t begin = 0;
+    size_t end = parentCount;
+    bool show = true;
+    if (changed) {
+      if (parentCount == 0) {
+        show = changed(node->id, node->info, kNoParent);
+      }
+      for (size_t i = 0; i < parentCount; ++i) {
+        if (!changed(node->id, node->info, i)) {
+          show = false; // same as this parent: follow only it
+          begin = i;
+          end = i + 1;
+          break;
+        }
+      }
+    }
+    for (size_t i = begin; i < end; ++i) {
+      Node *parent = load(node->info.parents[i]);
+      if (!parent || (parent->flags & (kQueued | kUninteresting))) {
+        continue;
+      }
+      parent->flags |= kQueued;
+      if (options.sort == RevSort::Topo) {
+        resolveGeneration(parent);
+      }
+      pending.push(parent);
+    }
+    if (!show) {
+      continue;
+    }
+    ++shown;
+    id = node->id;
+    info = node->info;
+    return true;
+  }
+  return false;
+}
+
+// ---------------- PathLimiter ----------------
+
+PathLimiter::PathLimiter(const std::string &gitDir,
+                         const std::vector<std::string> &limitPaths)
+    : gitDir(gitDir), commits(gitDir) {
+  graph = CommitGraph::forGitDir(gitDir);
+  if (graph && !graph->hasChangedPathFilters()) {
+    graph.reset();
+  }
+  std::string readFilters;
+  if (graph && std::filesystem::exists(gitDir + "/config") &&
+      GitConfig(gitDir).getConfig("commitGraph.readChangedPaths",
+                                  readFilters) &&
+      (readFilters == "false" || readFilters == "0")) {
+    graph.reset();
+  }
+
+  for (std::string path : limitPaths) {
+    while (!path.empty() && path.back() == '/') {
+      path.pop_back();
+    }
+    if (path.rfind("./", 0) == 0) {
+      path.erase(0, 2);
+    }
+    if (path == ".") {
+      path.clear(); // the whole tree
+    }
+    LimitPath limit;
+    for (size_t start = 0; start <= path.size();) {
+      size_t slash = path.find('/', start);
+      size_t stop = slash == std::string::npos ? path.size() : slash;
+      if (stop > start) {
+        limit.components.push_back(path.substr(start, stop - start));
+      }
+      if (graph && stop > start) {
+        limit.keys.emplace_back(path.substr(0, stop),
+                                graph->changedPathSettings());
+      }
+      start = stop + 1;
+    }
+    paths.push_back(std::move(limit));
+  }
+}
+
+bool PathLimiter::filterRulesOut(const ObjectId &id) {
+  uint32_t position = 0;
+  if (!graph || !graph->findPosition(id, position)) {
+    ++stats_.noFilter;
+    return false;
+  }
+  const unsigned char *filter = nullptr;
+  size_t filterSize = 0;
+  graph->changedPathFilter(position, filter, filterSize);
+  if (filterSize == 0) {
+    ++stats_.noFilter;
+    return false;
+  }
+  for (const auto &path : paths) {
+    // A path can only have changed if it and all its directories are in.
+    bool maybe = std::all_of(path.keys.begin(), path.keys.end(),
+                             [&](const BloomKey &key) {
+                               return bloomFilterContains(filter, filterSize,
+                                                          key);
+                             });
+    if (maybe) {
+      ++stats_.filterMaybe;
+      return false;
+    }
+  }
+  ++stats_.filterNo;
+  return true;
+}
+
+bool PathLimiter::sameEntry(const ObjectId &treeA, const ObjectId &treeB,
+                            const LimitPath &path) {
+  if (path.components.empty()) {
+    return treeA == treeB;
+  }
+  TreeObject trees(gitDir);
+  TreeCache::Tree a = treeA.isNull() ? nullptr : trees.readParsedTree(treeA);
+  TreeCache::Tree b = treeB.isNull() ? nullptr : trees.readParsedTree(treeB);
+  auto find = [](const TreeCache::Tree &tree,
+                 const std::string &name) -> const ParsedTreeEntry * {
+    if (!tree) {
+      return nullptr;
+    }
+    for (const auto &entry : tree->entries) {
+      if (entry.name == name) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  };
+  for (size_t i = 0; i < path.components.size(); ++i) {
+    const ParsedTreeEntry *entryA = find(a, path.components[i]);
+    const ParsedTreeEntry *entryB = find(b, path.components[i]);
+    if (!entryA || !entryB) {
+      return entryA == entryB;
+    }
+    if (entryA->mode == entryB->mode && entryA->id == entryB->id) {
+      return true; // everything below is identical as well
+    }
+    if (i + 1 == path.components.size() || !entryA->isTree() ||
+        !entryB->isTree()) {
+      return false;
+    }
+    a = trees.readParsedTree(entryA->id);
+    b = trees.readParsedTree(entryB->id);
+  }
+  return true;
+}
+
+bool PathLimiter::changed(const ObjectId &id, const CommitInfo &info,
+                          size_t parent) {
+  ObjectId parentTree;
+  bool filtered = false;
+  if (parent != RevWalk::kNoParent) {
+    if (parent == 0) {
+      uint64_t maybes = stats_.filterMaybe;
+      if (filterRulesOut(id)) {
+        return false;
+      }
+      filtered = stats_.filterMaybe != maybes;
+    }
+    CommitInfo parentInfo;
+    if (!commits.read(info.parents[parent], parentInfo)) {
+      return true;
+    }
+    parentTree = parentInfo.tree;
+  }
+  for (const auto &path : paths) {
+    if (!sameEntry(info.tree, parentTree, path)) {
+      return true;
+    }
+  }
+  if (filtered) {
+    ++stats_.falsePositive;
+  }
+  return false;
+}
@@ -0,0 +1,116 @@
+#include "headers/GitTreeCache.hpp"
+#include <cstring>
+#include <map>
+
+const char *treeEntryModeString(TreeEntryMode mode) {
+  switch (mode) {
+  case TreeEntryMode::Executable:
+    return "100755";
+  case TreeEntryMode::Symlink:
+    return "120000";
+  case TreeEntryMode::Directory:
+    return "040000";
+  case TreeEntryMode::Submodule:
+    return "160000";
+  default:
+    return "100644";
+  }
+}
+
+namespace {
+
+TreeEntryMode parseMode(const char *data, size_t size) {
+  std::string mode(data, size);
+  if (mode == "40000" || mode == "040000") {
+    return TreeEntryMode::Directory;
+  }
+  if (mode == "100755") {
+    return TreeEntryMode::Executable;
+  }
+  if (mode == "120000") {
+    return TreeEntryMode::Symlink;
+  }
+  if (mode == "160000") {
+    return TreeEntryMode::Submodule;
+  }
+  return TreeEntryMode::Regular;
+}
+
+} // namespace
+
+TreeCache::Tree TreeCache::parse(std::string_view object) {
+  size_t nul = object.find('\0');
+  if (nul == std::string_view::npos) {
+    return nullptr;
+  }
+  auto tree = std::make_shared<ParsedTree>();
+  const char *p = object.data() + nul + 1;
+  const char *end = object.data() + object.size();
+  // The names take less room than the body they came from.
+  tree->names.reset(new char[end - p]);
+  char *names = tree->names.get();
+  while (p < end) {
+    const char *space =
+        static_cast<const char *>(std::memchr(p, ' ', end - p));
+    if (!space) {
+      break;
+    }
+    const char *nameEnd = static_cast<const char *>(
+        std::memchr(space + 1, '\0', end - space - 1));
+    if (!nameEnd || end - nameEnd - 1 < 20) {
+      break;
+    }
+    ParsedTreeEntry entry;
+    entry.mode = parseMode(p, space - p);
+    size_t nameSize = nameEnd - space - 1;
+    std::memcpy(names, space + 1, nameSize);
+    entry.name = std::string_view(names, nameSize);
+    names += nameSize;
+    entry.id = ObjectId::fromRaw(nameEnd + 1);
+    tree->entries.push_back(entry);
+    p = nameEnd + 1 + 20;
+  }
+  return tree;
+}
+
+std::shared_ptr<TreeCache> TreeCache::forGitDir(const std::string &gitDir) {
+  static std::mutex registryMutex;
+  static std::map<std::string, std::shared_ptr<TreeCache>> registry;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = registry.find(gitDir);
+  if (it != registry.end()) {
+    return it->second;
+  }
+  std::shared_ptr<TreeCache> cache(new TreeCache());
+  registry[gitDir] = cache;
+  return cache;
+}
+
+TreeCache::Tree TreeCache::get(const ObjectId &id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(id);
+  if (it == index.end()) {
+    return nullptr;
+  }
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+void TreeCache::put(const ObjectId &id, Tree tree) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!tree || index.count(id)) {
+    return;
+  }
+  entries += tree->entries.size();
+  lru.emplace_front(id, std::move(tree));
+  index[id] = lru.begin();
+  evictLocked();
+}
+
+void TreeCache::evictLocked() {
+  while (entries > entryBudget && lru.size() > 1) {
+    entries -= lru.back().second->entries.size();
+    index.erase(lru.back().first);
+    lru.pop_back();
+  }
+}
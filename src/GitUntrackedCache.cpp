@@ -0,0 +1,184 @@
+#include "headers/GitUntrackedCache.hpp"
+
+namespace {
+
+// Bits of each directory's flags word.
+const uint32_t kValid = 1;
+const uint32_t kHasIgnoreFile = 2;
+
+void appendBE32(std::string &out, uint32_t value) {
+  out.push_back(static_cast<char>((value >> 24) & 0xff));
+  out.push_back(static_cast<char>((value >> 16) & 0xff));
+  out.push_back(static_cast<char>((value >> 8) & 0xff));
+  out.push_back(static_cast<char>(value & 0xff));
+}
+
+void appendBE64(std::string &out, uint64_t value) {
+  appendBE32(out, static_cast<uint32_t>(value >> 32));
+  appendBE32(out, static_cast<uint32_t>(value & 0xffffffff));
+}
+
+// Reads big-endian integers and NUL-terminated strings off the front of
+// data; any read past the end fails.
+class Reader {
+public:
+  explicit Reader(std::string_view data) : data(data) {}
+
+  bool readBE32(uint32_t &value) {
+    if (data.size() < 4) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value = value << 8 | static_cast<unsigned char>(data[i]);
+    }
+    data.remove_prefix(4);
+    return true;
+  }
+
+  bool readBE64(uint64_t &value) {
+    uint32_t high = 0;
+    uint32_t low = 0;
+    if (!readBE32(high) || !readBE32(low)) {
+      return false;
+    }
+    value = static_cast<uint64_t>(high) << 32 | low;
+    return true;
+  }
+
+  bool readString(std::string &value) {
+    size_t nul = data.find('\0');
+    if (nul == std::string_view::npos) {
+      return false;
+    }
+    value.assign(data.substr(0, nul));
+    data.remove_prefix(nul + 1);
+    return true;
+  }
+
+  bool readId(ObjectId &id) {
+    if (data.size() < ObjectId::kRawSize) {
+      return false;
+    }
+    id = ObjectId::fromRaw(data.data());
+    data.remove_prefix(ObjectId::kRawSize);
+    return true;
+  }
+
+  bool readNames(std::vector<std::string> &names) {
+    uint32_t count = 0;
+    if (!readBE32(count) || count > data.size()) {
+      return false;
+    }
+    names.resize(count);
+    for (auto &name : names) {
+      if (!readString(name)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool atEnd() const { return data.empty(); }
+
+private:
+  std::string_view data;
+};
+
+void appendNames(std::string &out, const std::vector<std::string> &names) {
+  appendBE32(out, static_cast<uint32_t>(names.size()));
+  for (const auto &name : names) {
+    out += name;
+    out.push_back('\0');
+  }
+}
+
+} // namespace
+
+void UntrackedCache::invalidate(std::string_view path) {
+  size_t slash = path.rfind('/');
+  std::string_view dir;
+  if (slash != std::string_view::npos) {
+    dir = path.substr(0, slash);
+  }
+  auto it = dirs.find(dir);
+  if (it != dirs.end()) {
+    it->second.valid = false;
+  }
+}
+
+bool UntrackedCache::invalidateNewerThan(int64_t mtimeNs) {
+  bool any = false;
+  for (auto &[path, dir] : dirs) {
+    if (dir.valid && dir.stat.mtimeNs >= mtimeNs) {
+      dir.valid = false;
+      any = true;
+    }
+  }
+  return any;
+}
+
+const UntrackedCache::Dir *UntrackedCache::lookup(const std::string &dir,
+                                                  const DirStat &stat) const {
+  auto it = dirs.find(dir);
+  if (it == dirs.end() || !it->second.valid || !(it->second.stat == stat)) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+const UntrackedCache::Dir *UntrackedCache::find(const std::string &dir) const {
+  auto it = dirs.find(dir);
+  return it == dirs.end() || !it->second.valid ? nullptr : &it->second;
+}
+
+void UntrackedCache::serialize(std::string &out) const {
+  appendBE32(out, static_cast<uint32_t>(dirs.size()));
+  for (const auto &[path, dir] : dirs) {
+    out += path;
+    out.push_back('\0');
+    appendBE64(out, static_cast<uint64_t>(dir.stat.mtimeNs));
+    appendBE64(out, static_cast<uint64_t>(dir.stat.ctimeNs));
+    appendBE64(out, dir.stat.ino);
+    appendBE64(out, dir.stat.dev);
+    appendBE32(out, (dir.valid ? kValid : 0) |
+                        (dir.hasIgnoreFile ? kHasIgnoreFile : 0));
+    out.append(reinterpret_cast<const char *>(dir.ignoreId.data()),
+               ObjectId::kRawSize);
+    appendNames(out, dir.untracked);
+    appendNames(out, dir.subdirs);
+  }
+}
+
+bool UntrackedCache::parse(std::string_view data) {
+  dirs.clear();
+  Reader reader(data);
+  uint32_t count = 0;
+  if (!reader.readBE32(count)) {
+    return data.empty(); // no extension: an empty cache
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    std::string path;
+    Dir dir;
+    uint64_t mtime = 0;
+    uint64_t ctime = 0;
+    uint32_t flags = 0;
+    if (!reader.readString(path) || !reader.readBE64(mtime) ||
+        !reader.readBE64(ctime) || !reader.readBE64(dir.stat.ino) ||
+        !reader.readBE64(dir.stat.dev) || !reader.readBE32(flags) ||
+        !reader.readId(dir.ignoreId) || !reader.readNames(dir.untracked) || !reader.readNames(dir.subdirs)) {
+      dirs.clear();
+      return false;
+    }
+    dir.stat.mtimeNs = static_cast<int64_t>(mtime);
+    dir.stat.ctimeNs = static_cast<int64_t>(ctime);
+    dir.valid = (flags & kValid) != 0;
+    dir.hasIgnoreFile = (flags & kHasIgnoreFile) != 0;
+    dirs.emplace(std::move(path), std::move(dir));
+  }
+  if (!reader.atEnd()) {
+    dirs.clear();
+    return false;
+  }
+  return true;
+}
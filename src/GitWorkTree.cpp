@@ -0,0 +1,340 @@
+#include "headers/GitWorkTree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+bool isIgnoredDir(const char *name) {
+  return std::strcmp(name, ".git") == 0 || std::strcmp(name, ".mgit") == 0;
+}
+
+// Runs body(worker) on `threads` threads (the caller's thread is worker 0)
+// and rethrows the first exception raised by any of them.
+void runWorkers(unsigned threads, const std::function<void(unsigned)> &body) {
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto guarded = [&](unsigned worker) {
+    try {
+      body(worker);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads > 0 ? threads - 1 : 0);
+  for (unsigned i = 1; i < threads; ++i) {
+    pool.emplace_back(guarded, i);
+  }
+  guarded(0);
+  for (auto &thread : pool) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+int64_t timespecToNs(const struct timespec &ts) {
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+std::string joinPath(const std::string &dir, const std::string &name) {
+  return dir.empty() ? name : dir + "/" + name;
+}
+
+// Names of the regular files and subdirectories of root/dir. Returns false
+// if the directory cannot be read.
+bool readDirectory(const std::string &root, const std::string &dir,
+                   std::vector<std::string> &files,
+                   std::vector<std::string> &subdirs) {
+  std::string fsPath = dir.empty() ? root : root + "/" + dir;
+  DIR *handle = opendir(fsPath.c_str());
+  if (!handle) {
+    return false;
+  }
+  while (dirent *ent = readdir(handle)) {
+    const char *name = ent->d_name;
+    if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+      continue;
+    }
+    unsigned char type = ent->d_type;
+    if (type == DT_UNKNOWN || type == DT_LNK) {
+      // Follow symlinks like recursive_directory_iterator's is_*() did.
+      struct stat st {};
+      if (stat((fsPath + "/" + name).c_str(), &st) != 0) {
+        continue;
+      }
+      type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : 0;
+      if (ent->d_type == DT_LNK && type == DT_DIR) {
+        continue; // do not descend through directory symlinks
+      }
+    }
+    if (type == DT_DIR) {
+      if (!isIgnoredDir(name)) {
+        subdirs.emplace_back(name);
+      }
+    } else if (type == DT_REG) {
+      files.emplace_back(name);
+    }
+  }
+  closedir(handle);
+  return true;
+}
+
+bool hasIgnoreFile(const std::vector<std::string> &names) {
+  return std::find(names.begin(), names.end(), IgnoreStack::kFileName) !=
+         names.end();
+}
+
+std::vector<std::string>
+mergeSorted(std::vector<std::vector<std::string>> &parts) {
+  std::vector<std::string> files;
+  size_t total = 0;
+  for (const auto &part : parts) {
+    total += part.size();
+  }
+  files.reserve(total);
+  for (auto &part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(files));
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+} // namespace
+
+WorkTreeScanner::WorkTreeScanner(const std::string &root, unsigned threads)
+    : root(root), threads(threads) {
+  if (this->threads == 0) {
+    this->threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+void WorkTreeScanner::walk(const IgnoreStack::Ptr &ignore,
+                           const DirVisitor &visit) const {
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<PendingDir> dirs;
+  };
+  std::vector<WorkerQueue> queues(threads);
+  // Directories queued or being read; the walk is over when it drops to 0.
+  std::atomic<size_t> outstanding{1};
+  queues[0].dirs.push_back({"", ignore});
+
+  auto takeWork = [&](unsigned self, PendingDir &dir) {
+    {
+      std::lock_guard<std::mutex> lock(queues[self].mutex);
+      if (!queues[self].dirs.empty()) {
+        dir = std::move(queues[self].dirs.back());
+        queues[self].dirs.pop_back();
+        return true;
+      }
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+      WorkerQueue &victim = queues[(self + i) % threads];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.dirs.empty()) {
+        dir = std::move(victim.dirs.front());
+        victim.dirs.pop_front();
+        return true;
+      }
+    }
+    return false;
+  };
+
+  runWorkers(threads, [&](unsigned self) {
+    PendingDir dir;
+    std::vector<PendingDir> subdirs;
+    while (outstanding.load() > 0) {
+      if (!takeWork(self, dir)) {
+        std::this_thread::yield();
+        continue;
+      }
+      try {
+        subdirs.clear();
+        visit(self, dir, subdirs);
+        if (!subdirs.empty()) {
+          outstanding += subdirs.size();
+          std::lock_guard<std::mutex> lock(queues[self].mutex);
+          for (auto &sub : subdirs) {
+            queues[self].dirs.push_back(std::move(sub));
+          }
+        }
+      } catch (...) {
+        --outstanding;
+        throw;
+      }
+      --outstanding;
+    }
+  });
+}
+
+std::vector<std::string>
+WorkTreeScanner::listFiles(const IgnoreStack::Ptr &ignore) const {
+  std::vector<std::vector<std::string>> found(threads);
+  walk(ignore, [&](unsigned self, const PendingDir &dir,
+                   std::vector<PendingDir> &subdirs) {
+    std::vector<std::string> names;
+    std::vector<std::string> dirNames;
+    if (!readDirectory(root, dir.path, names, dirNames)) {
+      return; // unreadable directories are skipped
+    }
+    IgnoreStack::Ptr rules = dir.ignore;
+    if (rules && hasIgnoreFile(names)) {
+      rules = IgnoreStack::enter(rules, root, dir.path);
+    }
+    for (const auto &name : names) {
+      std::string path = joinPath(dir.path, name);
+      if (!rules || !rules->isIgnored(path, false)) {
+        found[self].push_back(std::move(path));
+      }
+    }
+    for (const auto &name : dirNames) {
+      std::string path = joinPath(dir.path, name);
+      if (!rules || !rules->isIgnored(path, true)) {
+        subdirs.push_back({std::move(path), rules});
+      }
+    }
+  });
+  return mergeSorted(found);
+}
+
+std::vector<std::string>
+WorkTreeScanner::listUntracked(UntrackedCache &cache,
+                               const IgnoreStack::Ptr &ignore,
+                               const std::function<bool(const std::string &)>
+                                   &isTracked,
+                               UntrackedStats &stats,
+                               const std::function<bool(const std::string &)>
+                                   &dirMayHaveChanged) const {
+  std::vector<std::vector<std::string>> found(threads);
+  // Every directory reached, with what the cache should now say about it.
+  std::vector<std::vector<std::pair<std::string, UntrackedCache::Dir>>> seen(
+      threads);
+  std::atomic<size_t> dirsRead{0};
+  walk(ignore, [&](unsigned self, const PendingDir &dir,
+                   std::vector<PendingDir> &subdirs) {
+    UntrackedCache::Dir entry;
+    // The cache is only read while the walk runs.
+    const UntrackedCache::Dir *cached = nullptr;
+    if (dirMayHaveChanged && !dirMayHaveChanged(dir.path)) {
+      cached = cache.find(dir.path);
+      if (cached) {
+        entry.stat = cached->stat;
+      }
+    }
+    if (!cached) {
+      std::string fsPath = dir.path.empty() ? root : root + "/" + dir.path;
+      struct stat st {};
+      if (stat(fsPath.c_str(), &st) != 0) {
+        return;
+      }
+      entry.stat.mtimeNs = timespecToNs(st.st_mtim);
+      entry.stat.ctimeNs = timespecToNs(st.st_ctim);
+      entry.stat.ino = static_cast<uint64_t>(st.st_ino);
+      entry.stat.dev = static_cast<uint64_t>(st.st_dev);
+      cached = cache.lookup(dir.path, entry.stat);
+    }
+    std::vector<std::string> names;
+    if (!cached && !readDirectory(root, dir.path, names, entry.subdirs)) {
+      return;
+    }
+
+    // An unchanged directory still has its .mgitignore, but the file may
+    // have been edited in place, so it is read again either way.
+    entry.hasIgnoreFile = cached ? cached->hasIgnoreFile : hasIgnoreFile(names);
+    IgnoreStack::Ptr rules = dir.ignore;
+    if (rules && entry.hasIgnoreFile) {
+      rules = IgnoreStack::enter(rules, root, dir.path);
+    }
+    if (rules) {
+      entry.ignoreId = rules->id();
+    }
+    if (cached && cached->ignoreId != entry.ignoreId) {
+      cached = nullptr;
+      if (!readDirectory(root, dir.path, names, entry.subdirs)) {
+        return;
+      }
+    }
+
+    if (cached) {
+      entry.untracked = cached->untracked;
+      entry.subdirs = cached->subdirs;
+    } else {
+      for (auto &name : names) {
+        std::string path = joinPath(dir.path, name);
+        if (!isTracked(path) && (!rules || !rules->isIgnored(path, false))) {
+          entry.untracked.push_back(std::move(name));
+        }
+      }
+      if (rules) {
+        auto ignored = [&](const std::string &name) {
+          return rules->isIgnored(joinPath(dir.path, name), true);
+        };
+        entry.subdirs.erase(std::remove_if(entry.subdirs.begin(),
+                                           entry.subdirs.end(), ignored),
+                            entry.subdirs.end());
+      }
+      ++dirsRead;
+    }
+    entry.valid = true;
+    for (const auto &name : entry.untracked) {
+      found[self].push_back(joinPath(dir.path, name));
+    }
+    for (const auto &name : entry.subdirs) {
+      subdirs.push_back({joinPath(dir.path, name), rules});
+    }
+    seen[self].emplace_back(dir.path, std::move(entry));
+  });
+
+  // Directories that were not reached again (removed, or below a removed
+  // directory) drop out of the cache.
+  UntrackedCache::DirMap dirs;
+  for (auto &part : seen) {
+    for (auto &[dir, entry] : part) {
+      dirs.emplace(std::move(dir), std::move(entry));
+    }
+  }
+  stats.dirsChecked = dirs.size();
+  stats.dirsRead = dirsRead.load();
+  stats.changed = stats.dirsRead > 0 || dirs.size() != cache.size();
+  cache.replace(std::move(dirs));
+  return mergeSorted(found);
+}
+
+void WorkTreeScanner::parallelFor(size_t count,
+                                  const std::function<void(size_t)> &fn) const {
+  if (count == 0) {
+    return;
+  }
+  // Small batches keep the shared counter cool while still balancing files
+  // of very different sizes across workers.
+  const size_t batch =
+      std::max<size_t>(1, std::min<size_t>(64, count / (threads * 8) + 1));
+  std::atomic<size_t> next{0};
+  unsigned workers = static_cast<unsigned>(
+      std::min<size_t>(threads, (count + batch - 1) / batch));
+  runWorkers(workers, [&](unsigned) {
+    while (true) {
+      size_t begin = next.fetch_add(batch);
+      if (begin >= count) {
+        return;
+      }
+      size_t end = std::min(count, begin + batch);
+      for (size_t i = begin; i < end; ++i) {
+        fn(i);
+      }
+    }
+  });
+}
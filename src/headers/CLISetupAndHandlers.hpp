@@ -22,7 +22,7 @@ bool handleLsTree(GitRepository &repo, const std::string &hash);
 bool handleLsTreeRecursive(GitRepository &repo, const std::string &hash);
 
 bool handleAddCommand(GitRepository &repo,
-                      const std::vector<std::string> &paths);
+                      const std::vector<std::string> &paths, bool force);
 bool handleStatusCommand(GitRepository &repo, bool shortFormat,
                          bool showUntracked, bool showIgnore, bool showBranch);
 
@@ -46,6 +46,12 @@ bool handleResolveConflicts(GitRepository &repo);
 bool handlePushCommand(GitRepository &repo, const std::string &remoteGitDir);
 bool handlePullCommand(GitRepository &repo, const std::string &remoteGitDir);
 
+bool handleGcCommand(GitRepository &repo);
+bool handleCommitGraphWrite(GitRepository &repo);
+bool handleFsMonitorCommand(GitRepository &repo, const std::string &action);
+bool handleMergeBase(GitRepository &repo, const std::string &first,
+                     const std::string &second, bool all);
+
 bool handleRemoteAdd(GitRepository &repo, const std::string &name,
                      const std::string &path);
 bool handleRemoteRemove(GitRepository &repo, const std::string &name);
@@ -78,6 +84,10 @@ bool setupResolveConflictCommand(CLI::App &app, GitRepository &repo);
 bool setupPushCommand(CLI::App &app, GitRepository &repo);
 bool setupPullCommand(CLI::App &app, GitRepository &repo);
 bool setupRemoteCommand(CLI::App &app, GitRepository &repo);
+bool setupGcCommand(CLI::App &app, GitRepository &repo);
+bool setupCommitGraphCommand(CLI::App &app, GitRepository &repo);
+bool setupFsMonitorCommand(CLI::App &app, GitRepository &repo);
+bool setupMergeBaseCommand(CLI::App &app, GitRepository &repo);
 bool handleConfigSet(GitRepository &, const std::string &key,
                      const std::string &value);
 bool handleConfigGet(GitRepository &, const std::string &key);
@@ -85,3 +95,12 @@ bool setupConfigCommand(CLI::App &app, GitRepository &repo);
 bool handleCommitCommand(GitRepository &repo, const std::string &message,
                          const std::string &author);
 bool setupCommitCommand(CLI::App &app, GitRepository &repo);
+bool handleLogCommand(GitRepository &repo,
+                      const std::vector<std::string> &revisions,
+                      const std::vector<std::string> &paths,
+                      const RevWalkOptions &options, bool oneline);
+bool setupLogCommand(CLI::App &app, GitRepository &repo);
+// CLI11 hands "--" back to the main app as soon as a subcommand's
+// positional has a value, so `log A..B -- path` would fail to parse. Returns
+// argv with each path after log's "--" passed as --path=<path> instead.
+std::vector<std::string> logCommandLine(int argc, char **argv);
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Git-compatible binary deltas (the format stored in OFS_DELTA/REF_DELTA pack
+// entries): a varint source size, a varint target size, then a sequence of
+// copy-from-source and insert-literal instructions.
+
+// Block index over a delta source. Building it is the expensive part of delta
+// search, so the pack writer keeps one per object in its window and reuses it
+// against every later candidate target.
+class DeltaIndex {
+public:
+    explicit DeltaIndex(std::string source);
+
+    // Returns the delta turning the indexed source into `target`, or an empty
+    // string when none of at most `maxDeltaSize` bytes exists (0 = unlimited).
+    std::string createDelta(const std::string& target,
+                            size_t maxDeltaSize = 0) const;
+    const std::string& getSource() const { return source; }
+
+private:
+    std::string source;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> blocks;
+};
+
+// Returns the delta turning `source` into `target`, or an empty string when no
+// delta of at most `maxDeltaSize` bytes could be found (0 means unlimited).
+std::string createDelta(const std::string& source, const std::string& target,
+                        size_t maxDeltaSize = 0);
+
+// Applies `delta` (size `deltaSize`) to `source`. Throws std::runtime_error on
+// malformed input or a source size mismatch.
+std::string applyDelta(const std::string& source, const char* delta,
+                       size_t deltaSize);
+
+// Reads the target size recorded in a delta header without applying it.
+size_t deltaTargetSize(const char* delta, size_t deltaSize);
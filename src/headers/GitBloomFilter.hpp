@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ObjectId.hpp"
+
+// Changed-path Bloom filters as git stores them in the commit-graph (BIDX and
+// BDAT chunks). Each commit gets a filter over the paths that differ from its
+// first parent, plus every leading directory of those paths, so both
+// `log -- dir/file` and `log -- dir` can rule a commit out without reading a
+// single tree. A "no" from a filter is exact; a "maybe" still needs a tree
+// comparison.
+struct BloomSettings {
+  uint32_t hashVersion = 1;  // murmur3 variant (git's version 1 or 2)
+  uint32_t hashCount = 7;    // bits set per path
+  uint32_t bitsPerEntry = 10;
+  // Commits touching more paths get a single all-ones byte ("always maybe").
+  uint32_t maxChangedPaths = 512;
+};
+
+// The bit positions of one path. Build once per path, test many filters.
+class BloomKey {
+public:
+  BloomKey(const std::string &path, const BloomSettings &settings);
+  const std::vector<uint32_t> &hashes() const { return hashes_; }
+
+private:
+  std::vector<uint32_t> hashes_;
+};
+
+// 32-bit murmur3. Version 1 reproduces git's original implementation, which
+// sign-extends bytes >= 0x80 (it only differs for non-ASCII paths).
+uint32_t bloomMurmur3(uint32_t seed, const char *data, size_t size,
+                      uint32_t version);
+
+// Filter for a set of changed file paths; leading directories are added here.
+// With more than maxChangedPaths paths the result is the one-byte 0xff
+// filter.
+std::string buildBloomFilter(const std::vector<std::string> &paths,
+                             const BloomSettings &settings);
+
+// False only when the path was definitely not changed. An empty filter (not
+// computed) answers true.
+bool bloomFilterContains(const unsigned char *filter, size_t size,
+                         const BloomKey &key);
+
+// Files that differ between two trees, as `git diff-tree -r --name-only`
+// would list them (the null ID is the empty tree). Returns false, with out
+// incomplete, as soon as more than limit paths differ.
+bool collectChangedPaths(const std::string &gitDir, const ObjectId &oldTree,
+                         const ObjectId &newTree, size_t limit,
+                         std::vector<std::string> &out);
+
+// The filter of a commit: paths changed between its first parent's tree
+// (null for a root commit) and its own.
+std::string computeChangedPathFilter(const std::string &gitDir,
+                                     const ObjectId &parentTree,
+                                     const ObjectId &tree,
+                                     const BloomSettings &settings);
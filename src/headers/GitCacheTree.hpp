@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ObjectId.hpp"
+
+struct IndexEntry; // Forward declaration
+
+// Tree IDs of the index's directories, kept between commands so that
+// writing a tree only rebuilds directories whose entries changed (git's
+// cache-tree). Each node records how many index entries its tree covers;
+// -1 marks a directory that has to be rebuilt. Changing an index entry
+// invalidates the root and every directory on the entry's path.
+//
+// Stored in the index as a "TREE" extension in git's layout: for each
+// directory in pre-order, "<name>\0<entry count> <subtree count>\n"
+// followed by the raw tree ID when the count is not -1.
+class CacheTree {
+public:
+  // Writes "<mode> <name>\0<raw id>..." as a tree object; returns its ID.
+  using TreeWriter = std::function<ObjectId(const std::string &body)>;
+
+  void invalidate(std::string_view path);
+  void clear();
+  bool isValid() const { return root.entryCount >= 0; }
+  // Root tree of `entries`, which must be sorted by path. Valid directories
+  // are reused as they are; the others are rebuilt through `write`.
+  ObjectId update(const std::vector<const IndexEntry *> &entries,
+                  const TreeWriter &write);
+  // Trees written by the last update().
+  size_t rebuiltCount() const { return rebuilt; }
+  // Number of index entries below dir ("" for the root, else "a/b") if its
+  // node is valid and records tree `id`; -1 otherwise.
+  int32_t validCount(std::string_view dir, const ObjectId &id) const;
+  // Records that the entryCount index entries below dir make up tree `id`
+  // (e.g. because they match HEAD's tree) unless its node is already valid.
+  // Returns true if it was not.
+  bool prime(std::string_view dir, const ObjectId &id, int32_t entryCount);
+
+  void serialize(std::string &out) const;
+  // Returns false (leaving the cache empty) if data is malformed.
+  bool parse(std::string_view data);
+
+private:
+  struct Node {
+    int32_t entryCount = -1;
+    ObjectId id;
+    std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+  };
+
+  const Node *findNode(std::string_view dir) const;
+  size_t updateNode(Node &node, const std::vector<const IndexEntry *> &entries,
+                    size_t position, const std::string &prefix,
+                    const TreeWriter &write);
+  static void serializeNode(const std::string &name, const Node &node,
+                            std::string &out);
+  static bool parseNode(std::string_view &data, std::string &name, Node &node,
+                        int depth);
+
+  Node root;
+  size_t rebuilt = 0;
+};
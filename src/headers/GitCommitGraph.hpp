@@ -0,0 +1,163 @@
+#pragma once
+
+#include "GitBloomFilter.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CommitGraphException : public std::exception {
+public:
+  explicit CommitGraphException(const std::string &message)
+      : message_(message) {}
+  const char *what() const noexcept override { return message_.c_str(); }
+
+private:
+  std::string message_;
+};
+
+// What history walks need to know about a commit.
+struct CommitInfo {
+  ObjectId tree;
+  std::vector<ObjectId> parents; // in commit order
+  int64_t commitTime = 0;        // committer timestamp, seconds
+  // 1 for root commits, otherwise 1 + the largest parent generation. A
+  // commit can only reach commits of a lower generation. Commits that are
+  // not in the graph get kGenerationInfinity.
+  uint32_t generation = 0;
+};
+
+// Read-only, memory-mapped commit-graph, in git's v1 format so that git
+// itself can read it:
+//
+//   header   "CGPH", version 1, hash version 1 (SHA-1), chunk count, number
+//            of base layers
+//   chunks   table of (4-byte id, 8-byte offset), ended by a zero id
+//     OIDF   256-entry fan-out over the first ID byte
+//     OIDL   sorted raw 20-byte commit IDs
+//     CDAT   per commit: root tree ID, first and second parent position,
+//            then generation (30 bits) and commit time (34 bits)
+//     EDGE   extra parents of octopus merges (only when there are any)
+//     BIDX   per commit: end offset of its changed-path Bloom filter
+//     BDAT   Bloom settings, then the filters (see GitBloomFilter.hpp)
+//     BASE   checksums of the base layers, oldest first (layers only)
+//   trailer  SHA-1 of everything above
+//
+// The graph is a chain of such files, as git writes with --split:
+// objects/info/commit-graphs/commit-graph-chain lists the trailer checksums
+// of graph-<checksum>.graph layers, oldest first. Each layer holds the
+// commits missing from the layers below it, and positions count through
+// the whole chain (a layer's first commit follows the last one of its
+// base). A single objects/info/commit-graph from older versions is read as
+// a one-layer chain.
+//
+// Parents are stored as positions, so a walk that stays inside the graph
+// never inflates or parses a commit object.
+class CommitGraph {
+public:
+  static const uint32_t kGenerationInfinity = 0xffffffffu;
+
+  // Shared instance for a repository; null when there is no graph. The
+  // chain is remapped when it changes on disk (after commit, pull or gc).
+  static std::shared_ptr<CommitGraph> forGitDir(const std::string &gitDir);
+  // The chain if there is one, else the single file, else null. Throws
+  // CommitGraphException if a file is malformed.
+  static std::shared_ptr<CommitGraph> load(const std::string &gitDir);
+  static std::string pathFor(const std::string &gitDir);
+  static std::string chainPathFor(const std::string &gitDir);
+  static std::string layerPathFor(const std::string &gitDir,
+                                  const ObjectId &checksum);
+  // Maps one file on top of base (null for the first layer). Throws
+  // CommitGraphException if the file is malformed or names other bases.
+  static std::shared_ptr<CommitGraph>
+  open(const std::string &path,
+       const std::shared_ptr<CommitGraph> &base = nullptr);
+  ~CommitGraph();
+
+  CommitGraph(const CommitGraph &) = delete;
+  CommitGraph &operator=(const CommitGraph &) = delete;
+
+  // Commits in this layer and all below it.
+  uint32_t commitCount() const { return baseCount + count; }
+  // The layers below this one: null and 0 for the first layer.
+  const std::shared_ptr<CommitGraph> &baseGraph() const { return base; }
+  uint32_t baseCommitCount() const { return baseCount; }
+  uint32_t layerCount() const { return base ? base->layerCount() + 1 : 1; }
+  // The trailer, which names the file in a chain.
+  ObjectId checksum() const;
+
+  bool findPosition(const ObjectId &id, uint32_t &position) const;
+  ObjectId commitIdAt(uint32_t position) const;
+  ObjectId treeIdAt(uint32_t position) const;
+  std::vector<uint32_t> parentPositions(uint32_t position) const;
+  uint32_t generationAt(uint32_t position) const;
+  int64_t commitTimeAt(uint32_t position) const;
+  // Fills info for a commit; false if the commit is not in the graph.
+  bool read(const ObjectId &id, CommitInfo &info) const;
+
+  // Changed-path Bloom filters, present when every layer has BIDX and BDAT
+  // with the same settings.
+  bool hasChangedPathFilters() const { return allLayersHaveFilters; }
+  const BloomSettings &changedPathSettings() const { return bloomSettings; }
+  // The filter of the commit at position; size 0 if it has none.
+  void changedPathFilter(uint32_t position, const unsigned char *&filter,
+                         size_t &filterSize) const;
+
+private:
+  CommitGraph() = default;
+  // The layer holding position, which becomes an index into that layer.
+  const CommitGraph *layerOf(uint32_t &position) const;
+  const unsigned char *commitData(uint32_t position) const;
+
+  std::shared_ptr<CommitGraph> base;
+  uint32_t baseCount = 0;
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+  uint32_t count = 0;
+  const unsigned char *fanout = nullptr;
+  const unsigned char *ids = nullptr;
+  const unsigned char *commits = nullptr;
+  const unsigned char *edges = nullptr;
+  size_t edgeCount = 0;
+  const unsigned char *bloomIndex = nullptr;
+  const unsigned char *bloomData = nullptr; // filters, after the settings
+  size_t bloomDataSize = 0;
+  BloomSettings bloomSettings;
+  bool allLayersHaveFilters = false;
+};
+
+// Commit lookups for history walks: answered from the commit-graph when the
+// commit is in it, otherwise by parsing the commit object (commits made
+// since the graph was last written).
+class CommitInfoReader {
+public:
+  explicit CommitInfoReader(const std::string &gitDir);
+  // False if the commit is neither in the graph nor readable.
+  bool read(const ObjectId &id, CommitInfo &info);
+
+private:
+  std::string gitDir;
+  std::shared_ptr<CommitGraph> graph;
+};
+
+// Brings the commit-graph up to date with everything reachable from tips.
+// The commits missing from the graph are read from the object store and
+// written as a new layer on top of the chain, so the files already there
+// are left alone. The new layer absorbs the layers below it while it holds
+// more than half as many commits as the next one down, which keeps the
+// chain logarithmic in the history while each update costs about as much
+// as the commits it adds. Files are written under a temporary name and
+// renamed into place. Returns the number of commits added, or -1 on
+// failure. Honors core.commitGraph (set it to false to stop writing the
+// graph) unless force is set.
+//
+// Changed-path Bloom filters are computed, on all hardware threads, for the
+// new commits when the graph already carries filters; when force
+// (`mgit commit-graph write`) or addFilters (`gc`) asks for them on a graph
+// without, or commitGraph.changedPaths is false on one with, the whole
+// chain is rewritten as one layer. The automatic updates after commit and
+// pull never start filters on their own: that would diff all of history.
+long updateCommitGraph(const std::string &gitDir,
+                       const std::vector<ObjectId> &tips,
+                       bool force = false, bool addFilters = false);
@@ -19,7 +19,7 @@ public:
     
     // Core config operations
     bool setConfig(const std::string& key, const std::string& value);
-    bool getConfig(const std::string& key, std::string& value);
+    bool getConfig(const std::string& key, std::string& value) const;
     bool listConfig();
     bool removeConfig(const std::string& key);
     
@@ -32,6 +32,16 @@ public:
     std::string getUserEmail() const;
     std::string getRepositoryName() const;
     std::string getRemoteUrl() const;
+    // zlib levels (-1 = zlib default, 0 = store, 1 fastest .. 9 smallest),
+    // resolved like git: core.compression applies to everything and
+    // core.looseCompression overrides it for loose objects. Unset, packs use
+    // zlib's default and loose objects use level 1, since they are written
+    // on every add and usually repacked later anyway.
+    int getCompressionLevel() const;
+    int getLooseCompressionLevel() const;
+    // Byte size with an optional k/m/g suffix (core.objectCacheSize, ...);
+    // returns fallback when the key is unset or malformed.
+    size_t getByteSize(const std::string& key, size_t fallback) const;
 
     // Remote management
     bool addRemote(const std::string& name, const std::string& path);
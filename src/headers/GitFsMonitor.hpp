@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+
+// Filesystem monitor ("mgit fsmonitor"): a daemon that watches the working
+// tree with inotify, keeps a journal of the paths that changed, and tells
+// status and add which paths changed since a token it handed out earlier.
+// They save the token in the index and only look at the reported paths, so
+// an unchanged tree costs no lstat() at all.
+//
+// Tokens are "mgit:<epoch>:<sequence>". Each daemon start, and each inotify
+// queue overflow, begins a new epoch; a token from another epoch (or one
+// older than the trimmed journal) gets a trivial answer, "anything may have
+// changed", and the caller falls back to a full scan. So does a caller that
+// finds no daemon listening.
+//
+// Protocol, over the Unix socket <gitDir>/fsmonitor--daemon.ipc: the client
+// sends a token (empty to just get one) and a newline. The daemon answers
+// with a new token, NUL, then either "/" NUL (trivial) or every changed path
+// NUL-terminated. A path ending in '/' stands for everything below that
+// directory (created, removed or moved directories). "quit\n" stops it.
+class FsMonitor {
+public:
+  struct Changes {
+    bool trivial = true; // assume everything changed
+    std::string token;   // for the next query; empty if no daemon answered
+    std::unordered_set<std::string> paths; // reported files
+    std::unordered_set<std::string> dirs;  // reported directories, no '/'
+    // Directories with a reported entry, i.e. whose listing may differ.
+    std::unordered_set<std::string> parents;
+
+    bool mayHaveChanged(const std::string &path) const;
+    // The directory's entries may have been added, removed or renamed.
+    bool dirMayHaveChanged(const std::string &dir) const;
+    size_t reported() const { return paths.size() + dirs.size(); }
+  };
+
+  // What changed in the working tree of gitDir since token. Never fails: a
+  // missing, stale or slow daemon yields a trivial answer without a token.
+  static Changes query(const std::string &gitDir, const std::string &token);
+
+  // Runs the daemon for the working tree containing gitDir (the current
+  // directory) until it is stopped. Returns false if it cannot start, e.g.
+  // because one is already running.
+  static bool run(const std::string &gitDir);
+  // Starts the daemon in the background and waits until it answers.
+  static bool start(const std::string &gitDir);
+  static bool stop(const std::string &gitDir);
+  static bool isRunning(const std::string &gitDir);
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectId.hpp"
+
+// One wildcard pattern in git's wildmatch syntax ('*', '?', '[...]', '**',
+// backslash escapes), compiled to a small NFA: one state per token, and
+// matching advances the set of live states one character at a time. Patterns
+// with several stars therefore never backtrack. '*', '?' and classes do not
+// match '/'; "**/" matches any number of leading directories, "/**/" any
+// number of middle ones and a trailing "/**" everything below.
+//
+// Patterns of fewer than 64 tokens keep the state set in one word and step
+// it with precomputed per-character masks (shift-and); longer ones walk the
+// live states one by one.
+class IgnoreGlob {
+public:
+  explicit IgnoreGlob(std::string_view pattern);
+
+  bool matches(std::string_view text) const;
+  // True when the pattern has no wildcards (prefix() is all of it).
+  bool isLiteral() const { return literal; }
+  // Characters every match starts / ends with.
+  const std::string &prefix() const { return literalPrefix; }
+  const std::string &suffix() const { return literalSuffix; }
+  // The longest run of literal characters; every match contains it.
+  const std::string &infix() const { return literalInfix; }
+  // The pattern is '*' followed by literal characters only.
+  bool isStarSuffix() const { return starSuffix; }
+
+private:
+  enum class Op : uint8_t {
+    Char,         // ch
+    AnyChar,      // '?'
+    Class,        // '[...]', index into classes
+    Star,         // '*': zero or more characters other than '/'
+    AnyPath,      // trailing "**": anything, '/' included
+    AnyDirs,      // "**/": zero or more "<dir>/"
+    AnyDirsInner, // inside one of the directories of the preceding AnyDirs
+  };
+  struct Token {
+    Op op;
+    unsigned char ch = 0;
+    uint32_t cls = 0;
+  };
+
+  // State bits a character moves on to the next state, keeps, or (the
+  // '/' closing an AnyDirs directory) moves back to the previous one.
+  struct Moves {
+    uint64_t advance = 0;
+    uint64_t stay = 0;
+    uint64_t back = 0;
+    bool operator==(const Moves &other) const {
+      return advance == other.advance && stay == other.stay &&
+             back == other.back;
+    }
+  };
+
+  size_t parseClass(std::string_view pattern, size_t pos);
+  void compileMoves();
+  uint64_t closeStates(uint64_t states) const;
+  bool matchesLong(std::string_view text) const;
+
+  std::vector<Token> tokens;
+  std::vector<std::bitset<256>> classes;
+  std::vector<uint32_t> epsilonStates; // Star, AnyPath and AnyDirs tokens
+  // Shift-and tables (fewer than 64 tokens): characters with the same moves
+  // share an entry.
+  std::vector<Moves> moves;
+  unsigned char moveIndex[256] = {};
+  std::string literalPrefix;
+  std::string literalSuffix;
+  std::string literalInfix;
+  bool literal = true;
+  bool starSuffix = false;
+};
+
+// The patterns of one ignore file, relative to the directory holding it.
+// Semantics follow gitignore: blank lines and '#' comments are skipped, '!'
+// re-includes, a trailing '/' matches directories only, and a pattern
+// containing another '/' is matched against the path below that directory
+// instead of the basename. The last matching pattern decides.
+//
+// Rules are bucketed by the cheapest test that can decide them: literal
+// basenames and literal paths in hash tables, "*.ext" patterns by extension,
+// and only the remaining wildcards go through IgnoreGlob, after their
+// literal prefix, suffix and longest literal run have been checked.
+class IgnoreRules {
+public:
+  enum class Match { None, Ignored, Included };
+
+  // base is the directory of the ignore file ("" for the top level).
+  IgnoreRules(std::string base, std::string_view text);
+  // The buckets point into the rules.
+  IgnoreRules(const IgnoreRules &) = delete;
+  IgnoreRules &operator=(const IgnoreRules &) = delete;
+  IgnoreRules(IgnoreRules &&) = default;
+  IgnoreRules &operator=(IgnoreRules &&) = default;
+
+  bool empty() const { return rules.empty(); }
+  // path is relative to the work tree and lies below base.
+  Match match(std::string_view path, bool isDir) const;
+
+private:
+  struct Rule {
+    IgnoreGlob glob;
+    bool negated = false;
+    bool dirOnly = false;
+    bool anchored = false; // matched against the path below base
+  };
+  // Keys are views of the rules' literal text.
+  using Bucket = std::unordered_map<std::string_view, std::vector<uint32_t>>;
+
+  void addPattern(std::string_view line);
+  void addToBucket(uint32_t index);
+
+  std::string base;
+  std::vector<Rule> rules; // file order; indexes below are ascending
+  Bucket byName;           // literal, unanchored: the whole basename
+  Bucket byPath;           // literal, anchored: the path below base
+  Bucket byExtension;      // "*<literal>.<ext>": keyed by ext
+  std::vector<uint32_t> wildcards;
+};
+
+// The ignore rules in effect for the entries of one directory: its own
+// .mgitignore over those of its parents, over the repository-wide files
+// ($GIT_DIR/info/exclude, then core.excludesFile). Stacks are immutable and
+// share their parents, so walker threads hand them to subdirectories freely.
+class IgnoreStack {
+public:
+  using Ptr = std::shared_ptr<const IgnoreStack>;
+  static constexpr const char *kFileName = ".mgitignore";
+
+  static Ptr forRepository(const std::string &gitDir);
+  // parent plus root/dir/.mgitignore; parent itself if there is none.
+  static Ptr enter(const Ptr &parent, const std::string &root,
+                   const std::string &dir);
+  // True if path, or one of the directories above it, is ignored. Reads
+  // the .mgitignore files on the way down from root.
+  static bool isPathIgnored(const Ptr &repository, const std::string &root,
+                            std::string_view path);
+
+  // path is relative to the work tree and lies below the directory of the
+  // innermost ignore file.
+  bool isIgnored(std::string_view path, bool isDir) const;
+  // Changes whenever any of the stacked ignore files does.
+  const ObjectId &id() const { return stackId; }
+
+private:
+  IgnoreStack(Ptr parent, IgnoreRules rules, const ObjectId &id);
+  static Ptr push(const Ptr &parent, const std::string &dir,
+                  const std::string &text);
+
+  Ptr parent;
+  IgnoreRules rules;
+  ObjectId stackId;
+};
@@ -1,20 +1,38 @@
 #pragma once
 #include <memory>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "GitCacheTree.hpp"
+#include "GitIgnore.hpp"
+#include "GitUntrackedCache.hpp"
+#include "ObjectId.hpp"
+
 enum class ConflictState { NONE, UNRESOLVED, RESOLVED };
 
 struct IndexEntry {
   std::string mode;
   std::string path;
-  std::string hash;       // Our version
-  std::string base_hash;  // Base version
-  std::string their_hash; // Their version
+  ObjectId hash;       // Our version
+  ObjectId base_hash;  // Base version (null if none)
+  ObjectId their_hash; // Their version (null if none)
   ConflictState conflict_state = ConflictState::NONE;
   std::string conflict_marker; // For file conflicts
+
+  // lstat() data of the working-tree file when it was last hashed. A file
+  // whose stat data still matches is assumed unchanged (see computeStatus).
+  int64_t mtime_ns = 0;
+  int64_t ctime_ns = 0;
+  uint64_t size = 0;
+  uint64_t ino = 0;
+  uint64_t dev = 0;
+  // The file was clean as of the index's fsmonitor token, so unless the
+  // daemon reports it, it need not even be lstat()ed (see GitFsMonitor).
+  bool fsmonitor_valid = false;
 };
 
 struct ConflictMarker {
@@ -29,6 +47,67 @@ struct StatusResult {
   std::vector<std::string> untracked_files;
 };
 
+// Read-only, memory-mapped view of the binary index file (.git/index).
+//
+// Layout, all integers big-endian:
+//   header   "MGIX", version, entry count, record size, then (version 3)
+//            the size of the string table
+//   records  fixed-width, sorted by path: mode, conflict state, path and
+//            conflict-marker offsets/lengths into the string table, the
+//            raw 20-byte hash, base hash and their hash, then (version 2)
+//            the cached mtime, ctime, size, inode and device
+//   strings  paths and conflict markers, NUL-separated
+//   extensions (version 3) 4-byte signature, 4-byte size, data; readers
+//            skip signatures they do not know. "TREE" holds the CacheTree,
+//            "UNTR" the UntrackedCache, "FSMN" the fsmonitor token, NUL,
+//            and a bitmap of fsmonitor_valid, one bit per record.
+//   trailer  SHA-1 of everything above
+//
+// Records are fixed width and sorted by path, so find() binary-searches
+// them in place and entryAt() decodes any one of them straight from the
+// mapping; IndexManager::readIndex() decodes them all.
+class IndexFileView {
+public:
+  // Returns nullptr when the file is missing, empty or not in binary format.
+  static std::unique_ptr<IndexFileView> open(const std::string &indexPath);
+  ~IndexFileView();
+
+  IndexFileView(const IndexFileView &) = delete;
+  IndexFileView &operator=(const IndexFileView &) = delete;
+
+  uint32_t size() const { return count; }
+  // mtime of the index file itself; entries modified at or after it are
+  // "racily clean" and must be rehashed even if their stat data matches.
+  int64_t fileMtimeNs() const { return mtimeNs; }
+  IndexEntry entryAt(uint32_t position) const;
+  // Binary search over the records; false if path is not in the index.
+  bool find(std::string_view path, uint32_t &position) const;
+  bool verifyChecksum() const;
+  // Data of the extension with this 4-byte signature; empty if absent.
+  std::string_view extension(const char *signature) const;
+
+  // Detects the binary format by its magic bytes.
+  static bool isBinaryIndex(const std::string &indexPath);
+
+private:
+  IndexFileView() = default;
+  const unsigned char *record(uint32_t position) const;
+  std::string_view pathAt(uint32_t position) const;
+  std::string_view stringAt(uint32_t offset, uint32_t length) const;
+
+  const unsigned char *data = nullptr;
+  size_t dataSize = 0;
+  uint32_t version = 0;
+  uint32_t count = 0;
+  uint32_t recordSize = 0;
+  int64_t mtimeNs = 0;
+  const unsigned char *records = nullptr;
+  const unsigned char *strings = nullptr;
+  size_t stringsSize = 0;
+  const unsigned char *extensions = nullptr;
+  size_t extensionsSize = 0;
+};
+
 class IndexManager {
 private:
   std::string gitDir;
@@ -36,17 +115,56 @@ private:
   std::unordered_map<std::string, size_t>
       pathToIndex; // fast lookup: path → index in vector
   std::unordered_map<std::string, ConflictMarker> conflictMarkers;
+  // Tree IDs of unchanged directories, saved with the index.
+  CacheTree cacheTree;
+  // Untracked files of unchanged working-tree directories (status).
+  UntrackedCache untrackedCache;
+  // Last token from the fsmonitor daemon; empty if none.
+  std::string fsmonitorToken;
+
+  // mtime of the index file as last read or written (racy-git check).
+  int64_t indexMtimeNs = 0;
+  // Set by mapIndex() until readIndex() decodes the entries: path lookups
+  // then search the mapped file instead of entries.
+  std::unique_ptr<IndexFileView> view;
+
+  // Reads the tab-separated format used before the binary index.
+  bool readLegacyIndex(const std::string &path);
+  bool isRacilyClean(const IndexEntry &entry) const;
+  void clearCaches();
 
 public:
   IndexManager(const std::string &gitDir = ".git");
   // Core index methods
   bool readIndex();  // Populates entries and map
+  // Maps the index for path lookups (isTracked, isUnchanged) without
+  // decoding its entries. Call readIndex() before changing the index. An
+  // index in the old text format is read in full.
+  bool mapIndex();
   void writeIndex(); // Writes vector entries to disk
   void addOrUpdateEntry(const IndexEntry &entry);
   const std::vector<IndexEntry> &getEntries() const;
+  // Entries ordered by path (the order they are written in).
+  std::vector<const IndexEntry *> sortedEntries() const;
+  CacheTree &getCacheTree() { return cacheTree; }
   void printEntries() const;
-  StatusResult computeStatus(const std::string &headTreeHash);
+  // headTree is null for an unborn branch.
+  StatusResult computeStatus(const ObjectId &headTree);
+  // The files `add .` has to hash: untracked files that are not ignored and
+  // tracked ones that may have changed. Needs an answer from the fsmonitor
+  // daemon, whose token is then kept; returns false without one (the
+  // caller has to look at the whole tree).
+  bool listChangedFiles(const IgnoreStack::Ptr &ignore,
+                        std::vector<std::string> &files);
   IndexEntry gitIndexEntryFromPath(const std::string &path);
+  // Stores the current lstat() data of entry.path in the entry.
+  static bool fillStatData(IndexEntry &entry);
+  // True when entry.path still has the stat data cached in the entry.
+  static bool statDataMatches(const IndexEntry &entry);
+  // True when path is tracked and its file is known to be unchanged: the
+  // stat data matches and is not racy. Such files need not be hashed again.
+  bool isUnchanged(const std::string &path) const;
+  bool isTracked(const std::string &path) const;
 
   // Conflict handling
   void recordConflict(const std::string &path, const IndexEntry &base,
@@ -54,10 +172,10 @@ public:
   bool hasConflicts() const;
   std::vector<std::string> getConflictingFiles() const;
   bool isConflicted(const std::string &path) const;
-  bool resolveConflict(const std::string &path, const std::string &hash);
+  bool resolveConflict(const std::string &path, const ObjectId &id);
   void abortMerge();
   void addConflictMarker(const std::string &path, const ConflictMarker &marker);
   std::optional<ConflictMarker>
   getConflictMarker(const std::string &path) const;
-  void resetFromTree(const std::string &treeHash);
+  void resetFromTree(const ObjectId &treeId);
 };
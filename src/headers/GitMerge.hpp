@@ -44,11 +44,10 @@ public:
   std::string getConflictDetails(const std::string &filename);
 
   // Three-way merge methods
-  bool threeWayMerge(const std::string &currentCommit,
-                     const std::string &targetCommit,
-                     const std::string &commonAncestor);
-  bool mergeTrees(const std::string &currentTree, const std::string &targetTree,
-                  const std::string &ancestorTree, std::string &mergedTreeHash);
+  bool threeWayMerge(const ObjectId &currentCommit, const ObjectId &targetCommit,
+                     const ObjectId &commonAncestor);
+  bool mergeTrees(const ObjectId &currentTree, const ObjectId &targetTree,
+                  const ObjectId &ancestorTree, ObjectId &mergedTree);
 
   // Error handling
   class MergeException : public std::runtime_error {
@@ -65,27 +64,26 @@ private:
   std::mutex mergeMutex;
 
   // Helper functions
-  bool compareTrees(const std::string &tree1, const std::string &tree2);
-  bool compareBlobs(const std::string &blob1, const std::string &blob2);
-  bool findConflictsInTree(const std::string &tree1, const std::string &tree2);
-  bool findConflictsInBlob(const std::string &blob1, const std::string &blob2,
+  bool compareTrees(const ObjectId &tree1, const ObjectId &tree2);
+  bool compareBlobs(const ObjectId &blob1, const ObjectId &blob2);
+  bool findConflictsInTree(const ObjectId &tree1, const ObjectId &tree2);
+  bool findConflictsInBlob(const ObjectId &blob1, const ObjectId &blob2,
                            const std::string &filename);
-  bool detectFileRenames(const std::string &tree1, const std::string &tree2);
-  bool detectDirectoryConflicts(const std::string &tree1,
-                                const std::string &tree2);
+  bool detectFileRenames(const ObjectId &tree1, const ObjectId &tree2);
+  bool detectDirectoryConflicts(const ObjectId &tree1, const ObjectId &tree2);
 
   // Tree comparison helpers
-  std::string getBlobContent(const std::string &hash);
+  std::string getBlobContent(const ObjectId &id);
   std::string mergeFileContents(const std::string &baseContent,
                                 const std::string &ourContent,
                                 const std::string &theirContent);
-  bool compareTreeEntries(const std::string &tree1, const std::string &tree2,
+  bool compareTreeEntries(const ObjectId &tree1, const ObjectId &tree2,
                           bool recursive = true);
 
   // Error handling
-  bool validateCommit(const std::string &commitHash);
+  bool validateCommit(const ObjectId &commit);
   bool validateBranch(const std::string &branchName);
   bool validatePath(const std::string &path);
-  bool validateTreeHash(const std::string &treeHash);
-  bool validateBlobHash(const std::string &blobHash);
+  bool validateTreeHash(const ObjectId &tree);
+  bool validateBlobHash(const ObjectId &blob);
 };
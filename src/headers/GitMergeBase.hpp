@@ -0,0 +1,30 @@
+#pragma once
+
+#include "GitCommitGraph.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Loads a commit's parents, time and generation (see CommitInfoReader).
+using CommitLookup =
+    std::function<bool(const ObjectId &id, CommitInfo &info)>;
+
+// All best common ancestors of a and b: common ancestors that are not
+// ancestors of another common ancestor (git merge-base --all).
+//
+// Paints down from both commits along every parent with a priority queue
+// ordered by generation number, then commit time. A commit reached from both
+// sides is a merge base and marks everything below it stale; the walk ends as
+// soon as only stale commits are queued, so history below the merge bases is
+// never visited. Commits outside the commit-graph (generation infinity) are
+// ordered by date; any redundant result that clock skew lets through is
+// removed afterwards with a generation-bounded reachability check.
+//
+// Returns an empty list when the commits share no history.
+std::vector<ObjectId> findMergeBases(const ObjectId &a, const ObjectId &b,
+                                     const CommitLookup &lookup);
+
+// True if ancestor is reachable from descendant (or equal to it). The walk
+// never descends below the ancestor's generation.
+bool isAncestor(const ObjectId &ancestor, const ObjectId &descendant,
+                const CommitLookup &lookup);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "ObjectId.hpp"
+
+// Size-bounded LRU cache of decompressed objects ("<type> <size>\0<body>"),
+// keyed by object ID. Objects are immutable, so entries never go stale;
+// they only leave the cache when the memory budget forces them out or the
+// object is deleted. One instance is shared per git directory, so every
+// BlobObject/TreeObject/CommitObject of a command hits the same cache.
+class ObjectCache {
+public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget = 0;
+  };
+
+  using Object = std::shared_ptr<const std::string>;
+
+  static const size_t kDefaultBudget = 64 * 1024 * 1024;
+
+  // The budget comes from core.objectCacheSize (bytes, with an optional
+  // k/m/g suffix; 0 disables the cache) when the instance is first created.
+  static std::shared_ptr<ObjectCache> forGitDir(const std::string &gitDir);
+
+  // Returns null (and counts a miss) when the object is not cached.
+  Object get(const ObjectId &id);
+  // Objects larger than a quarter of the budget are not cached, so one big
+  // blob cannot flush every tree and commit.
+  void put(const ObjectId &id, std::string object);
+  // Shares an already allocated object with the cache instead of copying.
+  void put(const ObjectId &id, Object object);
+  void erase(const ObjectId &id);
+  void clear();
+  // Evicts least-recently-used entries until the cache fits the new budget.
+  void setBudget(size_t bytes);
+  Stats stats();
+
+private:
+  explicit ObjectCache(size_t budget);
+  void evictLocked(size_t budget);
+
+  using Entry = std::pair<ObjectId, Object>;
+  std::list<Entry> lru; // most recently used first
+  std::unordered_map<ObjectId, std::list<Entry>::iterator> index;
+  size_t budget;
+  size_t bytes = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  std::mutex mutex;
+};
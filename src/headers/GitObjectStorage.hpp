@@ -1,11 +1,20 @@
 #pragma once
+#include <cstdint>
 #include <cstdio>
+#include <istream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <memory>
 #include <optional>
 #include <filesystem>
+#include <functional>
+#include "ObjectId.hpp"
+#include "ZlibUtils.hpp"
+
+class ObjectCache;
 
 class ObjectException : public std::exception {
 public:
@@ -24,15 +33,15 @@ enum class GitObjectType {
 };
 
 struct CommitData {
-    std::string tree;
-    std::vector<std::string> parents;
+    ObjectId tree;
+    std::vector<ObjectId> parents;
     std::string author;
     std::string committer;
     std::string message;
 };
 
 struct TagData {
-    std::string objectHash;   // SHA of the object being tagged
+    ObjectId objectHash;      // the object being tagged
     std::string objectType;   // "commit", "tree", "blob"
     std::string tagName;      // e.g., "v1.0"
     std::string tagger;       // Full tagger line: "Name <email> timestamp +timezone"
@@ -48,7 +57,7 @@ struct BlobData {
 struct TreeEntry {
     std::string mode;
     std::string filename;
-    std::string hash;
+    ObjectId hash;
 };
 
 class StorageException : public std::exception {
@@ -59,27 +68,99 @@ private:
     std::string message_;
 };
 
+// A decompressed object: its type, size and body. The views point into one
+// shared "<type> <size>\0<body>" buffer (the one the object cache holds,
+// when the object is cached), so copying an ObjectView or taking views of
+// it never duplicates the object. Views stay valid while any copy lives.
+class ObjectView {
+public:
+    ObjectView() = default;
+
+    explicit operator bool() const { return buffer != nullptr; }
+    GitObjectType type() const { return type_; }
+    std::string_view typeName() const { return typeName_; }
+    uint64_t size() const { return body_.size(); }
+    std::string_view body() const { return body_; }
+    // The whole object, header included.
+    std::string_view raw() const {
+        return buffer ? std::string_view(*buffer) : std::string_view();
+    }
+
+private:
+    friend class GitObjectStorage;
+    // Parses the header; throws StorageException if it is malformed or its
+    // size disagrees with the body.
+    explicit ObjectView(std::shared_ptr<const std::string> object);
+
+    std::shared_ptr<const std::string> buffer;
+    GitObjectType type_ = GitObjectType::Unknown;
+    std::string_view typeName_;
+    std::string_view body_;
+};
+
 class GitObjectStorage {
 public:
     explicit GitObjectStorage(const std::string& gitDir = ".git");
     
     // Core storage operations
-    std::string readObject(const std::string& hash);
-    bool writeObject(const std::string& hash, const std::string& content);
-    std::string writeObject(const std::string& content);
-    bool deleteObject(const std::string& hash);
-    bool objectExists(const std::string& hash);
+    // The object without copying it out of the inflated buffer; an empty
+    // view if it is missing or corrupt. Results go through the repository's
+    // shared ObjectCache, so re-reading a tree or commit does not re-inflate.
+    ObjectView readObjectView(const ObjectId& id);
+    // Returns "<type> <size>\0<body>" as an owned copy of readObjectView().
+    std::string readObject(const ObjectId& id);
+    // Type ("blob", ...) and body size without reading the body: a loose
+    // object has only its first bytes inflated, a packed one is answered
+    // from its entry header. Returns false if the object is missing or
+    // corrupt.
+    bool readObjectHeader(const ObjectId& id, std::string& type,
+                          uint64_t& size);
+    // Called with the object's type and body size before any body bytes.
+    using ObjectHeaderFn =
+        std::function<void(const std::string& type, uint64_t size)>;
+    // Reads an object piecewise: onHeader gets the type and size, then the
+    // body is passed to onBody in chunks. Loose objects and whole pack
+    // entries are inflated as they are read, so memory stays constant;
+    // deltas are resolved first (they need their base) and handed over in
+    // one piece. Returns false if the object is missing or corrupt.
+    bool streamObject(const ObjectId& id, const ObjectHeaderFn& onHeader,
+                      const ZlibSink& onBody);
+    bool writeObject(const ObjectId& id, const std::string& content);
+    // Hashes, deflates and stores "<type> <size>\0<body>"; the null ID on
+    // failure.
+    ObjectId writeObject(const std::string& content);
+    // Streams `size` bytes from `in` into a loose object of the given type
+    // ("blob", ...). Chunks are hashed and deflated as they are read into a
+    // temporary file, which is renamed into objects/xx/ once the hash is
+    // known, so memory use does not grow with the object. Returns the null
+    // ID on failure, including when `in` does not hold exactly `size` bytes.
+    ObjectId writeObjectStream(const std::string& type, std::istream& in,
+                                  uint64_t size);
+    // Object hash of the same stream without writing anything.
+    static ObjectId hashObjectStream(const std::string& type,
+                                     std::istream& in, uint64_t size);
+    bool deleteObject(const ObjectId& id);
+    bool objectExists(const ObjectId& id);
     
     // Validation and maintenance
+    // Checks that user input is a 40-digit hex object name.
     bool validateHash(const std::string& hash);
-    bool validateObjectIntegrity(const std::string& hash);
+    bool validateObjectIntegrity(const ObjectId& id);
     bool cleanupOrphanedObjects();
-    bool compressObjects();
+    // Repacks loose and packed objects into a single delta-compressed pack.
+    // pathHints maps object IDs to the path they were seen at, which
+    // groups versions of the same file for the delta search. The window and
+    // chain depth come from pack.window / pack.depth (defaults 10 / 50).
+    bool compressObjects(
+        const std::unordered_map<ObjectId, std::string>& pathHints = {});
+    size_t getLastDeltaCount() const { return lastDeltaCount; }
     
     // Utility methods
-    std::string getObjectPath(const std::string& hash) const;
-    std::vector<std::string> listAllObjects() const;
+    std::string getObjectPath(const ObjectId& id) const;
+    std::vector<ObjectId> listAllObjects() const;
     size_t getObjectCount() const;
+    std::string objectTypeToString(GitObjectType type);
+    GitObjectType parseGitObjectTypeFromString(const std::string& header);
 
 protected:
     const std::string& getGitDir() const { return gitDir; }
@@ -87,6 +168,11 @@ protected:
 private:
     std::string gitDir;
     std::string objectsDir;
-    std::string objectTypeToString(GitObjectType type);
-    GitObjectType parseGitObjectTypeFromString(const std::string& header);
+    std::shared_ptr<ObjectCache> cache;
+    size_t lastDeltaCount = 0;
+    std::string readLooseObject(const ObjectId& id) const;
+    int looseCompressionLevel() const;
+    std::string tempObjectPath() const;
+    void installLooseObject(const std::string& tmpPath, const ObjectId& id);
+    std::vector<ObjectId> listLooseObjects() const;
 };
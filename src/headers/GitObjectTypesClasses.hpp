@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GitObjectStorage.hpp"
+#include "GitTreeCache.hpp"
 #include <map>
 #include <memory>
 #include <string>
@@ -8,16 +9,17 @@
 #include <vector>
 
 struct IndexEntry; // Forward declaration
+class IndexManager;
 
 class GitObject {
 public:
   GitObjectType type;
-  std::string hash;
+  ObjectId id;
   std::string content;
 
   virtual ~GitObject() = default;
   virtual bool writeObject(const std::string &content) = 0;
-  virtual std::string readObject(const std::string &hash) = 0;
+  virtual std::string readObject(const ObjectId &id) = 0;
 };
 
 class BlobObject : public GitObjectStorage {
@@ -27,10 +29,16 @@ private:
 
 public:
   BlobObject(const std::string &gitDir);
-  std::string writeObject(const std::string &path, const bool &write);
+  ObjectId writeObject(const std::string &path, const bool &write);
   bool validateContent(const std::string &content);
   bool updateContent(const std::string &newContent);
-  BlobData readObject(const std::string &hash);
+  // Owned copy of the blob's content; prefer readView() for blobs that may
+  // be large.
+  BlobData readObject(const ObjectId &id);
+  // The blob without copying it (an empty view if it is missing or not a
+  // blob).
+  ObjectView readView(const ObjectId &id);
+  // Content last set by updateContent().
   const BlobData &getContent() const;
   GitObjectType getType() const;
 };
@@ -39,24 +47,29 @@ class TreeObject : public GitObjectStorage {
 private:
   GitObjectType type;
   std::vector<TreeEntry> content;
-  std::string writeTreeRecursive(const std::vector<IndexEntry> &entries);
 
 public:
   TreeObject(const std::string &gitDir);
-  bool restoreWorkingDirectoryFromTreeHash(const std::string &hash,
+  bool restoreWorkingDirectoryFromTreeHash(const ObjectId &id,
                                            const std::string &path);
-  std::string writeObject(const std::string &path);
-  std::string writeTreeFromIndex(const std::vector<IndexEntry> &entries);
+  ObjectId writeObject(const std::string &path);
+  // Writes the index as trees. Only directories invalidated in the index's
+  // CacheTree are rebuilt; the refreshed cache is saved with the index.
+  ObjectId writeTreeFromIndex(IndexManager &index);
   bool validateEntry(const TreeEntry &entry);
   bool addEntry(const TreeEntry &entry);
   bool removeEntry(const std::string &filename);
-  std::vector<TreeEntry> readObject(const std::string &hash);
+  std::vector<TreeEntry> readObject(const ObjectId &id);
+  // Compact parsed form, shared through the repository's TreeCache; prefer
+  // it for walks that only look at names, modes and IDs. Null if the tree
+  // cannot be read.
+  TreeCache::Tree readParsedTree(const ObjectId &id);
   const std::vector<TreeEntry> &getContent() const;
   GitObjectType getType() const;
-  void restoreTreeContents(const std::string &hash, const std::string &path,
+  void restoreTreeContents(const ObjectId &id, const std::string &path,
                            std::unordered_set<std::string> &treePaths);
-  void getAllFiles(const std::string &treeHash,
-                   std::map<std::string, std::string> &files);
+  void getAllFiles(const ObjectId &treeId,
+                   std::map<std::string, ObjectId> &files);
 };
 
 class CommitObject : public GitObjectStorage {
@@ -66,9 +79,11 @@ private:
 
 public:
   CommitObject(const std::string &gitDir);
-  std::string writeObject(const CommitData &data);
-  bool validateCommit(const std::string &treeHash, const std::string &message);
-  CommitData readObject(const std::string &hash);
+  ObjectId writeObject(const CommitData &data);
+  bool validateCommit(const ObjectId &tree, const std::string &message);
+  CommitData readObject(const ObjectId &id);
+  // Parses a commit body in place; only the fields are copied out.
+  static CommitData parse(std::string_view body);
   const CommitData &getContent() const;
   GitObjectType getType() const;
 };
@@ -80,8 +95,10 @@ private:
 
 public:
   TagObject(const std::string &gitDir);
-  std::string writeObject(const TagData &data);
+  ObjectId writeObject(const TagData &data);
   const TagData &getContent() const;
   GitObjectType getType() const;
-  TagData readObject(const std::string &hash);
+  TagData readObject(const ObjectId &id);
+  // Parses a tag body in place; only the fields are copied out.
+  static TagData parse(std::string_view body);
 };
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ObjectId.hpp"
+#include "ZlibUtils.hpp"
+
+class PackException : public std::exception {
+public:
+  explicit PackException(const std::string &message) : message_(message) {}
+  const char *what() const noexcept override { return message_.c_str(); }
+
+private:
+  std::string message_;
+};
+
+// Object type codes used inside pack files (same numbering as git).
+enum class PackObjectType : uint8_t {
+  Commit = 1,
+  Tree = 2,
+  Blob = 3,
+  Tag = 4,
+  OfsDelta = 6,
+  RefDelta = 7
+};
+
+// A read-only, memory-mapped pack (.pack) together with its v2 index (.idx).
+// Lookups go through the 256-entry fan-out table and a binary search over the
+// sorted 20-byte object names, so no per-object file is ever opened.
+class PackFile {
+public:
+  static std::shared_ptr<PackFile> open(const std::string &packPath);
+  ~PackFile();
+
+  PackFile(const PackFile &) = delete;
+  PackFile &operator=(const PackFile &) = delete;
+
+  bool findOffset(const ObjectId &id, uint64_t &offset) const;
+  bool contains(const ObjectId &id) const;
+  // Returns the object as "<type> <size>\0<body>", like a loose object.
+  std::string readObject(const ObjectId &id) const;
+  // Type and size of an object from its entry header, without inflating
+  // the body. For a delta only the start of the delta is inflated (it
+  // records the target size) and the type comes from the end of its chain.
+  bool readHeader(const ObjectId &id, std::string &type, uint64_t &size) const;
+  // Called with the object's type and body size before any body bytes.
+  using HeaderFn = std::function<void(const std::string &type, uint64_t size)>;
+  // A whole entry is inflated straight into onBody in buffer-sized pieces;
+  // a delta is resolved in memory and passed in one piece. False if the
+  // object is not in this pack.
+  bool streamObject(const ObjectId &id, const HeaderFn &onHeader,
+                    const ZlibSink &onBody) const;
+
+  uint32_t objectCount() const { return count; }
+  ObjectId objectIdAt(uint32_t position) const;
+  const std::string &getPackPath() const { return packPath; }
+
+private:
+  PackFile() = default;
+  std::string readObjectAt(uint64_t offset) const;
+  // Parses the entry header at offset (type, size and, for deltas, the
+  // base's offset) and returns where its zlib data starts.
+  const unsigned char *readEntryHeader(uint64_t offset, uint8_t &type,
+                                       uint64_t &size,
+                                       uint64_t &baseOffset) const;
+  // Inflates the entry at offset, resolving OFS_DELTA/REF_DELTA chains.
+  void unpackEntry(uint64_t offset, uint8_t &type, std::string &body) const;
+
+  std::string packPath;
+  const unsigned char *packData = nullptr;
+  size_t packSize = 0;
+  const unsigned char *idxData = nullptr;
+  size_t idxSize = 0;
+  uint32_t count = 0;
+  const unsigned char *fanout = nullptr;
+  const unsigned char *names = nullptr;
+  const unsigned char *offsets = nullptr;
+  const unsigned char *largeOffsets = nullptr;
+  size_t largeOffsetCount = 0;
+};
+
+// All pack files of one repository. Instances are shared per git directory so
+// that the many short-lived GitObjectStorage objects reuse the same mappings.
+class PackStore {
+public:
+  static std::shared_ptr<PackStore> forGitDir(const std::string &gitDir);
+
+  bool contains(const ObjectId &id);
+  // Returns an empty string when no pack holds the object.
+  std::string readObject(const ObjectId &id);
+  // See PackFile::readHeader; false when no pack holds the object.
+  bool readHeader(const ObjectId &id, std::string &type, uint64_t &size);
+  // See PackFile::streamObject; false when no pack holds the object.
+  bool streamObject(const ObjectId &id, const PackFile::HeaderFn &onHeader,
+                    const ZlibSink &onBody);
+  std::vector<ObjectId> listObjects();
+  size_t packCount();
+  // Forces a rescan of objects/pack (e.g. after writing a new pack).
+  void reload();
+
+private:
+  explicit PackStore(const std::string &gitDir);
+  void scanLocked();
+  bool refreshIfChangedLocked();
+
+  std::string packDir;
+  std::vector<std::shared_ptr<PackFile>> packs;
+  int64_t scannedMtimeNs = -1;
+  bool scanned = false;
+  std::mutex mutex;
+};
+
+// Writes a set of objects into a new pack + v2 index under objects/pack.
+// Objects are sorted by type, path-name hash and size so that versions of the
+// same file end up next to each other, and each one is tried as a delta
+// against the previous `window` objects (git's sliding-window search).
+class PackWriter {
+public:
+  // Loads an object as "<type> <size>\0<body>"; returns "" on failure.
+  using ObjectLoader = std::function<std::string(const ObjectId &id)>;
+  // Type name and body size without the body; false on failure. When not
+  // given, the first pass loads whole objects to learn them.
+  using HeaderLoader = std::function<bool(const ObjectId &id,
+                                          std::string &type, uint64_t &size)>;
+
+  PackWriter(const std::string &gitDir, ObjectLoader loader,
+             HeaderLoader headerLoader = nullptr);
+
+  // nameHint is the path the object was seen at (used to group deltas).
+  void addObject(const ObjectId &id, const std::string &nameHint = "");
+  // window = 0 disables delta compression; depth bounds delta chain length.
+  void setDeltaOptions(size_t window, size_t depth);
+  // zlib level for entry data (-1 = zlib default; see core.compression).
+  void setCompressionLevel(int level) { compressionLevel = level; }
+  size_t size() const { return pending.size(); }
+  // Returns the path of the written .pack, or "" if nothing was written.
+  std::string write();
+  // The objects that actually made it into the pack.
+  const std::vector<ObjectId> &getWrittenObjects() const { return written; }
+  size_t getDeltaCount() const { return deltaCount; }
+
+private:
+  struct PendingObject {
+    ObjectId id;
+    uint32_t nameHash = 0;
+    PackObjectType type = PackObjectType::Blob;
+    size_t size = 0;
+  };
+
+  std::string gitDir;
+  ObjectLoader loader;
+  HeaderLoader headerLoader;
+  std::vector<PendingObject> pending;
+  std::vector<ObjectId> written;
+  size_t window = 10;
+  size_t depth = 50;
+  int compressionLevel = -1;
+  size_t deltaCount = 0;
+};
@@ -3,7 +3,9 @@
 #include "GitHead.hpp"
 #include "GitIndex.hpp"
 #include "GitMerge.hpp"
+#include "GitObjectCache.hpp"
 #include "GitObjectStorage.hpp"
+#include "GitRevWalk.hpp"
 #include <cstring> // Replaced memory.h with cstring
 #include <memory>  // For unique_ptr
 #include <mutex>   // For thread safety
@@ -16,35 +18,48 @@
 class GitRepository {
 private:
   std::string gitDir;
+  // Decompressed objects shared by every storage object of this repository.
+  std::shared_ptr<ObjectCache> objectCache;
   std::unique_ptr<GitMerge> merge; // Use smart pointer for better ownership
   std::mutex mergeMutex;           // For thread safety
   void ensureMergeInitialized();
 
 public:
   // Helper methods
-  std::string createMergeCommit(const std::string &message,
-                                const std::string &author,
-                                const std::string &currentCommit,
-                                const std::string &targetCommit);
+  ObjectId createMergeCommit(const std::string &message,
+                             const std::string &author,
+                             const ObjectId &currentCommit,
+                             const ObjectId &targetCommit);
   bool resolveConflicts();
 
 public:
   bool reportStatus(bool shortFormat = false, bool showUntracked = true);
   GitRepository(const std::string &root = ".git");
+  const std::string &getGitDir() const { return gitDir; }
   bool init(const std::string &path);
-  // For blob/tree:
-  std::string writeObject(GitObjectType type, const std::string &path,
-                          const bool &write);
+  // For blob/tree (null ID on failure):
+  ObjectId writeObject(GitObjectType type, const std::string &path,
+                       const bool &write);
 
   // For commit:
-  std::string writeObject(GitObjectType type, const CommitData &data);
+  ObjectId writeObject(GitObjectType type, const CommitData &data);
 
   // For tag:
-  std::string writeObject(GitObjectType type, const TagData &data);
-  std::string readObject(const GitObjectType type, const std::string &hash);
+  ObjectId writeObject(GitObjectType type, const TagData &data);
+  std::string readObject(const GitObjectType type, const ObjectId &id);
 
-  std::string readObjectRaw(const std::string &path);
-  void indexHandler(const std::vector<std::string> &paths = {"."});
+  // The whole object ("<type> <size>\0<body>") without copying it.
+  ObjectView readObjectRaw(const ObjectId &id);
+  // Type and size only (see GitObjectStorage::readObjectHeader).
+  bool readObjectHeader(const ObjectId &id, std::string &type, uint64_t &size);
+  // Streams an object's header and body (see GitObjectStorage::streamObject).
+  bool streamObjectRaw(const ObjectId &id,
+                       const GitObjectStorage::ObjectHeaderFn &onHeader,
+                       const ZlibSink &onBody);
+  // Stages paths ("." for the whole work tree). Untracked files matched by
+  // the ignore rules are skipped unless force is set.
+  void indexHandler(const std::vector<std::string> &paths = {"."},
+                    bool force = false);
 
   bool CreateBranch(const std::string &branchName);
   bool listbranches(const std::string &branchName);
@@ -52,27 +67,45 @@ public:
 
   bool changeCurrentBranch(const std::string &targetBranch, bool createflag);
 
-  std::string getHashOfBranchHead(const std::string &branchName);
+  // Null if the branch has no commits yet.
+  ObjectId getHashOfBranchHead(const std::string &branchName);
 
   bool deleteBranch(const std::string &branchName);
 
   bool renameBranch(const std::string &oldName, const std::string &newName);
   bool isFullyMerged(const std::string &branchName);
   bool createCommit(const std::string &message, const std::string &author);
-  std::unordered_set<std::string>
+  std::unordered_set<ObjectId>
   logBranchCommitHistory(const std::string &branchName);
-  std::string findCommonAncestor(const std::string &commitA,
-                                 const std::string &commitB);
-  bool gotoStateAtPerticularCommit(const std::string &hash);
+  // Commit for "HEAD", a branch name or a full hash; null if unknown.
+  ObjectId resolveRevision(const std::string &name);
+  // Best common ancestors of two commits, newest first (merge-base --all).
+  std::vector<ObjectId> findMergeBases(const ObjectId &commitA,
+                                       const ObjectId &commitB);
+  ObjectId findCommonAncestor(const ObjectId &commitA,
+                              const ObjectId &commitB);
+  // Print history like git log, streaming as the walk goes. Revisions are
+  // "A", "^A" (exclude) or "A..B"; HEAD if none names a starting commit.
+  // Non-empty paths limit the output to commits that changed them.
+  bool showLog(const std::vector<std::string> &revisions,
+               const std::vector<std::string> &paths,
+               const RevWalkOptions &options, bool oneline);
+  bool gotoStateAtPerticularCommit(const ObjectId &id);
   bool exportHeadAsZip(const std::string &branchName,
                        const std::string &outputZipPath);
+  // Hit/miss counters and memory use of the shared object cache.
+  ObjectCache::Stats objectCacheStats() const { return objectCache->stats(); }
+  // Pack all loose objects (mgit gc)
+  bool compressObjects();
+  // Extend the commit-graph chain with all branches' history.
+  bool writeCommitGraph();
 
   // Merge operations
   bool mergeBranch(const std::string &targetBranch);
   bool abortMerge();
   std::vector<std::string> getConflictingFiles();
   bool isConflicted(const std::string &path);
-  bool resolveConflict(const std::string &path, const std::string &hash);
+  bool resolveConflict(const std::string &path, const ObjectId &id);
   std::optional<ConflictMarker> getConflictMarker(const std::string &path);
   bool reportMergeConflicts(const std::string &targetBranch);
 
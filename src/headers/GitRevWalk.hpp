@@ -0,0 +1,126 @@
+#pragma once
+
+#include "GitMergeBase.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class RevSort {
+  Date, // newest commit time first (git log's default order)
+  Topo  // never show a parent before all of its children
+};
+
+struct RevWalkOptions {
+  RevSort sort = RevSort::Date;
+  bool firstParent = false; // follow only the first parent of merges
+  long maxCount = -1;       // stop after this many commits; -1 = no limit
+};
+
+// Incremental revision walker behind `mgit log`. Commits are produced one at
+// a time by next(), so the work done is proportional to what is consumed:
+// `log -n 20` loads a few dozen commits no matter how long the history is.
+// Commit data comes from the lookup (normally the commit-graph), so the walk
+// itself never inflates a commit object.
+//
+// Hidden commits (the A in A..B) are walked in a second queue ordered by
+// generation number. Before a commit is produced, every hidden commit of a
+// higher generation is expanded; anything that could reach it has then
+// marked it, so exclusion is exact without walking ahead. Topo order pops by
+// generation, which puts every child before its parents. Both need
+// generation numbers: commits missing from the commit-graph get theirs
+// computed from their parents (the whole history if there is no graph).
+class RevWalk {
+public:
+  // parent argument of ChangeCheck for a root commit (compare with nothing).
+  static const size_t kNoParent = static_cast<size_t>(-1);
+  // True if the paths of interest differ between a commit and its parent
+  // number `parent`.
+  using ChangeCheck = std::function<bool(
+      const ObjectId &id, const CommitInfo &info, size_t parent)>;
+
+  explicit RevWalk(CommitLookup lookup, RevWalkOptions options = {});
+
+  // Path-limited history, with git's default simplification: a commit that
+  // matches one of its parents for those paths is not shown, and only that
+  // parent is followed.
+  void limitToPaths(ChangeCheck check) { changed = std::move(check); }
+
+  // Start from this commit. False if it cannot be read.
+  bool push(const ObjectId &id);
+  // Leave out this commit and everything reachable from it.
+  bool hide(const ObjectId &id);
+  // The next commit in order; false when the walk is done.
+  bool next(ObjectId &id, CommitInfo &info);
+
+  // Commits loaded so far (for tests and benchmarks).
+  size_t loadedCount() const { return commits.size(); }
+
+private:
+  struct Node {
+    ObjectId id;
+    CommitInfo info;
+    uint8_t flags = 0;
+    uint64_t sequence = 0; // keeps the order stable among equal keys
+  };
+  struct ShowFirst {
+    RevSort sort;
+    bool operator()(const Node *a, const Node *b) const;
+  };
+  struct HigherGeneration {
+    bool operator()(const Node *a, const Node *b) const;
+  };
+
+  Node *load(const ObjectId &id);
+  void resolveGeneration(Node *node);
+  void hideAbove(uint32_t generation);
+
+  CommitLookup lookup;
+  RevWalkOptions options;
+  ChangeCheck changed;
+  std::unordered_map<ObjectId, std::unique_ptr<Node>> commits;
+  std::priority_queue<Node *, std::vector<Node *>, ShowFirst> pending;
+  std::priority_queue<Node *, std::vector<Node *>, HigherGeneration> hidden;
+  uint64_t nextSequence = 0;
+  long shown = 0;
+  bool hasHidden = false;
+};
+
+// ChangeCheck for `log -- <paths>`. First-parent questions are answered from
+// the commit-graph's changed-path Bloom filters when they rule every path
+// out; otherwise the entries at those paths are compared tree by tree, which
+// stops at the first directory whose ID is unchanged.
+class PathLimiter {
+public:
+  struct Stats {
+    uint64_t filterNo = 0;      // tree comparison skipped
+    uint64_t filterMaybe = 0;   // filter hit, trees compared
+    uint64_t falsePositive = 0; // ... and the paths were unchanged
+    uint64_t noFilter = 0;      // commit without a filter
+  };
+
+  // Paths are relative to the top of the work tree; "dir" covers everything
+  // below it. Filters are not used if commitGraph.readChangedPaths is false.
+  PathLimiter(const std::string &gitDir, const std::vector<std::string> &paths);
+
+  bool changed(const ObjectId &id, const CommitInfo &info, size_t parent);
+  const Stats &stats() const { return stats_; }
+
+private:
+  struct LimitPath {
+    std::vector<std::string> components;
+    std::vector<BloomKey> keys; // the path and each leading directory
+  };
+  bool filterRulesOut(const ObjectId &id);
+  bool sameEntry(const ObjectId &treeA, const ObjectId &treeB,
+                 const LimitPath &path);
+
+  std::string gitDir;
+  std::vector<LimitPath> paths;
+  std::shared_ptr<CommitGraph> graph; // null: no filters to consult
+  CommitInfoReader commits;
+  Stats stats_;
+};
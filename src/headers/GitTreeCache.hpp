@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectId.hpp"
+
+// File type of a tree entry, decoded once from its octal mode string.
+enum class TreeEntryMode : uint8_t {
+  Regular,    // 100644 (and legacy 100664)
+  Executable, // 100755
+  Symlink,    // 120000
+  Directory,  // 040000 / 40000
+  Submodule   // 160000
+};
+
+// Mode string as this repository writes it ("100644", "040000", ...).
+const char *treeEntryModeString(TreeEntryMode mode);
+
+// One entry of a parsed tree. The filename points into its tree's own copy
+// of the names, so a deep walk allocates nothing per entry and the names are
+// freed with the tree when the cache drops it.
+struct ParsedTreeEntry {
+  std::string_view name;
+  ObjectId id;
+  TreeEntryMode mode;
+
+  std::string_view filename() const { return name; }
+  bool isTree() const { return mode == TreeEntryMode::Directory; }
+};
+
+struct ParsedTree {
+  ParsedTree() = default;
+  // Entries refer into names; the tree stays where parse() built it.
+  ParsedTree(const ParsedTree &) = delete;
+  ParsedTree &operator=(const ParsedTree &) = delete;
+
+  std::vector<ParsedTreeEntry> entries;
+  std::unique_ptr<char[]> names;
+};
+
+// Parsed trees keyed by object ID, shared per git directory like
+// ObjectCache. Trees are immutable, so a parsed copy is reused for as long as
+// it stays within the entry budget (least recently used trees go first).
+class TreeCache {
+public:
+  using Tree = std::shared_ptr<const ParsedTree>;
+
+  static const size_t kDefaultEntryBudget = 1 << 20;
+
+  static std::shared_ptr<TreeCache> forGitDir(const std::string &gitDir);
+
+  // Parses "<type> <size>\0<body>" as returned by readObject. Returns null if
+  // the object has no header; a truncated entry ends the list.
+  static Tree parse(std::string_view object);
+
+  Tree get(const ObjectId &id);
+  void put(const ObjectId &id, Tree tree);
+
+private:
+  TreeCache() = default;
+  void evictLocked();
+
+  using Slot = std::pair<ObjectId, Tree>;
+  std::list<Slot> lru; // most recently used first
+  std::unordered_map<ObjectId, std::list<Slot>::iterator> index;
+  size_t entryBudget = kDefaultEntryBudget;
+  size_t entries = 0;
+  std::mutex mutex;
+};
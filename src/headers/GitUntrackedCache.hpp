@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ObjectId.hpp"
+
+// Untracked files of each working-tree directory, kept between status runs.
+// A directory's mtime changes whenever an entry is added, removed or renamed
+// in it, so while its stat data still matches, its untracked files and
+// subdirectories can be taken from the cache instead of reading it again;
+// each status then costs one stat per directory plus reads of the
+// directories that changed.
+//
+// Changing the index invalidates the directory of the changed path (a file
+// may have become tracked or untracked without the directory changing).
+// Ignored files and directories are left out, so each directory also records
+// the ID of the ignore rules it was filtered with (IgnoreStack::id()); when
+// an ignore file changes, the directories below it are read again.
+//
+// Stored in the index as a "UNTR" extension: a directory count, then per
+// directory its path, NUL, mtime, ctime, inode and device (8 bytes each),
+// a flags word (bit 0 = valid, bit 1 = has a .mgitignore), the raw ignore
+// rules ID, and NUL-terminated untracked file names and subdirectory names,
+// each list preceded by its length.
+class UntrackedCache {
+public:
+  struct DirStat {
+    int64_t mtimeNs = 0;
+    int64_t ctimeNs = 0;
+    uint64_t ino = 0;
+    uint64_t dev = 0;
+
+    bool operator==(const DirStat &other) const {
+      return mtimeNs == other.mtimeNs && ctimeNs == other.ctimeNs &&
+             ino == other.ino && dev == other.dev;
+    }
+  };
+
+  struct Dir {
+    DirStat stat;
+    bool valid = false;
+    bool hasIgnoreFile = false;
+    ObjectId ignoreId;
+    std::vector<std::string> untracked; // file names
+    std::vector<std::string> subdirs;   // directory names
+  };
+
+  // Directories keyed by relative path ("" for the root).
+  using DirMap = std::map<std::string, Dir, std::less<>>;
+
+  // Invalidates the directory that contains path.
+  void invalidate(std::string_view path);
+  void clear() { dirs.clear(); }
+  // Invalidates directories modified at or after mtimeNs, which might
+  // change again within the same timestamp tick unnoticed. Returns true if
+  // any was.
+  bool invalidateNewerThan(int64_t mtimeNs);
+
+  // The cached directory if it is valid and its stat data matches.
+  const Dir *lookup(const std::string &dir, const DirStat &stat) const;
+  // The cached directory if it is valid, whatever its stat data.
+  const Dir *find(const std::string &dir) const;
+  // Replaces the cache with the directories seen by a walk.
+  void replace(DirMap seen) { dirs = std::move(seen); }
+  size_t size() const { return dirs.size(); }
+
+  void serialize(std::string &out) const;
+  // Returns false (leaving the cache empty) if data is malformed.
+  bool parse(std::string_view data);
+
+private:
+  DirMap dirs;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "GitIgnore.hpp"
+#include "GitUntrackedCache.hpp"
+
+// Directory-parallel working-tree walker.
+//
+// Each worker owns a deque of directories still to be read. It pops work from
+// the back of its own deque (depth-first, cache friendly) and, when it runs
+// dry, steals from the front of another worker's deque, so one deep subtree
+// never leaves the other cores idle. Files found by each worker are collected
+// separately and merged and sorted at the end, so results do not depend on
+// thread scheduling.
+class WorkTreeScanner {
+public:
+  // threads = 0 uses one worker per hardware thread.
+  explicit WorkTreeScanner(const std::string &root = ".",
+                           unsigned threads = 0);
+
+  // Regular files below root as normalized relative paths ("dir/file"),
+  // sorted bytewise. .git and .mgit directories are not entered. With
+  // `ignore` (the repository's rules), ignored files are left out and
+  // ignored directories are not entered at all; .mgitignore files are
+  // picked up along the way.
+  std::vector<std::string>
+  listFiles(const IgnoreStack::Ptr &ignore = nullptr) const;
+
+  struct UntrackedStats {
+    size_t dirsChecked = 0; // directories stat'ed
+    size_t dirsRead = 0;    // of those, read because the cache was stale
+    bool changed = false;   // the cache needs saving
+  };
+  // Files below root for which isTracked() is false and that are not
+  // ignored, sorted like listFiles(). Directories whose stat data and ignore
+  // rules match `cache` are not read; the cache is updated with what the
+  // walk found. If given, cached directories for which dirMayHaveChanged()
+  // is false (per the fsmonitor) are not stat'ed either.
+  std::vector<std::string>
+  listUntracked(UntrackedCache &cache, const IgnoreStack::Ptr &ignore,
+                const std::function<bool(const std::string &)> &isTracked,
+                UntrackedStats &stats,
+                const std::function<bool(const std::string &)>
+                    &dirMayHaveChanged = nullptr) const;
+
+  // Calls fn(i) for every i in [0, count) across the worker threads. Each
+  // call should write only to its own output slot.
+  void parallelFor(size_t count, const std::function<void(size_t)> &fn) const;
+
+  unsigned getThreadCount() const { return threads; }
+
+private:
+  struct PendingDir {
+    std::string path;        // relative, "" for root
+    IgnoreStack::Ptr ignore; // rules in effect in its parent
+  };
+  // Called for each directory by one of the workers; pushes the
+  // subdirectories to visit next.
+  using DirVisitor = std::function<void(unsigned worker, const PendingDir &dir,
+                                        std::vector<PendingDir> &subdirs)>;
+  // Walks from the root, which starts with the `ignore` rules.
+  void walk(const IgnoreStack::Ptr &ignore, const DirVisitor &visit) const;
+
+  std::string root;
+  unsigned threads;
+};
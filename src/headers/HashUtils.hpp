@@ -1,4 +1,85 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <string>
 
+// Hex-encoded SHA-1 of data (40 lowercase characters).
 std::string hash_sha1(const std::string& data);
+// Raw 20-byte SHA-1 of data.
+std::string hash_sha1_raw(const std::string& data);
+
+// Block functions the SHA-1 context can run on. The best one supported by
+// the CPU is picked on first use.
+enum class Sha1Backend { Scalar, ShaNi };
+
+Sha1Backend sha1ActiveBackend();
+const char* sha1BackendName(Sha1Backend backend);
+// Switches the block function (used by benchmarks and tests). Returns false
+// and leaves the backend unchanged if the CPU lacks support for it.
+bool sha1SetBackend(Sha1Backend backend);
+
+// Collision detection (sha1dc-style): every block is checked for being half
+// of a SHAttered-style collision pair, and final() throws
+// Sha1CollisionException if one was. Off by default unless built with
+// MGIT_SHA1DC; core.sha1dc in the repository config overrides the default.
+// Contexts pick up the setting when they are init()ed.
+bool sha1CollisionDetection();
+void sha1SetCollisionDetection(bool enabled);
+
+// Collision-detection internals, exposed for tests: the disturbance-vector
+// table (in sha1dc's order), the unavoidable-condition filter that returns a
+// bitmask of DV indices, and the recompression check for one DV.
+namespace sha1dc {
+
+struct DisturbanceVectorInfo {
+    int type;
+    int k;
+    int b;
+    int testStep;
+    const uint32_t* dm; // 80 words
+};
+
+size_t disturbanceVectorCount();
+DisturbanceVectorInfo disturbanceVector(size_t n);
+uint32_t unavoidableConditionMask(const uint32_t W[80]);
+bool recompressionCollides(size_t n, const uint32_t W[80],
+                           const uint32_t ihvIn[5], const uint32_t ihvOut[5]);
+
+} // namespace sha1dc
+
+class Sha1CollisionException : public std::exception {
+public:
+    const char* what() const noexcept override {
+        return "SHA-1 appears to be part of a collision attack";
+    }
+};
+
+// Streaming SHA-1: init() / update()... / final(). Input never has to be
+// gathered into one buffer, so headers and file contents can be hashed
+// piecewise.
+class Sha1 {
+public:
+    static const size_t kDigestSize = 20;
+
+    Sha1() { init(); }
+
+    void init();
+    void update(const void* data, size_t size);
+    void update(const std::string& data) { update(data.data(), data.size()); }
+    // Writes the raw digest; the context must be init()ed again before reuse.
+    // Throws Sha1CollisionException when collision detection flagged a block.
+    void final(unsigned char digest[kDigestSize]);
+    std::string finalRaw();
+    std::string finalHex();
+
+private:
+    void compress(const unsigned char* data, size_t blocks);
+
+    uint32_t state[5];
+    uint64_t length;
+    unsigned char buffer[64];
+    size_t buffered;
+    bool detect;
+    bool collision;
+};
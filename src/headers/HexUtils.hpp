@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+// Kernels for hex conversion of object names and checksums. The widest one
+// supported by the CPU is picked on first use.
+enum class HexBackend { Scalar, Ssse3, Avx2 };
+
+HexBackend hexActiveBackend();
+const char* hexBackendName(HexBackend backend);
+// Switches kernels (used by benchmarks and tests). Returns false and leaves
+// the backend unchanged if the CPU lacks support for it.
+bool hexSetBackend(HexBackend backend);
+
+// Writes 2 * size lowercase hex digits for size bytes (no terminator).
+void hexEncode(const unsigned char* in, size_t size, char* out);
+// Reads 2 * size hex digits (either case) into size bytes. Returns false if
+// any character is not a hex digit; out is then partly written.
+bool hexDecode(const char* in, size_t size, unsigned char* out);
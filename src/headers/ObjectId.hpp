@@ -0,0 +1,134 @@
+#pragma once
+
+#include "HexUtils.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// SHA-1 object name as its raw 20 bytes. This is what storage, the index,
+// trees, commits and merges pass around; hex only appears where a name is
+// read from or shown to the user (and in text files such as refs).
+class ObjectId {
+public:
+  static const size_t kRawSize = 20;
+  static const size_t kHexSize = 40;
+
+  // The null ID (all zeros) stands for "no object".
+  constexpr ObjectId() : bytes{} {}
+
+  // Parses exactly 40 hex digits (either case). Leaves id alone on failure.
+  // At run time this goes through the vectorized hexDecode.
+  static constexpr bool parseHex(std::string_view hex, ObjectId &id) {
+    if (hex.size() != kHexSize) {
+      return false;
+    }
+    ObjectId parsed;
+    if (!__builtin_is_constant_evaluated()) {
+      if (!hexDecode(hex.data(), kRawSize, parsed.bytes)) {
+        return false;
+      }
+      id = parsed;
+      return true;
+    }
+    for (size_t i = 0; i < kRawSize; ++i) {
+      int high = hexValue(hex[2 * i]);
+      int low = hexValue(hex[2 * i + 1]);
+      if (high < 0 || low < 0) {
+        return false;
+      }
+      parsed.bytes[i] = static_cast<unsigned char>(high << 4 | low);
+    }
+    id = parsed;
+    return true;
+  }
+  // The parsed ID, or the null ID if hex is not a valid object name.
+  static constexpr ObjectId fromHex(std::string_view hex) {
+    ObjectId id;
+    parseHex(hex, id);
+    return id;
+  }
+  // Copies 20 raw bytes (as found in trees, packs and the index).
+  static ObjectId fromRaw(const void *raw) {
+    ObjectId id;
+    std::memcpy(id.bytes, raw, kRawSize);
+    return id;
+  }
+
+  constexpr bool isNull() const {
+    for (size_t i = 0; i < kRawSize; ++i) {
+      if (bytes[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  unsigned char *data() { return bytes; }
+  const unsigned char *data() const { return bytes; }
+
+  // Writes 40 lowercase hex digits (no terminator).
+  constexpr void toHex(char *out) const {
+    if (!__builtin_is_constant_evaluated()) {
+      hexEncode(bytes, kRawSize, out);
+      return;
+    }
+    const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < kRawSize; ++i) {
+      out[2 * i] = digits[bytes[i] >> 4];
+      out[2 * i + 1] = digits[bytes[i] & 0x0f];
+    }
+  }
+  std::string hex() const {
+    std::string out(kHexSize, '\0');
+    toHex(&out[0]);
+    return out;
+  }
+  std::string raw() const {
+    return std::string(reinterpret_cast<const char *>(bytes), kRawSize);
+  }
+
+  int compare(const ObjectId &other) const {
+    return std::memcmp(bytes, other.bytes, kRawSize);
+  }
+  bool operator==(const ObjectId &other) const { return compare(other) == 0; }
+  bool operator!=(const ObjectId &other) const { return compare(other) != 0; }
+  // Byte order, which is also hex order (pack indexes sort this way).
+  bool operator<(const ObjectId &other) const { return compare(other) < 0; }
+
+private:
+  static constexpr int hexValue(char c) {
+    return c >= '0' && c <= '9'   ? c - '0'
+           : c >= 'a' && c <= 'f' ? c - 'a' + 10
+           : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                  : -1;
+  }
+
+  unsigned char bytes[kRawSize];
+};
+
+static_assert(std::is_trivially_copyable<ObjectId>::value,
+              "ObjectId is copied as plain bytes");
+static_assert(sizeof(ObjectId) == ObjectId::kRawSize,
+              "ObjectId is exactly the raw digest");
+
+inline std::ostream &operator<<(std::ostream &out, const ObjectId &id) {
+  char hex[ObjectId::kHexSize];
+  id.toHex(hex);
+  return out.write(hex, sizeof(hex));
+}
+
+namespace std {
+// SHA-1 output is uniformly distributed: any 8 bytes are a good hash.
+template <> struct hash<ObjectId> {
+  size_t operator()(const ObjectId &id) const noexcept {
+    uint64_t value;
+    std::memcpy(&value, id.data(), sizeof(value));
+    return static_cast<size_t>(value);
+  }
+};
+} // namespace std
@@ -1,9 +1,78 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+struct z_stream_s;
+
+// Receives decompressed or compressed output piece by piece.
+using ZlibSink = std::function<void(const char* data, size_t size)>;
+
+// Inflates a whole zlib stream. If the output starts with an object header
+// ("<type> <size>\0") the result is sized from it up front; otherwise the
+// buffer grows as needed.
 std::string decompressZlib(const std::vector<char>& compressed);
-std::string compressZlib(const std::string& input);
+// Inflates a zlib stream whose decompressed size is known up front (packed
+// objects record it in their entry header). Trailing input is ignored.
+std::string decompressZlib(const unsigned char* data, size_t size,
+                           size_t expectedSize);
+// Inflates no more than the first maxOutput bytes of a zlib stream, e.g. to
+// read an object header without the body. Returns fewer bytes if the input
+// ends first.
+std::string inflatePrefix(const unsigned char* data, size_t size,
+                          size_t maxOutput);
+// level: -1 = zlib's default (6), 0 = store, 1 (fastest) .. 9 (smallest).
+// Built with MGIT_LIBDEFLATE, one-shot compression and size-known inflate
+// use libdeflate instead of zlib; the output is still a plain zlib stream.
+std::string compressZlib(const std::string& input, int level = -1);
+// Name of the one-shot compression backend ("zlib" or "libdeflate").
+const char* zlibBackendName();
+
+// Incremental deflate for inputs too large to hold in memory: feed data with
+// write() and end the stream with finish(). Compressed output is handed to
+// the sink whenever the internal buffer fills, so memory use is constant.
+class ZlibDeflater {
+public:
+    explicit ZlibDeflater(ZlibSink sink, int level = -1);
+    ~ZlibDeflater();
+    ZlibDeflater(const ZlibDeflater&) = delete;
+    ZlibDeflater& operator=(const ZlibDeflater&) = delete;
+
+    void write(const void* data, size_t size);
+    void finish();
+
+private:
+    void pump(int flush);
+
+    ZlibSink sink;
+    std::unique_ptr<z_stream_s> stream;
+    std::vector<char> buffer;
+    bool finished;
+};
+
+// Incremental inflate: feed compressed data with write() as it is read and
+// the decompressed bytes go to the sink in buffer-sized pieces, so large
+// objects never have to be held in memory.
+class ZlibInflater {
+public:
+    explicit ZlibInflater(ZlibSink sink);
+    ~ZlibInflater();
+    ZlibInflater(const ZlibInflater&) = delete;
+    ZlibInflater& operator=(const ZlibInflater&) = delete;
+
+    // Returns true once the end of the zlib stream has been reached; input
+    // after that is ignored. Throws on corrupt data.
+    bool write(const void* data, size_t size);
+    bool finished() const { return done; }
+
+private:
+    ZlibSink sink;
+    std::unique_ptr<z_stream_s> stream;
+    std::vector<char> buffer;
+    bool done;
+};
 std::string hash_sha1(const std::string& data);
 std::string getCurrentTimestampWithTimezone();
 std::string hexToBinary(const std::string& hex);
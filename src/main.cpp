@@ -1,7 +1,10 @@
 #include "headers/CLISetupAndHandlers.hpp"
 #include "headers/GitRepository.hpp"
 #include "headers/GitActivityLogger.hpp"
+#include "headers/GitConfig.hpp"
+#include "headers/HashUtils.hpp"
 #include <CLI/CLI.hpp>
+#include <cstdlib>
 #include <iostream>
 #include <exception>
 #include <vector>
@@ -43,12 +46,24 @@ int main(int argc, char** argv) {
             std::cerr << "Fatal error: Git directory does not exist: .git\n";
             return 1;
         }
+
+        // core.sha1dc overrides the build-time collision detection default.
+        std::string sha1dc;
+        if (std::filesystem::exists(".git/config") &&
+            GitConfig(".git").getConfig("core.sha1dc", sha1dc)) {
+            sha1SetCollisionDetection(sha1dc == "true" || sha1dc == "1");
+        }
         int exit_code = 0;
         std::string result = "Success";
         std::string error_msg = "";
         
         try {
-            app.parse(argc, argv);
+            std::vector<std::string> cliArgs = logCommandLine(argc, argv);
+            std::vector<const char*> cliArgv;
+            for (const auto& arg : cliArgs) {
+                cliArgv.push_back(arg.c_str());
+            }
+            app.parse(static_cast<int>(cliArgv.size()), cliArgv.data());
         } catch (const CLI::ParseError& e) {
             exit_code = app.exit(e);
             result = "CLI parse error";
@@ -60,6 +75,16 @@ int main(int argc, char** argv) {
             error_msg = e.what();
         }
         
+        // MGIT_TRACE_OBJECT_CACHE=1 reports how well the object cache did.
+        const char* traceCache = std::getenv("MGIT_TRACE_OBJECT_CACHE");
+        if (traceCache && *traceCache && std::string(traceCache) != "0") {
+            ObjectCache::Stats stats = repo.objectCacheStats();
+            std::cerr << "object cache: " << stats.hits << " hits, "
+                      << stats.misses << " misses, " << stats.evictions
+                      << " evictions, " << stats.entries << " objects / "
+                      << stats.bytes << " of " << stats.budget << " bytes\n";
+        }
+
         // Log the command end
         if (argc > 1) {
             logger.endCommand(result, exit_code, error_msg);
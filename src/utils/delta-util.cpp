@@ -0,0 +1,221 @@
+#include "../headers/DeltaUtils.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Source blocks are indexed every kBlock bytes; a match must cover at least
+// one full block to be worth a copy instruction.
+const size_t kBlock = 16;
+const size_t kMaxCopy = 0xffffff;
+const size_t kMaxInsert = 0x7f;
+const size_t kMaxBucket = 64;
+
+uint32_t blockHash(const unsigned char* p) {
+    // FNV-1a over one block; cheap and good enough to pick candidates.
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < kBlock; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void appendVarint(std::string& out, size_t value) {
+    do {
+        unsigned char c = value & 0x7f;
+        value >>= 7;
+        if (value)
+            c |= 0x80;
+        out.push_back(static_cast<char>(c));
+    } while (value);
+}
+
+size_t readVarint(const unsigned char*& p, const unsigned char* end) {
+    size_t value = 0;
+    int shift = 0;
+    unsigned char c;
+    do {
+        if (p >= end || shift > 63)
+            throw std::runtime_error("Corrupt delta header");
+        c = *p++;
+        value |= static_cast<size_t>(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return value;
+}
+
+void flushInsert(std::string& out, const unsigned char* data, size_t length) {
+    while (length) {
+        size_t chunk = length < kMaxInsert ? length : kMaxInsert;
+        out.push_back(static_cast<char>(chunk));
+        out.append(reinterpret_cast<const char*>(data), chunk);
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+void emitCopy(std::string& out, size_t offset, size_t length) {
+    while (length) {
+        size_t chunk = length < kMaxCopy ? length : kMaxCopy;
+        unsigned char op = 0x80;
+        char args[7];
+        int n = 0;
+        for (int i = 0; i < 4; ++i) {
+            unsigned char b = (offset >> (8 * i)) & 0xff;
+            if (b) {
+                op |= 1 << i;
+                args[n++] = static_cast<char>(b);
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            unsigned char b = (chunk >> (8 * i)) & 0xff;
+            if (b) {
+                op |= 1 << (4 + i);
+                args[n++] = static_cast<char>(b);
+            }
+        }
+        out.push_back(static_cast<char>(op));
+        out.append(args, n);
+        offset += chunk;
+        length -= chunk;
+    }
+}
+
+} // namespace
+
+DeltaIndex::DeltaIndex(std::string source) : source(std::move(source)) {
+    const std::string& data = this->source;
+    if (data.size() < kBlock || data.size() > 0xffffffffu)
+        return;
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(data.data());
+    blocks.reserve(data.size() / kBlock + 1);
+    for (size_t i = 0; i + kBlock <= data.size(); i += kBlock) {
+        auto& bucket = blocks[blockHash(src + i)];
+        if (bucket.size() < kMaxBucket)
+            bucket.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+std::string DeltaIndex::createDelta(const std::string& target,
+                                    size_t maxDeltaSize) const {
+    if (blocks.empty() || target.empty())
+        return "";
+
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(source.data());
+    const unsigned char* dst = reinterpret_cast<const unsigned char*>(target.data());
+    const size_t srcSize = source.size();
+    const size_t dstSize = target.size();
+
+    std::string out;
+    appendVarint(out, srcSize);
+    appendVarint(out, dstSize);
+
+    size_t insertStart = 0;
+    size_t pos = 0;
+    while (pos + kBlock <= dstSize) {
+        size_t bestLen = 0;
+        size_t bestSrc = 0;
+        auto it = blocks.find(blockHash(dst + pos));
+        if (it != blocks.end()) {
+            for (uint32_t candidate : it->second) {
+                size_t len = 0;
+                size_t maxLen = std::min(srcSize - candidate, dstSize - pos);
+                while (len < maxLen && src[candidate + len] == dst[pos + len])
+                    ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestSrc = candidate;
+                }
+            }
+        }
+        if (bestLen < kBlock) {
+            ++pos;
+            continue;
+        }
+        // Grow the match backwards into bytes still pending as literals.
+        while (pos > insertStart && bestSrc > 0 && src[bestSrc - 1] == dst[pos - 1]) {
+            --pos;
+            --bestSrc;
+            ++bestLen;
+        }
+        flushInsert(out, dst + insertStart, pos - insertStart);
+        emitCopy(out, bestSrc, bestLen);
+        pos += bestLen;
+        insertStart = pos;
+        if (maxDeltaSize && out.size() > maxDeltaSize)
+            return "";
+    }
+    flushInsert(out, dst + insertStart, dstSize - insertStart);
+
+    if (maxDeltaSize && out.size() > maxDeltaSize)
+        return "";
+    return out;
+}
+
+std::string createDelta(const std::string& source, const std::string& target,
+                        size_t maxDeltaSize) {
+    return DeltaIndex(source).createDelta(target, maxDeltaSize);
+}
+
+std::string applyDelta(const std::string& source, const char* delta,
+                       size_t deltaSize) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(delta);
+    const unsigned char* end = p + deltaSize;
+
+    size_t srcSize = readVarint(p, end);
+    size_t dstSize = readVarint(p, end);
+    if (srcSize != source.size())
+        throw std::runtime_error("Delta source size mismatch");
+
+    std::string out;
+    out.reserve(dstSize);
+    while (p < end) {
+        unsigned char op = *p++;
+        if (op & 0x80) {
+            size_t offset = 0;
+            size_t length = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (op & (1 << i)) {
+                    if (p >= end)
+                        throw std::runtime_error("Truncated delta copy");
+                    offset |= static_cast<size_t>(*p++) << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (op & (1 << (4 + i))) {
+                    if (p >= end)
+                        throw std::runtime_error("Truncated delta copy");
+                    length |= static_cast<size_t>(*p++) << (8 * i);
+                }
+            }
+            if (length == 0)
+                length = 0x10000;
+            if (offset + length > source.size() || out.size() + length > dstSize)
+                throw std::runtime_error("Delta copy out of range");
+            out.append(source, offset, length);
+        } else if (op) {
+            if (static_cast<size_t>(end - p) < op || out.size() + op > dstSize)
+                throw std::runtime_error("Delta insert out of range");
+            out.append(reinterpret_cast<const char*>(p), op);
+            p += op;
+        } else {
+            throw std::runtime_error("Invalid delta opcode");
+        }
+    }
+    if (out.size() != dstSize)
+        throw std::runtime_error("Delta result size mismatch");
+    return out;
+}
+
+size_t deltaTargetSize(const char* delta, size_t deltaSize) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(delta);
+    const unsigned char* end = p + deltaSize;
+    readVarint(p, end);
+    return readVarint(p, end);
+}
@@ -0,0 +1,274 @@
+#include "../headers/HexUtils.hpp"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MGIT_HEX_X86 1
+#endif
+
+namespace {
+
+using EncodeFn = void (*)(const unsigned char* in, size_t size, char* out);
+using DecodeFn = bool (*)(const char* in, size_t size, unsigned char* out);
+
+// Two digits per byte value, and the value of every character (-1 if it is
+// not a hex digit).
+struct HexTables {
+    char pairs[512];
+    signed char values[256];
+
+    constexpr HexTables() : pairs(), values() {
+        const char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i) {
+            pairs[2 * i] = digits[i >> 4];
+            pairs[2 * i + 1] = digits[i & 0x0f];
+            values[i] = -1;
+        }
+        for (int i = 0; i < 10; ++i)
+            values['0' + i] = static_cast<signed char>(i);
+        for (int i = 0; i < 6; ++i) {
+            values['a' + i] = static_cast<signed char>(10 + i);
+            values['A' + i] = static_cast<signed char>(10 + i);
+        }
+    }
+};
+
+constexpr HexTables kTables;
+
+void encodeScalar(const unsigned char* in, size_t size, char* out) {
+    for (size_t i = 0; i < size; ++i)
+        std::memcpy(out + 2 * i, kTables.pairs + 2 * in[i], 2);
+}
+
+// Invalid digits are collected in the sign bit so the loop has no branches.
+bool decodeScalar(const char* in, size_t size, unsigned char* out) {
+    int invalid = 0;
+    for (size_t i = 0; i < size; ++i) {
+        int high = kTables.values[static_cast<unsigned char>(in[2 * i])];
+        int low = kTables.values[static_cast<unsigned char>(in[2 * i + 1])];
+        invalid |= high | low;
+        out[i] = static_cast<unsigned char>((high & 0x0f) << 4 | (low & 0x0f));
+    }
+    return invalid >= 0;
+}
+
+#ifdef MGIT_HEX_X86
+
+// 16 bytes per step: split into nibbles and look each one up with pshufb.
+__attribute__((target("ssse3"))) void
+encodeSsse3(const unsigned char* in, size_t size, char* out) {
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6',
+                                         '7', '8', '9', 'a', 'b', 'c', 'd',
+                                         'e', 'f');
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; size >= 16; size -= 16, in += 16, out += 32) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i high = _mm_shuffle_epi8(
+            digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                         _mm_unpackhi_epi8(high, low));
+    }
+    encodeScalar(in, size, out);
+}
+
+// Nibble values of 16 characters; lanes that are not hex digits are cleared
+// in valid. '0'-'9' and (after folding case) 'a'-'f' are range checks done
+// as unsigned min compares.
+__attribute__((target("ssse3"))) inline __m128i
+nibblesSsse3(__m128i chars, __m128i& valid) {
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                                  _mm_set1_epi8('a'));
+    __m128i isDigit =
+        _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter =
+        _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(
+        _mm_and_si128(isDigit, digit),
+        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// 32 characters per step; pmaddubsw joins each pair as high * 16 + low.
+__attribute__((target("ssse3"))) bool
+decodeSsse3(const char* in, size_t size, unsigned char* out) {
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    __m128i valid = _mm_set1_epi8(-1);
+    for (; size >= 16; size -= 16, in += 32, out += 16) {
+        __m128i first = nibblesSsse3(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), valid);
+        __m128i second = nibblesSsse3(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16)), valid);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                                          _mm_maddubs_epi16(second, weights)));
+    }
+    bool tail = decodeScalar(in, size, out);
+    return tail && _mm_movemask_epi8(valid) == 0xffff;
+}
+
+// The same with 32 bytes per step. pshufb and the unpack/pack instructions
+// work within 128-bit lanes, so lanes are put back in order afterwards.
+__attribute__((target("avx2"))) void
+encodeAvx2(const unsigned char* in, size_t size, char* out) {
+    const __m256i digits = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd',
+        'e', 'f', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b',
+        'c', 'd', 'e', 'f');
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; size >= 32; size -= 32, in += 32, out += 64) {
+        __m256i bytes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        __m256i high = _mm256_shuffle_epi8(
+            digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        __m256i low =
+            _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, nibble));
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    encodeSsse3(in, size, out);
+}
+
+__attribute__((target("avx2"))) inline __m256i nibblesAvx2(__m256i chars,
+                                                           __m256i& valid) {
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(
+        _mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i isLetter =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+    valid = _mm256_and_si256(valid, _mm256_or_si256(isDigit, isLetter));
+    return _mm256_or_si256(
+        _mm256_and_si256(isDigit, digit),
+        _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2"))) bool
+decodeAvx2(const char* in, size_t size, unsigned char* out) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    __m256i valid = _mm256_set1_epi8(-1);
+    for (; size >= 32; size -= 32, in += 64, out += 32) {
+        __m256i first = nibblesAvx2(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)), valid);
+        __m256i second = nibblesAvx2(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 32)),
+            valid);
+        __m256i packed =
+            _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights),
+                                _mm256_maddubs_epi16(second, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                            _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    bool tail = decodeSsse3(in, size, out);
+    return tail && _mm256_movemask_epi8(valid) == -1;
+}
+
+#endif // MGIT_HEX_X86
+
+bool backendSupported(HexBackend backend) {
+    switch (backend) {
+    case HexBackend::Scalar:
+        return true;
+    case HexBackend::Ssse3:
+#ifdef MGIT_HEX_X86
+        return __builtin_cpu_supports("ssse3");
+#else
+        return false;
+#endif
+    case HexBackend::Avx2:
+#ifdef MGIT_HEX_X86
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+EncodeFn encodeFnFor(HexBackend backend) {
+#ifdef MGIT_HEX_X86
+    if (backend == HexBackend::Avx2)
+        return encodeAvx2;
+    if (backend == HexBackend::Ssse3)
+        return encodeSsse3;
+#endif
+    (void)backend;
+    return encodeScalar;
+}
+
+DecodeFn decodeFnFor(HexBackend backend) {
+#ifdef MGIT_HEX_X86
+    if (backend == HexBackend::Avx2)
+        return decodeAvx2;
+    if (backend == HexBackend::Ssse3)
+        return decodeSsse3;
+#endif
+    (void)backend;
+    return decodeScalar;
+}
+
+HexBackend detectBackend() {
+    if (backendSupported(HexBackend::Avx2))
+        return HexBackend::Avx2;
+    return backendSupported(HexBackend::Ssse3) ? HexBackend::Ssse3
+                                               : HexBackend::Scalar;
+}
+
+std::atomic<HexBackend>& activeBackend() {
+    static std::atomic<HexBackend> backend{detectBackend()};
+    return backend;
+}
+
+std::atomic<EncodeFn>& activeEncodeFn() {
+    static std::atomic<EncodeFn> fn{encodeFnFor(activeBackend().load())};
+    return fn;
+}
+
+std::atomic<DecodeFn>& activeDecodeFn() {
+    static std::atomic<DecodeFn> fn{decodeFnFor(activeBackend().load())};
+    return fn;
+}
+
+} // namespace
+
+HexBackend hexActiveBackend() {
+    return activeBackend().load();
+}
+
+const char* hexBackendName(HexBackend backend) {
+    switch (backend) {
+    case HexBackend::Scalar:
+        return "table";
+    case HexBackend::Ssse3:
+        return "ssse3";
+    case HexBackend::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+bool hexSetBackend(HexBackend backend) {
+    if (!backendSupported(backend))
+        return false;
+    activeBackend().store(backend);
+    activeEncodeFn().store(encodeFnFor(backend));
+    activeDecodeFn().store(decodeFnFor(backend));
+    return true;
+}
+
+void hexEncode(const unsigned char* in, size_t size, char* out) {
+    activeEncodeFn().load(std::memory_order_relaxed)(in, size, out);
+}
+
+bool hexDecode(const char* in, size_t size, unsigned char* out) {
+    return activeDecodeFn().load(std::memory_order_relaxed)(in, size, out);
+}
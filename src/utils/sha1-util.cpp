@@ -0,0 +1,1279 @@
+#include "../headers/HashUtils.hpp"
+#include "../headers/HexUtils.hpp"
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define MGIT_SHA1_X86 1
+#endif
+
+namespace {
+
+using BlockFn = void (*)(uint32_t state[5], const unsigned char* data,
+                         size_t blocks);
+
+inline uint32_t rol(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline uint32_t loadBE32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// Portable compression function. The message schedule is kept in a 16-word
+// ring and each round range has its own loop, so there are no per-round
+// branches on the round number.
+void sha1BlocksScalar(uint32_t state[5], const unsigned char* data,
+                      size_t blocks) {
+    while (blocks--) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; ++i)
+            w[i] = loadBE32(data + i * 4);
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+                 e = state[4];
+        auto schedule = [&w](int i) {
+            uint32_t v = rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^
+                             w[(i + 2) & 15] ^ w[i & 15], 1);
+            w[i & 15] = v;
+            return v;
+        };
+        auto step = [&](uint32_t f, uint32_t k, uint32_t wi) {
+            uint32_t t = rol(a, 5) + f + e + k + wi;
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        };
+
+        for (int i = 0; i < 16; ++i)
+            step(d ^ (b & (c ^ d)), 0x5A827999, w[i]);
+        for (int i = 16; i < 20; ++i)
+            step(d ^ (b & (c ^ d)), 0x5A827999, schedule(i));
+        for (int i = 20; i < 40; ++i)
+            step(b ^ c ^ d, 0x6ED9EBA1, schedule(i));
+        for (int i = 40; i < 60; ++i)
+            step((b & c) | (d & (b | c)), 0x8F1BBCDC, schedule(i));
+        for (int i = 60; i < 80; ++i)
+            step(b ^ c ^ d, 0xCA62C1D6, schedule(i));
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+}
+
+inline uint32_t roundF(int i, uint32_t b, uint32_t c, uint32_t d) {
+    if (i < 20)
+        return d ^ (b & (c ^ d));
+    if (i < 40 || i >= 60)
+        return b ^ c ^ d;
+    return (b & c) | (d & (b | c));
+}
+
+inline uint32_t roundK(int i) {
+    static const uint32_t k[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC,
+                                  0xCA62C1D6};
+    return k[i / 20];
+}
+
+// Compresses one block like sha1BlocksScalar but also hands back the
+// expanded message W[0..79], which the collision check works on.
+void sha1BlockScalarCapture(uint32_t state[5], const unsigned char* data,
+                            uint32_t W[80]) {
+    // The schedule runs in a local ring as in sha1BlocksScalar; W is only
+    // written, since reading back just-stored words stalls store forwarding.
+    uint32_t w[16];
+    for (int i = 0; i < 16; ++i)
+        W[i] = w[i] = loadBE32(data + i * 4);
+    auto schedule = [&](int i) {
+        uint32_t v = rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^
+                         w[(i + 2) & 15] ^ w[i & 15], 1);
+        w[i & 15] = v;
+        W[i] = v;
+        return v;
+    };
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+             e = state[4];
+    auto step = [&](uint32_t f, uint32_t k, uint32_t wi) {
+        uint32_t t = rol(a, 5) + f + e + k + wi;
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    };
+
+    for (int i = 0; i < 16; ++i)
+        step(d ^ (b & (c ^ d)), 0x5A827999, w[i]);
+    for (int i = 16; i < 20; ++i)
+        step(d ^ (b & (c ^ d)), 0x5A827999, schedule(i));
+    for (int i = 20; i < 40; ++i)
+        step(b ^ c ^ d, 0x6ED9EBA1, schedule(i));
+    for (int i = 40; i < 60; ++i)
+        step((b & c) | (d & (b | c)), 0x8F1BBCDC, schedule(i));
+    for (int i = 60; i < 80; ++i)
+        step(b ^ c ^ d, 0xCA62C1D6, schedule(i));
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+#ifdef MGIT_SHA1_X86
+
+bool cpuHasShaNi() {
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    const bool ssse3 = ecx & (1u << 9);
+    const bool sse41 = ecx & (1u << 19);
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return false;
+    const bool sha = ebx & (1u << 29);
+    return ssse3 && sse41 && sha;
+}
+
+// One group of four rounds using the SHA extensions. Even groups take their
+// E input from e0 and park ABCD in e1; odd groups do the reverse. The
+// message schedule for later groups is advanced in the same step. When
+// capturing, the group's four finished message words are stored first (lane
+// 3 holds the lowest-numbered word, hence the shuffle).
+#define MGIT_SHA1_NI_GROUP(i)                                                  \
+    do {                                                                       \
+        if (Capture) {                                                         \
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(W + 4 * (i)),          \
+                             _mm_shuffle_epi32(msg[(i) & 3], 0x1B));           \
+        }                                                                      \
+        __m128i& eIn = ((i) & 1) ? e1 : e0;                                    \
+        __m128i& eOut = ((i) & 1) ? e0 : e1;                                   \
+        if ((i) == 0)                                                          \
+            eIn = _mm_add_epi32(eIn, msg[0]);                                  \
+        else                                                                   \
+            eIn = _mm_sha1nexte_epu32(eIn, msg[(i) & 3]);                      \
+        eOut = abcd;                                                           \
+        if ((i) >= 3 && (i) <= 18)                                             \
+            msg[((i) + 1) & 3] = _mm_sha1msg2_epu32(msg[((i) + 1) & 3],        \
+                                                    msg[(i) & 3]);             \
+        abcd = _mm_sha1rnds4_epu32(abcd, eIn, (i) / 5);                        \
+        if ((i) >= 1 && (i) <= 16)                                             \
+            msg[((i) + 3) & 3] = _mm_sha1msg1_epu32(msg[((i) + 3) & 3],        \
+                                                    msg[(i) & 3]);             \
+        if ((i) >= 2 && (i) <= 17)                                             \
+            msg[((i) + 2) & 3] = _mm_xor_si128(msg[((i) + 2) & 3],             \
+                                               msg[(i) & 3]);                  \
+    } while (0)
+
+template <bool Capture>
+__attribute__((target("sha,sse4.1,ssse3"))) inline void
+sha1BlocksShaNiImpl(uint32_t state[5], const unsigned char* data,
+                    size_t blocks, uint32_t* W) {
+    const __m128i byteSwap =
+        _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    abcd = _mm_shuffle_epi32(abcd, 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+    __m128i e1 = _mm_setzero_si128();
+
+    while (blocks--) {
+        const __m128i abcdSave = abcd;
+        const __m128i e0Save = e0;
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)),
+                byteSwap);
+        }
+
+        MGIT_SHA1_NI_GROUP(0);  MGIT_SHA1_NI_GROUP(1);
+        MGIT_SHA1_NI_GROUP(2);  MGIT_SHA1_NI_GROUP(3);
+        MGIT_SHA1_NI_GROUP(4);  MGIT_SHA1_NI_GROUP(5);
+        MGIT_SHA1_NI_GROUP(6);  MGIT_SHA1_NI_GROUP(7);
+        MGIT_SHA1_NI_GROUP(8);  MGIT_SHA1_NI_GROUP(9);
+        MGIT_SHA1_NI_GROUP(10); MGIT_SHA1_NI_GROUP(11);
+        MGIT_SHA1_NI_GROUP(12); MGIT_SHA1_NI_GROUP(13);
+        MGIT_SHA1_NI_GROUP(14); MGIT_SHA1_NI_GROUP(15);
+        MGIT_SHA1_NI_GROUP(16); MGIT_SHA1_NI_GROUP(17);
+        MGIT_SHA1_NI_GROUP(18); MGIT_SHA1_NI_GROUP(19);
+
+        // Group 19 left the ABCD from before it in e0.
+        e0 = _mm_sha1nexte_epu32(e0, e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+        data += 64;
+    }
+
+    abcd = _mm_shuffle_epi32(abcd, 0x1B);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+#undef MGIT_SHA1_NI_GROUP
+
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha1BlocksShaNi(uint32_t state[5], const unsigned char* data, size_t blocks) {
+    sha1BlocksShaNiImpl<false>(state, data, blocks, nullptr);
+}
+
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha1BlockShaNiCapture(uint32_t state[5], const unsigned char* data,
+                      uint32_t W[80]) {
+    sha1BlocksShaNiImpl<true>(state, data, 1, W);
+}
+
+#endif // MGIT_SHA1_X86
+
+bool backendSupported(Sha1Backend backend) {
+    switch (backend) {
+    case Sha1Backend::Scalar:
+        return true;
+    case Sha1Backend::ShaNi:
+#ifdef MGIT_SHA1_X86
+    {
+        static const bool supported = cpuHasShaNi();
+        return supported;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+BlockFn blockFnFor(Sha1Backend backend) {
+#ifdef MGIT_SHA1_X86
+    if (backend == Sha1Backend::ShaNi)
+        return sha1BlocksShaNi;
+#endif
+    (void)backend;
+    return sha1BlocksScalar;
+}
+
+Sha1Backend detectBackend() {
+    return backendSupported(Sha1Backend::ShaNi) ? Sha1Backend::ShaNi
+                                                : Sha1Backend::Scalar;
+}
+
+std::atomic<Sha1Backend>& activeBackend() {
+    static std::atomic<Sha1Backend> backend{detectBackend()};
+    return backend;
+}
+
+std::atomic<BlockFn>& activeBlockFn() {
+    static std::atomic<BlockFn> fn{blockFnFor(activeBackend().load())};
+    return fn;
+}
+
+inline void processBlocks(uint32_t state[5], const unsigned char* data,
+                          size_t blocks) {
+    activeBlockFn().load(std::memory_order_relaxed)(state, data, blocks);
+}
+
+// ---------------------------------------------------------------------------
+// Collision detection (counter-cryptanalysis, after Stevens and Shumow's
+// sha1dc). Every known practical SHA-1 collision attack, SHAttered included,
+// builds its near-collision blocks around one of a small set of disturbance
+// vectors (DVs). For each DV we know the message difference dm it implies and
+// a step after which the two blocks' internal states must coincide. Given one
+// block, we can therefore recompute the "other" block of a would-be collision
+// pair backwards and forwards from that step; if the two produce the same
+// output, the input is one half of a collision.
+//
+// Recomputing 32 DVs per block would cost ~33 compressions, so each DV is
+// first filtered by unavoidable bit conditions on the expanded message (the
+// ubc_check of sha1dc): relations between message bits that every attack on
+// the DV must satisfy. Random input passes a DV's checked conditions with
+// probability 2^-8 or less, so full recompression almost never runs.
+// ---------------------------------------------------------------------------
+
+using CaptureFn = void (*)(uint32_t state[5], const unsigned char* data,
+                           uint32_t W[80]);
+
+inline uint32_t ror(uint32_t value, int bits) {
+    return rol(value, (32 - bits) & 31);
+}
+
+// A DV's message difference dm is the expansion of a single-bit disturbance
+// (two more for type II) at words K..K+15, with the five corrections that
+// make each disturbance a local collision. Both blocks of a pair reach the
+// same state before testStep: 58 where the DV is quiet in steps 53-57,
+// otherwise 65. Layout and entries follow sha1dc's sha1_dvs table; the
+// SHAttered blocks differ by exactly the II(52, 0) row.
+struct DisturbanceVector {
+    int type;
+    int k;
+    int b;
+    int testStep;
+    uint32_t dm[80];
+};
+
+constexpr uint32_t kDvI43_0 = 1u << 0;
+constexpr uint32_t kDvI44_0 = 1u << 1;
+constexpr uint32_t kDvI45_0 = 1u << 2;
+constexpr uint32_t kDvI46_0 = 1u << 3;
+constexpr uint32_t kDvI46_2 = 1u << 4;
+constexpr uint32_t kDvI47_0 = 1u << 5;
+constexpr uint32_t kDvI47_2 = 1u << 6;
+constexpr uint32_t kDvI48_0 = 1u << 7;
+constexpr uint32_t kDvI48_2 = 1u << 8;
+constexpr uint32_t kDvI49_0 = 1u << 9;
+constexpr uint32_t kDvI49_2 = 1u << 10;
+constexpr uint32_t kDvI50_0 = 1u << 11;
+constexpr uint32_t kDvI50_2 = 1u << 12;
+constexpr uint32_t kDvI51_0 = 1u << 13;
+constexpr uint32_t kDvI51_2 = 1u << 14;
+constexpr uint32_t kDvI52_0 = 1u << 15;
+constexpr uint32_t kDvII45_0 = 1u << 16;
+constexpr uint32_t kDvII46_0 = 1u << 17;
+constexpr uint32_t kDvII46_2 = 1u << 18;
+constexpr uint32_t kDvII47_0 = 1u << 19;
+constexpr uint32_t kDvII48_0 = 1u << 20;
+constexpr uint32_t kDvII49_0 = 1u << 21;
+constexpr uint32_t kDvII49_2 = 1u << 22;
+constexpr uint32_t kDvII50_0 = 1u << 23;
+constexpr uint32_t kDvII50_2 = 1u << 24;
+constexpr uint32_t kDvII51_0 = 1u << 25;
+constexpr uint32_t kDvII51_2 = 1u << 26;
+constexpr uint32_t kDvII52_0 = 1u << 27;
+constexpr uint32_t kDvII53_0 = 1u << 28;
+constexpr uint32_t kDvII54_0 = 1u << 29;
+constexpr uint32_t kDvII55_0 = 1u << 30;
+constexpr uint32_t kDvII56_0 = 1u << 31;
+
+const DisturbanceVector kDisturbanceVectors[] = {
+    {1, 43, 0, 58,
+     {0x08000000, 0x9800000c, 0xd8000010, 0x08000010, 0xb8000010, 0x98000000,
+      0x60000000, 0x00000008, 0xc0000000, 0x90000014, 0x10000010, 0xb8000014,
+      0x28000000, 0x20000010, 0x48000000, 0x08000018, 0x60000000, 0x90000010,
+      0xf0000010, 0x90000008, 0xc0000000, 0x90000010, 0xf0000010, 0xb0000008,
+      0x40000000, 0x90000000, 0xf0000010, 0x90000018, 0x60000000, 0x90000010,
+      0x90000010, 0x90000000, 0x80000000, 0x00000010, 0xa0000000, 0x20000000,
+      0xa0000000, 0x20000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010,
+      0x20000000, 0x00000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020,
+      0x00000001, 0x40000002, 0x40000040, 0x40000002, 0x80000004, 0x80000080,
+      0x80000006, 0x00000049, 0x00000103, 0x80000009, 0x80000012, 0x80000202,
+      0x00000018, 0x00000164, 0x00000408, 0x800000e6, 0x8000004c, 0x00000803,
+      0x80000161, 0x80000599}},
+    {1, 44, 0, 58,
+     {0xb4000008, 0x08000000, 0x9800000c, 0xd8000010, 0x08000010, 0xb8000010,
+      0x98000000, 0x60000000, 0x00000008, 0xc0000000, 0x90000014, 0x10000010,
+      0xb8000014, 0x28000000, 0x20000010, 0x48000000, 0x08000018, 0x60000000,
+      0x90000010, 0xf0000010, 0x90000008, 0xc0000000, 0x90000010, 0xf0000010,
+      0xb0000008, 0x40000000, 0x90000000, 0xf0000010, 0x90000018, 0x60000000,
+      0x90000010, 0x90000010, 0x90000000, 0x80000000, 0x00000010, 0xa0000000,
+      0x20000000, 0xa0000000, 0x20000010, 0x00000000, 0x20000010, 0x20000000,
+      0x00000010, 0x20000000, 0x00000010, 0xa0000000, 0x00000000, 0x20000000,
+      0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+      0x00000020, 0x00000001, 0x40000002, 0x40000040, 0x40000002, 0x80000004,
+      0x80000080, 0x80000006, 0x00000049, 0x00000103, 0x80000009, 0x80000012,
+      0x80000202, 0x00000018, 0x00000164, 0x00000408, 0x800000e6, 0x8000004c,
+      0x00000803, 0x80000161}},
+    {1, 45, 0, 58,
+     {0xf4000014, 0xb4000008, 0x08000000, 0x9800000c, 0xd8000010, 0x08000010,
+      0xb8000010, 0x98000000, 0x60000000, 0x00000008, 0xc0000000, 0x90000014,
+      0x10000010, 0xb8000014, 0x28000000, 0x20000010, 0x48000000, 0x08000018,
+      0x60000000, 0x90000010, 0xf0000010, 0x90000008, 0xc0000000, 0x90000010,
+      0xf0000010, 0xb0000008, 0x40000000, 0x90000000, 0xf0000010, 0x90000018,
+      0x60000000, 0x90000010, 0x90000010, 0x90000000, 0x80000000, 0x00000010,
+      0xa0000000, 0x20000000, 0xa0000000, 0x20000010, 0x00000000, 0x20000010,
+      0x20000000, 0x00000010, 0x20000000, 0x00000010, 0xa0000000, 0x00000000,
+      0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000040, 0x40000002,
+      0x80000004, 0x80000080, 0x80000006, 0x00000049, 0x00000103, 0x80000009,
+      0x80000012, 0x80000202, 0x00000018, 0x00000164, 0x00000408, 0x800000e6,
+      0x8000004c, 0x00000803}},
+    {1, 46, 0, 58,
+     {0x2c000010, 0xf4000014, 0xb4000008, 0x08000000, 0x9800000c, 0xd8000010,
+      0x08000010, 0xb8000010, 0x98000000, 0x60000000, 0x00000008, 0xc0000000,
+      0x90000014, 0x10000010, 0xb8000014, 0x28000000, 0x20000010, 0x48000000,
+      0x08000018, 0x60000000, 0x90000010, 0xf0000010, 0x90000008, 0xc0000000,
+      0x90000010, 0xf0000010, 0xb0000008, 0x40000000, 0x90000000, 0xf0000010,
+      0x90000018, 0x60000000, 0x90000010, 0x90000010, 0x90000000, 0x80000000,
+      0x00000010, 0xa0000000, 0x20000000, 0xa0000000, 0x20000010, 0x00000000,
+      0x20000010, 0x20000000, 0x00000010, 0x20000000, 0x00000010, 0xa0000000,
+      0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000040,
+      0x40000002, 0x80000004, 0x80000080, 0x80000006, 0x00000049, 0x00000103,
+      0x80000009, 0x80000012, 0x80000202, 0x00000018, 0x00000164, 0x00000408,
+      0x800000e6, 0x8000004c}},
+    {1, 46, 2, 58,
+     {0xb0000040, 0xd0000053, 0xd0000022, 0x20000000, 0x60000032, 0x60000043,
+      0x20000040, 0xe0000042, 0x60000002, 0x80000001, 0x00000020, 0x00000003,
+      0x40000052, 0x40000040, 0xe0000052, 0xa0000000, 0x80000040, 0x20000001,
+      0x20000060, 0x80000001, 0x40000042, 0xc0000043, 0x40000022, 0x00000003,
+      0x40000042, 0xc0000043, 0xc0000022, 0x00000001, 0x40000002, 0xc0000043,
+      0x40000062, 0x80000001, 0x40000042, 0x40000042, 0x40000002, 0x00000002,
+      0x00000040, 0x80000002, 0x80000000, 0x80000002, 0x80000040, 0x00000000,
+      0x80000040, 0x80000000, 0x00000040, 0x80000000, 0x00000040, 0x80000002,
+      0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000004, 0x00000080, 0x00000004, 0x00000009, 0x00000101,
+      0x00000009, 0x00000012, 0x00000202, 0x0000001a, 0x00000124, 0x0000040c,
+      0x00000026, 0x0000004a, 0x0000080a, 0x00000060, 0x00000590, 0x00001020,
+      0x0000039a, 0x00000132}},
+    {1, 47, 0, 58,
+     {0xc8000010, 0x2c000010, 0xf4000014, 0xb4000008, 0x08000000, 0x9800000c,
+      0xd8000010, 0x08000010, 0xb8000010, 0x98000000, 0x60000000, 0x00000008,
+      0xc0000000, 0x90000014, 0x10000010, 0xb8000014, 0x28000000, 0x20000010,
+      0x48000000, 0x08000018, 0x60000000, 0x90000010, 0xf0000010, 0x90000008,
+      0xc0000000, 0x90000010, 0xf0000010, 0xb0000008, 0x40000000, 0x90000000,
+      0xf0000010, 0x90000018, 0x60000000, 0x90000010, 0x90000010, 0x90000000,
+      0x80000000, 0x00000010, 0xa0000000, 0x20000000, 0xa0000000, 0x20000010,
+      0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x20000000, 0x00000010,
+      0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002,
+      0x40000040, 0x40000002, 0x80000004, 0x80000080, 0x80000006, 0x00000049,
+      0x00000103, 0x80000009, 0x80000012, 0x80000202, 0x00000018, 0x00000164,
+      0x00000408, 0x800000e6}},
+    {1, 47, 2, 58,
+     {0x20000043, 0xb0000040, 0xd0000053, 0xd0000022, 0x20000000, 0x60000032,
+      0x60000043, 0x20000040, 0xe0000042, 0x60000002, 0x80000001, 0x00000020,
+      0x00000003, 0x40000052, 0x40000040, 0xe0000052, 0xa0000000, 0x80000040,
+      0x20000001, 0x20000060, 0x80000001, 0x40000042, 0xc0000043, 0x40000022,
+      0x00000003, 0x40000042, 0xc0000043, 0xc0000022, 0x00000001, 0x40000002,
+      0xc0000043, 0x40000062, 0x80000001, 0x40000042, 0x40000042, 0x40000002,
+      0x00000002, 0x00000040, 0x80000002, 0x80000000, 0x80000002, 0x80000040,
+      0x00000000, 0x80000040, 0x80000000, 0x00000040, 0x80000000, 0x00000040,
+      0x80000002, 0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000004, 0x00000080, 0x00000004, 0x00000009,
+      0x00000101, 0x00000009, 0x00000012, 0x00000202, 0x0000001a, 0x00000124,
+      0x0000040c, 0x00000026, 0x0000004a, 0x0000080a, 0x00000060, 0x00000590,
+      0x00001020, 0x0000039a}},
+    {1, 48, 0, 58,
+     {0xb800000a, 0xc8000010, 0x2c000010, 0xf4000014, 0xb4000008, 0x08000000,
+      0x9800000c, 0xd8000010, 0x08000010, 0xb8000010, 0x98000000, 0x60000000,
+      0x00000008, 0xc0000000, 0x90000014, 0x10000010, 0xb8000014, 0x28000000,
+      0x20000010, 0x48000000, 0x08000018, 0x60000000, 0x90000010, 0xf0000010,
+      0x90000008, 0xc0000000, 0x90000010, 0xf0000010, 0xb0000008, 0x40000000,
+      0x90000000, 0xf0000010, 0x90000018, 0x60000000, 0x90000010, 0x90000010,
+      0x90000000, 0x80000000, 0x00000010, 0xa0000000, 0x20000000, 0xa0000000,
+      0x20000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x20000000,
+      0x00000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001,
+      0x40000002, 0x40000040, 0x40000002, 0x80000004, 0x80000080, 0x80000006,
+      0x00000049, 0x00000103, 0x80000009, 0x80000012, 0x80000202, 0x00000018,
+      0x00000164, 0x00000408}},
+    {1, 48, 2, 58,
+     {0xe000002a, 0x20000043, 0xb0000040, 0xd0000053, 0xd0000022, 0x20000000,
+      0x60000032, 0x60000043, 0x20000040, 0xe0000042, 0x60000002, 0x80000001,
+      0x00000020, 0x00000003, 0x40000052, 0x40000040, 0xe0000052, 0xa0000000,
+      0x80000040, 0x20000001, 0x20000060, 0x80000001, 0x40000042, 0xc0000043,
+      0x40000022, 0x00000003, 0x40000042, 0xc0000043, 0xc0000022, 0x00000001,
+      0x40000002, 0xc0000043, 0x40000062, 0x80000001, 0x40000042, 0x40000042,
+      0x40000002, 0x00000002, 0x00000040, 0x80000002, 0x80000000, 0x80000002,
+      0x80000040, 0x00000000, 0x80000040, 0x80000000, 0x00000040, 0x80000000,
+      0x00000040, 0x80000002, 0x00000000, 0x80000000, 0x80000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000004, 0x00000080, 0x00000004,
+      0x00000009, 0x00000101, 0x00000009, 0x00000012, 0x00000202, 0x0000001a,
+      0x00000124, 0x0000040c, 0x00000026, 0x0000004a, 0x0000080a, 0x00000060,
+      0x00000590, 0x00001020}},
+    {1, 49, 0, 58,
+     {0x18000000, 0xb800000a, 0xc8000010, 0x2c000010, 0xf4000014, 0xb4000008,
+      0x08000000, 0x9800000c, 0xd8000010, 0x08000010, 0xb8000010, 0x98000000,
+      0x60000000, 0x00000008, 0xc0000000, 0x90000014, 0x10000010, 0xb8000014,
+      0x28000000, 0x20000010, 0x48000000, 0x08000018, 0x60000000, 0x90000010,
+      0xf0000010, 0x90000008, 0xc0000000, 0x90000010, 0xf0000010, 0xb0000008,
+      0x40000000, 0x90000000, 0xf0000010, 0x90000018, 0x60000000, 0x90000010,
+      0x90000010, 0x90000000, 0x80000000, 0x00000010, 0xa0000000, 0x20000000,
+      0xa0000000, 0x20000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010,
+      0x20000000, 0x00000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020,
+      0x00000001, 0x40000002, 0x40000040, 0x40000002, 0x80000004, 0x80000080,
+      0x80000006, 0x00000049, 0x00000103, 0x80000009, 0x80000012, 0x80000202,
+      0x00000018, 0x00000164}},
+    {1, 49, 2, 58,
+     {0x60000000, 0xe000002a, 0x20000043, 0xb0000040, 0xd0000053, 0xd0000022,
+      0x20000000, 0x60000032, 0x60000043, 0x20000040, 0xe0000042, 0x60000002,
+      0x80000001, 0x00000020, 0x00000003, 0x40000052, 0x40000040, 0xe0000052,
+      0xa0000000, 0x80000040, 0x20000001, 0x20000060, 0x80000001, 0x40000042,
+      0xc0000043, 0x40000022, 0x00000003, 0x40000042, 0xc0000043, 0xc0000022,
+      0x00000001, 0x40000002, 0xc0000043, 0x40000062, 0x80000001, 0x40000042,
+      0x40000042, 0x40000002, 0x00000002, 0x00000040, 0x80000002, 0x80000000,
+      0x80000002, 0x80000040, 0x00000000, 0x80000040, 0x80000000, 0x00000040,
+      0x80000000, 0x00000040, 0x80000002, 0x00000000, 0x80000000, 0x80000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004, 0x00000080,
+      0x00000004, 0x00000009, 0x00000101, 0x00000009, 0x00000012, 0x00000202,
+      0x0000001a, 0x00000124, 0x0000040c, 0x00000026, 0x0000004a, 0x0000080a,
+      0x00000060, 0x00000590}},
+    {1, 50, 0, 58,
+     {0x0800000c, 0x18000000, 0xb800000a, 0xc8000010, 0x2c000010, 0xf4000014,
+      0xb4000008, 0x08000000, 0x9800000c, 0xd8000010, 0x08000010, 0xb8000010,
+      0x98000000, 0x60000000, 0x00000008, 0xc0000000, 0x90000014, 0x10000010,
+      0xb8000014, 0x28000000, 0x20000010, 0x48000000, 0x08000018, 0x60000000,
+      0x90000010, 0xf0000010, 0x90000008, 0xc0000000, 0x90000010, 0xf0000010,
+      0xb0000008, 0x40000000, 0x90000000, 0xf0000010, 0x90000018, 0x60000000,
+      0x90000010, 0x90000010, 0x90000000, 0x80000000, 0x00000010, 0xa0000000,
+      0x20000000, 0xa0000000, 0x20000010, 0x00000000, 0x20000010, 0x20000000,
+      0x00000010, 0x20000000, 0x00000010, 0xa0000000, 0x00000000, 0x20000000,
+      0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+      0x00000020, 0x00000001, 0x40000002, 0x40000040, 0x40000002, 0x80000004,
+      0x80000080, 0x80000006, 0x00000049, 0x00000103, 0x80000009, 0x80000012,
+      0x80000202, 0x00000018}},
+    {1, 50, 2, 58,
+     {0x20000030, 0x60000000, 0xe000002a, 0x20000043, 0xb0000040, 0xd0000053,
+      0xd0000022, 0x20000000, 0x60000032, 0x60000043, 0x20000040, 0xe0000042,
+      0x60000002, 0x80000001, 0x00000020, 0x00000003, 0x40000052, 0x40000040,
+      0xe0000052, 0xa0000000, 0x80000040, 0x20000001, 0x20000060, 0x80000001,
+      0x40000042, 0xc0000043, 0x40000022, 0x00000003, 0x40000042, 0xc0000043,
+      0xc0000022, 0x00000001, 0x40000002, 0xc0000043, 0x40000062, 0x80000001,
+      0x40000042, 0x40000042, 0x40000002, 0x00000002, 0x00000040, 0x80000002,
+      0x80000000, 0x80000002, 0x80000040, 0x00000000, 0x80000040, 0x80000000,
+      0x00000040, 0x80000000, 0x00000040, 0x80000002, 0x00000000, 0x80000000,
+      0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004,
+      0x00000080, 0x00000004, 0x00000009, 0x00000101, 0x00000009, 0x00000012,
+      0x00000202, 0x0000001a, 0x00000124, 0x0000040c, 0x00000026, 0x0000004a,
+      0x0000080a, 0x00000060}},
+    {1, 51, 0, 58,
+     {0xe8000000, 0x0800000c, 0x18000000, 0xb800000a, 0xc8000010, 0x2c000010,
+      0xf4000014, 0xb4000008, 0x08000000, 0x9800000c, 0xd8000010, 0x08000010,
+      0xb8000010, 0x98000000, 0x60000000, 0x00000008, 0xc0000000, 0x90000014,
+      0x10000010, 0xb8000014, 0x28000000, 0x20000010, 0x48000000, 0x08000018,
+      0x60000000, 0x90000010, 0xf0000010, 0x90000008, 0xc0000000, 0x90000010,
+      0xf0000010, 0xb0000008, 0x40000000, 0x90000000, 0xf0000010, 0x90000018,
+      0x60000000, 0x90000010, 0x90000010, 0x90000000, 0x80000000, 0x00000010,
+      0xa0000000, 0x20000000, 0xa0000000, 0x20000010, 0x00000000, 0x20000010,
+      0x20000000, 0x00000010, 0x20000000, 0x00000010, 0xa0000000, 0x00000000,
+      0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000040, 0x40000002,
+      0x80000004, 0x80000080, 0x80000006, 0x00000049, 0x00000103, 0x80000009,
+      0x80000012, 0x80000202}},
+    {1, 51, 2, 58,
+     {0xa0000003, 0x20000030, 0x60000000, 0xe000002a, 0x20000043, 0xb0000040,
+      0xd0000053, 0xd0000022, 0x20000000, 0x60000032, 0x60000043, 0x20000040,
+      0xe0000042, 0x60000002, 0x80000001, 0x00000020, 0x00000003, 0x40000052,
+      0x40000040, 0xe0000052, 0xa0000000, 0x80000040, 0x20000001, 0x20000060,
+      0x80000001, 0x40000042, 0xc0000043, 0x40000022, 0x00000003, 0x40000042,
+      0xc0000043, 0xc0000022, 0x00000001, 0x40000002, 0xc0000043, 0x40000062,
+      0x80000001, 0x40000042, 0x40000042, 0x40000002, 0x00000002, 0x00000040,
+      0x80000002, 0x80000000, 0x80000002, 0x80000040, 0x00000000, 0x80000040,
+      0x80000000, 0x00000040, 0x80000000, 0x00000040, 0x80000002, 0x00000000,
+      0x80000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000004, 0x00000080, 0x00000004, 0x00000009, 0x00000101, 0x00000009,
+      0x00000012, 0x00000202, 0x0000001a, 0x00000124, 0x0000040c, 0x00000026,
+      0x0000004a, 0x0000080a}},
+    {1, 52, 0, 58,
+     {0x04000010, 0xe8000000, 0x0800000c, 0x18000000, 0xb800000a, 0xc8000010,
+      0x2c000010, 0xf4000014, 0xb4000008, 0x08000000, 0x9800000c, 0xd8000010,
+      0x08000010, 0xb8000010, 0x98000000, 0x60000000, 0x00000008, 0xc0000000,
+      0x90000014, 0x10000010, 0xb8000014, 0x28000000, 0x20000010, 0x48000000,
+      0x08000018, 0x60000000, 0x90000010, 0xf0000010, 0x90000008, 0xc0000000,
+      0x90000010, 0xf0000010, 0xb0000008, 0x40000000, 0x90000000, 0xf0000010,
+      0x90000018, 0x60000000, 0x90000010, 0x90000010, 0x90000000, 0x80000000,
+      0x00000010, 0xa0000000, 0x20000000, 0xa0000000, 0x20000010, 0x00000000,
+      0x20000010, 0x20000000, 0x00000010, 0x20000000, 0x00000010, 0xa0000000,
+      0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000040,
+      0x40000002, 0x80000004, 0x80000080, 0x80000006, 0x00000049, 0x00000103,
+      0x80000009, 0x80000012}},
+    {2, 45, 0, 58,
+     {0xec000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018,
+      0xb0000010, 0x0000000c, 0xb8000010, 0x08000018, 0x78000010, 0x08000014,
+      0x70000010, 0xb800001c, 0xe8000000, 0xb0000004, 0x58000010, 0xb000000c,
+      0x48000000, 0xb0000000, 0xb8000010, 0x98000010, 0xa0000000, 0x00000000,
+      0x00000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010,
+      0x20000000, 0x00000010, 0x60000000, 0x00000018, 0xe0000000, 0x90000000,
+      0x30000010, 0xb0000000, 0x20000000, 0x20000000, 0xa0000000, 0x00000010,
+      0x80000000, 0x20000000, 0x20000000, 0x20000000, 0x80000000, 0x00000010,
+      0x00000000, 0x20000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000041, 0x40000022,
+      0x80000005, 0xc0000082, 0xc0000046, 0x4000004b, 0x80000107, 0x00000089,
+      0x00000014, 0x8000024b, 0x0000011b, 0x8000016d, 0x8000041a, 0x000002e4,
+      0x80000054, 0x00000967}},
+    {2, 46, 0, 58,
+     {0x2400001c, 0xec000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004,
+      0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010, 0x08000018, 0x78000010,
+      0x08000014, 0x70000010, 0xb800001c, 0xe8000000, 0xb0000004, 0x58000010,
+      0xb000000c, 0x48000000, 0xb0000000, 0xb8000010, 0x98000010, 0xa0000000,
+      0x00000000, 0x00000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+      0x20000010, 0x20000000, 0x00000010, 0x60000000, 0x00000018, 0xe0000000,
+      0x90000000, 0x30000010, 0xb0000000, 0x20000000, 0x20000000, 0xa0000000,
+      0x00000010, 0x80000000, 0x20000000, 0x20000000, 0x20000000, 0x80000000,
+      0x00000010, 0x00000000, 0x20000010, 0xa0000000, 0x00000000, 0x20000000,
+      0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000041,
+      0x40000022, 0x80000005, 0xc0000082, 0xc0000046, 0x4000004b, 0x80000107,
+      0x00000089, 0x00000014, 0x8000024b, 0x0000011b, 0x8000016d, 0x8000041a,
+      0x000002e4, 0x80000054}},
+    {2, 46, 2, 58,
+     {0x90000070, 0xb0000053, 0x30000008, 0x00000043, 0xd0000072, 0xb0000010,
+      0xf0000062, 0xc0000042, 0x00000030, 0xe0000042, 0x20000060, 0xe0000041,
+      0x20000050, 0xc0000041, 0xe0000072, 0xa0000003, 0xc0000012, 0x60000041,
+      0xc0000032, 0x20000001, 0xc0000002, 0xe0000042, 0x60000042, 0x80000002,
+      0x00000000, 0x00000000, 0x80000000, 0x00000002, 0x00000040, 0x00000000,
+      0x80000040, 0x80000000, 0x00000040, 0x80000001, 0x00000060, 0x80000003,
+      0x40000002, 0xc0000040, 0xc0000002, 0x80000000, 0x80000000, 0x80000002,
+      0x00000040, 0x00000002, 0x80000000, 0x80000000, 0x80000000, 0x00000002,
+      0x00000040, 0x00000000, 0x80000040, 0x80000002, 0x00000000, 0x80000000,
+      0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000004, 0x00000080, 0x00000004, 0x00000009, 0x00000105,
+      0x00000089, 0x00000016, 0x0000020b, 0x0000011b, 0x0000012d, 0x0000041e,
+      0x00000224, 0x00000050, 0x0000092e, 0x0000046c, 0x000005b6, 0x0000106a,
+      0x00000b90, 0x00000152}},
+    {2, 47, 0, 58,
+     {0x20000010, 0x2400001c, 0xec000014, 0x0c000002, 0xc0000010, 0xb400001c,
+      0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010, 0x08000018,
+      0x78000010, 0x08000014, 0x70000010, 0xb800001c, 0xe8000000, 0xb0000004,
+      0x58000010, 0xb000000c, 0x48000000, 0xb0000000, 0xb8000010, 0x98000010,
+      0xa0000000, 0x00000000, 0x00000000, 0x20000000, 0x80000000, 0x00000010,
+      0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x60000000, 0x00000018,
+      0xe0000000, 0x90000000, 0x30000010, 0xb0000000, 0x20000000, 0x20000000,
+      0xa0000000, 0x00000010, 0x80000000, 0x20000000, 0x20000000, 0x20000000,
+      0x80000000, 0x00000010, 0x00000000, 0x20000010, 0xa0000000, 0x00000000,
+      0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002,
+      0x40000041, 0x40000022, 0x80000005, 0xc0000082, 0xc0000046, 0x4000004b,
+      0x80000107, 0x00000089, 0x00000014, 0x8000024b, 0x0000011b, 0x8000016d,
+      0x8000041a, 0x000002e4}},
+    {2, 48, 0, 58,
+     {0xbc00001a, 0x20000010, 0x2400001c, 0xec000014, 0x0c000002, 0xc0000010,
+      0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010,
+      0x08000018, 0x78000010, 0x08000014, 0x70000010, 0xb800001c, 0xe8000000,
+      0xb0000004, 0x58000010, 0xb000000c, 0x48000000, 0xb0000000, 0xb8000010,
+      0x98000010, 0xa0000000, 0x00000000, 0x00000000, 0x20000000, 0x80000000,
+      0x00000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x60000000,
+      0x00000018, 0xe0000000, 0x90000000, 0x30000010, 0xb0000000, 0x20000000,
+      0x20000000, 0xa0000000, 0x00000010, 0x80000000, 0x20000000, 0x20000000,
+      0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0xa0000000,
+      0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001,
+      0x40000002, 0x40000041, 0x40000022, 0x80000005, 0xc0000082, 0xc0000046,
+      0x4000004b, 0x80000107, 0x00000089, 0x00000014, 0x8000024b, 0x0000011b,
+      0x8000016d, 0x8000041a}},
+    {2, 49, 0, 58,
+     {0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c, 0xec000014, 0x0c000002,
+      0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c,
+      0xb8000010, 0x08000018, 0x78000010, 0x08000014, 0x70000010, 0xb800001c,
+      0xe8000000, 0xb0000004, 0x58000010, 0xb000000c, 0x48000000, 0xb0000000,
+      0xb8000010, 0x98000010, 0xa0000000, 0x00000000, 0x00000000, 0x20000000,
+      0x80000000, 0x00000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010,
+      0x60000000, 0x00000018, 0xe0000000, 0x90000000, 0x30000010, 0xb0000000,
+      0x20000000, 0x20000000, 0xa0000000, 0x00000010, 0x80000000, 0x20000000,
+      0x20000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010,
+      0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020,
+      0x00000001, 0x40000002, 0x40000041, 0x40000022, 0x80000005, 0xc0000082,
+      0xc0000046, 0x4000004b, 0x80000107, 0x00000089, 0x00000014, 0x8000024b,
+      0x0000011b, 0x8000016d}},
+    {2, 49, 2, 58,
+     {0xf0000010, 0xf000006a, 0x80000040, 0x90000070, 0xb0000053, 0x30000008,
+      0x00000043, 0xd0000072, 0xb0000010, 0xf0000062, 0xc0000042, 0x00000030,
+      0xe0000042, 0x20000060, 0xe0000041, 0x20000050, 0xc0000041, 0xe0000072,
+      0xa0000003, 0xc0000012, 0x60000041, 0xc0000032, 0x20000001, 0xc0000002,
+      0xe0000042, 0x60000042, 0x80000002, 0x00000000, 0x00000000, 0x80000000,
+      0x00000002, 0x00000040, 0x00000000, 0x80000040, 0x80000000, 0x00000040,
+      0x80000001, 0x00000060, 0x80000003, 0x40000002, 0xc0000040, 0xc0000002,
+      0x80000000, 0x80000000, 0x80000002, 0x00000040, 0x00000002, 0x80000000,
+      0x80000000, 0x80000000, 0x00000002, 0x00000040, 0x00000000, 0x80000040,
+      0x80000002, 0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004, 0x00000080,
+      0x00000004, 0x00000009, 0x00000105, 0x00000089, 0x00000016, 0x0000020b,
+      0x0000011b, 0x0000012d, 0x0000041e, 0x00000224, 0x00000050, 0x0000092e,
+      0x0000046c, 0x000005b6}},
+    {2, 50, 0, 65,
+     {0xb400001c, 0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c, 0xec000014,
+      0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010,
+      0x0000000c, 0xb8000010, 0x08000018, 0x78000010, 0x08000014, 0x70000010,
+      0xb800001c, 0xe8000000, 0xb0000004, 0x58000010, 0xb000000c, 0x48000000,
+      0xb0000000, 0xb8000010, 0x98000010, 0xa0000000, 0x00000000, 0x00000000,
+      0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0x20000000,
+      0x00000010, 0x60000000, 0x00000018, 0xe0000000, 0x90000000, 0x30000010,
+      0xb0000000, 0x20000000, 0x20000000, 0xa0000000, 0x00000010, 0x80000000,
+      0x20000000, 0x20000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+      0x20000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+      0x00000020, 0x00000001, 0x40000002, 0x40000041, 0x40000022, 0x80000005,
+      0xc0000082, 0xc0000046, 0x4000004b, 0x80000107, 0x00000089, 0x00000014,
+      0x8000024b, 0x0000011b}},
+    {2, 50, 2, 65,
+     {0xd0000072, 0xf0000010, 0xf000006a, 0x80000040, 0x90000070, 0xb0000053,
+      0x30000008, 0x00000043, 0xd0000072, 0xb0000010, 0xf0000062, 0xc0000042,
+      0x00000030, 0xe0000042, 0x20000060, 0xe0000041, 0x20000050, 0xc0000041,
+      0xe0000072, 0xa0000003, 0xc0000012, 0x60000041, 0xc0000032, 0x20000001,
+      0xc0000002, 0xe0000042, 0x60000042, 0x80000002, 0x00000000, 0x00000000,
+      0x80000000, 0x00000002, 0x00000040, 0x00000000, 0x80000040, 0x80000000,
+      0x00000040, 0x80000001, 0x00000060, 0x80000003, 0x40000002, 0xc0000040,
+      0xc0000002, 0x80000000, 0x80000000, 0x80000002, 0x00000040, 0x00000002,
+      0x80000000, 0x80000000, 0x80000000, 0x00000002, 0x00000040, 0x00000000,
+      0x80000040, 0x80000002, 0x00000000, 0x80000000, 0x80000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004,
+      0x00000080, 0x00000004, 0x00000009, 0x00000105, 0x00000089, 0x00000016,
+      0x0000020b, 0x0000011b, 0x0000012d, 0x0000041e, 0x00000224, 0x00000050,
+      0x0000092e, 0x0000046c}},
+    {2, 51, 0, 65,
+     {0xc0000010, 0xb400001c, 0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c,
+      0xec000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018,
+      0xb0000010, 0x0000000c, 0xb8000010, 0x08000018, 0x78000010, 0x08000014,
+      0x70000010, 0xb800001c, 0xe8000000, 0xb0000004, 0x58000010, 0xb000000c,
+      0x48000000, 0xb0000000, 0xb8000010, 0x98000010, 0xa0000000, 0x00000000,
+      0x00000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010,
+      0x20000000, 0x00000010, 0x60000000, 0x00000018, 0xe0000000, 0x90000000,
+      0x30000010, 0xb0000000, 0x20000000, 0x20000000, 0xa0000000, 0x00000010,
+      0x80000000, 0x20000000, 0x20000000, 0x20000000, 0x80000000, 0x00000010,
+      0x00000000, 0x20000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000041, 0x40000022,
+      0x80000005, 0xc0000082, 0xc0000046, 0x4000004b, 0x80000107, 0x00000089,
+      0x00000014, 0x8000024b}},
+    {2, 51, 2, 65,
+     {0x00000043, 0xd0000072, 0xf0000010, 0xf000006a, 0x80000040, 0x90000070,
+      0xb0000053, 0x30000008, 0x00000043, 0xd0000072, 0xb0000010, 0xf0000062,
+      0xc0000042, 0x00000030, 0xe0000042, 0x20000060, 0xe0000041, 0x20000050,
+      0xc0000041, 0xe0000072, 0xa0000003, 0xc0000012, 0x60000041, 0xc0000032,
+      0x20000001, 0xc0000002, 0xe0000042, 0x60000042, 0x80000002, 0x00000000,
+      0x00000000, 0x80000000, 0x00000002, 0x00000040, 0x00000000, 0x80000040,
+      0x80000000, 0x00000040, 0x80000001, 0x00000060, 0x80000003, 0x40000002,
+      0xc0000040, 0xc0000002, 0x80000000, 0x80000000, 0x80000002, 0x00000040,
+      0x00000002, 0x80000000, 0x80000000, 0x80000000, 0x00000002, 0x00000040,
+      0x00000000, 0x80000040, 0x80000002, 0x00000000, 0x80000000, 0x80000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000004, 0x00000080, 0x00000004, 0x00000009, 0x00000105, 0x00000089,
+      0x00000016, 0x0000020b, 0x0000011b, 0x0000012d, 0x0000041e, 0x00000224,
+      0x00000050, 0x0000092e}},
+    {2, 52, 0, 65,
+     {0x0c000002, 0xc0000010, 0xb400001c, 0x3c000004, 0xbc00001a, 0x20000010,
+      0x2400001c, 0xec000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004,
+      0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010, 0x08000018, 0x78000010,
+      0x08000014, 0x70000010, 0xb800001c, 0xe8000000, 0xb0000004, 0x58000010,
+      0xb000000c, 0x48000000, 0xb0000000, 0xb8000010, 0x98000010, 0xa0000000,
+      0x00000000, 0x00000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+      0x20000010, 0x20000000, 0x00000010, 0x60000000, 0x00000018, 0xe0000000,
+      0x90000000, 0x30000010, 0xb0000000, 0x20000000, 0x20000000, 0xa0000000,
+      0x00000010, 0x80000000, 0x20000000, 0x20000000, 0x20000000, 0x80000000,
+      0x00000010, 0x00000000, 0x20000010, 0xa0000000, 0x00000000, 0x20000000,
+      0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000041,
+      0x40000022, 0x80000005, 0xc0000082, 0xc0000046, 0x4000004b, 0x80000107,
+      0x00000089, 0x00000014}},
+    {2, 53, 0, 65,
+     {0xcc000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x3c000004, 0xbc00001a,
+      0x20000010, 0x2400001c, 0xec000014, 0x0c000002, 0xc0000010, 0xb400001c,
+      0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010, 0x08000018,
+      0x78000010, 0x08000014, 0x70000010, 0xb800001c, 0xe8000000, 0xb0000004,
+      0x58000010, 0xb000000c, 0x48000000, 0xb0000000, 0xb8000010, 0x98000010,
+      0xa0000000, 0x00000000, 0x00000000, 0x20000000, 0x80000000, 0x00000010,
+      0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x60000000, 0x00000018,
+      0xe0000000, 0x90000000, 0x30000010, 0xb0000000, 0x20000000, 0x20000000,
+      0xa0000000, 0x00000010, 0x80000000, 0x20000000, 0x20000000, 0x20000000,
+      0x80000000, 0x00000010, 0x00000000, 0x20000010, 0xa0000000, 0x00000000,
+      0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002,
+      0x40000041, 0x40000022, 0x80000005, 0xc0000082, 0xc0000046, 0x4000004b,
+      0x80000107, 0x00000089}},
+    {2, 54, 0, 65,
+     {0x0400001c, 0xcc000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x3c000004,
+      0xbc00001a, 0x20000010, 0x2400001c, 0xec000014, 0x0c000002, 0xc0000010,
+      0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010,
+      0x08000018, 0x78000010, 0x08000014, 0x70000010, 0xb800001c, 0xe8000000,
+      0xb0000004, 0x58000010, 0xb000000c, 0x48000000, 0xb0000000, 0xb8000010,
+      0x98000010, 0xa0000000, 0x00000000, 0x00000000, 0x20000000, 0x80000000,
+      0x00000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x60000000,
+      0x00000018, 0xe0000000, 0x90000000, 0x30000010, 0xb0000000, 0x20000000,
+      0x20000000, 0xa0000000, 0x00000010, 0x80000000, 0x20000000, 0x20000000,
+      0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0xa0000000,
+      0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001,
+      0x40000002, 0x40000041, 0x40000022, 0x80000005, 0xc0000082, 0xc0000046,
+      0x4000004b, 0x80000107}},
+    {2, 55, 0, 65,
+     {0x00000010, 0x0400001c, 0xcc000014, 0x0c000002, 0xc0000010, 0xb400001c,
+      0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c, 0xec000014, 0x0c000002,
+      0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c,
+      0xb8000010, 0x08000018, 0x78000010, 0x08000014, 0x70000010, 0xb800001c,
+      0xe8000000, 0xb0000004, 0x58000010, 0xb000000c, 0x48000000, 0xb0000000,
+      0xb8000010, 0x98000010, 0xa0000000, 0x00000000, 0x00000000, 0x20000000,
+      0x80000000, 0x00000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010,
+      0x60000000, 0x00000018, 0xe0000000, 0x90000000, 0x30000010, 0xb0000000,
+      0x20000000, 0x20000000, 0xa0000000, 0x00000010, 0x80000000, 0x20000000,
+      0x20000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010,
+      0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020,
+      0x00000001, 0x40000002, 0x40000041, 0x40000022, 0x80000005, 0xc0000082,
+      0xc0000046, 0x4000004b}},
+    {2, 56, 0, 65,
+     {0x2600001a, 0x00000010, 0x0400001c, 0xcc000014, 0x0c000002, 0xc0000010,
+      0xb400001c, 0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c, 0xec000014,
+      0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010,
+      0x0000000c, 0xb8000010, 0x08000018, 0x78000010, 0x08000014, 0x70000010,
+      0xb800001c, 0xe8000000, 0xb0000004, 0x58000010, 0xb000000c, 0x48000000,
+      0xb0000000, 0xb8000010, 0x98000010, 0xa0000000, 0x00000000, 0x00000000,
+      0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0x20000000,
+      0x00000010, 0x60000000, 0x00000018, 0xe0000000, 0x90000000, 0x30000010,
+      0xb0000000, 0x20000000, 0x20000000, 0xa0000000, 0x00000010, 0x80000000,
+      0x20000000, 0x20000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+      0x20000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+      0x00000020, 0x00000001, 0x40000002, 0x40000041, 0x40000022, 0x80000005,
+      0xc0000082, 0xc0000046}},
+};
+
+// Unavoidable bit conditions. A local collision only cancels if every
+// correction has the opposite sign to the disturbance it corrects, and the
+// sign of a message difference is the value of the message bit it flips.
+// That ties bits of W together: a disturbance at bit b of W[t] differs from
+// its corrections at bit b + 5 of W[t + 1] and b + 30 of W[t + 5] (they go
+// through the adder unchanged), and in rounds 40-59, where the majority
+// function passes a difference on with its sign, from those at W[t + 2..4]
+// too. The sign of a bit-31 disturbance is free, but its corrections still
+// share one sign, so their bits are equal. Only local collisions that end
+// inside the block count; the last steps of an attack block need not follow
+// the DV, and SHAttered's second block breaks the rule at step 77.
+//
+// Each DV's conditions recur one step later in the DV after it, so they are
+// checked four consecutive steps at a time: a window relates bit `bit` of
+// W[step + lane] to bit `otherBit` of W[step + offset + lane] and lists, per
+// lane, the DVs the condition belongs to. The 24 windows were picked
+// greedily, each ruling out the most DVs still standing, and leave about
+// 0.02 DVs per random block for recompression.
+struct UbcWindow {
+    int step;
+    int offset;
+    int bit;
+    int otherBit;
+    bool equal; // the bits must be equal (else they must differ)
+    uint32_t vectors[4];
+};
+
+constexpr UbcWindow kUbcWindows[] = {
+    {71, 1, 3, 8, false,
+     {kDvI47_0 | kDvI48_2 | kDvII47_0 | kDvII49_2,
+      kDvI43_0 | kDvI48_0 | kDvI49_2 | kDvII48_0 | kDvII49_2 | kDvII50_2,
+      kDvI44_0 | kDvI49_0 | kDvI50_2 | kDvII45_0 | kDvII49_0 | kDvII50_2 |
+       kDvII51_2,
+      kDvI45_0 | kDvI50_0 | kDvI51_2 | kDvII45_0 | kDvII46_0 | kDvII50_0 |
+       kDvII51_2}},
+    {44, 1, 29, 29, true,
+     {kDvI48_0 | kDvI51_0 | kDvI52_0 | kDvII45_0 | kDvII46_0 | kDvII50_0 |
+       kDvII51_0,
+      kDvI49_0 | kDvI52_0 | kDvII46_0 | kDvII47_0 | kDvII51_0 | kDvII52_0,
+      kDvI50_0 | kDvII47_0 | kDvII48_0 | kDvII52_0 | kDvII53_0,
+      kDvI51_0 | kDvII48_0 | kDvII49_0 | kDvII53_0 | kDvII54_0}},
+    {67, 1, 3, 8, false,
+     {kDvI43_0 | kDvI49_2 | kDvII49_2,
+      kDvI44_0 | kDvI50_2 | kDvII46_2 | kDvII50_2,
+      kDvI45_0 | kDvI46_2 | kDvI51_2 | kDvII45_0 | kDvII46_2 | kDvII51_2,
+      kDvI46_0 | kDvI47_2 | kDvII46_0}},
+    {48, 1, 29, 29, true,
+     {kDvI52_0 | kDvII49_0 | kDvII50_0 | kDvII54_0 | kDvII55_0,
+      kDvII45_0 | kDvII50_0 | kDvII51_0 | kDvII55_0 | kDvII56_0,
+      kDvII46_0 | kDvII51_0 | kDvII52_0 | kDvII56_0,
+      kDvII47_0 | kDvII52_0 | kDvII53_0}},
+    {23, 1, 1, 6, false,
+     {kDvI46_2 | kDvI49_2 | kDvII49_2,
+      kDvI46_2 | kDvI47_2 | kDvI50_2 | kDvII49_2 | kDvII50_2,
+      kDvI47_2 | kDvI48_2 | kDvI51_2 | kDvII50_2 | kDvII51_2,
+      kDvI48_2 | kDvI49_2 | kDvII51_2}},
+    {40, 1, 29, 29, true,
+     {kDvI44_0 | kDvI47_0 | kDvI48_0 | kDvII46_0 | kDvII47_0 | kDvII56_0,
+      kDvI45_0 | kDvI48_0 | kDvI49_0 | kDvII47_0 | kDvII48_0,
+      kDvI46_0 | kDvI49_0 | kDvI50_0 | kDvII48_0 | kDvII49_0,
+      kDvI47_0 | kDvI50_0 | kDvI51_0 | kDvII45_0 | kDvII49_0 | kDvII50_0}},
+    {20, 1, 30, 3, false,
+     {kDvI45_0 | kDvI49_0 | kDvII49_0 | kDvII53_0,
+      kDvI46_0 | kDvI50_0 | kDvII50_0 | kDvII54_0,
+      kDvI43_0 | kDvI47_0 | kDvI51_0 | kDvII51_0 | kDvII55_0,
+      kDvI44_0 | kDvI48_0 | kDvI52_0 | kDvII52_0 | kDvII56_0}},
+    {27, 1, 1, 6, false,
+     {kDvI49_2 | kDvI50_2 | kDvII46_2,
+      kDvI46_2 | kDvI50_2 | kDvI51_2,
+      kDvI46_2 | kDvI47_2 | kDvI51_2,
+      kDvI47_2 | kDvI48_2 | kDvII49_2}},
+    {20, 5, 30, 28, false,
+     {kDvI45_0 | kDvI49_0 | kDvII49_0 | kDvII53_0,
+      kDvI46_0 | kDvI50_0 | kDvII50_0 | kDvII54_0,
+      kDvI43_0 | kDvI47_0 | kDvI51_0 | kDvII51_0 | kDvII55_0,
+      kDvI44_0 | kDvI48_0 | kDvI52_0 | kDvII52_0 | kDvII56_0}},
+    {70, 5, 4, 2, false,
+     {kDvI43_0 | kDvI49_2 | kDvII49_2,
+      kDvI44_0 | kDvI50_2 | kDvII46_2 | kDvII50_2,
+      kDvI45_0 | kDvI51_2 | kDvII45_0 | kDvII51_2,
+      kDvI46_0 | kDvII46_0}},
+    {24, 4, 4, 29, true,
+     {kDvI45_0 | kDvI49_0 | kDvII48_0 | kDvII53_0,
+      kDvI46_0 | kDvI50_0 | kDvII49_0 | kDvII54_0,
+      kDvI47_0 | kDvI51_0 | kDvII50_0 | kDvII55_0,
+      kDvI48_0 | kDvI52_0 | kDvII51_0 | kDvII56_0}},
+    {31, 1, 1, 6, false,
+     {kDvI48_2 | kDvI49_2 | kDvII50_2,
+      kDvI46_2 | kDvI49_2 | kDvI50_2 | kDvII51_2,
+      kDvI47_2 | kDvI50_2 | kDvI51_2,
+      kDvI48_2 | kDvI51_2}},
+    {24, 1, 30, 3, false,
+     {kDvI45_0 | kDvI49_0 | kDvII53_0,
+      kDvI46_0 | kDvI50_0 | kDvII54_0,
+      kDvI43_0 | kDvI47_0 | kDvI51_0 | kDvII55_0,
+      kDvI44_0 | kDvI48_0 | kDvI52_0 | kDvII56_0}},
+    {20, 1, 1, 6, false,
+     {kDvI46_2 | kDvII46_2 | kDvII50_2,
+      kDvI47_2 | kDvII46_2 | kDvII51_2,
+      kDvI48_2,
+      kDvI46_2 | kDvI49_2 | kDvII49_2}},
+    {68, 1, 1, 6, false,
+     {kDvI45_0 | kDvI50_0 | kDvII45_0 | kDvII46_0 | kDvII50_0,
+      kDvI46_0 | kDvI51_0 | kDvII46_0 | kDvII47_0 | kDvII51_0,
+      kDvI47_0 | kDvI52_0 | kDvII47_0 | kDvII48_0 | kDvII52_0,
+      kDvI48_0 | kDvII48_0 | kDvII49_0 | kDvII53_0}},
+    {52, 1, 29, 29, true,
+     {kDvII48_0 | kDvII53_0 | kDvII54_0,
+      kDvII49_0 | kDvII54_0 | kDvII55_0,
+      kDvII50_0 | kDvII55_0 | kDvII56_0,
+      kDvII51_0 | kDvII56_0}},
+    {63, 5, 2, 0, false,
+     {kDvI48_2,
+      kDvI43_0 | kDvI49_2 | kDvII49_2,
+      kDvI44_0 | kDvI50_2 | kDvII46_2 | kDvII50_2,
+      kDvI45_0 | kDvI51_2 | kDvII45_0 | kDvII51_2}},
+    {24, 5, 30, 28, false,
+     {kDvI45_0 | kDvI49_0 | kDvII53_0,
+      kDvI46_0 | kDvI50_0 | kDvII54_0,
+      kDvI43_0 | kDvI47_0 | kDvI51_0 | kDvII55_0,
+      kDvI44_0 | kDvI48_0 | kDvI52_0 | kDvII56_0}},
+    {38, 1, 1, 6, false,
+     {kDvI49_2,
+      kDvI46_2 | kDvI50_2 | kDvII49_2,
+      kDvI47_2 | kDvI51_2 | kDvII50_2,
+      kDvI48_2 | kDvII46_2 | kDvII51_2}},
+    {40, 2, 4, 29, true,
+     {kDvI46_0 | kDvI50_0 | kDvII49_0,
+      kDvI47_0 | kDvI51_0 | kDvII45_0 | kDvII50_0,
+      kDvI48_0 | kDvI52_0 | kDvII46_0 | kDvII51_0,
+      kDvI49_0 | kDvII47_0 | kDvII52_0}},
+    {69, 5, 3, 1, false,
+     {kDvI46_2 | kDvI51_2 | kDvII46_2 | kDvII51_2,
+      kDvI47_2,
+      kDvI48_2,
+      kDvI43_0 | kDvI49_2 | kDvII49_2}},
+    {28, 4, 4, 29, true,
+     {kDvI49_0 | kDvII52_0,
+      kDvI50_0 | kDvII53_0,
+      kDvI43_0 | kDvI51_0 | kDvII54_0,
+      kDvI44_0 | kDvI52_0 | kDvII55_0}},
+    {65, 1, 2, 7, false,
+     {kDvI44_0 | kDvI50_2 | kDvII46_2 | kDvII50_2,
+      kDvI45_0 | kDvI51_2 | kDvII45_0 | kDvII51_2,
+      kDvI46_0 | kDvII46_0,
+      kDvI47_0 | kDvII47_0 | kDvII49_2}},
+    {70, 5, 2, 0, false,
+     {kDvI49_0 | kDvII45_0 | kDvII49_0 | kDvII51_2,
+      kDvI50_0 | kDvII46_0 | kDvII50_0,
+      kDvI51_0 | kDvII47_0 | kDvII51_0,
+      kDvI52_0 | kDvII48_0 | kDvII52_0}},
+};
+
+// Constant shifts let the compiler evaluate all four lanes as one vector.
+template <size_t N>
+inline void applyUbcWindow(uint32_t failed[4], const uint32_t W[80]) {
+    constexpr UbcWindow window = kUbcWindows[N];
+    for (int lane = 0; lane < 4; ++lane) {
+        uint32_t other = W[window.step + window.offset + lane];
+        if (window.bit > window.otherBit)
+            other <<= (window.bit - window.otherBit) & 31;
+        else
+            other >>= (window.otherBit - window.bit) & 31;
+        const uint32_t differ =
+            ((W[window.step + lane] ^ other) >> window.bit) & 1;
+        failed[lane] |= window.vectors[lane] & ((differ ^ window.equal) - 1);
+    }
+}
+
+template <size_t... N>
+uint32_t unavoidableConditionMask(const uint32_t W[80],
+                                  std::index_sequence<N...>) {
+    uint32_t failed[4] = {};
+    (applyUbcWindow<N>(failed, W), ...);
+    return ~(failed[0] | failed[1] | failed[2] | failed[3]);
+}
+
+// Bitmask of the DVs whose unavoidable conditions all hold for W.
+uint32_t unavoidableConditionMask(const uint32_t W[80]) {
+    return unavoidableConditionMask(
+        W, std::make_index_sequence<sizeof(kUbcWindows) /
+                                    sizeof(kUbcWindows[0])>());
+}
+
+// Rebuilds the partner block implied by `vector` and reports whether it ends
+// in the same chaining value as the real block (ihvIn -> ihvOut under W).
+bool recompressionCollides(const DisturbanceVector& vector,
+                           const uint32_t W[80], const uint32_t ihvIn[5],
+                           const uint32_t ihvOut[5]) {
+    // Replay the real block up to the step both blocks share.
+    uint32_t a = ihvIn[0], b = ihvIn[1], c = ihvIn[2], d = ihvIn[3],
+             e = ihvIn[4];
+    for (int i = 0; i < vector.testStep; ++i) {
+        uint32_t t = rol(a, 5) + roundF(i, b, c, d) + e + roundK(i) + W[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    const uint32_t shared[5] = {a, b, c, d, e};
+
+    uint32_t m2[80];
+    for (int j = 0; j < 80; ++j)
+        m2[j] = W[j] ^ vector.dm[j];
+
+    // Undo the partner's steps back to its input chaining value...
+    for (int i = vector.testStep - 1; i >= 0; --i) {
+        const uint32_t prevA = b, prevB = ror(c, 30), prevC = d, prevD = e;
+        e = a - rol(prevA, 5) - roundF(i, prevB, prevC, prevD) - roundK(i) -
+            m2[i];
+        a = prevA;
+        b = prevB;
+        c = prevC;
+        d = prevD;
+    }
+    const uint32_t ihvIn2[5] = {a, b, c, d, e};
+
+    // ...then finish its compression from the shared state.
+    a = shared[0], b = shared[1], c = shared[2], d = shared[3], e = shared[4];
+    for (int i = vector.testStep; i < 80; ++i) {
+        uint32_t t = rol(a, 5) + roundF(i, b, c, d) + e + roundK(i) + m2[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    return ihvIn2[0] + a == ihvOut[0] && ihvIn2[1] + b == ihvOut[1] &&
+           ihvIn2[2] + c == ihvOut[2] && ihvIn2[3] + d == ihvOut[3] &&
+           ihvIn2[4] + e == ihvOut[4];
+}
+
+// processBlocks with the collision check after every block. Returns true if
+// any block looks like half of a collision pair.
+bool processBlocksDetecting(uint32_t state[5], const unsigned char* data,
+                            size_t blocks) {
+    CaptureFn capture = sha1BlockScalarCapture;
+#ifdef MGIT_SHA1_X86
+    if (activeBackend().load(std::memory_order_relaxed) == Sha1Backend::ShaNi)
+        capture = sha1BlockShaNiCapture;
+#endif
+    struct Captured {
+        alignas(16) uint32_t W[80];
+        uint32_t ihvIn[5];
+        uint32_t ihvOut[5];
+    };
+    bool collision = false;
+    auto check = [&](const Captured& block) {
+        uint32_t candidates = unavoidableConditionMask(block.W);
+        while (candidates) {
+            const int n = __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+            if (recompressionCollides(kDisturbanceVectors[n], block.W, block.ihvIn,
+                                      block.ihvOut))
+                collision = true;
+        }
+    };
+
+    // Each block is checked after the next one has been compressed. By then
+    // its W has drained from the store buffer, and the vectorized loads that
+    // derive X from it no longer stall on store forwarding.
+    Captured ring[2];
+    for (size_t i = 0; i < blocks; ++i) {
+        Captured& current = ring[i & 1];
+        std::memcpy(current.ihvIn, state, sizeof(current.ihvIn));
+        capture(state, data + i * 64, current.W);
+        std::memcpy(current.ihvOut, state, sizeof(current.ihvOut));
+        if (i > 0)
+            check(ring[(i - 1) & 1]);
+    }
+    if (blocks > 0)
+        check(ring[(blocks - 1) & 1]);
+    return collision;
+}
+
+bool defaultCollisionDetection() {
+#ifdef MGIT_SHA1DC
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::atomic<bool>& collisionDetection() {
+    static std::atomic<bool> enabled{defaultCollisionDetection()};
+    return enabled;
+}
+
+} // namespace
+
+namespace sha1dc {
+
+size_t disturbanceVectorCount() {
+    return sizeof(kDisturbanceVectors) / sizeof(kDisturbanceVectors[0]);
+}
+
+DisturbanceVectorInfo disturbanceVector(size_t n) {
+    const DisturbanceVector& vector = kDisturbanceVectors[n];
+    return {vector.type, vector.k, vector.b, vector.testStep, vector.dm};
+}
+
+uint32_t unavoidableConditionMask(const uint32_t W[80]) {
+    return ::unavoidableConditionMask(W);
+}
+
+bool recompressionCollides(size_t n, const uint32_t W[80],
+                           const uint32_t ihvIn[5], const uint32_t ihvOut[5]) {
+    return ::recompressionCollides(kDisturbanceVectors[n], W, ihvIn, ihvOut);
+}
+
+} // namespace sha1dc
+
+Sha1Backend sha1ActiveBackend() {
+    return activeBackend().load();
+}
+
+const char* sha1BackendName(Sha1Backend backend) {
+    switch (backend) {
+    case Sha1Backend::Scalar:
+        return "scalar";
+    case Sha1Backend::ShaNi:
+        return "sha-ni";
+    }
+    return "unknown";
+}
+
+bool sha1SetBackend(Sha1Backend backend) {
+    if (!backendSupported(backend))
+        return false;
+    activeBackend().store(backend);
+    activeBlockFn().store(blockFnFor(backend));
+    return true;
+}
+
+bool sha1CollisionDetection() {
+    return collisionDetection().load();
+}
+
+void sha1SetCollisionDetection(bool enabled) {
+    collisionDetection().store(enabled);
+}
+
+void Sha1::init() {
+    state[0] = 0x67452301;
+    state[1] = 0xEFCDAB89;
+    state[2] = 0x98BADCFE;
+    state[3] = 0x10325476;
+    state[4] = 0xC3D2E1F0;
+    length = 0;
+    buffered = 0;
+    detect = collisionDetection().load(std::memory_order_relaxed);
+    collision = false;
+}
+
+void Sha1::compress(const unsigned char* data, size_t blocks) {
+    if (!detect)
+        processBlocks(state, data, blocks);
+    else if (processBlocksDetecting(state, data, blocks))
+        collision = true;
+}
+
+void Sha1::update(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    length += size;
+
+    if (buffered) {
+        size_t take = 64 - buffered;
+        if (take > size)
+            take = size;
+        std::memcpy(buffer + buffered, p, take);
+        buffered += take;
+        p += take;
+        size -= take;
+        if (buffered < 64)
+            return;
+        compress(buffer, 1);
+        buffered = 0;
+    }
+
+    // Whole blocks are hashed straight from the caller's memory.
+    if (size >= 64) {
+        size_t blocks = size / 64;
+        compress(p, blocks);
+        p += blocks * 64;
+        size -= blocks * 64;
+    }
+
+    if (size) {
+        std::memcpy(buffer, p, size);
+        buffered = size;
+    }
+}
+
+void Sha1::final(unsigned char digest[kDigestSize]) {
+    const uint64_t bitLength = length * 8;
+    buffer[buffered++] = 0x80;
+    if (buffered > 56) {
+        std::memset(buffer + buffered, 0, 64 - buffered);
+        compress(buffer, 1);
+        buffered = 0;
+    }
+    std::memset(buffer + buffered, 0, 56 - buffered);
+    for (int i = 0; i < 8; ++i)
+        buffer[56 + i] = static_cast<unsigned char>(bitLength >> (56 - 8 * i));
+    compress(buffer, 1);
+    buffered = 0;
+
+    if (collision)
+        throw Sha1CollisionException();
+    for (int i = 0; i < 5; ++i) {
+        digest[i * 4] = static_cast<unsigned char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<unsigned char>(state[i]);
+    }
+}
+
+std::string Sha1::finalRaw() {
+    unsigned char digest[kDigestSize];
+    final(digest);
+    return std::string(reinterpret_cast<const char*>(digest), kDigestSize);
+}
+
+std::string Sha1::finalHex() {
+    unsigned char digest[kDigestSize];
+    final(digest);
+    std::string hex(kDigestSize * 2, '0');
+    hexEncode(digest, kDigestSize, &hex[0]);
+    return hex;
+}
+
+std::string hash_sha1(const std::string& data) {
+    Sha1 ctx;
+    ctx.update(data);
+    return ctx.finalHex();
+}
+
+std::string hash_sha1_raw(const std::string& data) {
+    Sha1 ctx;
+    ctx.update(data);
+    return ctx.finalRaw();
+}
@@ -1,36 +1,239 @@
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include "../headers/ZlibUtils.hpp"
+#include "../headers/HexUtils.hpp"
 #include <zlib.h>
+#ifdef MGIT_LIBDEFLATE
+#include <libdeflate.h>
+#endif
 #include <iostream>
-#include <iomanip>
 #include <sstream>
 #include <ctime>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+
+namespace {
+
+// zlib counts in 32-bit units; larger buffers are fed in slices.
+uInt zlibSlice(size_t size) {
+    return static_cast<uInt>(std::min<size_t>(size, UINT32_MAX));
+}
+
+// Deflate cannot expand data by more than about 1032:1, which bounds how
+// much a (possibly corrupt) header may make us reserve.
+const size_t kMaxInflateRatio = 1032;
+
+// Total size of "<type> <size>\0<body>" if data starts with such a header.
+bool objectSizeFromHeader(const char* data, size_t size, size_t& total) {
+    const char* nul = static_cast<const char*>(std::memchr(data, '\0', size));
+    const char* space = static_cast<const char*>(std::memchr(data, ' ', size));
+    if (!nul || !space || space > nul || nul - space < 2)
+        return false;
+    uint64_t bodySize = 0;
+    for (const char* p = space + 1; p < nul; ++p) {
+        if (*p < '0' || *p > '9' || bodySize > UINT64_MAX / 10 - 1)
+            return false;
+        bodySize = bodySize * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    size_t headerSize = static_cast<size_t>(nul - data) + 1;
+    if (bodySize > SIZE_MAX - headerSize)
+        return false;
+    total = headerSize + static_cast<size_t>(bodySize);
+    return true;
+}
+
+} // namespace
 
 std::string decompressZlib(const std::vector<char>& compressed) {
-    std::vector<char> output(100000); // Start with 100KB, resize if needed
+    // A small first pass yields the object header; the output is then sized
+    // from it once (plus a byte, so a correct object ends without another
+    // resize). Data without a header falls back to doubling.
+    std::string output(64, '\0');
+    const char* input = compressed.data();
+    size_t inputLeft = compressed.size();
 
     z_stream stream{};
-    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
-    stream.avail_in = compressed.size();
-    stream.next_out = reinterpret_cast<Bytef*>(output.data());
-    stream.avail_out = output.size();
+    if (inflateInit(&stream) != Z_OK)
+        throw std::runtime_error("inflateInit failed");
+
+    bool sized = false;
+    int result = Z_OK;
+    while (true) {
+        if (stream.avail_in == 0 && inputLeft > 0) {
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            stream.avail_in = zlibSlice(inputLeft);
+            input += stream.avail_in;
+            inputLeft -= stream.avail_in;
+        }
+        size_t have = stream.total_out;
+        if (have == output.size()) {
+            size_t total = 0;
+            size_t target = 0;
+            if (!sized && objectSizeFromHeader(output.data(), have, total) &&
+                total / kMaxInflateRatio <= compressed.size()) {
+                target = total + 1;
+            }
+            sized = true;
+            output.resize(std::max(target, have * 2));
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(&output[have]);
+        stream.avail_out = zlibSlice(output.size() - have);
+
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END)
+            break;
+        bool stalled = stream.avail_in == 0 && inputLeft == 0 &&
+                       stream.total_out < output.size();
+        if ((result != Z_OK && result != Z_BUF_ERROR) || stalled) {
+            inflateEnd(&stream);
+            throw std::runtime_error("inflate failed");
+        }
+    }
+
+    inflateEnd(&stream);
+    output.resize(stream.total_out);
+    return output;
+}
+
+std::string decompressZlib(const unsigned char* data, size_t size,
+                           size_t expectedSize) {
+    std::string output(expectedSize, '\0');
+#ifdef MGIT_LIBDEFLATE
+    {
+        // Decompressors are cheap but not thread-safe: one per thread.
+        struct Decompressor {
+            libdeflate_decompressor* handle = libdeflate_alloc_decompressor();
+            ~Decompressor() { libdeflate_free_decompressor(handle); }
+        };
+        thread_local Decompressor decompressor;
+        size_t consumed = 0;
+        size_t produced = 0;
+        if (!decompressor.handle ||
+            libdeflate_zlib_decompress_ex(decompressor.handle, data, size,
+                                          &output[0], expectedSize, &consumed,
+                                          &produced) != LIBDEFLATE_SUCCESS ||
+            produced != expectedSize)
+            throw std::runtime_error("inflate failed");
+        return output;
+    }
+#endif
+
+    z_stream stream{};
+    // zlib wants a non-null output pointer even for empty objects.
+    unsigned char empty = 0;
+    unsigned char* out =
+        expectedSize ? reinterpret_cast<unsigned char*>(&output[0]) : &empty;
+    size_t inputLeft = size;
+    size_t outputLeft = expectedSize;
 
     if (inflateInit(&stream) != Z_OK)
         throw std::runtime_error("inflateInit failed");
 
-    int result = inflate(&stream, Z_FINISH);
-    if (result != Z_STREAM_END)
+    // Both sides are fed in slices, like the vector overload: objects over
+    // 4 GiB do not fit zlib's 32-bit counters.
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.avail_in == 0 && inputLeft > 0) {
+            stream.next_in = const_cast<Bytef*>(data + (size - inputLeft));
+            stream.avail_in = zlibSlice(inputLeft);
+            inputLeft -= stream.avail_in;
+        }
+        if (stream.avail_out == 0) {
+            stream.next_out = out + (expectedSize - outputLeft);
+            stream.avail_out = zlibSlice(outputLeft);
+            outputLeft -= stream.avail_out;
+        }
+        result = inflate(&stream, Z_NO_FLUSH);
+        // Z_BUF_ERROR is only a stall if no slice is left to refill.
+        bool refill = (stream.avail_in == 0 && inputLeft > 0) ||
+                      (stream.avail_out == 0 && outputLeft > 0);
+        if (result == Z_BUF_ERROR && refill)
+            result = Z_OK;
+    }
+    inflateEnd(&stream);
+    if (result != Z_STREAM_END || stream.total_out != expectedSize)
         throw std::runtime_error("inflate failed");
 
+    return output;
+}
+
+std::string inflatePrefix(const unsigned char* data, size_t size,
+                          size_t maxOutput) {
+    std::string output(maxOutput, '\0');
+    z_stream stream{};
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = zlibSlice(size);
+    unsigned char empty = 0;
+    stream.next_out = maxOutput ? reinterpret_cast<Bytef*>(&output[0]) : &empty;
+    stream.avail_out = static_cast<uInt>(maxOutput);
+
+    if (inflateInit(&stream) != Z_OK)
+        throw std::runtime_error("inflateInit failed");
+
+    // Z_BUF_ERROR only means the input or the output ran out.
+    int result = inflate(&stream, Z_SYNC_FLUSH);
     inflateEnd(&stream);
-    return std::string(output.data(), stream.total_out);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+        throw std::runtime_error("inflate failed");
+
+    output.resize(stream.total_out);
+    return output;
+}
+
+#ifdef MGIT_LIBDEFLATE
+namespace {
+
+// libdeflate compressors are not thread-safe and costly to allocate, so each
+// thread keeps one per level.
+libdeflate_compressor* threadCompressor(int level) {
+    struct Cache {
+        libdeflate_compressor* byLevel[10] = {};
+        ~Cache() {
+            for (auto* compressor : byLevel)
+                if (compressor)
+                    libdeflate_free_compressor(compressor);
+        }
+    };
+    thread_local Cache cache;
+    if (!cache.byLevel[level])
+        cache.byLevel[level] = libdeflate_alloc_compressor(level);
+    if (!cache.byLevel[level])
+        throw std::runtime_error("libdeflate_alloc_compressor failed");
+    return cache.byLevel[level];
+}
+
+} // namespace
+#endif
+
+const char* zlibBackendName() {
+#ifdef MGIT_LIBDEFLATE
+    return "libdeflate";
+#else
+    return "zlib";
+#endif
 }
 
-std::string compressZlib(const std::string& input) {
+std::string compressZlib(const std::string& input, int level) {
+    if (level < -1 || level > 9)
+        throw std::invalid_argument("Compression level must be -1..9");
+#ifdef MGIT_LIBDEFLATE
+    // Level 0 (store) is left to zlib; older libdeflate releases reject it.
+    if (level != 0) {
+        libdeflate_compressor* compressor =
+            threadCompressor(level == -1 ? 6 : level);
+        std::string output(
+            libdeflate_zlib_compress_bound(compressor, input.size()), '\0');
+        size_t written = libdeflate_zlib_compress(
+            compressor, input.data(), input.size(), &output[0], output.size());
+        if (written == 0)
+            throw std::runtime_error("Compression failed");
+        output.resize(written);
+        return output;
+    }
+#endif
     uLongf compressedSize = compressBound(input.size());
     std::vector<unsigned char> buffer(compressedSize);
 
@@ -39,7 +242,7 @@ std::string compressZlib(const std::string& input) {
         &compressedSize,
         reinterpret_cast<const Bytef*>(input.data()),
         input.size(),
-        Z_BEST_COMPRESSION
+        level
     );
 
     if (result != Z_OK) {
@@ -49,90 +252,95 @@ std::string compressZlib(const std::string& input) {
     return std::string(reinterpret_cast<char*>(buffer.data()), compressedSize);
 }
 
+ZlibDeflater::ZlibDeflater(ZlibSink sink, int level)
+    : sink(std::move(sink)), stream(new z_stream{}), buffer(128 * 1024),
+      finished(false) {
+    // Always zlib: libdeflate has no streaming interface.
+    if (deflateInit(stream.get(), level) != Z_OK)
+        throw std::runtime_error("deflateInit failed");
+}
 
-std::string hash_sha1(const std::string& data) {
-    auto leftrotate = [](uint32_t value, int bits) -> uint32_t {
-        return (value << bits) | (value >> (32 - bits));
-    };
-
-    std::vector<unsigned char> msg(data.begin(), data.end());
-    uint64_t bit_len = static_cast<uint64_t>(msg.size()) * 8;
+ZlibDeflater::~ZlibDeflater() {
+    deflateEnd(stream.get());
+}
 
-    msg.push_back(0x80);
-    while ((msg.size() % 64) != 56) {
-        msg.push_back(0x00);
+void ZlibDeflater::write(const void* data, size_t size) {
+    const Bytef* input = static_cast<const Bytef*>(data);
+    while (size > 0) {
+        uInt slice = zlibSlice(size);
+        stream->next_in = const_cast<Bytef*>(input);
+        stream->avail_in = slice;
+        pump(Z_NO_FLUSH);
+        input += slice;
+        size -= slice;
     }
-    for (int i = 7; i >= 0; --i) {
-        msg.push_back(static_cast<unsigned char>((bit_len >> (i * 8)) & 0xFF));
+}
+
+void ZlibDeflater::finish() {
+    if (finished)
+        return;
+    stream->next_in = nullptr;
+    stream->avail_in = 0;
+    pump(Z_FINISH);
+    finished = true;
+}
+
+void ZlibDeflater::pump(int flush) {
+    while (true) {
+        stream->next_out = reinterpret_cast<Bytef*>(buffer.data());
+        stream->avail_out = static_cast<uInt>(buffer.size());
+        int result = deflate(stream.get(), flush);
+        if (result == Z_STREAM_ERROR)
+            throw std::runtime_error("Compression failed");
+        size_t produced = buffer.size() - stream->avail_out;
+        if (produced > 0)
+            sink(buffer.data(), produced);
+        if (flush == Z_FINISH ? result == Z_STREAM_END
+                              : stream->avail_in == 0 && stream->avail_out != 0)
+            return;
     }
+}
 
-    uint32_t h0 = 0x67452301;
-    uint32_t h1 = 0xEFCDAB89;
-    uint32_t h2 = 0x98BADCFE;
-    uint32_t h3 = 0x10325476;
-    uint32_t h4 = 0xC3D2E1F0;
-
-    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
-        uint32_t w[80];
-        for (int i = 0; i < 16; ++i) {
-            size_t j = chunk + i * 4;
-            w[i] = (static_cast<uint32_t>(msg[j]) << 24) |
-                   (static_cast<uint32_t>(msg[j + 1]) << 16) |
-                   (static_cast<uint32_t>(msg[j + 2]) << 8) |
-                   static_cast<uint32_t>(msg[j + 3]);
-        }
-        for (int i = 16; i < 80; ++i) {
-            w[i] = leftrotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
-        }
+ZlibInflater::ZlibInflater(ZlibSink sink)
+    : sink(std::move(sink)), stream(new z_stream{}), buffer(128 * 1024),
+      done(false) {
+    if (inflateInit(stream.get()) != Z_OK)
+        throw std::runtime_error("inflateInit failed");
+}
+
+ZlibInflater::~ZlibInflater() {
+    inflateEnd(stream.get());
+}
 
-        uint32_t a = h0;
-        uint32_t b = h1;
-        uint32_t c = h2;
-        uint32_t d = h3;
-        uint32_t e = h4;
-
-        for (int i = 0; i < 80; ++i) {
-            uint32_t f = 0;
-            uint32_t k = 0;
-            if (i < 20) {
-                f = (b & c) | ((~b) & d);
-                k = 0x5A827999;
-            } else if (i < 40) {
-                f = b ^ c ^ d;
-                k = 0x6ED9EBA1;
-            } else if (i < 60) {
-                f = (b & c) | (b & d) | (c & d);
-                k = 0x8F1BBCDC;
-            } else {
-                f = b ^ c ^ d;
-                k = 0xCA62C1D6;
+bool ZlibInflater::write(const void* data, size_t size) {
+    const Bytef* input = static_cast<const Bytef*>(data);
+    while (size > 0 && !done) {
+        uInt slice = zlibSlice(size);
+        stream->next_in = const_cast<Bytef*>(input);
+        stream->avail_in = slice;
+        while (true) {
+            stream->next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream->avail_out = static_cast<uInt>(buffer.size());
+            int result = inflate(stream.get(), Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+                throw std::runtime_error("inflate failed");
+            size_t produced = buffer.size() - stream->avail_out;
+            if (produced > 0)
+                sink(buffer.data(), produced);
+            if (result == Z_STREAM_END) {
+                done = true;
+                break;
             }
-            uint32_t temp = leftrotate(a, 5) + f + e + k + w[i];
-            e = d;
-            d = c;
-            c = leftrotate(b, 30);
-            b = a;
-            a = temp;
+            if (stream->avail_out != 0)
+                break; // all input consumed
         }
-
-        h0 += a;
-        h1 += b;
-        h2 += c;
-        h3 += d;
-        h4 += e;
-    }
-
-    uint32_t digest[5] = {h0, h1, h2, h3, h4};
-    std::ostringstream result;
-    result << std::hex << std::setfill('0');
-    for (int i = 0; i < 5; ++i) {
-        result << std::setw(8) << digest[i];
+        input += slice;
+        size -= slice;
     }
-    return result.str();
+    return done;
 }
 
 
-
 std::string getCurrentTimestampWithTimezone() {
     std::time_t now = std::time(nullptr);
 
@@ -163,19 +371,15 @@ std::string getCurrentTimestampWithTimezone() {
 
 
 std::string hexToBinary(const std::string& hex) {
-    if (hex.length() != 40 || (hex.length() % 2) != 0) {
+    if (hex.length() != 40) {
         throw std::invalid_argument("Hex string must be 40 characters for SHA-1");
     }
 
-    std::string binary;
-    binary.reserve(20);
-
-    for (size_t i = 0; i < hex.length(); i += 2) {
-        std::string byteStr = hex.substr(i, 2);
-        unsigned char byte = static_cast<unsigned char>(std::stoi(byteStr, nullptr, 16));
-        binary.push_back(static_cast<char>(byte));
+    std::string binary(20, '\0');
+    if (!hexDecode(hex.data(), binary.size(),
+                   reinterpret_cast<unsigned char*>(&binary[0]))) {
+        throw std::invalid_argument("Invalid hex digit in SHA-1: " + hex);
     }
-
     return binary;
 }
 
@@ -184,10 +388,8 @@ std::string binaryToHex(const std::string& binary) {
         throw std::invalid_argument("Binary input must be 20 bytes for SHA-1");
     }
 
-    std::ostringstream hex;
-    hex << std::hex << std::setfill('0');
-    for (unsigned char byte : binary) {
-        hex << std::setw(2) << static_cast<unsigned int>(byte);
-    }
-    return hex.str();
+    std::string hex(40, '0');
+    hexEncode(reinterpret_cast<const unsigned char*>(binary.data()),
+              binary.size(), &hex[0]);
+    return hex;
 }
@@ -1,10 +1,13 @@
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <regex>
+#include <sstream>
 #include <string>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -136,6 +139,32 @@ int main(int argc, char **argv) {
                        "Commit created successfully.");
     expectZeroContains("status clean", shellQuote(mgit) + " status",
                        "working tree clean");
+    // Adding an unchanged tracked file is answered from the mapped index
+    // and leaves the file alone; a changed one is staged.
+    {
+      // An old mtime keeps the entry from being racily clean.
+      fs::last_write_time(repo / "a.txt", fs::last_write_time(repo / "a.txt") -
+                                              std::chrono::seconds(10));
+      expectZero("add restamped", shellQuote(mgit) + " add a.txt");
+      const fs::file_time_type indexWritten =
+          fs::last_write_time(repo / ".git/index");
+      expectZero("add unchanged", shellQuote(mgit) + " add a.txt");
+      if (fs::last_write_time(repo / ".git/index") != indexWritten) {
+        failures.push_back("add of an unchanged file rewrote the index");
+      }
+      std::ofstream(repo / "b.txt") << "world, edited\n";
+      expectZero("add edited", shellQuote(mgit) + " add a.txt b.txt");
+      expectZeroContains("add edited staged", shellQuote(mgit) + " status",
+                         "modified:   b.txt");
+      std::ofstream(repo / "b.txt") << "world\n";
+      expectZero("add restored", shellQuote(mgit) + " add b.txt");
+      expectZeroContains("add restored clean", shellQuote(mgit) + " status",
+                         "working tree clean");
+    }
+    // Everything below reads objects back through the pack index.
+    expectZeroContains("gc", shellQuote(mgit) + " gc", "Packed");
+    expectZeroContains("status after gc", shellQuote(mgit) + " status",
+                       "working tree clean");
 
     CmdResult writeTreeRes = runCmd(repo, shellQuote(mgit) + " write-tree");
     std::smatch m;
@@ -172,8 +201,92 @@ int main(int argc, char **argv) {
     expectNonZero("resolve-conflict invalid",
                   shellQuote(mgit) + " resolve-conflict missing.txt deadbeef",
                   "Failed to resolve conflict");
-    expectNonZero("log unimplemented", shellQuote(mgit) + " log",
-                  "Not implemented");
+    expectZeroContains("log", shellQuote(mgit) + " log", "Author: Tester");
+    CmdResult emptyRange =
+        runCmd(repo, shellQuote(mgit) + " log --oneline HEAD..HEAD");
+    if (emptyRange.rc != 0 || !emptyRange.output.empty()) {
+      failures.push_back("log HEAD..HEAD expected no commits\n" +
+                         emptyRange.output);
+    }
+    expectNonZero("log unknown revision", shellQuote(mgit) + " log nosuch",
+                  "unknown revision");
+    expectZeroContains("log path", shellQuote(mgit) + " log --oneline -- feature.txt",
+                       "feature");
+
+    // Log order: two lines of history joined by a two-parent merge commit
+    // (a conflicted merge, so that --continue records both parents).
+    auto logSubjects = [&](const std::string &args) {
+      std::vector<std::string> subjects;
+      CmdResult r = runCmd(repo, shellQuote(mgit) + " log --oneline " + args);
+      if (r.rc != 0) {
+        failures.push_back("log " + args + " expected rc=0 got " +
+                           std::to_string(r.rc) + "\n" + r.output);
+        return subjects;
+      }
+      std::istringstream lines(r.output);
+      for (std::string line; std::getline(lines, line);) {
+        size_t space = line.find(' ');
+        subjects.push_back(space == std::string::npos ? line
+                                                      : line.substr(space + 1));
+      }
+      return subjects;
+    };
+    auto expectLog = [&](const std::string &args,
+                         const std::vector<std::string> &expected) {
+      std::vector<std::string> subjects = logSubjects(args);
+      if (subjects != expected) {
+        std::string got;
+        for (const auto &subject : subjects) {
+          got += subject + "\n";
+        }
+        failures.push_back("log " + args + " printed unexpected commits\n" + got);
+      }
+    };
+    auto commitLogFile = [&](const std::string &text) {
+      std::ofstream(repo / "log.txt") << text << "\n";
+      expectZero("log add " + text, shellQuote(mgit) + " add log.txt");
+      expectZero("log commit " + text,
+                 shellQuote(mgit) + " commit -m '" + text + "'");
+    };
+    commitLogFile("log base");
+    expectZero("log branch side", shellQuote(mgit) + " branch side");
+    commitLogFile("main one");
+    commitLogFile("main two");
+    expectZero("log switch side", shellQuote(mgit) + " switch side");
+    commitLogFile("side one");
+    commitLogFile("side two");
+    expectZero("log checkout main", shellQuote(mgit) + " checkout main");
+    expectLog("main..side", {"side two", "side one"});
+    expectLog("side..main", {"main two", "main one"});
+    expectNonZero("log merge side", shellQuote(mgit) + " merge side",
+                  "CONFLICT");
+    std::ofstream(repo / "log.txt") << "resolved\n";
+    expectZero("log add resolved", shellQuote(mgit) + " add log.txt");
+    expectZero("log merge --continue", shellQuote(mgit) + " merge --continue");
+    expectLog("main..side", {});
+    expectLog("side..main", {"Merge branch 'side'", "main two", "main one"});
+    expectLog("--first-parent -n 4",
+              {"Merge branch 'side'", "main two", "main one", "log base"});
+    {
+      // Both lines appear, each commit before its parents.
+      std::vector<std::string> topo = logSubjects("--topo-order -n 6");
+      auto at = [&](const std::string &subject) {
+        return std::find(topo.begin(), topo.end(), subject) - topo.begin();
+      };
+      bool ok = topo.size() == 6 && topo.front() == "Merge branch 'side'" &&
+                topo.back() == "log base" && at("main two") < at("main one") &&
+                at("side two") < at("side one") && at("main one") < 5 &&
+                at("side one") < 5;
+      if (!ok) {
+        std::string got;
+        for (const auto &subject : topo) {
+          got += subject + "\n";
+        }
+        failures.push_back("log --topo-order printed a parent before its "
+                           "child or missed a commit\n" + got);
+      }
+    }
+    expectZero("log branch delete side", shellQuote(mgit) + " branch -d side");
 
     // Remote flow
     {
@@ -202,6 +315,222 @@ int main(int argc, char **argv) {
     expectZeroContains("activity recent", shellQuote(mgit) + " activity recent -l 5",
                        "Recent Activity");
 
+    // Delta chains: versions of one file packed by gc as deltas of each
+    // other must all read back unchanged.
+    std::vector<std::pair<std::string, std::string>> versions; // blob, text
+    for (int v = 1; v <= 5; ++v) {
+      std::string text;
+      for (int line = 0; line < 40 * v; ++line) {
+        text += "version line " + std::to_string(line) + "\n";
+      }
+      if (v % 2 == 0) {
+        text.insert(0, "edited in version " + std::to_string(v) + "\n");
+      }
+      std::ofstream(repo / "versions.txt", std::ios::binary) << text;
+      CmdResult blobRes =
+          runCmd(repo, shellQuote(mgit) + " hash-object versions.txt");
+      std::smatch blob;
+      if (!std::regex_search(blobRes.output, blob, std::regex("[0-9a-f]{40}"))) {
+        failures.push_back("hash-object versions.txt\n" + blobRes.output);
+        continue;
+      }
+      versions.emplace_back(blob[0], text);
+      expectZero("versions add", shellQuote(mgit) + " add versions.txt");
+      expectZero("versions commit", shellQuote(mgit) + " commit -m 'version " +
+                                        std::to_string(v) + "'");
+    }
+    CmdResult gcRes = runCmd(repo, shellQuote(mgit) + " gc");
+    std::smatch deltas;
+    if (gcRes.rc != 0 ||
+        !std::regex_search(gcRes.output, deltas,
+                           std::regex("\\(([0-9]+) stored as deltas\\)")) ||
+        deltas[1] == "0") {
+      failures.push_back("gc versions expected deltas\n" + gcRes.output);
+    }
+    for (const auto &[blob, text] : versions) {
+      // cat-file -p ends its output with a newline of its own.
+      CmdResult readRes = runCmd(repo, shellQuote(mgit) + " cat-file -p " + blob);
+      if (readRes.rc != 0 || readRes.output != text + "\n") {
+        failures.push_back("cat-file -p " + blob + " after gc differs\n" +
+                           readRes.output.substr(0, 200));
+      }
+    }
+
+    // Commit-graph chain: a commit writes a layer of its own on top of the
+    // chain and leaves the files below it untouched.
+    {
+      const fs::path graphs = repo / ".git/objects/info/commit-graphs";
+      auto chainLayers = [&] {
+        std::vector<std::string> layers;
+        std::ifstream chain(graphs / "commit-graph-chain");
+        for (std::string line; std::getline(chain, line);) {
+          layers.push_back(line);
+        }
+        return layers;
+      };
+      auto layerPath = [&](const std::string &layer) {
+        return graphs / ("graph-" + layer + ".graph");
+      };
+      const std::vector<std::string> before = chainLayers();
+      std::vector<fs::file_time_type> written;
+      for (const auto &layer : before) {
+        written.push_back(fs::last_write_time(layerPath(layer)));
+      }
+      std::ofstream(repo / "graph.txt") << "layered\n";
+      expectZero("graph add", shellQuote(mgit) + " add graph.txt");
+      expectZero("graph commit", shellQuote(mgit) + " commit -m 'graph layer'");
+      const std::vector<std::string> after = chainLayers();
+      if (before.empty() || after.size() < 2 || after[0] != before[0] ||
+          std::find(before.begin(), before.end(), after.back()) !=
+              before.end()) {
+        failures.push_back("commit-graph chain after a commit: " +
+                           std::to_string(before.size()) + " -> " +
+                           std::to_string(after.size()) + " layers");
+      } else {
+        for (size_t i = 0; i + 1 < after.size(); ++i) {
+          if (i >= before.size() || after[i] != before[i] ||
+              fs::last_write_time(layerPath(after[i])) != written[i]) {
+            failures.push_back("commit rewrote commit-graph layer " + after[i]);
+          }
+        }
+      }
+      expectZeroContains("log over graph layers",
+                         shellQuote(mgit) + " log -n 1 --oneline -- graph.txt",
+                         "graph layer");
+    }
+
+    // Cache-tree: after "add ." with one file edited, status reads only the
+    // HEAD trees on that file's path and skips the untouched subtrees.
+    for (const char *dir : {"ct/a/b", "ct/c", "ct/d"}) {
+      fs::create_directories(repo / dir);
+      std::ofstream(repo / dir / "f") << dir << "\n";
+    }
+    expectZero("cache-tree add", shellQuote(mgit) + " add .");
+    expectZero("cache-tree commit", shellQuote(mgit) + " commit -m 'cache-tree'");
+    {
+      std::ofstream(repo / "ct/a/b/f", std::ios::app) << "z\n";
+    }
+    expectZero("cache-tree add edit", shellQuote(mgit) + " add .");
+    expectZeroContains("cache-tree status after add .",
+                       "MGIT_TRACE_CACHE_TREE=1 " + shellQuote(mgit) + " status",
+                       "cache-tree: 4 HEAD trees read, 2 subtrees skipped");
+    expectZero("cache-tree commit edit", shellQuote(mgit) + " commit -m 'cache-tree edit'");
+
+    // Status sections: the text from a heading to the blank line ending it.
+    auto statusSection = [&](const std::string &heading) {
+      CmdResult r = runCmd(repo, shellQuote(mgit) + " status");
+      if (r.rc != 0) {
+        failures.push_back("status expected rc=0 got " + std::to_string(r.rc) +
+                           "\n" + r.output);
+        return std::string();
+      }
+      size_t start = r.output.find(heading);
+      if (start == std::string::npos) {
+        return std::string();
+      }
+      size_t stop = r.output.find("\n\n", start);
+      return r.output.substr(start, stop == std::string::npos
+                                        ? std::string::npos
+                                        : stop - start);
+    };
+    const std::string kStaged = "Changes to be committed:";
+    const std::string kUnstaged = "Changes not staged for commit:";
+    const std::string kUntracked = "Untracked files:";
+
+    // Racy edit: same size, written right after add, with the old mtime put
+    // back, so only the racy-clean check or ctime can tell.
+    {
+      std::ofstream(repo / "racy.txt") << "aaaa\n";
+    }
+    expectZero("racy add", shellQuote(mgit) + " add racy.txt");
+    {
+      auto mtime = fs::last_write_time(repo / "racy.txt");
+      std::ofstream(repo / "racy.txt") << "bbbb\n";
+      fs::last_write_time(repo / "racy.txt", mtime);
+    }
+    if (!contains(statusSection(kUnstaged), "modified:   racy.txt")) {
+      failures.push_back("status missed a same-size edit in the same second");
+    }
+    expectZero("racy add edit", shellQuote(mgit) + " add racy.txt");
+    expectZero("racy commit", shellQuote(mgit) + " commit -m 'racy'");
+
+    // A new file in a directory that already has tracked files.
+    {
+      std::ofstream(repo / "ct/c/new.txt") << "new\n";
+    }
+    if (!contains(statusSection(kUntracked), "ct/c/new.txt")) {
+      failures.push_back("status missed an untracked file in a tracked dir");
+    }
+    expectZero("untracked add", shellQuote(mgit) + " add ct/c/new.txt");
+    if (contains(statusSection(kUntracked), "ct/c/new.txt") ||
+        !contains(statusSection(kStaged), "new file:   ct/c/new.txt")) {
+      failures.push_back("status after add still lists ct/c/new.txt as "
+                         "untracked or not as staged");
+    }
+    expectZero("untracked commit", shellQuote(mgit) + " commit -m 'untracked'");
+
+    // One file added deep below new directories shows as staged, and it is
+    // the only staged change: the unchanged subtrees around it are joined
+    // without reporting anything.
+    fs::create_directories(repo / "deep/a/b/c/d");
+    {
+      std::ofstream(repo / "deep/a/b/c/d/file.txt") << "deep\n";
+    }
+    expectZero("deep add", shellQuote(mgit) + " add deep/a/b/c/d/file.txt");
+    {
+      std::string staged = statusSection(kStaged);
+      if (!contains(staged, "new file:   deep/a/b/c/d/file.txt") ||
+          std::count(staged.begin(), staged.end(), '\t') != 1) {
+        failures.push_back("status after deep add\n" + staged);
+      }
+    }
+    expectZero("deep commit", shellQuote(mgit) + " commit -m 'deep'");
+
+    // .mgitignore: a negation re-includes a file, but not below a directory
+    // that is itself ignored (that directory is never scanned).
+    fs::create_directories(repo / "ign/build");
+    fs::create_directories(repo / "build");
+    {
+      std::ofstream(repo / ".mgitignore")
+          << "*.log\n!keep.log\nbuild/\n!build/keep.txt\n";
+      std::ofstream(repo / "ign/a.log") << "1\n";
+      std::ofstream(repo / "ign/keep.log") << "1\n";
+      std::ofstream(repo / "ign/build/x.txt") << "1\n";
+      std::ofstream(repo / "build/keep.txt") << "1\n";
+    }
+    {
+      std::string untracked = statusSection(kUntracked);
+      if (!contains(untracked, "ign/keep.log") ||
+          contains(untracked, "a.log") || contains(untracked, "build")) {
+        failures.push_back("status with .mgitignore negation and an "
+                           "ignored directory\n" + untracked);
+      }
+    }
+    expectZero("ignore add", shellQuote(mgit) + " add .");
+    expectZero("ignore commit", shellQuote(mgit) + " commit -m 'ignore'");
+
+    // fsmonitor: after an edit, status only checks the reported paths and
+    // still sees the change.
+    expectZeroContains("fsmonitor start", shellQuote(mgit) + " fsmonitor start",
+                       "started");
+    expectZeroContains("fsmonitor first status",
+                       "MGIT_TRACE_FSMONITOR=1 " + shellQuote(mgit) + " status",
+                       "working tree clean");
+    {
+      std::ofstream(repo / "ct/d/f", std::ios::app) << "watched\n";
+    }
+    usleep(200 * 1000); // let the inotify event reach the daemon
+    {
+      CmdResult r = runCmd(repo, "MGIT_TRACE_FSMONITOR=1 " + shellQuote(mgit) +
+                                     " status");
+      if (r.rc != 0 || !contains(r.output, "paths reported") ||
+          !contains(r.output, "modified:   ct/d/f")) {
+        failures.push_back("status with fsmonitor after an edit\n" + r.output);
+      }
+    }
+    expectZeroContains("fsmonitor stop", shellQuote(mgit) + " fsmonitor stop",
+                       "stopped");
+
     if (!failures.empty()) {
       std::cerr << "Integration test failures: " << failures.size() << "\n";
       for (const auto &f : failures) {
@@ -47,6 +47,8 @@ fi
 run_expect "commit" 0 "$BIN" commit -m "initial commit"
 HEAD_HASH=""
 [[ -f .git/refs/heads/main ]] && HEAD_HASH=$(cat .git/refs/heads/main)
+run_expect "commit-graph-after-commit" 0 test -s .git/objects/info/commit-graphs/commit-graph-chain
+run_expect "commit-graph-write" 0 "$BIN" commit-graph write
 
 run_expect "cat-file-type-head" 0 "$BIN" cat-file -t HEAD
 run_expect "cat-file-pretty-head" 0 "$BIN" cat-file -p HEAD
@@ -66,6 +68,7 @@ run_expect "branch-current" 0 "$BIN" branch --show-current
 run_expect "switch-feature" 0 "$BIN" switch feature
 run_expect "checkout-main" 0 "$BIN" checkout main
 
+run_expect "merge-base" 0 "$BIN" merge-base main feature
 run_expect "merge-feature" 0 "$BIN" merge feature
 run_expect "merge-status" 0 "$BIN" merge-status
 run_expect "merge-continue" nonzero "$BIN" merge --continue
@@ -104,7 +107,11 @@ run_expect "activity-raw" 0 "$BIN" activity raw
 run_expect "activity-errors-raw" 0 "$BIN" activity errors-raw
 run_expect "activity-performance-raw" 0 "$BIN" activity performance-raw
 run_expect "resolve-conflict-noop" nonzero "$BIN" resolve-conflict a.txt deadbeef
-run_expect "log-placeholder" nonzero "$BIN" log
+run_expect "log" 0 "$BIN" log
+run_expect "log-oneline-topo" 0 "$BIN" log --oneline --topo-order -n 5
+run_expect "log-first-parent-range" 0 "$BIN" log --first-parent main..HEAD
+run_expect "log-path" 0 "$BIN" log --oneline -- a.txt
+run_expect "log-range-path" 0 "$BIN" log --oneline main..HEAD -- a.txt
 
 TOTAL=$(wc -l < "$SUMMARY" | tr -d ' ')
 PASS=$(awk -F'\t' '$3==1{c++} END{print c+0}' "$SUMMARY")
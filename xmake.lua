@@ -4,11 +4,36 @@ set_languages("cxx17")
 
 add_requires("zlib", "sqlite3")
 
+-- Detect SHA-1 collision attacks by default (core.sha1dc still overrides).
+option("sha1dc")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Enable SHA-1 collision detection by default")
+    add_defines("MGIT_SHA1DC")
+option_end()
+
+-- One-shot compression and pack inflate through libdeflate instead of zlib.
+option("libdeflate")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Use libdeflate for one-shot zlib compression")
+    add_defines("MGIT_LIBDEFLATE")
+option_end()
+
+if has_config("libdeflate") then
+    add_requires("libdeflate")
+end
+
 target("mgit")
     set_kind("binary")
     add_files("src/*.cpp", "src/utils/*.cpp")
     add_includedirs("src/headers", "src/utils", "external")
     add_packages("zlib", "sqlite3")
+    add_syslinks("pthread")
+    add_options("sha1dc", "libdeflate")
+    if has_config("libdeflate") then
+        add_packages("libdeflate")
+    end
 
 target("mgit_prod")
     set_kind("binary")
@@ -17,6 +42,11 @@ target("mgit_prod")
     add_files("src/*.cpp", "src/utils/*.cpp")
     add_includedirs("src/headers", "src/utils", "external")
     add_packages("zlib", "sqlite3")
+    add_syslinks("pthread")
+    add_options("sha1dc", "libdeflate")
+    if has_config("libdeflate") then
+        add_packages("libdeflate")
+    end
     set_optimize("fastest")
     set_strip("all")
     set_symbols("hidden")
@@ -32,24 +62,72 @@ target("integration_cli_test")
     set_languages("cxx17")
     add_deps("mgit")
 
+target("sha1_collision_test")
+    set_kind("binary")
+    set_default(false)
+    add_files("tests/sha1_collision_test.cpp", "src/utils/sha1-util.cpp",
+              "src/utils/hex-util.cpp")
+    set_languages("cxx17")
+
+target("sha1_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/sha1_bench.cpp", "src/utils/sha1-util.cpp",
+              "src/utils/hex-util.cpp")
+    set_optimize("fastest")
+
+target("merge_base_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/merge_base_bench.cpp", "src/GitMergeBase.cpp",
+              "src/utils/hex-util.cpp")
+    set_optimize("fastest")
+
+target("compress_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/compress_bench.cpp", "src/utils/zlib-util.cpp",
+              "src/utils/hex-util.cpp")
+    add_packages("zlib")
+    add_options("libdeflate")
+    if has_config("libdeflate") then
+        add_packages("libdeflate")
+    end
+    set_optimize("fastest")
+
+target("hex_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/hex_bench.cpp", "src/utils/hex-util.cpp")
+    set_optimize("fastest")
+
+target("ignore_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/ignore_bench.cpp", "src/GitIgnore.cpp", "src/GitConfig.cpp",
+              "src/utils/sha1-util.cpp", "src/utils/hex-util.cpp")
+    set_optimize("fastest")
+
 target("test")
     set_kind("phony")
-    add_deps("mgit", "integration_cli_test")
+    add_deps("mgit", "integration_cli_test", "sha1_collision_test")
     on_run(function ()
         import("core.project.project")
         local mgit = project.target("mgit"):targetfile()
         local itest = project.target("integration_cli_test"):targetfile()
+        os.execv(project.target("sha1_collision_test"):targetfile())
         os.execv(itest, {mgit})
         os.execv("bash", {"tests/smoke_cli.sh", mgit})
     end)
 
 target("compile-test")
     set_kind("phony")
-    add_deps("mgit", "integration_cli_test")
+    add_deps("mgit", "integration_cli_test", "sha1_collision_test")
     on_run(function ()
         import("core.project.project")
         local mgit = project.target("mgit"):targetfile()
         local itest = project.target("integration_cli_test"):targetfile()
+        os.execv(project.target("sha1_collision_test"):targetfile())
         os.execv(itest, {mgit})
         os.execv("bash", {"tests/smoke_cli.sh", mgit})
     end)